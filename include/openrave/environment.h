@@ -232,6 +232,37 @@ public:
     ///
     /// See \ref arch_simulation for more about the simulation thread.
     virtual uint64_t GetSimulationTime() = 0;
+
+    /// \brief Timing of a simulation batch, see \ref StepSimulationBatch
+    struct OPENRAVE_API SimulationBatchStats
+    {
+        uint64_t numsteps = 0; ///< number of steps taken
+        uint64_t simulationtime = 0; ///< simulation time advanced by the batch in microseconds
+        uint64_t elapsedtime = 0; ///< wall clock time the batch took in microseconds
+
+        inline double GetStepsPerSecond() const {
+            return elapsedtime > 0 ? 1e6*(double)numsteps/(double)elapsedtime : 0;
+        }
+        /// \brief how many times faster than real time the batch ran
+        inline double GetRealTimeFactor() const {
+            return elapsedtime > 0 ? (double)simulationtime/(double)elapsedtime : 0;
+        }
+    };
+
+    /// \brief Makes numsteps calls to \ref StepSimulation back to back without any sleeping. <b>[multi-thread safe]</b>
+    ///
+    /// Every step updates physics, the bodies (and with them their controllers), modules and sensors. The environment is locked once for the whole batch, so the internal simulation thread should be stopped. Other threads waiting for the environment only get it after the batch finishes.
+    /// \param numsteps number of simulation steps
+    /// \param timestep simulation time of one step in seconds
+    SimulationBatchStats StepSimulationBatch(int numsteps, dReal timestep);
+
+    /// \brief Calls \ref StepSimulationBatch on several independent environments in parallel. <b>[multi-thread safe]</b>
+    ///
+    /// Every environment is stepped by one thread at a time, the environments must not share bodies or interfaces (for example clones made with \ref CloneSelf).
+    /// If any batch throws, the first exception is rethrown after all threads finished.
+    /// \param[out] vstats the timing of each environment's batch, in the same order as venvs
+    /// \param numthreads maximum number of threads, if 0 uses the number of hardware threads
+    static void StepSimulationBatches(const std::vector<EnvironmentBasePtr>& venvs, int numsteps, dReal timestep, std::vector<SimulationBatchStats>& vstats, int numthreads=0);
     //@}
 
     /// \name File Loading and Parsing
@@ -521,46 +552,50 @@ public:
     /// \throw openrave_exception with ORE_Timeout error code
     virtual void GetRobots(std::vector<RobotBasePtr>& robots, uint64_t timeout=0) const = 0;
 
+    // The GetPublished* functions read the last generation published by UpdatePublishedBodies without locking, so they never wait on it.
+
     /// \brief Retrieve published bodies, completes even if environment is locked. <b>[multi-thread safe]</b>
     ///
-    /// A separate **interface mutex** is locked for reading the modules.
     /// Note that the pbody pointer might become invalid as soon as GetPublishedBodies returns.
-    /// \param timeout microseconds to wait before throwing an exception, if 0, will block indefinitely.
-    /// \throw openrave_exception with ORE_Timeout error code
+    /// \param timeout unused, kept for compatibility
     virtual void GetPublishedBodies(std::vector<KinBody::BodyState>& vbodies, uint64_t timeout=0) = 0;
 
     /// \brief Retrieve published body of specified name, completes even if environment is locked. <b>[multi-thread safe]</b>
     ///
-    /// A separate **interface mutex** is locked for reading the modules.
     /// Note that the pbody pointer might become invalid as soon as GetPublishedBody returns.
-    /// \param timeout microseconds to wait before throwing an exception, if 0, will block indefinitely.
-    /// \throw openrave_exception with ORE_Timeout error code
+    /// \param timeout unused, kept for compatibility
     /// \return true if name matches to a published body
     virtual bool GetPublishedBody(const std::string& name, KinBody::BodyState& bodystate, uint64_t timeout=0) = 0;
 
     /// \brief Retrieve joint values of published body of specified name, completes even if environment is locked. <b>[multi-thread safe]</b>
     ///
-    /// A separate **interface mutex** is locked for reading the modules.
     /// Note that the pbody pointer might become invalid as soon as GetPublishedBodyJointValues returns.
-    /// \param timeout microseconds to wait before throwing an exception, if 0, will block indefinitely.
-    /// \throw openrave_exception with ORE_Timeout error code
+    /// \param timeout unused, kept for compatibility
     /// \return true if name matches to a published body
     virtual bool GetPublishedBodyJointValues(const std::string& name, std::vector<dReal> &jointValues, uint64_t timeout=0) = 0;
 
     /// \brief Retrieve body transform of all published bodies whose name matches prefix, completes even if environment is locked. <b>[multi-thread safe]</b>
     ///
-    /// A separate **interface mutex** is locked for reading the modules.
     /// Note that the pbody pointer might become invalid as soon as GetPublishedBody returns.
     /// \param prefix the prefix to match to the target names.
-    /// \param timeout microseconds to wait before throwing an exception, if 0, will block indefinitely.
-    /// \throw openrave_exception with ORE_Timeout error code
+    /// \param timeout unused, kept for compatibility
     virtual void GetPublishedBodyTransformsMatchingPrefix(const std::string& prefix, std::vector<std::pair<std::string, Transform> >& nameTransfPairs, uint64_t timeout = 0) = 0;
 
+    /// \brief Retrieve the published bodies whose state changed since a previous generation, completes even if environment is locked. <b>[multi-thread safe]</b>
+    ///
+    /// Every call to UpdatePublishedBodies publishes a new generation. A body is reported as changed if its update stamp, enable states, active manipulator or grabbed bodies differ from the previous generation.
+    /// The default implementation does not track generations, it reports all the published bodies as changed and returns 0.
+    /// \param generation the generation returned by a previous call, 0 to retrieve all the published bodies
+    /// \param[out] vChangedBodies filled with the states of the bodies that changed after generation
+    /// \param[out] vEnvironmentBodyIndices filled with the environment body indices of all the published bodies, so that callers can detect removed bodies
+    /// \return the generation of the returned states, to pass to the next call
+    virtual uint64_t GetPublishedBodiesChangedSince(uint64_t generation, std::vector<KinBody::BodyState>& vChangedBodies, std::vector<int>& vEnvironmentBodyIndices);
+
     /// \brief Updates the published bodies that viewers and other programs listening in on the environment see.
     ///
     /// For example, calling this function inside a planning loop allows the viewer to update the environment
     /// reflecting the status of the planner.
-    /// Assumes that the physics are locked.
+    /// Assumes that the physics are locked. The new generation is swapped in atomically, readers of the published bodies are never blocked.
     /// \param timeout microseconds to wait before throwing an exception, if 0, will block indefinitely.
     /// \throw openrave_exception with ORE_Timeout error code
     virtual void UpdatePublishedBodies(uint64_t timeout=0) = 0;
@@ -834,6 +869,20 @@ public:
         std::map<std::string, uint64_t> _uInt64Parameters; ///< user parameters associated with the environment
         int _revision = 0;  ///< environment revision number
         std::pair<std::string, dReal> _unit = {"meter", 1.0}; ///< environment unit
+
+protected:
+        /// \brief a new body info already placed in _vBodyInfos whose json still needs to be decoded
+        struct PendingBodyInfo
+        {
+            PendingBodyInfo(KinBody::KinBodyInfoPtr pinfo, const rapidjson::Value* prInfo, const std::string& id) : pinfo(pinfo), prInfo(prInfo), id(id) {
+            }
+            KinBody::KinBodyInfoPtr pinfo;
+            const rapidjson::Value* prInfo; ///< points into the json passed to DeserializeJSONWithMapping
+            std::string id;
+        };
+
+        /// \brief decodes all pending body infos in parallel, then removes the ones that came out without a name. Clears vPendingBodyInfos.
+        void _DeserializePendingBodyInfos(std::vector<PendingBodyInfo>& vPendingBodyInfos, dReal fUnitScale, int options);
     };
     typedef boost::shared_ptr<EnvironmentBaseInfo> EnvironmentBaseInfoPtr;
     typedef boost::shared_ptr<EnvironmentBaseInfo const> EnvironmentBaseInfoConstPtr;
@@ -864,6 +913,82 @@ public:
     /// \param updateMode one of UFIM_X
     virtual void UpdateFromInfo(const EnvironmentBaseInfo& info, std::vector<KinBodyPtr>& vCreatedBodies, std::vector<KinBodyPtr>& vModifiedBodies, std::vector<KinBodyPtr>& vRemovedBodies, UpdateFromInfoMode updateMode) = 0;
 
+    /// \brief returns how many bodies, links and geometries the last UpdateFromInfo (or LoadJSON) created, modified or skipped
+    ///
+    /// The default implementation does not count anything and returns all zeros.
+    virtual UpdateFromInfoCounters GetUpdateFromInfoCounters() const;
+
+    /// \brief Helper class to save and restore the mutable state of all bodies in the environment without cloning it.
+    ///
+    /// Link transforms, dof branches and link enable states of all bodies are packed into shared buffers. Bodies whose update stamp did not change since the save are skipped on restore, and the enable states and grabbed bodies are only reset when they differ, so collision checkers only see the bodies that were actually touched.
+    /// Bodies added after the save are left untouched and removed bodies are not re-added.
+    /// Options are the same as \ref KinBody::SaveParameters, only Save_LinkTransformation, Save_LinkEnable, Save_GrabbedBodies, Save_ActiveDOF and Save_ActiveManipulator are supported.
+    /// The environment should be locked while saving and restoring.
+    class OPENRAVE_API EnvironmentStateSaver
+    {
+public:
+        EnvironmentStateSaver(EnvironmentBasePtr penv, int options = KinBody::Save_LinkTransformation|KinBody::Save_LinkEnable|KinBody::Save_GrabbedBodies|KinBody::Save_ActiveDOF|KinBody::Save_ActiveManipulator);
+        virtual ~EnvironmentStateSaver();
+        inline EnvironmentBasePtr GetEnv() const {
+            return _penv;
+        }
+
+        /// \brief restore the state of all saved bodies that are still in the environment. Can be called multiple times.
+        virtual void Restore();
+
+        /// \brief release the environment state. nothing will get restored on destruction
+        virtual void Release();
+
+        /// \brief sets whether the state saver will restore the state on destruction. by default this is true.
+        virtual void SetRestoreOnDestructor(bool restore);
+
+        /// \brief number of bytes used by the saved state buffers
+        size_t GetBufferSize() const;
+
+protected:
+        struct SavedBodyState
+        {
+            KinBodyWeakPtr pbody;
+            int environmentBodyIndex = 0;
+            int updateStamp = 0; ///< KinBody::GetUpdateStamp right after the state was last saved or restored
+            uint32_t linkOffset = 0; ///< offset into _vLinkTransforms
+            uint32_t numLinks = 0;
+            uint32_t dofOffset = 0; ///< offset into _vDOFLastSetValues
+            uint32_t numDOFs = 0;
+            uint32_t enableMaskOffset = 0; ///< offset into _vLinkEnableMasks
+            uint32_t numEnableMasks = 0;
+            int grabbedIndex = -1; ///< index into _vGrabbedBodySavers, -1 if the body was not grabbing anything
+            int robotIndex = -1; ///< index into _vRobotStates, -1 if not a robot
+        };
+
+        struct SavedRobotState
+        {
+            std::vector<int> vActiveDOFIndices;
+            int affineDOFs = 0;
+            Vector rotationAxis;
+            std::string activeManipulatorName;
+        };
+
+        void _RestoreBody(SavedBodyState& savedstate);
+
+        EnvironmentBasePtr _penv;
+        int _options;
+        std::vector<SavedBodyState> _vSavedBodyStates;
+        std::vector<Transform> _vLinkTransforms; ///< link transforms of all bodies
+        std::vector<dReal> _vDOFLastSetValues; ///< dof branches of all bodies
+        std::vector<uint64_t> _vLinkEnableMasks; ///< KinBody::GetLinkEnableStatesMasks of all bodies
+        std::vector<KinBody::KinBodyStateSaverPtr> _vGrabbedBodySavers; ///< only for bodies grabbing something, keeps their Grabbed objects so that restoring does not recompute non-colliding links
+        std::vector<SavedRobotState> _vRobotStates;
+        bool _bRestoreOnDestructor;
+
+        // scratch buffers used when restoring
+        std::vector<Transform> _vTempTransforms;
+        std::vector<dReal> _vTempDOFValues;
+        std::vector<uint8_t> _vTempEnableStates;
+        std::vector<KinBodyPtr> _vTempGrabbedBodies;
+    };
+    typedef boost::shared_ptr<EnvironmentStateSaver> EnvironmentStateSaverPtr;
+
     int _revision = 0;  ///< environment current revision
     std::string _description;   ///< environment description
     std::vector<std::string> _keywords;  ///< some string values for describinging the environment
@@ -50,6 +50,8 @@ enum SerializationOptions
 enum InfoSerializeOption
 {
     ISO_ReferenceUriHint = 1, ///< if set, will save the referenceURI as a hint rather than as a referenceUri
+    ISO_BinaryMeshBlobs = 2, ///< if set, will save trimesh vertices and indices as binary blobs (little-endian float64 xyz and int32, see orjson::SetJsonBinaryBlob) rather than as number arrays. Only for msgpack, where the blobs are written as bin objects, since JSON text cannot hold them.
+    ISO_ContentHash = 4, ///< if set, geometry, link and body infos also write a "contentHash" computed from their serialized content. UpdateFromInfo uses it to skip the parts that did not change since the last update.
 };
 
 enum InfoDeserializeOption
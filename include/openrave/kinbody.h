@@ -36,6 +36,38 @@ enum UpdateFromInfoResult
     UFIR_RequireReinitialize = 3, ///< Failed to update, require InitFromInfo() to be called before update can succeed
 };
 
+/// \brief Counts what UpdateFromInfo calls did, so the cost of synchronizing a scene can be related to what actually changed.
+///
+/// Parts are skipped when the contentHash of their info (see ISO_ContentHash) matches the one they were last updated with and nothing modified them since.
+struct UpdateFromInfoCounters
+{
+    inline void Reset() {
+        *this = UpdateFromInfoCounters();
+    }
+    UpdateFromInfoCounters& operator+=(const UpdateFromInfoCounters& other) {
+        numCreatedBodies += other.numCreatedBodies;
+        numModifiedBodies += other.numModifiedBodies;
+        numRemovedBodies += other.numRemovedBodies;
+        numUnchangedBodies += other.numUnchangedBodies;
+        numSkippedBodyStructures += other.numSkippedBodyStructures;
+        numComparedLinks += other.numComparedLinks;
+        numSkippedLinks += other.numSkippedLinks;
+        numComparedGeometries += other.numComparedGeometries;
+        numSkippedGeometries += other.numSkippedGeometries;
+        return *this;
+    }
+
+    int numCreatedBodies = 0;
+    int numModifiedBodies = 0;
+    int numRemovedBodies = 0;
+    int numUnchangedBodies = 0;
+    int numSkippedBodyStructures = 0; ///< bodies whose links and joints were not compared since the KinBodyInfo contentHash matched
+    int numComparedLinks = 0;
+    int numSkippedLinks = 0;
+    int numComparedGeometries = 0;
+    int numSkippedGeometries = 0;
+};
+
 /// \brief The type of geometry primitive.
 enum GeometryType {
     GT_None = 0,
@@ -469,6 +501,7 @@ public:
         GeometryType _type = GT_None; ///< the type of geometry primitive
         std::string _id;   ///< unique id of the geometry
         std::string _name; ///< the name of the geometry
+        std::string _contentHash; ///< optional hash of the serialized geometry, see ISO_ContentHash. Not part of the comparison operators.
 
         /// \brief filename for render model (optional)
         ///
@@ -643,6 +676,11 @@ public:
             return _info._meshcollision;
         }
 
+        /// \brief creates a compact immutable copy of the local collision mesh.
+        ///
+        /// The geometry does not keep the buffer, so the mesh is only held once by the geometry. Consumers that keep meshes around (e.g. caches shared between bodies) can hold on to the buffer instead of a TriMesh.
+        TriMeshBufferConstPtr CreateCollisionMeshBuffer() const;
+
         inline const KinBody::GeometryInfo& GetInfo() const {
             return _info;
         }
@@ -838,6 +876,8 @@ public:
         std::string _id;
         /// \brief unique link name
         std::string _name;
+        /// \brief optional hash of the serialized link including its geometries, see ISO_ContentHash. Not part of the comparison operators.
+        std::string _contentHash;
 
         /// the frame for inertia and center of mass of the link in the link's coordinate system
         Transform _tMassFrame;
@@ -2186,6 +2226,8 @@ public:
 
         boost::shared_ptr<rapidjson::Document> _prAssociatedFileEntries; ///< files tag maintaining entries of data files associated with this object
 
+        std::string _contentHash; ///< optional hash of the serialized links and joints, see ISO_ContentHash. Not part of the comparison operators.
+
         bool _isRobot = false; ///< true if should create a RobotBasePtr
         bool _isPartial = true; ///< true if this info contains partial information. false if the info contains the full body information and can ignore anything that is currently saved on the environment when updating.
 
@@ -3321,8 +3363,15 @@ private:
     virtual void ExtractInfo(KinBodyInfo& info);
 
     /// \brief update KinBody according to new KinBodyInfo, returns false if update cannot be performed and requires InitFromInfo
+    ///
+    /// If the infos carry a contentHash (see ISO_ContentHash) equal to the one of the previous update and the body was not modified in between, the links, joints or geometries they describe are not compared again.
     virtual UpdateFromInfoResult UpdateFromKinBodyInfo(const KinBodyInfo& info);
 
+    /// \brief returns the counters of the last UpdateFromKinBodyInfo call
+    inline const UpdateFromInfoCounters& GetUpdateFromInfoCounters() const {
+        return _updateFromInfoCounters;
+    }
+
     /// \brief Associate the kinbody's current kinematics geometry hash with a forward kinematics generator
     virtual void SetKinematicsGenerator(KinematicsGeneratorPtr pGenerator);
 
@@ -3377,6 +3426,9 @@ protected:
     /// recomputes the hashes if geometry changed.
     virtual void _PostprocessChangedParameters(uint32_t parameters);
 
+    /// \brief does the work of UpdateFromKinBodyInfo, which takes care of recording the info content hashes
+    UpdateFromInfoResult _UpdateFromKinBodyInfo(const KinBodyInfo& info);
+
     /// \brief Return true if two bodies should be considered as one during collision (ie one is grabbing the other)
     bool _IsAttached(const KinBody &body, std::set<KinBodyConstPtr>& setChecked) const;
 
@@ -3446,6 +3498,14 @@ protected:
 
     std::vector<GrabbedPtr> _vGrabbedBodies; ///< vector of grabbed bodies
 
+    /// \brief links found by Grabbed::ComputeListNonCollidingLinks to be non-colliding with a grabbed body
+    struct GrabbedNonCollidingLinks
+    {
+        std::vector<int> vGrabberLinkIndices; ///< indices of the links of this body
+        std::vector< std::pair<int, int> > vOtherGrabbedLinks; ///< environment body index and link index of the links of the other grabbed bodies
+    };
+    std::map<std::string, GrabbedNonCollidingLinks> _mapGrabbedNonCollidingLinksCache; ///< results of Grabbed::ComputeListNonCollidingLinks indexed by the grab-time state they depend on, so that grabbing again in the same state (RegrabAll, ResetGrabbed, repeated grab/release cycles) does not repeat the collision checks
+
     mutable std::vector<std::list<UserDataWeakPtr> > _vlistRegisteredCallbacks; ///< callbacks to call when particular properties of the body change. _vlistRegisteredCallbacks[index] is the list of change callbacks where 1<<index is part of KinBodyProperty, this makes it easy to find out if any particular bits have callbacks. The registration/de-registration of the lists can happen at any point and does not modify the kinbody state exposed to the user, hence it is mutable.
 
     mutable boost::array<std::vector<int>, 4> _vNonAdjacentLinks; ///< contains cached versions of the non-adjacent links depending on values in AdjacentOptions. Declared as mutable since data is cached.
@@ -3470,6 +3530,11 @@ protected:
     int _environmentBodyIndex; ///< \see GetEnvironmentBodyIndex
     mutable int _nUpdateStampId; ///< \see GetUpdateStamp
     uint32_t _nParametersChanged; ///< set of parameters that changed and need callbacks
+    int _nStructureStamp; ///< incremented by _PostprocessChangedParameters for every change besides link transforms, grabbing and active dofs
+    int _nInfoContentHashStamp; ///< _nStructureStamp when UpdateFromKinBodyInfo last recorded the content hashes. The hashes stored in the body, link and geometry infos are only trusted while both stamps are equal
+    bool _bUseInfoContentHash; ///< true while UpdateFromKinBodyInfo runs with trusted content hashes
+    std::string _infoContentHash; ///< KinBodyInfo::_contentHash that the links and joints were last updated with
+    UpdateFromInfoCounters _updateFromInfoCounters; ///< \see GetUpdateFromInfoCounters
     ManageDataPtr _pManageData;
     uint32_t _nHierarchyComputed; ///< 2 if the joint heirarchy and other cached information is computed. 1 if the hierarchy information is computing
     bool _bMakeJoinedLinksAdjacent; ///< if true, then automatically add adjacent links to the adjacency list so that their self-collisions are ignored.
@@ -3564,8 +3629,15 @@ public:
     std::set<int> _setGrabberLinkIndicesToIgnore; ///< indices to the links of the grabber whose collisions with the grabbed bodies should be ignored.
     rapidjson::Document _rGrabbedUserData; ///< user-defined data to be updated when kinbody grabs and releases objects
 private:
+    /// \brief fills _listNonCollidingLinksWhenGrabbed from the grabber's cache if it has a result for cachekey
+    bool _LoadListNonCollidingLinksFromCache(KinBodyPtr pGrabber, const std::string& cachekey);
+
+    /// \brief stores _listNonCollidingLinksWhenGrabbed in the grabber's cache
+    void _SaveListNonCollidingLinksToCache(KinBodyPtr pGrabber, const std::string& cachekey) const;
+
     bool _listNonCollidingIsValid = false; ///< a flag indicating whether the current _listNonCollidingLinksWhenGrabbed is valid or not.
     std::vector<KinBody::LinkPtr> _vAttachedToGrabbingLink; ///< vector of all links that are rigidly attached to _pGrabbingLink
+    std::string _nonCollidingCacheKey; ///< binary snapshot of the grab-time state that _listNonCollidingLinksWhenGrabbed depends on: kinematics-geometry hashes and dof values of the grabber, the grabbed body and the other grabbed bodies, and their poses relative to _pGrabbingLink.
     KinBody::KinBodyStateSaverPtr _pGrabberSaver; ///< statesaver that saves the snapshot of the grabber at the time Grab is called. The saved state will be used (i.e. restored) temporarily when computation of _listNonCollidingLinksWhenGrabbed is necessary.
     KinBody::KinBodyStateSaverPtr _pGrabbedSaver; ///< statesaver that saves the snapshot of the grabbed at the time Grab is called. The saved state will be used (i.e. restored) temporarily when computation of _listNonCollidingLinksWhenGrabbed is necessary.
 
@@ -2473,6 +2473,55 @@ public:
 OPENRAVE_API std::ostream& operator<<(std::ostream& O, const TriMesh& trimesh);
 OPENRAVE_API std::istream& operator>>(std::istream& I, TriMesh& trimesh);
 
+/** \brief Compact immutable copy of a TriMesh: float32 xyz positions, and 16-bit indices when there are less than 65536 vertices.
+
+    Uses about a third of the memory of TriMesh. Once created, a buffer is never modified, so the same TriMeshBufferConstPtr can be shared by any number of users without copying. Currently created by KinBody::Geometry::CreateCollisionMeshBuffer for the bullet mesh shape cache and the python mesh views.
+    Positions are rounded to float, so consumers that need the full precision of far-from-origin meshes should keep using TriMesh.
+ */
+class OPENRAVE_API TriMeshBuffer
+{
+public:
+    explicit TriMeshBuffer(const TriMesh& mesh);
+
+    inline size_t GetNumVertices() const {
+        return _vpositions.size()/3;
+    }
+
+    inline size_t GetNumIndices() const {
+        return _b16BitIndices ? _vindices16.size() : _vindices32.size();
+    }
+
+    /// \brief returns the xyz positions of the vertices, 3*GetNumVertices() values
+    inline const float* GetPositions() const {
+        return _vpositions.size() > 0 ? &_vpositions[0] : NULL;
+    }
+
+    /// \brief true if the indices are stored with GetIndices16, otherwise with GetIndices32
+    inline bool Has16BitIndices() const {
+        return _b16BitIndices;
+    }
+
+    inline const uint16_t* GetIndices16() const {
+        return _vindices16.size() > 0 ? &_vindices16[0] : NULL;
+    }
+
+    inline const int32_t* GetIndices32() const {
+        return _vindices32.size() > 0 ? &_vindices32[0] : NULL;
+    }
+
+    inline int32_t GetIndex(size_t i) const {
+        return _b16BitIndices ? (int32_t)_vindices16[i] : _vindices32[i];
+    }
+
+private:
+    std::vector<float> _vpositions; ///< xyz of every vertex
+    std::vector<uint16_t> _vindices16; ///< used if _b16BitIndices
+    std::vector<int32_t> _vindices32; ///< used if not _b16BitIndices
+    bool _b16BitIndices;
+};
+
+typedef boost::shared_ptr<TriMeshBuffer const> TriMeshBufferConstPtr;
+
 /// \brief Selects which DOFs of the affine transformation to include in the active configuration.
 enum DOFAffine
 {
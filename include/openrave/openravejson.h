@@ -22,12 +22,14 @@
 #include <openrave/openraveexception.h>
 #include <openrave/sensor.h>
 
+#include <algorithm>
 #include <array>
 #include <boost/shared_ptr.hpp>
 #include <boost/smart_ptr/make_shared.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/format.hpp>
 #include <stdint.h>
+#include <cstring>
 #include <string>
 #include <stdexcept>
 #include <vector>
@@ -106,6 +108,66 @@ inline void DumpJson(const rapidjson::Value& value, std::ostream& os, const unsi
     }
 }
 
+/// \brief member name of a binary blob. A blob is an object whose only member is this key holding the raw bytes as a string.
+///
+/// The msgpack writer packs blobs as bin objects, and the msgpack reader reads bin objects back as plain strings.
+#define ORJSON_BINARY_BLOB_KEY "__bin__"
+
+/// \brief returns true if v was set with SetJsonBinaryBlob
+inline bool IsJsonBinaryBlob(const rapidjson::Value& v) {
+    return v.IsObject() && v.MemberCount() == 1 && v.MemberBegin()->name == ORJSON_BINARY_BLOB_KEY && v.MemberBegin()->value.IsString();
+}
+
+/// \brief returns true if the host stores numbers in little-endian, the byte order of binary blobs
+inline bool IsLittleEndianHost() {
+    const uint16_t test = 1;
+    return *reinterpret_cast<const uint8_t*>(&test) == 1;
+}
+
+/// \brief sets v to a binary blob holding the elements of vdata in little-endian byte order
+template<class T>
+inline void SetJsonBinaryBlob(rapidjson::Value& v, const std::vector<T>& vdata, rapidjson::Document::AllocatorType& alloc) {
+    rapidjson::Value rData;
+    if (vdata.empty()) {
+        rData.SetString("", 0, alloc);
+    }
+    else if (IsLittleEndianHost()) {
+        rData.SetString(reinterpret_cast<const char*>(&vdata[0]), vdata.size()*sizeof(T), alloc);
+    }
+    else {
+        std::vector<char> vbytes(reinterpret_cast<const char*>(&vdata[0]), reinterpret_cast<const char*>(&vdata[0]) + vdata.size()*sizeof(T));
+        for (size_t ielement = 0; ielement < vdata.size(); ++ielement) {
+            std::reverse(vbytes.begin() + ielement*sizeof(T), vbytes.begin() + (ielement + 1)*sizeof(T));
+        }
+        rData.SetString(&vbytes[0], vbytes.size(), alloc);
+    }
+    v.SetObject();
+    v.AddMember(rapidjson::Document::StringRefType(ORJSON_BINARY_BLOB_KEY), rData, alloc);
+}
+
+/// \brief loads a binary blob written by SetJsonBinaryBlob into vdata. Also accepts a plain string, which is how a blob reads back from msgpack.
+///
+/// \return false if v is not a blob or its size is not a multiple of sizeof(T)
+template<class T>
+inline bool LoadJsonBinaryBlob(const rapidjson::Value& v, std::vector<T>& vdata) {
+    const rapidjson::Value& rData = IsJsonBinaryBlob(v) ? v.MemberBegin()->value : v;
+    if (!rData.IsString() || rData.GetStringLength() % sizeof(T) != 0) {
+        return false;
+    }
+    vdata.resize(rData.GetStringLength()/sizeof(T));
+    if (vdata.empty()) {
+        return true;
+    }
+    std::memcpy(&vdata[0], rData.GetString(), rData.GetStringLength());
+    if (!IsLittleEndianHost()) {
+        char* pbytes = reinterpret_cast<char*>(&vdata[0]);
+        for (size_t ielement = 0; ielement < vdata.size(); ++ielement) {
+            std::reverse(pbytes + ielement*sizeof(T), pbytes + (ielement + 1)*sizeof(T));
+        }
+    }
+    return true;
+}
+
 class VectorWrapper {
 public:
     typedef char Ch;
@@ -495,6 +557,22 @@ inline void LoadJsonValue(const rapidjson::Value& v, OpenRAVE::TriMesh& t)
         throw OPENRAVE_EXCEPTION_FORMAT0("Cannot load value of non-object.", OpenRAVE::ORE_InvalidArguments);
     }
 
+    if (v.HasMember("vertices") && !v["vertices"].IsArray()) {
+        // binary blobs written with ISO_BinaryMeshBlobs
+        std::vector<double> vpositions;
+        if (!LoadJsonBinaryBlob(v["vertices"], vpositions) || vpositions.size() % 3 != 0) {
+            throw OPENRAVE_EXCEPTION_FORMAT0("failed to deserialize json, value cannot be decoded as a TriMesh, \"vertices\" blob malformatted", OpenRAVE::ORE_InvalidArguments);
+        }
+        t.vertices.resize(vpositions.size()/3);
+        for (size_t ivertex = 0; ivertex < t.vertices.size(); ++ivertex) {
+            t.vertices[ivertex] = OpenRAVE::Vector(vpositions[3*ivertex], vpositions[3*ivertex+1], vpositions[3*ivertex+2]);
+        }
+        if (!v.HasMember("indices") || !LoadJsonBinaryBlob(v["indices"], t.indices)) {
+            throw OPENRAVE_EXCEPTION_FORMAT0("failed to deserialize json, value cannot be decoded as a TriMesh, \"indices\" blob malformatted", OpenRAVE::ORE_InvalidArguments);
+        }
+        return;
+    }
+
     if (!v.HasMember("vertices") || !v["vertices"].IsArray() || v["vertices"].Size() % 3 != 0) {
         throw OPENRAVE_EXCEPTION_FORMAT0("failed to deserialize json, value cannot be decoded as a TriMesh, \"vertices\" malformatted", OpenRAVE::ORE_InvalidArguments);
     }
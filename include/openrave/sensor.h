@@ -88,6 +88,7 @@ public:
             return ST_Camera;
         }
         std::vector<uint8_t> vimagedata;         ///< rgb image data, if camera only outputs in grayscale, fill each channel with the same value
+        std::vector<float> vdepthdata;         ///< optional width*height depth along the optical axis in meters, 0 where nothing was hit. Empty if the camera does not measure depth.
         virtual bool serialize(std::ostream& O) const;
     };
 
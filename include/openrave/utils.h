@@ -289,6 +289,12 @@ OPENRAVE_API std::string GetMD5HashString(const std::string& s);
 /// \brief compute the md5 hash of an array
 OPENRAVE_API std::string GetMD5HashString(const std::vector<uint8_t>& v);
 
+/// \brief calls fn(index) for every index in [0, count) distributed over worker threads, returns after all calls finish.
+///
+/// Indices are handed out dynamically so uneven work loads balance themselves. If any call throws, the remaining indices are skipped and the first exception is rethrown in the calling thread.
+/// \param maxthreads maximum number of threads to use including the calling thread. If 0, uses the hardware concurrency.
+OPENRAVE_API void ParallelForEachIndex(int count, const boost::function<void(int)>& fn, int maxthreads=0);
+
 template<class T>
 inline T ClampOnRange(T value, T min, T max)
 {
@@ -17,13 +17,16 @@
 
 #include <boost/bind/bind.hpp>
 #include <boost/lexical_cast.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
 
 using namespace boost::placeholders;
 
 class IdealController : public ControllerBase
 {
 public:
-    IdealController(EnvironmentBasePtr penv, std::istream& sinput) : ControllerBase(penv), cmdid(0), _bPause(false), _bIsDone(true), _bCheckCollision(false), _bThrowExceptions(false), _bEnableLogging(false)
+    IdealController(EnvironmentBasePtr penv, std::istream& sinput) : ControllerBase(penv), cmdid(0), _bPause(false), _bIsDone(true), _bCheckCollision(false), _bThrowExceptions(false), _bEnableLogging(false), _bPrefetch(true), _nPrefetchCapacity(4096), _bStopPrefetch(false), _fPrefetchStartTime(0), _fPrefetchTimeStep(0), _nPrefetchSamples(0), _nprefetchready(0), _nprefetchconsumed(0)
     {
         __description = ":Interface Author: Rosen Diankov\n\nIdeal controller used for planning and non-physics simulations. Forces exact robot positions.\n\n\
 If \ref ControllerBase::SetPath is called and the trajectory finishes, then the controller will continue to set the trajectory's final joint values and transformation until one of three things happens:\n\n\
@@ -39,11 +42,14 @@ If SetDesired is called, only joint values will be set at every timestep leaving
                         "If set, will throw exceptions instead of print warnings. Format is:\n\n  [0/1]");
         RegisterCommand("SetEnableLogging",boost::bind(&IdealController::_SetEnableLogging,this,_1,_2),
                         "If set, will write trajectories to disk");
+        RegisterCommand("SetPrefetch",boost::bind(&IdealController::_SetPrefetch,this,_1,_2),
+                        "If set, the trajectory is sampled ahead of time on a separate thread so that every simulation step only reads the buffered sample. Enabled by default. Format is:\n\n  [0/1] [buffersize]\n\nbuffersize is the maximum number of samples computed ahead of the current time.");
         _fCommandTime = 0;
         _fSpeed = 1;
         _nControlTransformation = 0;
     }
     virtual ~IdealController() {
+        _StopPrefetch();
     }
 
     virtual bool Init(RobotBasePtr robot, const std::vector<int>& dofindices, int nControlTransformation)
@@ -95,6 +101,8 @@ If SetDesired is called, only joint values will be set at every timestep leaving
 
     virtual void Reset(int options)
     {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _StopPrefetch();
         _ptraj.reset();
         _vecdesired.resize(0);
         if( flog.is_open() ) {
@@ -145,6 +153,7 @@ If SetDesired is called, only joint values will be set at every timestep leaving
     {
         OPENRAVE_ASSERT_FORMAT0(!ptraj || GetEnv()==ptraj->GetEnv(), "trajectory needs to come from the same environment as the controller", ORE_InvalidArguments);
         std::lock_guard<std::mutex> lock(_mutex);
+        _StopPrefetch();
         if( _bPause ) {
             RAVELOG_DEBUG("IdealController cannot start trajectories when paused\n");
             _ptraj.reset();
@@ -249,6 +258,10 @@ If SetDesired is called, only joint values will be set at every timestep leaving
             _ptraj = RaveCreateTrajectory(GetEnv(),ptraj->GetXMLId());
             _ptraj->Clone(ptraj,0);
             _bIsDone = false;
+            if( _bPrefetch && _fPrefetchTimeStep > 0 ) {
+                // assume the simulation keeps the time step of the previous trajectory
+                _StartPrefetch(0, _fPrefetchTimeStep);
+            }
         }
 
         return true;
@@ -261,10 +274,14 @@ If SetDesired is called, only joint values will be set at every timestep leaving
         }
         std::lock_guard<std::mutex> lock(_mutex);
         TrajectoryBaseConstPtr ptraj = _ptraj; // because of multi-threading setting issues
+        if( !ptraj ) {
+            // trajectory was dropped by SetDesired
+            _StopPrefetch();
+        }
         if( !!ptraj ) {
             RobotBasePtr probot = _probot.lock();
-            vector<dReal> sampledata;
-            ptraj->Sample(sampledata,_fCommandTime,_samplespec);
+            vector<dReal>& sampledata = _vsampledata;
+            _SampleTrajectory(ptraj, sampledata);
 
             // already sampled, so change the command times before before setting values
             // incase the below functions fail
@@ -275,6 +292,9 @@ If SetDesired is called, only joint values will be set at every timestep leaving
             }
             else {
                 _fCommandTime += _fSpeed * fTimeElapsed;
+                if( _bPrefetch ) {
+                    _UpdatePrefetch(_fSpeed * fTimeElapsed);
+                }
             }
 
             // first process all grab info
@@ -364,6 +384,7 @@ If SetDesired is called, only joint values will be set at every timestep leaving
             if( bIsDone ) {
                 // trajectory is done, so reset it so that the controller doesn't continously set the dof values (which can get annoying)
                 _ptraj.reset();
+                _StopPrefetch();
             }
         }
 
@@ -414,6 +435,146 @@ private:
         is >> _bEnableLogging;
         return !!is;
     }
+    virtual bool _SetPrefetch(std::ostream& os, std::istream& is)
+    {
+        bool bPrefetch = false;
+        is >> bPrefetch;
+        if( !is ) {
+            return false;
+        }
+        size_t nCapacity = 0;
+        is >> nCapacity;
+        std::lock_guard<std::mutex> lock(_mutex);
+        _StopPrefetch();
+        _bPrefetch = bPrefetch;
+        if( !!is ) {
+            _nPrefetchCapacity = std::max(nCapacity, size_t(s_nPrefetchChunkSize));
+        }
+        return true;
+    }
+
+    /// \brief samples the trajectory at _fCommandTime, reading the prefetched sample if there is one. Has to be called with _mutex locked.
+    void _SampleTrajectory(TrajectoryBaseConstPtr ptraj, std::vector<dReal>& sampledata)
+    {
+        if( _prefetchthread.joinable() ) {
+            dReal fIndex = (_fCommandTime - _fPrefetchStartTime)/_fPrefetchTimeStep;
+            if( fIndex > -0.5 ) {
+                size_t isample = (size_t)(fIndex+0.5);
+                // the command time accumulates the time steps, so it can be off the sample times by the round-off error
+                if( RaveFabs(fIndex - isample) <= 1e-6 && isample < _nPrefetchSamples ) {
+                    {
+                        // samples before isample are not needed anymore, so the thread can overwrite them
+                        std::lock_guard<std::mutex> lockprefetch(_mutexprefetch);
+                        _nprefetchconsumed = std::max(_nprefetchconsumed, isample);
+                    }
+                    _condprefetch.notify_one();
+                    if( isample < _nprefetchready.load(std::memory_order_acquire) ) {
+                        const int dof = _samplespec.GetDOF();
+                        std::vector<dReal>::const_iterator itsample = _vprefetchdata.begin() + (isample % (_vprefetchdata.size()/dof))*dof;
+                        sampledata.assign(itsample, itsample+dof);
+                        return;
+                    }
+                }
+            }
+        }
+        std::lock_guard<std::mutex> locksample(_mutexsample);
+        ptraj->Sample(sampledata,_fCommandTime,_samplespec);
+    }
+
+    /// \brief restarts prefetching if the simulation changed its time step. Has to be called with _mutex locked.
+    void _UpdatePrefetch(dReal fTimeStep)
+    {
+        if( fTimeStep <= 0 || _samplespec.GetDOF() == 0 ) {
+            return;
+        }
+        if( _prefetchthread.joinable() && RaveFabs(fTimeStep - _fPrefetchTimeStep) <= 1e-9*fTimeStep ) {
+            return;
+        }
+        _StartPrefetch(_fCommandTime, fTimeStep);
+    }
+
+    /// \brief starts sampling _ptraj at fStartTime + k*fTimeStep on _prefetchthread. Has to be called with _mutex locked.
+    void _StartPrefetch(dReal fStartTime, dReal fTimeStep)
+    {
+        _StopPrefetch();
+        _fPrefetchTimeStep = fTimeStep;
+        const int dof = _samplespec.GetDOF();
+        if( !_ptraj || dof == 0 ) {
+            return;
+        }
+        dReal fDuration;
+        {
+            std::lock_guard<std::mutex> locksample(_mutexsample);
+            fDuration = _ptraj->GetDuration();
+        }
+        _fPrefetchStartTime = fStartTime;
+        // SimulationStep samples once past the duration before it notices the trajectory is done
+        _nPrefetchSamples = fStartTime <= fDuration ? (size_t)((fDuration - fStartTime)/fTimeStep) + 2 : 1;
+        _vprefetchdata.resize(std::min(_nPrefetchSamples, _nPrefetchCapacity)*dof);
+        _nprefetchready = 0;
+        _nprefetchconsumed = 0;
+        _bStopPrefetch = false;
+        _prefetchthread = std::thread(&IdealController::_PrefetchThread, this, TrajectoryBaseConstPtr(_ptraj));
+    }
+
+    /// \brief stops _prefetchthread. Has to be called with _mutex locked, or from the destructor.
+    void _StopPrefetch()
+    {
+        if( _prefetchthread.joinable() ) {
+            {
+                std::lock_guard<std::mutex> lockprefetch(_mutexprefetch);
+                _bStopPrefetch = true;
+            }
+            _condprefetch.notify_one();
+            _prefetchthread.join();
+        }
+    }
+
+    /// \brief samples the trajectory in chunks into the ring buffer _vprefetchdata, staying at most its size ahead of SimulationStep
+    void _PrefetchThread(TrajectoryBaseConstPtr ptraj)
+    {
+        const int dof = _samplespec.GetDOF();
+        const size_t nringsize = _vprefetchdata.size()/dof;
+        std::vector<dReal> vtimes, vchunkdata;
+        size_t isample = 0;
+        try {
+            while( isample < _nPrefetchSamples ) {
+                size_t nchunk = std::min(size_t(s_nPrefetchChunkSize), _nPrefetchSamples - isample);
+                {
+                    std::unique_lock<std::mutex> lockprefetch(_mutexprefetch);
+                    _condprefetch.wait(lockprefetch, [&]() {
+                        return _bStopPrefetch || isample + nchunk <= _nprefetchconsumed + nringsize;
+                    });
+                    if( _bStopPrefetch ) {
+                        return;
+                    }
+                    if( isample < _nprefetchconsumed ) {
+                        // SimulationStep got ahead and sampled these itself
+                        isample = _nprefetchconsumed;
+                        continue;
+                    }
+                }
+
+                vtimes.resize(nchunk);
+                for(size_t i = 0; i < nchunk; ++i) {
+                    vtimes[i] = _fPrefetchStartTime + (isample+i)*_fPrefetchTimeStep;
+                }
+                {
+                    std::lock_guard<std::mutex> locksample(_mutexsample);
+                    ptraj->SamplePoints(vchunkdata, vtimes, _samplespec);
+                }
+                for(size_t i = 0; i < nchunk; ++i) {
+                    std::copy(vchunkdata.begin()+i*dof, vchunkdata.begin()+(i+1)*dof, _vprefetchdata.begin()+((isample+i)%nringsize)*dof);
+                }
+                isample += nchunk;
+                _nprefetchready.store(isample, std::memory_order_release);
+            }
+        }
+        catch(const std::exception& ex) {
+            // SimulationStep samples the remaining points itself and reports the error
+            RAVELOG_WARN_FORMAT("env=%s, failed to prefetch trajectory samples at %f: %s", GetEnv()->GetNameId()%(_fPrefetchStartTime + isample*_fPrefetchTimeStep)%ex.what());
+        }
+    }
 
     inline boost::shared_ptr<IdealController> shared_controller() {
         return boost::static_pointer_cast<IdealController>(shared_from_this());
@@ -517,6 +678,7 @@ private:
                 string filename = str(boost::format("%s/failedtrajectory%d.xml")%RaveGetHomeDirectory()%(RaveRandomInt()%1000));
                 ofstream f(filename.c_str());
                 f << std::setprecision(std::numeric_limits<dReal>::digits10+1);     /// have to do this or otherwise precision gets lost
+                std::lock_guard<std::mutex> locksample(_mutexsample);
                 _ptraj->serialize(f);
                 RAVELOG_VERBOSE(str(boost::format("trajectory dumped to %s")%filename));
             }
@@ -563,6 +725,22 @@ private:
     ConfigurationSpecification _samplespec;
     boost::shared_ptr<ConfigurationSpecification::Group> _gjointvalues, _gtransform;
     std::mutex _mutex;
+    std::vector<dReal> _vsampledata; ///< cache
+
+    // prefetching of trajectory samples, see _StartPrefetch
+    static const size_t s_nPrefetchChunkSize = 64; ///< number of samples computed at once
+    bool _bPrefetch;
+    size_t _nPrefetchCapacity; ///< max number of samples in _vprefetchdata
+    std::thread _prefetchthread;
+    std::mutex _mutexsample; ///< sampling _ptraj updates its internal caches, so only one thread can sample at a time
+    std::mutex _mutexprefetch; ///< protects _nprefetchconsumed and _bStopPrefetch
+    std::condition_variable _condprefetch; ///< notified when _nprefetchconsumed or _bStopPrefetch change
+    bool _bStopPrefetch;
+    std::vector<dReal> _vprefetchdata; ///< ring buffer of samples in _samplespec, sample k is at index k%(_vprefetchdata.size()/dof)
+    dReal _fPrefetchStartTime, _fPrefetchTimeStep; ///< sample k is at time _fPrefetchStartTime + k*_fPrefetchTimeStep
+    size_t _nPrefetchSamples; ///< number of samples until the end of the trajectory
+    std::atomic<size_t> _nprefetchready; ///< samples before this one have been written to _vprefetchdata
+    size_t _nprefetchconsumed; ///< last sample read by SimulationStep, the samples before it can be overwritten
 };
 
 ControllerBasePtr CreateIdealController(EnvironmentBasePtr penv, std::istream& sinput)
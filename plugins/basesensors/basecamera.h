@@ -18,6 +18,8 @@
 
 #include <boost/lexical_cast.hpp>
 
+#include "camerarasterizer.h"
+
 class BaseCameraSensor : public SensorBase
 {
 protected:
@@ -35,7 +37,7 @@ public:
                 }
                 return PE_Ignore;
             }
-            static boost::array<string, 18> tags = { { "sensor", "kk", "width", "height", "framerate", "power", "color", "focal_length","image_dimensions","intrinsic","measurement_time", "format", "distortion_model", "distortion_coeffs", "target_region", "gain", "hardware_id"}};
+            static boost::array<string, 18> tags = { { "sensor", "kk", "width", "height", "framerate", "power", "color", "focal_length","image_dimensions","intrinsic","measurement_time", "format", "distortion_model", "distortion_coeffs", "target_region", "gain", "hardware_id", "software_rendering"}};
             if( find(tags.begin(),tags.end(),name) == tags.end() ) {
                 return PE_Pass;
             }
@@ -118,6 +120,13 @@ public:
             else if( name == "hardware_id" ) {
                 ss >> _psensor->_pgeom->hardware_id;
             }
+            else if( name == "software_rendering" ) {
+                ss >> _psensor->_softwarerendering;
+                if( !!ss && !_psensor->_IsValidSoftwareRendering(_psensor->_softwarerendering) ) {
+                    RAVELOG_WARN_FORMAT("unknown software_rendering %s, expecting off, depth, or color", _psensor->_softwarerendering);
+                    _psensor->_softwarerendering = "off";
+                }
+            }
             else {
                 RAVELOG_WARN(str(boost::format("bad tag: %s")%name));
             }
@@ -185,6 +194,8 @@ public:
                         "Set the dimensions of the image (width,height)");
         RegisterCommand("SaveImage",boost::bind(&BaseCameraSensor::_SaveImage,this,_1,_2),
                         "Saves the next camera image to the given filename");
+        RegisterCommand("SetSoftwareRendering",boost::bind(&BaseCameraSensor::_SetSoftwareRendering,this,_1,_2),
+                        "Set how images are rendered when there is no viewer: off, depth, or color. Optionally followed by the number of rasterizer threads (0 for all cores).");
         _pgeom.reset(new CameraGeomData());
         _pdata.reset(new CameraSensorData());
         _bPower = false;
@@ -193,6 +204,7 @@ public:
         //_numchannels = 3;
         _bRenderGeometry = true;
         _bRenderData = false;
+        _softwarerendering = "off";
         _Reset();
     }
 
@@ -253,6 +265,7 @@ public:
     virtual void _Reset()
     {
         _pdata->vimagedata.resize(0);
+        _pdata->vdepthdata.resize(0);
         _pdata->__stamp = 0;
         _vimagedata.clear(); // do not resize vector here since it might never be used and it will take up lots of memory!
         _fTimeToImage = 0;
@@ -277,15 +290,33 @@ public:
             if( _fTimeToImage <= 0 ) {
                 _fTimeToImage = 1 / (float)framerate;
                 GetEnv()->UpdatePublishedBodies();
+                bool bRendered = false;
                 if( !!GetEnv()->GetViewer() ) {
                     _vimagedata.resize(3*_pgeom->width*_pgeom->height);
                     if( GetEnv()->GetViewer()->GetCameraImage(_vimagedata, _pgeom->width, _pgeom->height, _trans, _pgeom->KK) ) {
                         // copy the data
                         std::lock_guard<std::mutex> lock(_mutexdata);
                         pdata->vimagedata = _vimagedata;
+                        pdata->vdepthdata.resize(0);
                         pdata->__stamp = GetEnv()->GetSimulationTime();
                         pdata->__trans = _trans;
+                        bRendered = true;
+                    }
+                }
+                if( !bRendered && _softwarerendering != "off" ) {
+                    // no viewer to render with, so rasterize the geometry directly
+                    const bool bColor = _softwarerendering == "color";
+                    _rasterizer.Render(GetEnv(), _trans, _pgeom->KK, _pgeom->width, _pgeom->height, _vdepthdata, bColor ? &_vimagedata : NULL);
+                    std::lock_guard<std::mutex> lock(_mutexdata);
+                    if( bColor ) {
+                        pdata->vimagedata = _vimagedata;
                     }
+                    else {
+                        pdata->vimagedata.resize(0);
+                    }
+                    pdata->vdepthdata = _vdepthdata;
+                    pdata->__stamp = GetEnv()->GetSimulationTime();
+                    pdata->__trans = _trans;
                 }
             }
         }
@@ -314,7 +345,7 @@ public:
     {
         if( _bPower &&( psensordata->GetType() == ST_Camera) ) {
             std::lock_guard<std::mutex> lock(_mutexdata);
-            if( _pdata->vimagedata.size() > 0 ) {
+            if( _pdata->vimagedata.size() > 0 || _pdata->vdepthdata.size() > 0 ) {
                 *boost::dynamic_pointer_cast<CameraSensorData>(psensordata) = *_pdata;
                 return true;
             }
@@ -333,6 +364,7 @@ public:
         if( !_bPower ) {
             // should reset!
             _pdata->vimagedata.resize(0);
+            _pdata->vdepthdata.resize(0);
             _pdata->__stamp = 0;
         }
         return !!sinput;
@@ -357,6 +389,20 @@ public:
         }
         return false;
     }
+    bool _SetSoftwareRendering(ostream& sout, istream& sinput)
+    {
+        std::string softwarerendering;
+        sinput >> softwarerendering;
+        if( !sinput || !_IsValidSoftwareRendering(softwarerendering) ) {
+            return false;
+        }
+        _softwarerendering = softwarerendering;
+        int numthreads = 0;
+        if( sinput >> numthreads ) {
+            _rasterizer.SetNumThreads(numthreads);
+        }
+        return true;
+    }
     bool _SaveImage(ostream& sout, istream& sinput)
     {
         RAVELOG_WARN("SaveImage not implemented yet\n");
@@ -384,6 +430,7 @@ public:
         _bRenderGeometry = r->_bRenderGeometry;
         _bRenderData = r->_bRenderData;
         _bPower = r->_bPower;
+        _softwarerendering = r->_softwarerendering;
         _Reset();
     }
 
@@ -395,9 +442,15 @@ public:
         ss << _vColor.x << " " << _vColor.y << " " << _vColor.z;
         writer->AddChild("color",atts)->SetCharData(ss.str());
         writer->AddChild("format",atts)->SetCharData(_channelformat.size() > 0 ? _channelformat : std::string("uint8"));
+        writer->AddChild("software_rendering",atts)->SetCharData(_softwarerendering);
     }
 
 protected:
+    static bool _IsValidSoftwareRendering(const std::string& softwarerendering)
+    {
+        return softwarerendering == "off" || softwarerendering == "depth" || softwarerendering == "color";
+    }
+
     void _RenderGeometry()
     {
         if( !_bRenderGeometry ) {
@@ -446,6 +499,7 @@ protected:
 
     // more geom stuff
     vector<uint8_t> _vimagedata;
+    vector<float> _vdepthdata;
     RaveVector<float> _vColor;
 
     Transform _trans;
@@ -455,6 +509,8 @@ protected:
     GraphHandlePtr _graphgeometry;
     ViewerBasePtr _dataviewer;
     string _channelformat;
+    string _softwarerendering; ///< what to render on the cpu when there is no viewer image: off, depth, or color (depth and rgb)
+    CameraRasterizer _rasterizer;
 
     mutable std::mutex _mutexdata;
 
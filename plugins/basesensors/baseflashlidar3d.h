@@ -16,6 +16,8 @@
 #ifndef OPENRAVE_BASEFLASHLIDAR_H
 #define OPENRAVE_BASEFLASHLIDAR_H
 
+#include "lidarscanner.h"
+
 /// Flash LIDAR - sends laser points given a camera projection matrix
 class BaseFlashLidar3DSensor : public SensorBase
 {
@@ -34,7 +36,7 @@ public:
                 }
                 return PE_Ignore;
             }
-            static boost::array<string, 18> tags = { { "sensor", "minangle", "min_angle", "maxangle", "max_angle", "maxrange", "max_range", "minrange", "min_range", "scantime", "color", "time_scan", "time_increment", "power", "kk", "width", "height"}};
+            static boost::array<string, 19> tags = { { "sensor", "minangle", "min_angle", "maxangle", "max_angle", "maxrange", "max_range", "minrange", "min_range", "scantime", "color", "time_scan", "time_increment", "power", "kk", "width", "height", "scan_threads", "async_scan"}};
             if( find(tags.begin(),tags.end(),name) == tags.end() ) {
                 return PE_Pass;
             }
@@ -88,6 +90,16 @@ public:
             else if( name == "height" ) {
                 ss >> _psensor->_pgeom->height;
             }
+            else if( name == "scan_threads" ) {
+                int numthreads = 1;
+                ss >> numthreads;
+                _psensor->_scanner.SetNumThreads(numthreads);
+            }
+            else if( name == "async_scan" ) {
+                bool bAsync = false;
+                ss >> bAsync;
+                _psensor->_scanner.SetAsync(bAsync);
+            }
             else {
                 RAVELOG_WARN(str(boost::format("bad tag: %s")%name));
             }
@@ -160,10 +172,11 @@ public:
                         "Set rendering of the plots (1 or 0).");
         RegisterCommand("collidingbodies",boost::bind(&BaseFlashLidar3DSensor::_CollidingBodies,this,_1,_2),
                         "Returns the ids of the bodies that the laser beams have hit.");
+        RegisterCommand("scanthreads",boost::bind(&BaseFlashLidar3DSensor::_ScanThreads,this,_1,_2),
+                        "Set the number of threads casting the beams of a scan, optionally followed by whether scans run in the background while the simulation advances (1 or 0).");
 
         _pgeom.reset(new BaseFlashLidar3DGeom());
         _pdata.reset(new LaserSensorData());
-        _report.reset(new CollisionReport());
 
         _bRenderData = false;
         _bRenderGeometry = true;
@@ -174,6 +187,7 @@ public:
         _pgeom->KK.fx = 500; _pgeom->KK.fy = 500; _pgeom->KK.cx = 250; _pgeom->KK.cy = 250;
         _pgeom->width = 64; _pgeom->height = 64;
         _fTimeToScan = 0;
+        _scanstamp = 0;
         _vColor = RaveVector<float>(0.5f,0.5f,1,1);
         _Reset();
     }
@@ -222,24 +236,18 @@ public:
     {
         _RenderGeometry();
         _fTimeToScan -= fTimeElapsed;
-        if(( _fTimeToScan <= 0) && _bPower ) {
-            _fTimeToScan = _pgeom->time_scan;
-
-            RAY r;
-
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(CO_Distance);
-            Transform t;
-
-            {
-                // Lock the data mutex and fill with the range data (get all in one timestep)
-                std::lock_guard<std::mutex> lock(_mutexdata);
-                t = GetTransform();
-                _pdata->__trans = t;
-                _pdata->__stamp = GetEnv()->GetSimulationTime();
-
+        if( _bPower ) {
+            // an asynchronous scan started in an earlier step might have finished
+            _PublishScan();
+            if( _fTimeToScan <= 0 && !_scanner.IsScanning() ) {
+                _fTimeToScan = _pgeom->time_scan;
+
+                RAY r;
+                _tscan = GetTransform();
+                _scanstamp = GetEnv()->GetSimulationTime();
+                const Transform& t = _tscan;
                 r.pos = t.trans;
-                _pdata->positions.at(0) = t.trans;
-
+                _vscanrays.resize(_pgeom->width*_pgeom->height);
                 for(int w = 0; w < _pgeom->width; ++w) {
                     for(int h = 0; h < _pgeom->height; ++h) {
                         Vector vdir;
@@ -248,72 +256,12 @@ public:
                         vdir.z = 1.0f;
                         vdir = t.rotate(vdir.normalize3());
                         r.dir = _pgeom->max_range*vdir;
-
-                        int index = w*_pgeom->height+h;
-
-                        if( GetEnv()->CheckCollision(r, _report)) {
-                            _pdata->ranges[index] = vdir*_report->minDistance;
-                            _pdata->intensity[index] = 1;
-                            // store the colliding bodies
-                            KinBody::LinkConstPtr plink = !!_report->plink1 ? _report->plink1 : _report->plink2;
-                            if( !!plink ) {
-                                _databodyids[index] = plink->GetParent()->GetEnvironmentBodyIndex();
-                            }
-                        }
-                        else {
-                            _databodyids[index] = 0;
-                            _pdata->ranges[index] = vdir*_pgeom->max_range;
-                            _pdata->intensity[index] = 0;
-                        }
-                    }
-                }
-
-                _report->Reset();
-            }
-
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(0);
-
-            if( _bRenderData ) {
-                // If can render, check if some time passed before last update
-                list<GraphHandlePtr> listhandles;
-                int N = 0;
-                vector<RaveVector<float> > vpoints;
-                vector<int> vindices;
-
-                {
-                    // Lock the data mutex and fill the arrays used for rendering
-                    std::lock_guard<std::mutex> lock(_mutexdata);
-                    N = (int)_pdata->ranges.size();
-                    vpoints.resize(N+1);
-                    for(int i = 0; i < N; ++i)
-                        vpoints[i] = _pdata->ranges[i] + t.trans;
-                    vpoints[N] = t.trans;
-                }
-
-                // render the transparent fan for every column
-                vindices.resize(3*(_pgeom->height-1)*_pgeom->width);
-                int index = 0;
-                for(int w = 0; w < _pgeom->width; ++w) {
-                    for(int i = 0; i < _pgeom->height-1; ++i) {
-                        vindices[index++] = w*_pgeom->height+i;
-                        vindices[index++] = w*_pgeom->height+i+1;
-                        vindices[index++] = N;
+                        _vscanrays[w*_pgeom->height+h] = r;
                     }
                 }
-
-                _vColor.w = 1;
-                // Render points at each measurement, and a triangle fan for the entire free surface of the laser
-                listhandles.push_back(GetEnv()->plot3(&vpoints[0].x, N, sizeof(vpoints[0]), 5.0f, _vColor));
-
-                _vColor.w = 0.01f;
-                listhandles.push_back(GetEnv()->drawtrimesh(&vpoints[0].x, sizeof(vpoints[0]), &vindices[0], vindices.size()/3, _vColor));
-
-                _listGraphicsHandles.swap(listhandles);
-
-            }
-            else {
-                // destroy graphs
-                _listGraphicsHandles.clear();
+                _scanner.StartScan(GetEnv(), _vscanrays);
+                // synchronous scans are already done
+                _PublishScan();
             }
         }
 
@@ -357,6 +305,20 @@ public:
         sinput >> _bRenderData;
         return !!sinput;
     }
+    bool _ScanThreads(ostream& sout, istream& sinput)
+    {
+        int numthreads = 1;
+        sinput >> numthreads;
+        if( !sinput ) {
+            return false;
+        }
+        _scanner.SetNumThreads(numthreads);
+        bool bAsync = false;
+        if( sinput >> bAsync ) {
+            _scanner.SetAsync(bAsync);
+        }
+        return true;
+    }
     bool _CollidingBodies(ostream& sout, istream& sinput)
     {
         std::lock_guard<std::mutex> lock(_mutexdata);
@@ -387,12 +349,15 @@ public:
         _bRenderGeometry = r->_bRenderGeometry;
         _bRenderData = r->_bRenderData;
         _bPower = r->_bPower;
+        _scanner.SetNumThreads(r->_scanner.GetNumThreads());
+        _scanner.SetAsync(r->_scanner.IsAsync());
         _Reset();
     }
 
 protected:
     virtual void _Reset()
     {
+        _scanner.Cancel();
         _iKK[0] = 1.0f / _pgeom->KK.fx;
         _iKK[1] = 1.0f / _pgeom->KK.fy;
         _iKK[2] = -_pgeom->KK.cx / _pgeom->KK.fx;
@@ -410,6 +375,85 @@ protected:
         }
     }
 
+    /// \brief copies the results of a finished scan into the sensor data and renders them
+    void _PublishScan()
+    {
+        if( !_scanner.GetScanResults(_vscanrays, _vscandistances, _vscanbodyids) ) {
+            return;
+        }
+        const Transform& t = _tscan;
+        {
+            std::lock_guard<std::mutex> lock(_mutexdata);
+            if( _vscanrays.size() != _pdata->ranges.size() ) {
+                // geometry changed while scanning
+                return;
+            }
+            _pdata->__trans = t;
+            _pdata->__stamp = _scanstamp;
+            _pdata->positions.at(0) = t.trans;
+            for(size_t index = 0; index < _vscanrays.size(); ++index) {
+                Vector vdir = _vscanrays[index].dir;
+                vdir.normalize3();
+                if( _vscandistances[index] >= 0 ) {
+                    _pdata->ranges[index] = vdir*_vscandistances[index];
+                    _pdata->intensity[index] = 1;
+                    // store the colliding bodies
+                    if( _vscanbodyids[index] != 0 ) {
+                        _databodyids[index] = _vscanbodyids[index];
+                    }
+                }
+                else {
+                    _databodyids[index] = 0;
+                    _pdata->ranges[index] = vdir*_pgeom->max_range;
+                    _pdata->intensity[index] = 0;
+                }
+            }
+        }
+
+        if( _bRenderData ) {
+            // If can render, check if some time passed before last update
+            list<GraphHandlePtr> listhandles;
+            int N = 0;
+            vector<RaveVector<float> > vpoints;
+            vector<int> vindices;
+
+            {
+                // Lock the data mutex and fill the arrays used for rendering
+                std::lock_guard<std::mutex> lock(_mutexdata);
+                N = (int)_pdata->ranges.size();
+                vpoints.resize(N+1);
+                for(int i = 0; i < N; ++i)
+                    vpoints[i] = _pdata->ranges[i] + t.trans;
+                vpoints[N] = t.trans;
+            }
+
+            // render the transparent fan for every column
+            vindices.resize(3*(_pgeom->height-1)*_pgeom->width);
+            int index = 0;
+            for(int w = 0; w < _pgeom->width; ++w) {
+                for(int i = 0; i < _pgeom->height-1; ++i) {
+                    vindices[index++] = w*_pgeom->height+i;
+                    vindices[index++] = w*_pgeom->height+i+1;
+                    vindices[index++] = N;
+                }
+            }
+
+            _vColor.w = 1;
+            // Render points at each measurement, and a triangle fan for the entire free surface of the laser
+            listhandles.push_back(GetEnv()->plot3(&vpoints[0].x, N, sizeof(vpoints[0]), 5.0f, _vColor));
+
+            _vColor.w = 0.01f;
+            listhandles.push_back(GetEnv()->drawtrimesh(&vpoints[0].x, sizeof(vpoints[0]), &vindices[0], vindices.size()/3, _vColor));
+
+            _listGraphicsHandles.swap(listhandles);
+
+        }
+        else {
+            // destroy graphs
+            _listGraphicsHandles.clear();
+        }
+    }
+
     void _RenderGeometry()
     {
         if( !_bRenderGeometry ) {
@@ -445,7 +489,13 @@ protected:
     boost::shared_ptr<BaseFlashLidar3DGeom> _pgeom;
     boost::shared_ptr<LaserSensorData> _pdata;
     vector<int> _databodyids;     ///< if non 0, for each point in _data, specifies the body that was hit
-    CollisionReportPtr _report;
+
+    LidarScanner _scanner;
+    vector<RAY> _vscanrays;
+    vector<dReal> _vscandistances;
+    vector<int> _vscanbodyids;
+    Transform _tscan; ///< sensor transform when the last scan started
+    uint64_t _scanstamp; ///< simulation time when the last scan started
     // more geom stuff
     RaveVector<float> _vColor;
     dReal _iKK[4];     // inverse of KK
@@ -16,6 +16,8 @@
 #ifndef OPENRAVE_BASELASER_H
 #define OPENRAVE_BASELASER_H
 
+#include "lidarscanner.h"
+
 /// Laser rotates around the zaxis and it's 0 angle is pointed toward the xaxis.
 class BaseLaser2DSensor : public SensorBase
 {
@@ -33,7 +35,7 @@ public:
                     return PE_Support;
                 return PE_Ignore;
             }
-            static boost::array<string, 16> tags = { { "sensor", "minangle", "min_angle", "maxangle", "max_angle", "maxrange", "max_range", "minrange", "min_range", "scantime", "color", "time_scan", "time_increment", "power","resolution"}};
+            static boost::array<string, 17> tags = { { "sensor", "minangle", "min_angle", "maxangle", "max_angle", "maxrange", "max_range", "minrange", "min_range", "scantime", "color", "time_scan", "time_increment", "power","resolution", "scan_threads", "async_scan"}};
             if( find(tags.begin(),tags.end(),name) == tags.end() ) {
                 return PE_Pass;
             }
@@ -92,6 +94,16 @@ public:
                     ss.clear();
                 }
             }
+            else if( name == "scan_threads" ) {
+                int numthreads = 1;
+                ss >> numthreads;
+                _psensor->_scanner.SetNumThreads(numthreads);
+            }
+            else if( name == "async_scan" ) {
+                bool bAsync = false;
+                ss >> bAsync;
+                _psensor->_scanner.SetAsync(bAsync);
+            }
             else {
                 RAVELOG_WARN(str(boost::format("bad tag: %s")%name));
             }
@@ -133,6 +145,8 @@ public:
                         "Set rendering of the plots (1 or 0).");
         RegisterCommand("collidingbodies",boost::bind(&BaseLaser2DSensor::_CollidingBodies,this,_1,_2),
                         "Returns the ids of the bodies that the laser beams have hit. The order is the same as the returned laser points.");
+        RegisterCommand("scanthreads",boost::bind(&BaseLaser2DSensor::_ScanThreads,this,_1,_2),
+                        "Set the number of threads casting the beams of a scan, optionally followed by whether scans run in the background while the simulation advances (1 or 0).");
         //        RegisterCommand("GatherData",boost::bind(&BaseLaser2DSensor::_CollidingBodies,this,_1,_2),
         //                        "Controls whether to gather all laser data, or delete the old one after every new scan.");
         _pgeom.reset(new LaserGeomData());
@@ -143,8 +157,8 @@ public:
         _pgeom->min_range = 0.03;
         _pgeom->max_range = 100;
         _fTimeToScan = 0;
+        _scanstamp = 0;
         _vColor = RaveVector<float>(0.5f,0.5f,1,1);
-        _report.reset(new CollisionReport());
         _bPower = false;
         _bRenderData = false;
         _bRenderGeometry = true;
@@ -195,92 +209,31 @@ public:
     {
         _RenderGeometry();
         _fTimeToScan -= fTimeElapsed;
-        if( _bPower &&( _fTimeToScan <= 0) ) {
-            _fTimeToScan = _pgeom->time_scan;
-            Vector rotaxis(0,0,1);
-            RAY r;
-
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(CO_Distance);
-            Transform t;
-
-            {
-                // Lock the data mutex and fill with the range data (get all in one timestep)
-                std::lock_guard<std::mutex> lock(_mutexdata);
-                _pdata->__trans = GetTransform();
-                _pdata->__stamp = GetEnv()->GetSimulationTime();
-                t = GetLaserPlaneTransform();
-                _pdata->positions.at(0) = t.trans;
-                size_t index = 0;
-                for(dReal frotangle = _pgeom->min_angle[0]; frotangle <= _pgeom->max_angle[0]; frotangle += _pgeom->resolution[0], ++index) {
-                    if( index >= _pdata->ranges.size() ) {
+        if( _bPower ) {
+            // an asynchronous scan started in an earlier step might have finished
+            _PublishScan();
+            if( _fTimeToScan <= 0 && !_scanner.IsScanning() ) {
+                _fTimeToScan = _pgeom->time_scan;
+                Vector rotaxis(0,0,1);
+                RAY r;
+                _tscan = GetTransform();
+                _tscanlaserplane = GetLaserPlaneTransform();
+                _scanstamp = GetEnv()->GetSimulationTime();
+                const Transform& t = _tscanlaserplane;
+                _vscanrays.resize(0);
+                for(dReal frotangle = _pgeom->min_angle[0]; frotangle <= _pgeom->max_angle[0]; frotangle += _pgeom->resolution[0]) {
+                    if( _vscanrays.size() >= _databodyids.size() ) {
                         break;
                     }
                     Vector vdir(t.rotate(quatRotate(quatFromAxisAngle(rotaxis, (dReal)frotangle),Vector(1,0,0))));
                     r.pos = t.trans+_pgeom->min_range*vdir;
                     r.dir = (_pgeom->max_range-_pgeom->min_range)*vdir;
-
-                    if( GetEnv()->CheckCollision(r, _report)) {
-                        _pdata->ranges[index] = vdir*(_report->minDistance+_pgeom->min_range);
-                        _pdata->intensity[index] = 1;
-                        // store the colliding bodies
-                        KinBody::LinkConstPtr plink = !!_report->plink1 ? _report->plink1 : _report->plink2;
-                        if( !!plink ) {
-                            _databodyids[index] = plink->GetParent()->GetEnvironmentBodyIndex();
-                        }
-                    }
-                    else {
-                        _databodyids[index] = 0;
-                        _pdata->ranges[index] = vdir*_pgeom->max_range;
-                        _pdata->intensity[index] = 0;
-                    }
-                }
-            }
-
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(0);
-
-            if( _bRenderData ) {
-                // If can render, check if some time passed before last update
-                list<GraphHandlePtr> listhandles;
-                int N = 0;
-                vector<RaveVector<float> > vpoints;
-                vector<int> vindices;
-
-                {
-                    // Lock the data mutex and fill the arrays used for rendering
-                    std::lock_guard<std::mutex> lock(_mutexdata);
-                    N = (int)_pdata->ranges.size();
-                    vpoints.resize(N+1);
-                    for(int i = 0; i < N; ++i) {
-                        vpoints[i] = _pdata->ranges[i] + t.trans;
-                    }
-                    vpoints[N] = t.trans;
-                }
-
-                // render the transparent fan
-                vindices.resize(3*(N-1));
-
-                for(int i = 0; i < N-1; ++i) {
-                    vindices[3*i+0] = i;
-                    vindices[3*i+1] = i+1;
-                    vindices[3*i+2] = N;
+                    _vscanrays.push_back(r);
                 }
-
-                _vColor.w = 1;
-                // Render points at each measurement, and a triangle fan for the entire free surface of the laser
-                listhandles.push_back(GetEnv()->plot3(&vpoints[0].x, N, sizeof(vpoints[0]), 5.0f, _vColor));
-
-                _vColor.w = 0.2f;
-                listhandles.push_back(GetEnv()->drawtrimesh(&vpoints[0].x, sizeof(vpoints[0]), &vindices[0], N-1, _vColor));
-
-                // close the old graphs last to avoid flickering
-                _listGraphicsHandles.swap(listhandles);
-
-            }
-            else {
-                _listGraphicsHandles.clear();
+                _scanner.StartScan(GetEnv(), _vscanrays);
+                // synchronous scans are already done
+                _PublishScan();
             }
-
-            _report->Reset();
         }
 
         return true;
@@ -323,6 +276,20 @@ public:
         sinput >> _bRenderData;
         return !!sinput;
     }
+    bool _ScanThreads(ostream& sout, istream& sinput)
+    {
+        int numthreads = 1;
+        sinput >> numthreads;
+        if( !sinput ) {
+            return false;
+        }
+        _scanner.SetNumThreads(numthreads);
+        bool bAsync = false;
+        if( sinput >> bAsync ) {
+            _scanner.SetAsync(bAsync);
+        }
+        return true;
+    }
     bool _CollidingBodies(ostream& sout, istream& sinput)
     {
         std::lock_guard<std::mutex> lock(_mutexdata);
@@ -352,6 +319,8 @@ public:
         _bRenderGeometry = r->_bRenderGeometry;
         _bRenderData = r->_bRenderData;
         _bPower = r->_bPower;
+        _scanner.SetNumThreads(r->_scanner.GetNumThreads());
+        _scanner.SetAsync(r->_scanner.IsAsync());
         _Reset();
     }
 
@@ -369,6 +338,7 @@ protected:
 
     virtual void _Reset()
     {
+        _scanner.Cancel();
         std::lock_guard<std::mutex> lock(_mutexdata);
         int N;
         if( _pgeom->resolution[0] > 0 ) {
@@ -393,6 +363,84 @@ protected:
         _RenderGeometry();
     }
 
+    /// \brief copies the results of a finished scan into the sensor data and renders them
+    void _PublishScan()
+    {
+        if( !_scanner.GetScanResults(_vscanrays, _vscandistances, _vscanbodyids) ) {
+            return;
+        }
+        const Transform& t = _tscanlaserplane;
+        {
+            std::lock_guard<std::mutex> lock(_mutexdata);
+            if( _vscanrays.size() > _pdata->ranges.size() ) {
+                // geometry changed while scanning
+                return;
+            }
+            _pdata->__trans = _tscan;
+            _pdata->__stamp = _scanstamp;
+            _pdata->positions.at(0) = t.trans;
+            for(size_t index = 0; index < _vscanrays.size(); ++index) {
+                Vector vdir = _vscanrays[index].dir;
+                vdir.normalize3();
+                if( _vscandistances[index] >= 0 ) {
+                    _pdata->ranges[index] = vdir*(_vscandistances[index]+_pgeom->min_range);
+                    _pdata->intensity[index] = 1;
+                    // store the colliding bodies
+                    if( _vscanbodyids[index] != 0 ) {
+                        _databodyids[index] = _vscanbodyids[index];
+                    }
+                }
+                else {
+                    _databodyids[index] = 0;
+                    _pdata->ranges[index] = vdir*_pgeom->max_range;
+                    _pdata->intensity[index] = 0;
+                }
+            }
+        }
+
+        if( _bRenderData ) {
+            // If can render, check if some time passed before last update
+            list<GraphHandlePtr> listhandles;
+            int N = 0;
+            vector<RaveVector<float> > vpoints;
+            vector<int> vindices;
+
+            {
+                // Lock the data mutex and fill the arrays used for rendering
+                std::lock_guard<std::mutex> lock(_mutexdata);
+                N = (int)_pdata->ranges.size();
+                vpoints.resize(N+1);
+                for(int i = 0; i < N; ++i) {
+                    vpoints[i] = _pdata->ranges[i] + t.trans;
+                }
+                vpoints[N] = t.trans;
+            }
+
+            // render the transparent fan
+            vindices.resize(3*(N-1));
+
+            for(int i = 0; i < N-1; ++i) {
+                vindices[3*i+0] = i;
+                vindices[3*i+1] = i+1;
+                vindices[3*i+2] = N;
+            }
+
+            _vColor.w = 1;
+            // Render points at each measurement, and a triangle fan for the entire free surface of the laser
+            listhandles.push_back(GetEnv()->plot3(&vpoints[0].x, N, sizeof(vpoints[0]), 5.0f, _vColor));
+
+            _vColor.w = 0.2f;
+            listhandles.push_back(GetEnv()->drawtrimesh(&vpoints[0].x, sizeof(vpoints[0]), &vindices[0], N-1, _vColor));
+
+            // close the old graphs last to avoid flickering
+            _listGraphicsHandles.swap(listhandles);
+
+        }
+        else {
+            _listGraphicsHandles.clear();
+        }
+    }
+
     void _RenderGeometry()
     {
         if( !_bRenderGeometry ) {
@@ -431,7 +479,13 @@ protected:
     boost::shared_ptr<LaserGeomData> _pgeom;
     boost::shared_ptr<LaserSensorData> _pdata;
     vector<int> _databodyids;     ///< if non 0, for each point in _data, specifies the body that was hit
-    CollisionReportPtr _report;
+
+    LidarScanner _scanner;
+    vector<RAY> _vscanrays;
+    vector<dReal> _vscandistances;
+    vector<int> _vscanbodyids;
+    Transform _tscan, _tscanlaserplane; ///< sensor and laser plane transforms when the last scan started
+    uint64_t _scanstamp; ///< simulation time when the last scan started
 
     // more geom stuff
     RaveVector<float> _vColor;
@@ -0,0 +1,299 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 OpenRAVE
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef OPENRAVE_CAMERARASTERIZER_H
+#define OPENRAVE_CAMERARASTERIZER_H
+
+#include <atomic>
+#include <thread>
+
+/// \brief Renders depth and flat-shaded color images of the visible link geometries on the CPU, so that cameras produce
+/// data without a viewer.
+///
+/// Triangles are transformed into the camera frame (z along the optical axis), clipped against the near plane, projected
+/// with the pinhole intrinsics and binned into square tiles. The tiles are rasterized in parallel with edge functions
+/// evaluated a row at a time so that the inner loop vectorizes. Each pixel keeps the inverse depth and the index of the
+/// closest triangle; colors are only resolved once all tiles are done. Lens distortion is ignored.
+class CameraRasterizer
+{
+public:
+    CameraRasterizer() : _numthreads(std::max(1u, std::thread::hardware_concurrency())), _fnear(0.01f)
+    {
+    }
+
+    /// \brief set the maximum number of threads used to rasterize tiles. 0 uses all hardware threads.
+    void SetNumThreads(int numthreads)
+    {
+        _numthreads = numthreads > 0 ? numthreads : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /// \brief render the environment as seen from tcamera.
+    ///
+    /// Has to be called with the environment locked.
+    /// \param vdepthdata filled with width*height distances along the optical axis in meters, 0 where nothing is visible
+    /// \param pvimagedata if not NULL, filled with width*height*3 rgb values
+    void Render(EnvironmentBasePtr penv, const Transform& tcamera, const SensorBase::CameraIntrinsics& KK, int width, int height, std::vector<float>& vdepthdata, std::vector<uint8_t>* pvimagedata)
+    {
+        _width = width;
+        _height = height;
+        _fx = KK.fx; _fy = KK.fy; _cx = KK.cx; _cy = KK.cy;
+        _CollectTriangles(penv, tcamera.inverse());
+        _BinTriangles();
+
+        const size_t numpixels = (size_t)width*(size_t)height;
+        _vinvdepth.resize(numpixels);
+        _vtriangleindices.resize(numpixels);
+        std::fill(_vinvdepth.begin(), _vinvdepth.end(), 0.0f);
+
+        std::atomic<int> nexttile(0);
+        const int numtiles = (int)_vtilebins.size();
+        const int numthreads = std::max(1, std::min(_numthreads, numtiles));
+        std::vector<std::thread> vthreads;
+        vthreads.reserve(numthreads - 1);
+        for(int ithread = 1; ithread < numthreads; ++ithread) {
+            vthreads.emplace_back(&CameraRasterizer::_RasterizeTiles, this, std::ref(nexttile));
+        }
+        _RasterizeTiles(nexttile);
+        FOREACH(itthread, vthreads) {
+            itthread->join();
+        }
+
+        vdepthdata.resize(numpixels);
+        for(size_t ipixel = 0; ipixel < numpixels; ++ipixel) {
+            vdepthdata[ipixel] = _vinvdepth[ipixel] > 0 ? 1.0f/_vinvdepth[ipixel] : 0.0f;
+        }
+        if( !!pvimagedata ) {
+            pvimagedata->resize(3*numpixels);
+            uint8_t* pcolor = pvimagedata->data();
+            for(size_t ipixel = 0; ipixel < numpixels; ++ipixel, pcolor += 3) {
+                if( _vinvdepth[ipixel] > 0 ) {
+                    const ScreenTriangle& tri = _vtriangles[_vtriangleindices[ipixel]];
+                    pcolor[0] = tri.color[0]; pcolor[1] = tri.color[1]; pcolor[2] = tri.color[2];
+                }
+                else {
+                    pcolor[0] = pcolor[1] = pcolor[2] = 0;
+                }
+            }
+        }
+    }
+
+private:
+    static const int s_tilesize = 32;
+
+    struct ScreenTriangle
+    {
+        float x[3], y[3];   ///< pixel coordinates of the vertices
+        float invz[3];      ///< inverse depth of the vertices, interpolated linearly in screen space
+        uint8_t color[3];
+    };
+
+    void _CollectTriangles(EnvironmentBasePtr penv, const Transform& tinvcamera)
+    {
+        _vtriangles.resize(0);
+        penv->GetBodies(_vbodies);
+        FOREACHC(itbody, _vbodies) {
+            if( !(*itbody)->IsVisible() ) {
+                continue;
+            }
+            FOREACHC(itlink, (*itbody)->GetLinks()) {
+                if( !(*itlink)->IsVisible() ) {
+                    continue;
+                }
+                const Transform tlink = tinvcamera*(*itlink)->GetTransform();
+                FOREACHC(itgeom, (*itlink)->GetGeometries()) {
+                    const KinBody::Link::Geometry& geom = **itgeom;
+                    if( !geom.IsVisible() || geom.GetTransparency() >= 1 ) {
+                        continue;
+                    }
+                    const TriMesh& mesh = geom.GetCollisionMesh();
+                    if( mesh.indices.size() < 3 ) {
+                        continue;
+                    }
+                    const Transform tgeom = tlink*geom.GetTransform();
+                    _vcamerapoints.resize(mesh.vertices.size());
+                    for(size_t ivertex = 0; ivertex < mesh.vertices.size(); ++ivertex) {
+                        _vcamerapoints[ivertex] = tgeom*mesh.vertices[ivertex];
+                    }
+                    const RaveVector<float>& vcolor = geom.GetDiffuseColor();
+                    for(size_t iindex = 0; iindex+2 < mesh.indices.size(); iindex += 3) {
+                        _AddTriangle(_vcamerapoints[mesh.indices[iindex]], _vcamerapoints[mesh.indices[iindex+1]], _vcamerapoints[mesh.indices[iindex+2]], vcolor);
+                    }
+                }
+            }
+        }
+        _vbodies.clear(); // do not hold on to the bodies
+    }
+
+    /// \brief clip the camera frame triangle against the near plane and project what remains
+    void _AddTriangle(const Vector& p0, const Vector& p1, const Vector& p2, const RaveVector<float>& vcolor)
+    {
+        if( p0.z < _fnear && p1.z < _fnear && p2.z < _fnear ) {
+            return;
+        }
+
+        // flat shading with a headlight
+        uint8_t color[3];
+        {
+            Vector vnormal = (p1-p0).cross(p2-p0);
+            Vector vcenter = p0+p1+p2;
+            const dReal fnormalizer = RaveSqrt(vnormal.lengthsqr3()*vcenter.lengthsqr3());
+            const dReal fshade = 0.25 + 0.75*(fnormalizer > 0 ? RaveFabs(vnormal.dot3(vcenter))/fnormalizer : 0);
+            color[0] = (uint8_t)std::min(255.0, 255*fshade*vcolor.x);
+            color[1] = (uint8_t)std::min(255.0, 255*fshade*vcolor.y);
+            color[2] = (uint8_t)std::min(255.0, 255*fshade*vcolor.z);
+        }
+
+        if( p0.z >= _fnear && p1.z >= _fnear && p2.z >= _fnear ) {
+            _AddProjectedTriangle(p0, p1, p2, color);
+            return;
+        }
+
+        // Sutherland-Hodgman against z = _fnear leaves at most 4 vertices
+        const Vector* pin[3] = { &p0, &p1, &p2 };
+        Vector vclipped[4];
+        int numclipped = 0;
+        for(int i = 0; i < 3; ++i) {
+            const Vector& a = *pin[i];
+            const Vector& b = *pin[(i+1)%3];
+            if( a.z >= _fnear ) {
+                vclipped[numclipped++] = a;
+            }
+            if( (a.z >= _fnear) != (b.z >= _fnear) ) {
+                const dReal s = (_fnear - a.z)/(b.z - a.z);
+                vclipped[numclipped++] = a + (b - a)*s;
+            }
+        }
+        for(int i = 1; i+1 < numclipped; ++i) {
+            _AddProjectedTriangle(vclipped[0], vclipped[i], vclipped[i+1], color);
+        }
+    }
+
+    void _AddProjectedTriangle(const Vector& p0, const Vector& p1, const Vector& p2, const uint8_t color[3])
+    {
+        ScreenTriangle tri;
+        const Vector* pv[3] = { &p0, &p1, &p2 };
+        for(int i = 0; i < 3; ++i) {
+            const dReal invz = 1/pv[i]->z;
+            tri.x[i] = (float)(_fx*pv[i]->x*invz + _cx);
+            tri.y[i] = (float)(_fy*pv[i]->y*invz + _cy);
+            tri.invz[i] = (float)invz;
+        }
+        const float minx = std::min(tri.x[0], std::min(tri.x[1], tri.x[2])), maxx = std::max(tri.x[0], std::max(tri.x[1], tri.x[2]));
+        const float miny = std::min(tri.y[0], std::min(tri.y[1], tri.y[2])), maxy = std::max(tri.y[0], std::max(tri.y[1], tri.y[2]));
+        if( maxx < 0 || maxy < 0 || minx >= _width || miny >= _height ) {
+            return;
+        }
+        tri.color[0] = color[0]; tri.color[1] = color[1]; tri.color[2] = color[2];
+        _vtriangles.push_back(tri);
+    }
+
+    void _BinTriangles()
+    {
+        _numtilesx = (_width + s_tilesize - 1)/s_tilesize;
+        const int numtilesy = (_height + s_tilesize - 1)/s_tilesize;
+        _vtilebins.resize(_numtilesx*numtilesy);
+        FOREACH(itbin, _vtilebins) {
+            itbin->resize(0); // keep the capacity
+        }
+        for(uint32_t itri = 0; itri < (uint32_t)_vtriangles.size(); ++itri) {
+            const ScreenTriangle& tri = _vtriangles[itri];
+            const int minx = std::max(0, (int)std::floor(std::min(tri.x[0], std::min(tri.x[1], tri.x[2]))));
+            const int maxx = std::min(_width - 1, (int)std::ceil(std::max(tri.x[0], std::max(tri.x[1], tri.x[2]))));
+            const int miny = std::max(0, (int)std::floor(std::min(tri.y[0], std::min(tri.y[1], tri.y[2]))));
+            const int maxy = std::min(_height - 1, (int)std::ceil(std::max(tri.y[0], std::max(tri.y[1], tri.y[2]))));
+            for(int tiley = miny/s_tilesize; tiley <= maxy/s_tilesize; ++tiley) {
+                for(int tilex = minx/s_tilesize; tilex <= maxx/s_tilesize; ++tilex) {
+                    _vtilebins[tiley*_numtilesx + tilex].push_back(itri);
+                }
+            }
+        }
+    }
+
+    /// \brief worker loop, takes tiles until there are none left
+    void _RasterizeTiles(std::atomic<int>& nexttile)
+    {
+        for(int itile = nexttile++; itile < (int)_vtilebins.size(); itile = nexttile++) {
+            const int tilex0 = (itile % _numtilesx)*s_tilesize, tiley0 = (itile / _numtilesx)*s_tilesize;
+            const int tilex1 = std::min(tilex0 + s_tilesize, _width) - 1, tiley1 = std::min(tiley0 + s_tilesize, _height) - 1;
+            FOREACHC(ittri, _vtilebins[itile]) {
+                _RasterizeTriangle(*ittri, tilex0, tiley0, tilex1, tiley1);
+            }
+        }
+    }
+
+    void _RasterizeTriangle(uint32_t itri, int tilex0, int tiley0, int tilex1, int tiley1)
+    {
+        const ScreenTriangle& tri = _vtriangles[itri];
+        int i1 = 1, i2 = 2;
+        float area = (tri.x[1] - tri.x[0])*(tri.y[2] - tri.y[0]) - (tri.y[1] - tri.y[0])*(tri.x[2] - tri.x[0]);
+        if( area < 0 ) {
+            // both windings are rendered, so make the edge functions positive inside
+            std::swap(i1, i2);
+            area = -area;
+        }
+        if( area <= 1e-12f ) {
+            return;
+        }
+        const float x0 = tri.x[0], y0 = tri.y[0], x1 = tri.x[i1], y1 = tri.y[i1], x2 = tri.x[i2], y2 = tri.y[i2];
+        const float iz0 = tri.invz[0], iz1 = tri.invz[i1], iz2 = tri.invz[i2];
+
+        const int minx = std::max(tilex0, (int)std::floor(std::min(x0, std::min(x1, x2))));
+        const int maxx = std::min(tilex1, (int)std::ceil(std::max(x0, std::max(x1, x2))));
+        const int miny = std::max(tiley0, (int)std::floor(std::min(y0, std::min(y1, y2))));
+        const int maxy = std::min(tiley1, (int)std::ceil(std::max(y0, std::max(y1, y2))));
+        if( minx > maxx || miny > maxy ) {
+            return;
+        }
+
+        // edge function e_ab(x,y) = (xb - xa)*(y - ya) - (yb - ya)*(x - xa) weights the vertex opposite to ab and is
+        // positive inside. stepping one pixel in x adds ya - yb to it.
+        const float invarea = 1.0f/area;
+        const float a12 = y1 - y2, b12 = x2 - x1;
+        const float a20 = y2 - y0, b20 = x0 - x2;
+        const float a01 = y0 - y1, b01 = x1 - x0;
+        const int numcols = maxx - minx + 1;
+        for(int py = miny; py <= maxy; ++py) {
+            const float fx = minx + 0.5f, fy = py + 0.5f;
+            const float w0row = a12*(fx - x1) + b12*(fy - y1);
+            const float w1row = a20*(fx - x2) + b20*(fy - y2);
+            const float w2row = a01*(fx - x0) + b01*(fy - y0);
+            float* pinvdepth = &_vinvdepth[(size_t)py*_width + minx];
+            uint32_t* pindices = &_vtriangleindices[(size_t)py*_width + minx];
+            // independent iterations without early exits, so the compiler can evaluate several pixels at once
+            for(int i = 0; i < numcols; ++i) {
+                const float w0 = w0row + a12*i, w1 = w1row + a20*i, w2 = w2row + a01*i;
+                const float invz = (w0*iz0 + w1*iz1 + w2*iz2)*invarea;
+                const bool bdraw = (w0 >= 0) & (w1 >= 0) & (w2 >= 0) & (invz > pinvdepth[i]);
+                pinvdepth[i] = bdraw ? invz : pinvdepth[i];
+                pindices[i] = bdraw ? itri : pindices[i];
+            }
+        }
+    }
+
+    int _numthreads;
+    float _fnear; ///< distance of the near clipping plane
+    int _width = 0, _height = 0, _numtilesx = 0;
+    dReal _fx = 0, _fy = 0, _cx = 0, _cy = 0;
+
+    std::vector<KinBodyPtr> _vbodies;
+    std::vector<Vector> _vcamerapoints;
+    std::vector<ScreenTriangle> _vtriangles;
+    std::vector< std::vector<uint32_t> > _vtilebins; ///< indices of the triangles overlapping each tile
+    std::vector<float> _vinvdepth; ///< inverse depth of the closest triangle at each pixel, 0 if none
+    std::vector<uint32_t> _vtriangleindices; ///< closest triangle at each pixel, only valid where _vinvdepth > 0
+};
+
+#endif
@@ -0,0 +1,307 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 OpenRAVE
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef OPENRAVE_LIDARSCANNER_H
+#define OPENRAVE_LIDARSCANNER_H
+
+#include <atomic>
+#include <thread>
+
+/// \brief Casts the beams of a laser scan, either serially in the sensor's environment or on several threads.
+///
+/// Collision checkers are not thread safe, so in parallel mode every worker owns a clone of the environment with its own
+/// checker and report. When a scan starts, the link transforms, dof branches and link enable states of all bodies are
+/// copied on the simulation thread, and each worker applies this snapshot to its clone before casting its share of the
+/// beams. Because the workers never touch the sensor's environment, an asynchronous scan can keep running while the
+/// simulation advances. The clones are synchronized again with EnvironmentBase::Clone whenever bodies are added, removed
+/// or change their geometry.
+class LidarScanner
+{
+public:
+    LidarScanner() : _numthreads(1), _bAsync(false), _bScanning(false), _bFinished(false), _nextray(0)
+    {
+    }
+    virtual ~LidarScanner()
+    {
+        Reset();
+    }
+
+    /// \brief number of threads casting beams. With 1 thread and no asynchronous scans, beams are cast in the sensor's environment.
+    void SetNumThreads(int numthreads)
+    {
+        if( _numthreads != std::max(1, numthreads) ) {
+            Reset();
+            _numthreads = std::max(1, numthreads);
+        }
+    }
+    int GetNumThreads() const
+    {
+        return _numthreads;
+    }
+
+    /// \brief if true, StartScan returns right away and the results are picked up by a later GetScanResults
+    void SetAsync(bool bAsync)
+    {
+        if( _bAsync != bAsync ) {
+            Reset();
+            _bAsync = bAsync;
+        }
+    }
+    bool IsAsync() const
+    {
+        return _bAsync;
+    }
+
+    /// \brief starts casting vrays, swapping them into the scanner.
+    ///
+    /// Has to be called from the simulation thread with the environment locked.
+    /// \return false if the results of the previous scan have not been retrieved yet
+    bool StartScan(EnvironmentBasePtr penv, std::vector<RAY>& vrays)
+    {
+        if( _bScanning ) {
+            return false;
+        }
+        _vrays.swap(vrays);
+        _vdistances.resize(_vrays.size());
+        _vbodyindices.resize(_vrays.size());
+        _bScanning = true;
+        _nextray = 0;
+        if( _numthreads <= 1 && !_bAsync ) {
+            _CastRays(penv, _GetSerialReport());
+            _bFinished = true;
+            return true;
+        }
+
+        _SyncClones(penv);
+        _TakeSnapshot();
+        _bFinished = false;
+        if( _bAsync ) {
+            _scanthread = std::thread(&LidarScanner::_RunWorkers, this);
+        }
+        else {
+            _RunWorkers();
+        }
+        return true;
+    }
+
+    /// \brief retrieves the results of a finished scan so that the next one can start. The buffers are swapped with the scanner.
+    ///
+    /// \param vrays the rays that were passed to StartScan
+    /// \param vdistances distance from the ray origin to the first hit, negative if nothing was hit
+    /// \param vbodyindices environment body index of the hit body, 0 if nothing was hit
+    /// \return false if there is no scan or it is still running
+    bool GetScanResults(std::vector<RAY>& vrays, std::vector<dReal>& vdistances, std::vector<int>& vbodyindices)
+    {
+        if( !_bScanning || !_bFinished ) {
+            return false;
+        }
+        if( _scanthread.joinable() ) {
+            _scanthread.join();
+        }
+        vrays.swap(_vrays);
+        vdistances.swap(_vdistances);
+        vbodyindices.swap(_vbodyindices);
+        _bScanning = false;
+        return true;
+    }
+
+    /// \brief true from StartScan until the results are retrieved by GetScanResults
+    bool IsScanning() const
+    {
+        return _bScanning;
+    }
+
+    /// \brief waits for any running scan and drops its results
+    void Cancel()
+    {
+        if( _scanthread.joinable() ) {
+            _scanthread.join();
+        }
+        _bScanning = false;
+    }
+
+    /// \brief cancels the running scan and destroys the environment clones
+    void Reset()
+    {
+        Cancel();
+        FOREACH(itworker, _vworkers) {
+            itworker->penv->Destroy();
+        }
+        _vworkers.clear();
+        _vbodysignatures.clear();
+        _serialreport.reset();
+    }
+
+protected:
+    struct Worker
+    {
+        EnvironmentBasePtr penv;
+        CollisionReportPtr report;
+        std::vector<KinBodyPtr> vbodies; ///< bodies of the clone in the same order as _vbodystates
+    };
+
+    struct BodyState
+    {
+        uint32_t linkoffset, numlinks; ///< into _vlinktransforms and _vlinkenablestates
+        uint32_t dofoffset, numdofs; ///< into _vdofvalues
+    };
+
+    CollisionReportPtr _GetSerialReport()
+    {
+        if( !_serialreport ) {
+            _serialreport.reset(new CollisionReport());
+        }
+        return _serialreport;
+    }
+
+    /// \brief clones the environment for every worker, or updates the clones when the set of bodies changed
+    void _SyncClones(EnvironmentBasePtr penv)
+    {
+        penv->GetBodies(_vbodies);
+        _vtempsignatures.resize(_vbodies.size());
+        for(size_t ibody = 0; ibody < _vbodies.size(); ++ibody) {
+            _vtempsignatures[ibody].first = _vbodies[ibody]->GetEnvironmentBodyIndex();
+            _vtempsignatures[ibody].second = _vbodies[ibody]->GetKinematicsGeometryHash();
+        }
+        if( (int)_vworkers.size() == _numthreads && _vtempsignatures == _vbodysignatures ) {
+            return;
+        }
+
+        RAVELOG_DEBUG_FORMAT("env=%s, cloning %d environments for parallel laser scans", penv->GetNameId()%_numthreads);
+        _vbodysignatures.swap(_vtempsignatures);
+        _vworkers.resize(_numthreads);
+        FOREACH(itworker, _vworkers) {
+            if( !itworker->penv ) {
+                itworker->penv = penv->CloneSelf(Clone_Bodies);
+                itworker->report.reset(new CollisionReport());
+            }
+            else {
+                itworker->penv->Clone(penv, Clone_Bodies);
+            }
+            itworker->vbodies.resize(_vbodies.size());
+            for(size_t ibody = 0; ibody < _vbodies.size(); ++ibody) {
+                itworker->vbodies[ibody] = itworker->penv->GetBodyFromEnvironmentBodyIndex(_vbodies[ibody]->GetEnvironmentBodyIndex());
+            }
+        }
+    }
+
+    /// \brief copies the state of all bodies of the sensor's environment, has to be called after _SyncClones
+    void _TakeSnapshot()
+    {
+        _vbodystates.resize(_vbodies.size());
+        _vlinktransforms.resize(0);
+        _vlinkenablestates.resize(0);
+        _vdofvalues.resize(0);
+        for(size_t ibody = 0; ibody < _vbodies.size(); ++ibody) {
+            BodyState& state = _vbodystates[ibody];
+            _vbodies[ibody]->GetLinkTransformations(_vtemptransforms, _vtempdofvalues);
+            _vbodies[ibody]->GetLinkEnableStates(_vtempenablestates);
+            state.linkoffset = _vlinktransforms.size();
+            state.numlinks = _vtemptransforms.size();
+            state.dofoffset = _vdofvalues.size();
+            state.numdofs = _vtempdofvalues.size();
+            _vlinktransforms.insert(_vlinktransforms.end(), _vtemptransforms.begin(), _vtemptransforms.end());
+            _vlinkenablestates.insert(_vlinkenablestates.end(), _vtempenablestates.begin(), _vtempenablestates.end());
+            _vdofvalues.insert(_vdofvalues.end(), _vtempdofvalues.begin(), _vtempdofvalues.end());
+        }
+        _vbodies.clear(); // do not hold on to the bodies of the sensor's environment
+    }
+
+    void _RunWorkers()
+    {
+        std::vector<std::thread> vthreads;
+        vthreads.reserve(_vworkers.size());
+        for(size_t iworker = 1; iworker < _vworkers.size(); ++iworker) {
+            vthreads.emplace_back(&LidarScanner::_WorkerThread, this, iworker);
+        }
+        _WorkerThread(0);
+        FOREACH(itthread, vthreads) {
+            itthread->join();
+        }
+        _bFinished = true;
+    }
+
+    void _WorkerThread(size_t iworker)
+    {
+        Worker& worker = _vworkers[iworker];
+        EnvironmentLock lock(worker.penv->GetMutex());
+        std::vector<Transform> vtransforms;
+        std::vector<dReal> vdofvalues;
+        std::vector<uint8_t> venablestates;
+        for(size_t ibody = 0; ibody < worker.vbodies.size(); ++ibody) {
+            if( !worker.vbodies[ibody] ) {
+                continue;
+            }
+            const BodyState& state = _vbodystates[ibody];
+            vtransforms.assign(_vlinktransforms.begin()+state.linkoffset, _vlinktransforms.begin()+state.linkoffset+state.numlinks);
+            vdofvalues.assign(_vdofvalues.begin()+state.dofoffset, _vdofvalues.begin()+state.dofoffset+state.numdofs);
+            venablestates.assign(_vlinkenablestates.begin()+state.linkoffset, _vlinkenablestates.begin()+state.linkoffset+state.numlinks);
+            worker.vbodies[ibody]->SetLinkTransformations(vtransforms, vdofvalues);
+            worker.vbodies[ibody]->SetLinkEnableStates(venablestates);
+        }
+        _CastRays(worker.penv, worker.report);
+    }
+
+    /// \brief casts rays handed out by _nextray in small batches until there are none left
+    void _CastRays(EnvironmentBasePtr penv, CollisionReportPtr report)
+    {
+        static const size_t s_batchsize = 32;
+        CollisionOptionsStateSaver optionsaver(penv->GetCollisionChecker(), CO_Distance);
+        const size_t numrays = _vrays.size();
+        for(size_t istart = _nextray.fetch_add(s_batchsize); istart < numrays; istart = _nextray.fetch_add(s_batchsize)) {
+            for(size_t iray = istart; iray < std::min(istart + s_batchsize, numrays); ++iray) {
+                if( penv->CheckCollision(_vrays[iray], report) ) {
+                    _vdistances[iray] = report->minDistance;
+                    KinBody::LinkConstPtr plink = !!report->plink1 ? report->plink1 : report->plink2;
+                    _vbodyindices[iray] = !!plink ? plink->GetParent()->GetEnvironmentBodyIndex() : 0;
+                }
+                else {
+                    _vdistances[iray] = -1;
+                    _vbodyindices[iray] = 0;
+                }
+            }
+        }
+        report->Reset();
+    }
+
+    int _numthreads;
+    bool _bAsync;
+    bool _bScanning; ///< true from StartScan until the results are retrieved
+    std::atomic<bool> _bFinished;
+    std::atomic<size_t> _nextray;
+    std::thread _scanthread; ///< runs the workers of an asynchronous scan
+
+    std::vector<RAY> _vrays;
+    std::vector<dReal> _vdistances;
+    std::vector<int> _vbodyindices;
+
+    std::vector<Worker> _vworkers;
+    CollisionReportPtr _serialreport;
+    std::vector< std::pair<int, std::string> > _vbodysignatures; ///< environment body index and kinematics geometry hash of the bodies the clones were made from
+    std::vector<BodyState> _vbodystates;
+    std::vector<Transform> _vlinktransforms;
+    std::vector<uint8_t> _vlinkenablestates;
+    std::vector<dReal> _vdofvalues;
+
+    // scratch buffers used on the simulation thread
+    std::vector<KinBodyPtr> _vbodies;
+    std::vector< std::pair<int, std::string> > _vtempsignatures;
+    std::vector<Transform> _vtemptransforms;
+    std::vector<dReal> _vtempdofvalues;
+    std::vector<uint8_t> _vtempenablestates;
+};
+
+#endif
@@ -113,6 +113,12 @@ public:
                 _ss >> _physics->_super_damp2;
                 
             }
+            else if( name == "warmstarting_factor" ) {
+                _ss >> _physics->_warmstarting_factor;
+            }
+            else if( name == "contact_processing_threshold" ) {
+                _ss >> _physics->_contact_processing_threshold;
+            }
             else if( name == "gravity" ) {
                 Vector v;
                 _ss >> v.x >> v.y >> v.z;
@@ -142,9 +148,9 @@ public:
             }
         }
 
-        static const boost::array<string, 8>& GetTags() {
-        static const boost::array<string, 8> tags = {{"solver_iterations","margin_depth","linear_damping","rotation_damping",
-        "global_contact_force_mixing","global_friction","global_restitution","gravity" }};
+        static const boost::array<string, 10>& GetTags() {
+        static const boost::array<string, 10> tags = {{"solver_iterations","margin_depth","linear_damping","rotation_damping",
+        "global_contact_force_mixing","global_friction","global_restitution","gravity","warmstarting_factor","contact_processing_threshold" }};
             return tags;
         }
 
@@ -177,6 +183,9 @@ public:
         
         _super_damp = 0.3; 
         _super_damp2 = 0.9;
+
+        _warmstarting_factor = 0.85;
+        _contact_processing_threshold = 0.01;
           
         FOREACHC(it, PhysicsPropertiesXMLReader::GetTags()) {
             ss << "**" << *it << "**, ";
@@ -314,7 +323,18 @@ public:
         solverInfo.m_erp2 = _super_damp2;
         //solverInfo. m_splitImpulsePenetrationThreshold = 0.5;
         
-        solverInfo.m_solverMode |= SOLVER_SIMD | SOLVER_DISABLE_VELOCITY_DEPENDENT_FRICTION_DIRECTION |SOLVER_USE_2_FRICTION_DIRECTIONS; //SOLVER_ENABLE_FRICTION_DIRECTION_CACHING ;
+        solverInfo.m_solverMode |= SOLVER_SIMD | SOLVER_DISABLE_VELOCITY_DEPENDENT_FRICTION_DIRECTION |SOLVER_USE_2_FRICTION_DIRECTIONS;
+
+        // the contact points persist in the manifolds of the overlapping pairs (at most 4 per pair), so the impulses solved in
+        // the last step are a good initial guess for resting contacts like stacked parts. The friction directions have to be
+        // cached with the points, otherwise the warm started friction impulses would be applied along different directions.
+        solverInfo.m_warmstartingFactor = _warmstarting_factor;
+        if( _warmstarting_factor > 0 ) {
+            solverInfo.m_solverMode |= SOLVER_USE_WARMSTARTING | SOLVER_ENABLE_FRICTION_DIRECTION_CACHING;
+        }
+        else {
+            solverInfo.m_solverMode &= ~(SOLVER_USE_WARMSTARTING | SOLVER_ENABLE_FRICTION_DIRECTION_CACHING);
+        }
         
 	//solverInfo.m_solverMode |=    SOLVER_FRICTION_SEPARATE  |SOLVER_USE_2_FRICTION_DIRECTIONS;
 	
@@ -412,6 +432,11 @@ public:
              }
             }
         }
+
+        // points of a manifold that are farther apart than this are kept for warm starting but not passed to the solver
+        FOREACH(itlink, pinfo->vlinks) {
+            (*itlink)->obj->setContactProcessingThreshold(_contact_processing_threshold);
+        }
         return !!pinfo;
     }
 
@@ -645,6 +670,17 @@ public:
         GetEnv()->GetBodies(vbodies);
         FOREACHC(itbody, vbodies) {
             BulletSpace::KinBodyInfoPtr pinfo = GetPhysicsInfo(*itbody);
+            // bodies whose links all went to sleep did not move, most of the parts of a settled bin are sleeping
+            bool bActive = false;
+            FOREACHC(itlink, pinfo->vlinks) {
+                if( (*itlink)->_rigidbody->isActive() ) {
+                    bActive = true;
+                    break;
+                }
+            }
+            if( !bActive ) {
+                continue;
+            }
             FOREACH(itlink, pinfo->vlinks) {
                 Transform t = BulletSpace::GetTransform((*itlink)->_rigidbody->getCenterOfMassTransform());
                 (*itlink)->plink->SetTransform(t*(*itlink)->tlocal.inverse());
@@ -665,6 +701,8 @@ public:
     btScalar _global_restitution;
     btScalar _super_damp;
     btScalar _super_damp2;
+    btScalar _warmstarting_factor; ///< scales the impulses of the last step that the solver starts from, 0 disables warm starting
+    btScalar _contact_processing_threshold; ///< contact points with a larger distance are not solved
 
 private:
     static BulletSpace::KinBodyInfoPtr GetPhysicsInfo(KinBodyConstPtr pbody)
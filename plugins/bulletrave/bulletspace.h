@@ -27,6 +27,7 @@
 #include <BulletCollision/Gimpact/btGImpactShape.h>
 #include <BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
 #include <BulletCollision/CollisionShapes/btShapeHull.h>
+#include <boost/functional/hash.hpp>
 //#include <BulletCollision/Gimpact/btConcaveConcaveCollisionAlgorithm.h>
 
 // groups bits for bullet
@@ -68,8 +69,7 @@ public:
             boost::shared_ptr<btCollisionObject> obj;
             boost::shared_ptr<btRigidBody> _rigidbody;
             boost::shared_ptr<btCollisionShape> shape;
-            list<boost::shared_ptr<btCollisionShape> > listchildren;
-            list<boost::shared_ptr<btStridingMeshInterface> > listmeshes;
+            list<boost::shared_ptr<btCollisionShape> > listchildren; ///< can be shared with the links of other bodies, see BulletSpace::_GetSharedShape
 
             KinBody::LinkPtr plink;
             Transform tlocal;     /// local offset transform to account for inertias not aligned to axes
@@ -122,7 +122,7 @@ private:
     typedef boost::function<KinBodyInfoPtr(KinBodyConstPtr)> GetInfoFn;
     typedef boost::function<void (KinBodyInfoPtr)> SynchronizeCallbackFn;
 
-    BulletSpace(EnvironmentBasePtr penv, const GetInfoFn& infofn, bool bPhysics) : _penv(penv), GetInfo(infofn), _bPhysics(bPhysics) {
+    BulletSpace(EnvironmentBasePtr penv, const GetInfoFn& infofn, bool bPhysics) : _penv(penv), GetInfo(infofn), _bPhysics(bPhysics), _nsharedshapescount(16) {
     }
     virtual ~BulletSpace() {
     }
@@ -141,6 +141,7 @@ private:
     {
         _world.reset();
         _worlddynamics.reset();
+        _mapsharedshapes.clear();
     }
 
     KinBodyInfoPtr InitKinBody(KinBodyPtr pbody, KinBodyInfoPtr pinfo = KinBodyInfoPtr(), btScalar fmargin=0.0005) //  -> changed fmargin because penetration was too little. For collision the values needs to be changed. There will be an XML interface for fmargin.
@@ -163,71 +164,16 @@ private:
 
             // add all the correct geometry objects
             FOREACHC(itgeom, (*itlink)->GetGeometries()) {
-                boost::shared_ptr<btCollisionShape> child;
                 KinBody::Link::GeometryPtr geom = *itgeom;
-                switch(geom->GetType()) {
-                case GT_None:
-                    break;
-                case GT_Box:
-                    child.reset(new btBoxShape(GetBtVector(geom->GetBoxExtents())));
-                    break;
-                case GT_Sphere:
-                    child.reset(new btSphereShape(geom->GetSphereRadius()));
-                    break;
-                case GT_Cylinder:
-                    // cylinder axis aligned to Y
-                    child.reset(new btCylinderShapeZ(btVector3(geom->GetCylinderRadius(),geom->GetCylinderRadius(),geom->GetCylinderHeight()*0.5f)));
-                    break;
-                case GT_TriMesh: {
-                    if( geom->GetCollisionMesh().indices.size() >= 3 ) {
-                        btTriangleMesh* ptrimesh = new btTriangleMesh();
-
-                        // for some reason adding indices makes everything crash
-                        for(size_t i = 0; i < geom->GetCollisionMesh().indices.size(); i += 3) {
-                            ptrimesh->addTriangle(GetBtVector(geom->GetCollisionMesh().vertices[i]), GetBtVector(geom->GetCollisionMesh().vertices[i+1]), GetBtVector(geom->GetCollisionMesh().vertices[i+2]));
-                        }
-                        //child.reset(new btBvhTriangleMeshShape(ptrimesh, true, true)); // doesn't do tri-tri collisions!
-
-                        if( _bPhysics ) {
-                            RAVELOG_DEBUG("converting triangle mesh to convex hull for physics\n");
-                            boost::shared_ptr<btConvexShape> pconvexbuilder(new btConvexTriangleMeshShape(ptrimesh));
-                            pconvexbuilder->setMargin(fmargin);
-
-                            //Create a hull shape to approximate Trimesh
-                            boost::shared_ptr<btShapeHull> hull(new btShapeHull(pconvexbuilder.get()));
-                            hull->buildHull(fmargin);
-
-                            btConvexHullShape* convexShape = new btConvexHullShape();
-                            convexShape->setLocalScaling(btVector3(1,1,1));
-                            //ofstream f((*itlink)->GetName().c_str());
-                            for (int i=0; i< hull->numVertices(); i++) {
-                                convexShape->addPoint(hull->getVertexPointer()[i]);
-                                //f << hull->getVertexPointer()[i].getX() << " " << hull->getVertexPointer()[i].getY() << " " << hull->getVertexPointer()[i].getZ() << endl;
-                            }
-                            child.reset(convexShape);
-                            delete ptrimesh;
-                        }
-                        else {
-                            btGImpactMeshShape* pgimpact = new btGImpactMeshShape(ptrimesh);
-                            pgimpact->setMargin(fmargin);     // need to set margin very small (we're not simulating anyway)
-                            pgimpact->updateBound();
-                            child.reset(pgimpact);
-                            link->listmeshes.push_back(boost::shared_ptr<btStridingMeshInterface>(ptrimesh));
-                        }
+                boost::shared_ptr<btCollisionShape> child = _GetSharedShape(geom, fmargin);
+                if( !child ) {
+                    if( geom->GetType() != GT_None ) {
+                        RAVELOG_WARN("did not create geom type 0x%x\n", geom->GetType());
                     }
-                    break;
-                }
-                default:
-                    break;
-                }
-
-                if( !child && geom->GetType() != GT_None ) {
-                    RAVELOG_WARN("did not create geom type 0x%x\n", geom->GetType());
                     continue;
                 }
 
                 link->listchildren.push_back(child);
-                child->setMargin(fmargin);     // need to set margin very small (we're not simulating anyway)
                 pshapeparent->addChildShape(GetBtTransform(geom->GetTransform()), child.get());
             }
 
@@ -437,6 +383,186 @@ private:
 
 private:
 
+    /// \brief identifies the collision shape of a geometry, geometries with equal keys share one shape
+    struct SharedShapeKey
+    {
+        SharedShapeKey() : type(GT_None) {
+            params.assign(0);
+        }
+        bool operator==(const SharedShapeKey& r) const
+        {
+            if( type != r.type || params != r.params || !meshbuffer != !r.meshbuffer ) {
+                return false;
+            }
+            return !meshbuffer || _IsSameMesh(*meshbuffer, *r.meshbuffer);
+        }
+
+        GeometryType type;
+        boost::array<btScalar, 4> params; ///< dimensions of the primitive and the collision margin
+        TriMeshBufferConstPtr meshbuffer; ///< collision mesh of GT_TriMesh geometries
+    };
+
+    /// \brief deletes a mesh shape together with the triangles it references
+    class MeshShapeDeleter
+    {
+public:
+        MeshShapeDeleter(boost::shared_ptr<btStridingMeshInterface> mesh) : _mesh(mesh) {
+        }
+        void operator()(btCollisionShape* pshape) {
+            delete pshape;
+            _mesh.reset();
+        }
+private:
+        boost::shared_ptr<btStridingMeshInterface> _mesh;
+    };
+
+    static bool _IsSameMesh(const TriMeshBuffer& mesh0, const TriMeshBuffer& mesh1)
+    {
+        if( &mesh0 == &mesh1 ) {
+            return true;
+        }
+        if( mesh0.GetNumVertices() != mesh1.GetNumVertices() || mesh0.GetNumIndices() != mesh1.GetNumIndices() ) {
+            return false;
+        }
+        if( mesh0.GetNumVertices() > 0 && memcmp(mesh0.GetPositions(), mesh1.GetPositions(), 3*mesh0.GetNumVertices()*sizeof(float)) != 0 ) {
+            return false;
+        }
+        for(size_t i = 0; i < mesh0.GetNumIndices(); ++i) {
+            if( mesh0.GetIndex(i) != mesh1.GetIndex(i) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// \brief returns the collision shape of a geometry, reusing the shape of any other link with an identical geometry.
+    ///
+    /// Building the convex hulls and the gimpact trees of meshes dominates the time to add bodies, and a bin of identical
+    /// parts only needs them once. The shapes are immutable and defined in the geometry frame, so bullet lets any number of
+    /// collision objects reference them. The cache only holds weak references, a shape is deleted with the last link using it.
+    /// \return empty if the geometry does not have a collision shape
+    boost::shared_ptr<btCollisionShape> _GetSharedShape(KinBody::Link::GeometryPtr geom, btScalar fmargin)
+    {
+        SharedShapeKey key;
+        key.type = geom->GetType();
+        key.params[3] = fmargin;
+        switch(geom->GetType()) {
+        case GT_Box:
+            key.params[0] = geom->GetBoxExtents().x; key.params[1] = geom->GetBoxExtents().y; key.params[2] = geom->GetBoxExtents().z;
+            break;
+        case GT_Sphere:
+            key.params[0] = geom->GetSphereRadius();
+            break;
+        case GT_Cylinder:
+            key.params[0] = geom->GetCylinderRadius(); key.params[1] = geom->GetCylinderHeight();
+            break;
+        case GT_TriMesh:
+            key.meshbuffer = geom->CreateCollisionMeshBuffer();
+            if( !key.meshbuffer || key.meshbuffer->GetNumIndices() < 3 ) {
+                return boost::shared_ptr<btCollisionShape>();
+            }
+            break;
+        default:
+            return boost::shared_ptr<btCollisionShape>();
+        }
+
+        size_t hash = 0;
+        boost::hash_combine(hash, (int)key.type);
+        FOREACHC(itparam, key.params) {
+            boost::hash_combine(hash, *itparam);
+        }
+        if( !!key.meshbuffer ) {
+            const TriMeshBuffer& mesh = *key.meshbuffer;
+            boost::hash_combine(hash, boost::hash_range(mesh.GetPositions(), mesh.GetPositions()+3*mesh.GetNumVertices()));
+            for(size_t i = 0; i < mesh.GetNumIndices(); ++i) {
+                boost::hash_combine(hash, mesh.GetIndex(i));
+            }
+        }
+
+        std::pair<SHAREDSHAPEMAP::iterator, SHAREDSHAPEMAP::iterator> range = _mapsharedshapes.equal_range(hash);
+        for(SHAREDSHAPEMAP::iterator it = range.first; it != range.second; ) {
+            boost::shared_ptr<btCollisionShape> shape = it->second.second.lock();
+            if( !shape ) {
+                _mapsharedshapes.erase(it++);
+                continue;
+            }
+            if( it->second.first == key ) {
+                return shape;
+            }
+            ++it;
+        }
+
+        boost::shared_ptr<btCollisionShape> shape;
+        switch(key.type) {
+        case GT_Box:
+            shape.reset(new btBoxShape(GetBtVector(geom->GetBoxExtents())));
+            break;
+        case GT_Sphere:
+            shape.reset(new btSphereShape(geom->GetSphereRadius()));
+            break;
+        case GT_Cylinder:
+            // cylinder axis aligned to Y
+            shape.reset(new btCylinderShapeZ(btVector3(geom->GetCylinderRadius(),geom->GetCylinderRadius(),geom->GetCylinderHeight()*0.5f)));
+            break;
+        case GT_TriMesh: {
+            const TriMeshBuffer& mesh = *key.meshbuffer;
+            btTriangleMesh* ptrimesh = new btTriangleMesh();
+
+            // for some reason adding indices makes everything crash
+            const float* ppositions = mesh.GetPositions();
+            for(size_t i = 0; i+2 < mesh.GetNumIndices(); i += 3) {
+                const float* p0 = ppositions + 3*mesh.GetIndex(i), *p1 = ppositions + 3*mesh.GetIndex(i+1), *p2 = ppositions + 3*mesh.GetIndex(i+2);
+                ptrimesh->addTriangle(btVector3(p0[0], p0[1], p0[2]), btVector3(p1[0], p1[1], p1[2]), btVector3(p2[0], p2[1], p2[2]));
+            }
+            //child.reset(new btBvhTriangleMeshShape(ptrimesh, true, true)); // doesn't do tri-tri collisions!
+
+            if( _bPhysics ) {
+                RAVELOG_DEBUG("converting triangle mesh to convex hull for physics\n");
+                boost::shared_ptr<btConvexShape> pconvexbuilder(new btConvexTriangleMeshShape(ptrimesh));
+                pconvexbuilder->setMargin(fmargin);
+
+                //Create a hull shape to approximate Trimesh
+                boost::shared_ptr<btShapeHull> hull(new btShapeHull(pconvexbuilder.get()));
+                hull->buildHull(fmargin);
+
+                // passing all points at once computes the local aabb only once instead of after every addPoint
+                if( hull->numVertices() > 0 ) {
+                    shape.reset(new btConvexHullShape(&hull->getVertexPointer()[0].getX(), hull->numVertices(), sizeof(btVector3)));
+                }
+                else {
+                    shape.reset(new btConvexHullShape());
+                }
+                delete ptrimesh;
+            }
+            else {
+                btGImpactMeshShape* pgimpact = new btGImpactMeshShape(ptrimesh);
+                pgimpact->setMargin(fmargin);     // need to set margin very small (we're not simulating anyway)
+                pgimpact->updateBound();
+                shape.reset(pgimpact, MeshShapeDeleter(boost::shared_ptr<btStridingMeshInterface>(ptrimesh)));
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        shape->setMargin(fmargin);     // need to set margin very small (we're not simulating anyway)
+        if( _mapsharedshapes.size() >= 2*_nsharedshapescount ) {
+            // drop the entries of deleted shapes so that the cache does not hold on to their meshes
+            for(SHAREDSHAPEMAP::iterator it = _mapsharedshapes.begin(); it != _mapsharedshapes.end(); ) {
+                if( it->second.second.expired() ) {
+                    _mapsharedshapes.erase(it++);
+                }
+                else {
+                    ++it;
+                }
+            }
+            _nsharedshapescount = std::max(_mapsharedshapes.size(), size_t(16));
+        }
+        _mapsharedshapes.insert(std::make_pair(hash, std::make_pair(key, boost::weak_ptr<btCollisionShape>(shape))));
+        return shape;
+    }
+
     void _Synchronize(KinBodyInfoPtr pinfo)
     {
         vector<Transform> vtrans;
@@ -471,6 +597,10 @@ private:
     boost::shared_ptr<btDiscreteDynamicsWorld> _worlddynamics;
     SynchronizeCallbackFn _synccallback;
     bool _bPhysics;
+
+    typedef std::multimap<size_t, std::pair<SharedShapeKey, boost::weak_ptr<btCollisionShape> > > SHAREDSHAPEMAP;
+    SHAREDSHAPEMAP _mapsharedshapes; ///< collision shapes of the geometries indexed by the hash of their SharedShapeKey
+    size_t _nsharedshapescount; ///< size of _mapsharedshapes after the expired entries were last removed
 };
 
 static KinBody::LinkPtr GetLinkFromCollision(const btCollisionObject* co) {
@@ -52,6 +52,10 @@ public:
                         "load self collision cache");
         RegisterCommand("GetCacheTimes",boost::bind(&CacheCollisionChecker::_GetCacheTimesCommand,this,_1,_2),
                         "get the cache times: insert, query, collision checking, load");
+        RegisterCommand("SetSharedCache",boost::bind(&CacheCollisionChecker::_SetSharedCacheCommand,this,_1,_2),
+                        "share the collision caches with the checkers of other environments (e.g. clones) tracking the same robot in the same static environment state. [0/1]");
+        RegisterCommand("ResetSharedCache",boost::bind(&CacheCollisionChecker::_ResetSharedCacheCommand,this,_1,_2),
+                        "release all the shared collision caches of the process");
         std::string collisionname="ode";
         sinput >> collisionname;
         _pintchecker = RaveCreateCollisionChecker(GetEnv(), collisionname);
@@ -64,6 +68,9 @@ public:
         _selfcachedcollisionhits=0;
         _selfcachedfreehits = 0;
 
+        _bUseSharedCache = false;
+        _bSharedCacheKeyDirty = true;
+
         __cachehash.resize(0);
 
         _stime = 0;
@@ -144,6 +151,7 @@ public:
             _pintchecker->DestroyEnvironment();
         }
         _handleRobotDOFChange.reset();
+        _ReleaseSharedCaches();
         _probot.reset();
     }
 
@@ -166,6 +174,7 @@ public:
         }
 
         _strRobotName = clone->_strRobotName;
+        _bUseSharedCache = clone->_bUseSharedCache;
         _probot.reset(); // have to rest to force creating a new cache
         _probot = GetRobot();
 
@@ -211,7 +220,16 @@ public:
 
         // see if cache contains the result, closestdist is used to determine if the configuration should be inserted into the cache
         _stime = utils::GetMilliTime();
-        int ret = _cache->CheckCollision(robotlink, collidinglink, closestdist);
+        int ret;
+        SharedCacheTreePtr psharedcache;
+        if( _bUseSharedCache ) {
+            psharedcache = _GetSharedCache(false);
+            _cache->GetDOFValues(_dofvals);
+            ret = _CheckSharedCacheCollision(*psharedcache, *_cache, _dofvals, robotlink, collidinglink, closestdist);
+        }
+        else {
+            ret = _cache->CheckCollision(robotlink, collidinglink, closestdist);
+        }
         _querytime += utils::GetMilliTime()-_stime;
 
         ++_cachedcollisionchecks;
@@ -257,7 +275,12 @@ public:
         _stime = utils::GetMilliTime();
         _cache->GetDOFValues(_dofvals);
         // insert collisioncheck result into cache
-        _cache->InsertConfiguration(_dofvals, !col ? CollisionReportPtr() : report, closestdist);
+        if( !!psharedcache ) {
+            _InsertSharedCacheConfiguration(*psharedcache, *_cache, _dofvals, !col ? CollisionReportPtr() : report);
+        }
+        else {
+            _cache->InsertConfiguration(_dofvals, !col ? CollisionReportPtr() : report, closestdist);
+        }
         _intime += utils::GetMilliTime()-_stime;
 
         return col;
@@ -326,7 +349,16 @@ public:
         dReal closestdist=0;
 
         _stime = utils::GetMilliTime();
-        int ret = _selfcache->CheckCollision(robotlink, collidinglink, closestdist);
+        int ret;
+        SharedCacheTreePtr psharedcache;
+        if( _bUseSharedCache ) {
+            psharedcache = _GetSharedCache(true);
+            _selfcache->GetDOFValues(_dofvals);
+            ret = _CheckSharedCacheCollision(*psharedcache, *_selfcache, _dofvals, robotlink, collidinglink, closestdist);
+        }
+        else {
+            ret = _selfcache->CheckCollision(robotlink, collidinglink, closestdist);
+        }
         _selfquerytime += utils::GetMilliTime()-_stime;
 
         ++_selfcachedcollisionchecks;
@@ -345,7 +377,7 @@ public:
         }
 
         // save cache every other iteration if its size has increased by 1.5
-        if (_selfcachedcollisionchecks % 4000 == 0) {
+        if (!psharedcache && _selfcachedcollisionchecks % 4000 == 0) {
             if (_size*1.5 < _selfcache->GetNumKnownNodes()) {
                 _selfcache->SaveCache(GetCacheHash());
                 _size = _selfcache->GetNumKnownNodes();
@@ -377,7 +409,12 @@ public:
 
         _stime = utils::GetMilliTime();
         _selfcache->GetDOFValues(_dofvals);
-        _selfcache->InsertConfiguration(_dofvals, !col ? CollisionReportPtr() : report, closestdist);
+        if( !!psharedcache ) {
+            _InsertSharedCacheConfiguration(*psharedcache, *_selfcache, _dofvals, !col ? CollisionReportPtr() : report);
+        }
+        else {
+            _selfcache->InsertConfiguration(_dofvals, !col ? CollisionReportPtr() : report, closestdist);
+        }
         _selfintime += utils::GetMilliTime()-_stime;
 
         return col;
@@ -442,7 +479,7 @@ protected:
 
     virtual bool _GetCacheStatisticsCommand(std::ostream& sout, std::istream& sinput)
     {
-        sout << _cachedcollisionchecks << " " << _cachedcollisionhits << " " << _cachedfreehits << " " << _cache->GetNumKnownNodes();
+        sout << _cachedcollisionchecks << " " << _cachedcollisionhits << " " << _cachedfreehits << " " << (!!_psharedcache ? _psharedcache->GetNumNodes() : _cache->GetNumKnownNodes());
 
         _cachedcollisionchecks=0;
         _cachedcollisionhits=0;
@@ -452,7 +489,7 @@ protected:
 
     virtual bool _GetSelfCacheStatisticsCommand(std::ostream& sout, std::istream& sinput)
     {
-        sout << _selfcachedcollisionchecks << " " << _selfcachedcollisionhits << " " << _selfcachedfreehits << " " << _selfcache->GetNumKnownNodes();
+        sout << _selfcachedcollisionchecks << " " << _selfcachedcollisionhits << " " << _selfcachedfreehits << " " << (!!_psharedselfcache ? _psharedselfcache->GetNumNodes() : _selfcache->GetNumKnownNodes());
 
         _selfcachedcollisionchecks=0;
         _selfcachedcollisionhits=0;
@@ -525,6 +562,9 @@ protected:
     virtual bool _ResetCacheCommand(std::ostream& sout, std::istream& sinput)
     {
         _cache->Reset();
+        if( !!_psharedcache ) {
+            _psharedcache->Reset();
+        }
 
         _cachedcollisionchecks=0;
         _cachedcollisionhits=0;
@@ -535,6 +575,9 @@ protected:
     virtual bool _ResetSelfCacheCommand(std::ostream& sout, std::istream& sinput)
     {
         _selfcache->Reset();
+        if( !!_psharedselfcache ) {
+            _psharedselfcache->Reset();
+        }
 
         _selfcachedcollisionchecks=0;
         _selfcachedcollisionhits=0;
@@ -589,6 +632,27 @@ protected:
         return true;
     }
 
+    virtual bool _SetSharedCacheCommand(std::ostream& sout, std::istream& sinput)
+    {
+        int usesharedcache = 0;
+        sinput >> usesharedcache;
+        if( !sinput ) {
+            return false;
+        }
+        _bUseSharedCache = usesharedcache != 0;
+        if( !_bUseSharedCache ) {
+            _ReleaseSharedCaches();
+        }
+        return true;
+    }
+
+    virtual bool _ResetSharedCacheCommand(std::ostream& sout, std::istream& sinput)
+    {
+        _ReleaseSharedCaches();
+        ResetSharedCacheTrees();
+        return true;
+    }
+
     RobotBasePtr GetRobot()
     {
         if( !_probot && _strRobotName.size() > 0 ) {
@@ -666,6 +730,7 @@ protected:
         {
             RAVELOG_VERBOSE_FORMAT("Updating robot dofs, %d/%d",_numdofs%_probot->GetActiveDOF());
             _cache.reset(new ConfigurationCache(_probot));
+            _bSharedCacheKeyDirty = true;
 
             _numdofs = _probot->GetActiveDOF();
             _dofindices = _probot->GetActiveDOFIndices();
@@ -673,6 +738,170 @@ protected:
         }
     }
 
+    /// \brief returns the shared environment (bself is false) or self collision cache tree, looking them up again if the state they depend on changed
+    SharedCacheTreePtr _GetSharedCache(bool bself)
+    {
+        if( !_bSharedCacheKeyDirty && !!_psharedcache && _probot->GetAffineDOF() == 0 && _probot->GetTransform() != _tSharedCacheRobot ) {
+            // the environment cache does not store the robot base, so it has to be part of the key
+            _bSharedCacheKeyDirty = true;
+        }
+        if( _bSharedCacheKeyDirty || !_psharedcache ) {
+            _UpdateSharedCaches();
+        }
+        return bself ? _psharedselfcache : _psharedcache;
+    }
+
+    /// \brief computes the keys of the shared caches from the robot and the static environment state and looks up the trees
+    void _UpdateSharedCaches()
+    {
+        _bSharedCacheKeyDirty = false;
+        _tSharedCacheRobot = _probot->GetTransform();
+        if( !_handleSharedCacheBodyAddRemove ) {
+            _handleSharedCacheBodyAddRemove = GetEnv()->RegisterBodyCallback(boost::bind(&CacheCollisionChecker::_SharedCacheBodyAddRemove, this, _1, _2));
+            _handleSharedCacheRobotChange = _probot->RegisterChangeCallback(KinBody::Prop_RobotGrabbed|KinBody::Prop_LinkGeometry|KinBody::Prop_LinkEnable, boost::bind(&CacheCollisionChecker::_SetSharedCacheKeyDirty, this));
+        }
+
+        std::stringstream ss;
+        ss << std::setprecision(std::numeric_limits<dReal>::digits10+1);
+        // nodes store colliding links by environment body index, so the indices of the robot and grabbed bodies are part of the key
+        ss << _probot->GetEnvironmentBodyIndex() << " " << _probot->GetKinematicsGeometryHash() << " " << _pintchecker->GetXMLId() << " " << GetGeometryGroup() << " ";
+        // disabled links are skipped by the collision checks, so trees of different enable states cannot be shared
+        FOREACHC(itmask, _probot->GetLinkEnableStatesMasks()) {
+            ss << *itmask << " ";
+        }
+        _vGrabbedBodies.resize(0);
+        _probot->GetGrabbed(_vGrabbedBodies);
+        FOREACHC(itbody, _vGrabbedBodies) {
+            KinBody::LinkPtr pgrabbinglink = _probot->IsGrabbing(**itbody);
+            ss << (*itbody)->GetEnvironmentBodyIndex() << " " << (*itbody)->GetKinematicsGeometryHash() << " " << pgrabbinglink->GetIndex() << " " << pgrabbinglink->GetTransform().inverse()*(*itbody)->GetTransform() << " ";
+            FOREACHC(itmask, (*itbody)->GetLinkEnableStatesMasks()) {
+                ss << *itmask << " ";
+            }
+        }
+        std::string robotkey = ss.str();
+
+        ss.str(std::string());
+        ss << robotkey << "self ";
+        FOREACHC(itweight, _selfcache->GetWeights()) {
+            ss << *itweight << " ";
+        }
+        ss << _selfcache->GetMaxDistance() << " " << _selfcache->GetBase();
+        _psharedselfcache = GetSharedCacheTree(utils::GetMD5HashString(ss.str()), _selfcache->GetWeights(), _selfcache->GetMaxDistance(), _selfcache->GetBase());
+
+        ss.str(std::string());
+        ss << robotkey << "env ";
+        FOREACHC(itindex, _probot->GetActiveDOFIndices()) {
+            ss << *itindex << " ";
+        }
+        ss << _probot->GetAffineDOF() << " ";
+        if( _probot->GetAffineDOF() == 0 ) {
+            ss << _tSharedCacheRobot << " ";
+        }
+        FOREACHC(itweight, _cache->GetWeights()) {
+            ss << *itweight << " ";
+        }
+        ss << _cache->GetMaxDistance() << " " << _cache->GetBase() << " ";
+
+        // static state of the other bodies, also re-register the change callbacks so new bodies are tracked
+        _vSharedCacheBodyHandles.resize(0);
+        std::vector<KinBodyPtr> vbodies;
+        GetEnv()->GetBodies(vbodies);
+        std::vector<dReal> vdofvalues;
+        std::vector<uint8_t> venablestates;
+        FOREACHC(itbody, vbodies) {
+            const KinBodyPtr& pbody = *itbody;
+            if( pbody == _probot || !!_probot->IsGrabbing(*pbody) ) {
+                continue;
+            }
+            _vSharedCacheBodyHandles.push_back(pbody->RegisterChangeCallback(KinBody::Prop_LinkGeometry|KinBody::Prop_LinkEnable|KinBody::Prop_LinkTransforms, boost::bind(&CacheCollisionChecker::_SharedCacheBodyChanged, this, KinBodyWeakPtr(pbody))));
+            pbody->GetDOFValues(vdofvalues);
+            pbody->GetLinkEnableStates(venablestates);
+            ss << pbody->GetEnvironmentBodyIndex() << " " << pbody->GetName() << " " << pbody->GetKinematicsGeometryHash() << " " << pbody->GetTransform() << " ";
+            FOREACHC(itvalue, vdofvalues) {
+                ss << *itvalue << " ";
+            }
+            FOREACHC(itenable, venablestates) {
+                ss << (int)*itenable;
+            }
+            ss << " ";
+        }
+        _psharedcache = GetSharedCacheTree(utils::GetMD5HashString(ss.str()), _cache->GetWeights(), _cache->GetMaxDistance(), _cache->GetBase());
+        RAVELOG_VERBOSE_FORMAT("env=%d, using shared caches with %d env nodes and %d self nodes", GetEnv()->GetId()%_psharedcache->GetNumNodes()%_psharedselfcache->GetNumNodes());
+    }
+
+    void _ReleaseSharedCaches()
+    {
+        _psharedcache.reset();
+        _psharedselfcache.reset();
+        _vSharedCacheBodyHandles.clear();
+        _handleSharedCacheBodyAddRemove.reset();
+        _handleSharedCacheRobotChange.reset();
+        _bSharedCacheKeyDirty = true;
+    }
+
+    void _SetSharedCacheKeyDirty()
+    {
+        _bSharedCacheKeyDirty = true;
+    }
+
+    void _SharedCacheBodyAddRemove(KinBodyPtr pbody, int action)
+    {
+        _bSharedCacheKeyDirty = true;
+    }
+
+    void _SharedCacheBodyChanged(KinBodyWeakPtr pweakbody)
+    {
+        KinBodyPtr pbody = pweakbody.lock();
+        // bodies grabbed by the robot move with it and are part of the robot key
+        if( !!pbody && !!_probot && !!_probot->IsGrabbing(*pbody) ) {
+            return;
+        }
+        _bSharedCacheKeyDirty = true;
+    }
+
+    /// \brief queries the shared cache with conf, the links returned are converted to the links of this environment
+    ///
+    /// \param cache the local cache giving the thresholds
+    /// \return same as ConfigurationCache::CheckCollision
+    int _CheckSharedCacheCollision(const SharedCacheTree& sharedcache, const ConfigurationCache& cache, const std::vector<dReal>& conf, KinBody::LinkConstPtr& robotlink, KinBody::LinkConstPtr& collidinglink, dReal& closestdist)
+    {
+        int robotlinkindex = -1, collidingbodyindex = -1, collidinglinkindex = -1;
+        int ret = sharedcache.CheckCollision(conf, cache.GetCollisionThresh(), cache.GetFreeSpaceThresh(), _vSharedCurrentLevelNodes, _vSharedNextLevelNodes, robotlinkindex, collidingbodyindex, collidinglinkindex, closestdist);
+        if( ret != 1 ) {
+            return ret;
+        }
+
+        if( robotlinkindex >= 0 && robotlinkindex < (int)_probot->GetLinks().size() ) {
+            robotlink = _probot->GetLinks()[robotlinkindex];
+        }
+        else {
+            robotlink.reset();
+        }
+        // the node might have been inserted by another environment, the key guarantees that its bodies have the same environment body indices
+        KinBodyPtr pcollidingbody;
+        if( collidingbodyindex > 0 ) {
+            pcollidingbody = GetEnv()->GetBodyFromEnvironmentBodyIndex(collidingbodyindex);
+        }
+        if( !!pcollidingbody && collidinglinkindex >= 0 && collidinglinkindex < (int)pcollidingbody->GetLinks().size() ) {
+            collidinglink = pcollidingbody->GetLinks()[collidinglinkindex];
+        }
+        else {
+            collidinglink.reset();
+        }
+        return ret;
+    }
+
+    /// \brief inserts conf into the shared cache with the insertion distance of the local cache, see ConfigurationCache::InsertConfiguration
+    void _InsertSharedCacheConfiguration(SharedCacheTree& sharedcache, const ConfigurationCache& cache, const std::vector<dReal>& conf, CollisionReportPtr report)
+    {
+        if( !!report ) {
+            if( !!report->plink2 && report->plink2->GetParent() == _probot ) {
+                std::swap(report->plink1, report->plink2);
+            }
+        }
+        sharedcache.InsertNode(conf, report, !report ? cache.GetFreeSpaceThresh()*cache.GetInsertionDistanceMult() : cache.GetCollisionThresh()*cache.GetInsertionDistanceMult());
+    }
+
     std::vector<dReal> _dofvals;
     std::vector<KinBodyPtr> _vGrabbedBodies;
     std::vector<int> _dofindices;
@@ -691,6 +920,14 @@ protected:
     ostringstream _oss;
 
     UserDataPtr _handleRobotDOFChange;
+
+    bool _bUseSharedCache; ///< if true, _psharedcache and _psharedselfcache are used instead of the local caches
+    bool _bSharedCacheKeyDirty; ///< if true, the state the shared caches depend on changed and they have to be looked up again
+    SharedCacheTreePtr _psharedcache, _psharedselfcache;
+    Transform _tSharedCacheRobot; ///< the robot transform when _psharedcache was looked up
+    std::vector< std::pair<CacheTreeNodePtr, dReal> > _vSharedCurrentLevelNodes, _vSharedNextLevelNodes; ///< buffers for querying the shared caches
+    UserDataPtr _handleSharedCacheBodyAddRemove, _handleSharedCacheRobotChange;
+    std::vector<UserDataPtr> _vSharedCacheBodyHandles;
 };
 
 CollisionCheckerBasePtr CreateCacheCollisionChecker(EnvironmentBasePtr penv, std::istream& sinput)
@@ -17,6 +17,8 @@
 #include <boost/lexical_cast.hpp>
 
 #include <boost/multi_array.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <algorithm>
 
 using boost::multi_array;
@@ -28,6 +30,8 @@ inline dReal Sqr(dReal x) {
     return x*x;
 }
 
+static const size_t s_nPoolNodesBlockSize = 1024; ///< number of nodes of the first block of the pool, following blocks double in size
+
 CacheTreeNode::CacheTreeNode(const std::vector<dReal>& cs, Vector* plinkspheres)
 {
     std::copy(cs.begin(), cs.end(), _pcstate);
@@ -37,9 +41,13 @@ CacheTreeNode::CacheTreeNode(const std::vector<dReal>& cs, Vector* plinkspheres)
 //    _approxnn.first = CacheTreeNodePtr();
 //    _approxnn.second = std::numeric_limits<float>::infinity();
     _conftype = CNT_Unknown;
+    _collidingbodyindex = -1;
+    _collidinglinkindex = -1;
     _robotlinkindex = -1;
     _level = 0;
+    _levelindex = -1;
     _hasselfchild = 0;
+    _isrootorphan = 0;
     _usenn = 1;
     _hitcount = 0;
 }
@@ -49,9 +57,13 @@ CacheTreeNode::CacheTreeNode(const dReal* pstate, int dof, Vector* plinkspheres)
     std::copy(pstate, pstate+dof, _pcstate);
     _plinkspheres = plinkspheres;
     _conftype = CNT_Unknown;
+    _collidingbodyindex = -1;
+    _collidinglinkindex = -1;
     _robotlinkindex = -1;
     _level = 0;
+    _levelindex = -1;
     _hasselfchild = 0;
+    _isrootorphan = 0;
     _usenn = 1;
     _hitcount = 0;
 }
@@ -61,16 +73,40 @@ void CacheTreeNode::SetCollisionInfo(CollisionReportPtr report)
     if( !!report ) {
         _collidinglinktrans = report->plink1->GetTransform();
         _robotlinkindex = report->plink1->GetIndex();
-        _collidinglink = report->plink2;
+        KinBodyPtr pcollidingbody;
+        if( !!report->plink2 ) {
+            pcollidingbody = report->plink2->GetParent(true);
+        }
+        if( !!pcollidingbody ) {
+            _collidingbodyindex = pcollidingbody->GetEnvironmentBodyIndex();
+            _collidinglinkindex = report->plink2->GetIndex();
+        }
+        else {
+            _collidingbodyindex = -1;
+            _collidinglinkindex = -1;
+        }
         _conftype = CNT_Collision;
     }
     else {
         _conftype = CNT_Free;
-        _collidinglink.reset();
+        _collidingbodyindex = -1;
+        _collidinglinkindex = -1;
         _robotlinkindex = 0;
     }
 }
 
+KinBody::LinkConstPtr CacheTreeNode::GetCollidingLink(EnvironmentBaseConstPtr penv) const
+{
+    if( _collidingbodyindex <= 0 ) {
+        return KinBody::LinkConstPtr();
+    }
+    KinBodyPtr pcollidingbody = penv->GetBodyFromEnvironmentBodyIndex(_collidingbodyindex);
+    if( !pcollidingbody || _collidinglinkindex < 0 || _collidinglinkindex >= (int)pcollidingbody->GetLinks().size() ) {
+        return KinBody::LinkConstPtr();
+    }
+    return pcollidingbody->GetLinks()[_collidinglinkindex];
+}
+
 void CacheTreeNode::SetCollisionInfo(int robotlinkindex, int type)
 {
     _robotlinkindex = robotlinkindex;
@@ -106,7 +142,7 @@ void CacheTreeNode::SetCollisionInfo(int robotlinkindex, int type)
 
 CacheTree::CacheTree(int statedof)
 {
-    _poolNodes.reset(new boost::pool<>(sizeof(CacheTreeNode)+sizeof(dReal)*statedof));
+    _poolNodes.reset(new boost::pool<>(sizeof(CacheTreeNode)+sizeof(dReal)*statedof, s_nPoolNodesBlockSize));
     _vnodes.resize(0);
     _dummycs.resize(0);
     _fulldirname.resize(0);
@@ -139,8 +175,8 @@ void CacheTree::Init(const std::vector<dReal>& weights, dReal maxdistance)
     _minlevel = _maxlevel - 1;
     _fMaxLevelBound = RavePow(_base, _maxlevel);
     int enclevel = _EncodeLevel(_maxlevel);
-    if( enclevel >= (int)_vsetLevelNodes.size() ) {
-        _vsetLevelNodes.resize(enclevel+1);
+    if( enclevel >= (int)_vvLevelNodes.size() ) {
+        _vvLevelNodes.resize(enclevel+1);
     }
 }
 
@@ -153,21 +189,23 @@ void CacheTree::Reset()
     _mapNodeIndices.clear();
     _collidingbodyname.resize(0);
 
-    // make sure all children are deleted
-    for(size_t ilevel = 0; ilevel < _vsetLevelNodes.size(); ++ilevel) {
-        FOREACH(itnode, _vsetLevelNodes[ilevel]) {
-            (*itnode)->~CacheTreeNode();
+    // make sure all children are deleted. a node can be referenced by the root level without belonging to it, so only destroy it from its own level
+    for(size_t ilevel = 0; ilevel < _vvLevelNodes.size(); ++ilevel) {
+        FOREACH(itnode, _vvLevelNodes[ilevel]) {
+            if( _EncodeLevel((*itnode)->_level) == (int)ilevel ) {
+                (*itnode)->~CacheTreeNode();
+            }
         }
     }
-    FOREACH(itchildren, _vsetLevelNodes) {
-        itchildren->clear();
+    FOREACH(itlevelnodes, _vvLevelNodes) {
+        itlevelnodes->clear(); // keep the capacity
     }
     FOREACH(itnode, _vnodes) {
         (*itnode)->~CacheTreeNode();
     }
     // purge_memory leaks!
     //_poolNodes.purge_memory();
-    _poolNodes.reset(new boost::pool<>(sizeof(CacheTreeNode)+sizeof(dReal)*_statedof));
+    _poolNodes.reset(new boost::pool<>(sizeof(CacheTreeNode)+sizeof(dReal)*_statedof, s_nPoolNodesBlockSize));
     //_pNodesPool.reset(new boost::pool<>(sizeof(Node)+_dof*sizeof(dReal)));
     _numnodes = 0;
 }
@@ -209,7 +247,8 @@ CacheTreeNodePtr CacheTree::_CloneCacheTreeNode(CacheTreeNodeConstPtr refnode)
     clonenode->_conftype = refnode->_conftype;
     clonenode->_hitcount = refnode->_hitcount;
     if( clonenode->IsInCollision() ) {
-        clonenode->_collidinglink = refnode->_collidinglink;
+        clonenode->_collidingbodyindex = refnode->_collidingbodyindex;
+        clonenode->_collidinglinkindex = refnode->_collidinglinkindex;
         clonenode->_collidinglinktrans = refnode->_collidinglinktrans;
         clonenode->_robotlinkindex = refnode->_robotlinkindex;
     }
@@ -238,6 +277,66 @@ dReal CacheTree::_ComputeDistance2(const dReal* cstatei, const dReal* cstatef) c
     return distance;
 }
 
+dReal CacheTree::_ComputeDistance2Bounded(const dReal* cstatei, const dReal* cstatef, dReal bound2) const
+{
+    dReal distance = 0;
+    for (size_t i = 0; i < _weights.size(); ++i) {
+        dReal f = (cstatei[i] - cstatef[i]) * _weights[i];
+        distance += f*f;
+        if( distance > bound2 ) {
+            break;
+        }
+    }
+    return distance;
+}
+
+void CacheTree::_AddNodeToLevel(CacheTreeNodePtr node)
+{
+    int enclevel = _EncodeLevel(node->_level);
+    if( enclevel >= (int)_vvLevelNodes.size() ) {
+        _vvLevelNodes.resize(enclevel+1);
+    }
+    std::vector<CacheTreeNodePtr>& vlevelnodes = _vvLevelNodes[enclevel];
+    node->_levelindex = (int)vlevelnodes.size();
+    vlevelnodes.push_back(node);
+}
+
+void CacheTree::_RemoveNodeFromLevel(CacheTreeNodePtr node)
+{
+    std::vector<CacheTreeNodePtr>& vlevelnodes = _vvLevelNodes.at(_EncodeLevel(node->_level));
+    OPENRAVE_ASSERT_OP(node->_levelindex,<,(int)vlevelnodes.size());
+    BOOST_ASSERT(vlevelnodes[node->_levelindex] == node);
+    CacheTreeNodePtr lastnode = vlevelnodes.back();
+    vlevelnodes[node->_levelindex] = lastnode;
+    if( lastnode->_level == node->_level ) {
+        lastnode->_levelindex = node->_levelindex;
+    }
+    vlevelnodes.pop_back();
+    node->_levelindex = -1;
+    if( node->_isrootorphan ) {
+        // rare, so ok to search
+        std::vector<CacheTreeNodePtr>& vrootnodes = _vvLevelNodes.at(_EncodeLevel(_maxlevel));
+        std::vector<CacheTreeNodePtr>::iterator itnode = find(vrootnodes.begin(), vrootnodes.end(), node);
+        if( itnode != vrootnodes.end() ) {
+            *itnode = vrootnodes.back();
+            if( _EncodeLevel((*itnode)->_level) == _EncodeLevel(_maxlevel) ) {
+                (*itnode)->_levelindex = itnode - vrootnodes.begin();
+            }
+            vrootnodes.pop_back();
+        }
+        node->_isrootorphan = 0;
+    }
+}
+
+bool CacheTree::_IsNodeInLevel(CacheTreeNodeConstPtr node, int enclevel) const
+{
+    if( _EncodeLevel(node->_level) == enclevel ) {
+        return node->_levelindex >= 0;
+    }
+    // orphaned children of a removed root are kept on the root level without changing their level
+    return enclevel == _EncodeLevel(_maxlevel) && node->_isrootorphan;
+}
+
 void CacheTree::SetWeights(const std::vector<dReal>& weights)
 {
     Reset();
@@ -252,8 +351,8 @@ void CacheTree::SetMaxDistance(dReal maxdistance)
     _minlevel = _maxlevel - 1;
     _fMaxLevelBound = RavePow(_base, _maxlevel);
     int enclevel = _EncodeLevel(_maxlevel);
-    if( enclevel >= (int)_vsetLevelNodes.size() ) {
-        _vsetLevelNodes.resize(enclevel+1);
+    if( enclevel >= (int)_vvLevelNodes.size() ) {
+        _vvLevelNodes.resize(enclevel+1);
     }
 }
 
@@ -269,8 +368,8 @@ void CacheTree::SetBase(dReal base)
     _minlevel = _maxlevel - 1;
     _fMaxLevelBound = RavePow(_base, _maxlevel);
     int enclevel = _EncodeLevel(_maxlevel);
-    if( enclevel >= (int)_vsetLevelNodes.size() ) {
-        _vsetLevelNodes.resize(enclevel+1);
+    if( enclevel >= (int)_vvLevelNodes.size() ) {
+        _vvLevelNodes.resize(enclevel+1);
     }
 }
 
@@ -290,7 +389,7 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
     // traverse all levels gathering up the children at each level
     dReal fLevelBound2 = Sqr(_fMaxLevelBound);
     _vCurrentLevelNodes.resize(1);
-    _vCurrentLevelNodes[0].first = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
+    _vCurrentLevelNodes[0].first = _GetRootNode();
     _vCurrentLevelNodes[0].second = _ComputeDistance2(pquerystate, _vCurrentLevelNodes[0].first->GetConfigurationState());
     if( (conftype == CNT_Any || _vCurrentLevelNodes[0].first->GetType() == conftype) && _vCurrentLevelNodes[0].first->_usenn ) {
         pbestnode = _vCurrentLevelNodes[0].first;
@@ -342,6 +441,16 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
 }
 
 std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::vector<dReal>& vquerystate, dReal collisionthresh, dReal freespacethresh) const
+{
+    return _FindNearestNode(vquerystate, collisionthresh, freespacethresh, _vCurrentLevelNodes, _vNextLevelNodes, true);
+}
+
+std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::vector<dReal>& vquerystate, dReal collisionthresh, dReal freespacethresh, std::vector< std::pair<CacheTreeNodePtr, dReal> >& vCurrentLevelNodes, std::vector< std::pair<CacheTreeNodePtr, dReal> >& vNextLevelNodes) const
+{
+    return _FindNearestNode(vquerystate, collisionthresh, freespacethresh, vCurrentLevelNodes, vNextLevelNodes, false);
+}
+
+std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::_FindNearestNode(const std::vector<dReal>& vquerystate, dReal collisionthresh, dReal freespacethresh, std::vector< std::pair<CacheTreeNodePtr, dReal> >& vCurrentLevelNodes, std::vector< std::pair<CacheTreeNodePtr, dReal> >& vNextLevelNodes, bool bUpdateHitCount) const
 {
     std::pair<CacheTreeNodeConstPtr, dReal> bestnode;
     bestnode.first = NULL;
@@ -359,12 +468,14 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
     int currentlevel = _maxlevel; // where the root node is
     dReal fLevelBound = _fMaxLevelBound;
     {
-        CacheTreeNodePtr proot = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
+        CacheTreeNodePtr proot = _GetRootNode();
         dReal curdist2 = _ComputeDistance2(pquerystate, proot->GetConfigurationState());
         if( proot->_usenn ) {
             ConfigurationNodeType cntype = proot->GetType();
             if( cntype == CNT_Collision && curdist2 <= collisionthresh2 ) {
-                proot->_hitcount++;
+                if( bUpdateHitCount ) {
+                    proot->_hitcount++;
+                }
                 return make_pair(proot,RaveSqrt(curdist2));
             }
             else if( cntype == CNT_Free && curdist2 <= freespacethresh2 ) {
@@ -372,26 +483,29 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
                 bestnode = make_pair(proot,RaveSqrt(curdist2));
             }
         }
-        _vCurrentLevelNodes.resize(1);
-        _vCurrentLevelNodes[0].first = proot;
-        _vCurrentLevelNodes[0].second = curdist2;
+        vCurrentLevelNodes.resize(1);
+        vCurrentLevelNodes[0].first = proot;
+        vCurrentLevelNodes[0].second = curdist2;
     }
-    dReal pruneradius2 = Sqr(_maxdistance); // the radius to prune all _vCurrentLevelNodes when going through them. Equivalent to min(query,children) + levelbound from the previous iteration
-    while(_vCurrentLevelNodes.size() > 0 ) {
-        _vNextLevelNodes.resize(0);
+    dReal pruneradius2 = Sqr(_maxdistance); // the radius to prune all vCurrentLevelNodes when going through them. Equivalent to min(query,children) + levelbound from the previous iteration
+    while(vCurrentLevelNodes.size() > 0 ) {
+        vNextLevelNodes.resize(0);
         dReal minchilddist=_maxdistance;
-        FOREACH(itcurrentnode, _vCurrentLevelNodes) {
+        FOREACH(itcurrentnode, vCurrentLevelNodes) {
             if( itcurrentnode->second > pruneradius2 ) {
                 continue;
             }
             dReal comparedist2 = Sqr(minchilddist + fLevelBound);
             // only take the children whose distances are within the bound
             FOREACHC(itchild, itcurrentnode->first->_vchildren) {
-                dReal curdist2 = _ComputeDistance2(pquerystate, (*itchild)->GetConfigurationState());
+                // children further than all the bounds are not used, so do not need their exact distance
+                dReal curdist2 = _ComputeDistance2Bounded(pquerystate, (*itchild)->GetConfigurationState(), max(comparedist2, max(collisionthresh2, freespacethresh2)));
                 if( (*itchild)->_usenn ) {
                     ConfigurationNodeType cntype = (*itchild)->GetType();
                     if( cntype == CNT_Collision && curdist2 <= collisionthresh2 ) {
-                        (*itchild)->_hitcount++;
+                        if( bUpdateHitCount ) {
+                            (*itchild)->_hitcount++;
+                        }
                         return make_pair(*itchild, RaveSqrt(curdist2));
                     }
                     else if( cntype == CNT_Free && curdist2 <= freespacethresh2 ) {
@@ -402,7 +516,7 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
                     }
                 }
                 if( curdist2 < comparedist2 ) {
-                    _vNextLevelNodes.emplace_back(*itchild,  curdist2);
+                    vNextLevelNodes.emplace_back(*itchild,  curdist2);
                     if( Sqr(minchilddist) > curdist2 ) {
                         minchilddist = RaveSqrt(curdist2);
                         comparedist2 = Sqr(minchilddist + fLevelBound);
@@ -411,7 +525,7 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
             }
         }
 
-        _vCurrentLevelNodes.swap(_vNextLevelNodes);
+        vCurrentLevelNodes.swap(vNextLevelNodes);
         pruneradius2 = Sqr(minchilddist + fLevelBound);
         currentlevel -= 1;
         fLevelBound *= _fBaseInv;
@@ -432,14 +546,14 @@ int CacheTree::InsertNode(const std::vector<dReal>& cs, CollisionReportPtr repor
     // if there is no root, make this the root, otherwise call the lowlevel  insert
     if( _numnodes == 0 ) {
         // no root
-        _vsetLevelNodes.at(_EncodeLevel(_maxlevel)).insert(nodein); // add to the level
-        _numnodes += 1;
         nodein->_level = _maxlevel;
+        _AddNodeToLevel(nodein); // add to the level
+        _numnodes += 1;
         return 1;
     }
 
     _vCurrentLevelNodes.resize(1);
-    _vCurrentLevelNodes[0].first = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
+    _vCurrentLevelNodes[0].first = _GetRootNode();
     _vCurrentLevelNodes[0].second = _ComputeDistance2(_vCurrentLevelNodes[0].first->GetConfigurationState(), &cs[0]);
     int nParentFound = _Insert(nodein, _vCurrentLevelNodes, _maxlevel, Sqr(_fMaxLevelBound), Sqr(fMinSeparationDist));
     if( nParentFound != 1 ) {
@@ -460,7 +574,7 @@ int CacheTree::_Insert(CacheTreeNodePtr nodein, const std::vector< std::pair<Cac
     int enclevel = _EncodeLevel(currentlevel);
     dReal fChildLevelBound2 = fLevelBound2*Sqr(_fBaseChildMult);
     dReal fEpsilon = g_fEpsilon*_maxdistance; // min distance
-    if( enclevel < (int)_vsetLevelNodes.size() ) {
+    if( enclevel < (int)_vvLevelNodes.size() ) {
         // build the level below
         _vNextLevelNodes.resize(0);
         FOREACHC(itcurrentnode, vCurrentLevelNodes) {
@@ -578,11 +692,7 @@ bool CacheTree::_InsertDirectly(CacheTreeNodePtr nodein, CacheTreeNodePtr parent
         clonenode->_level = parentnode->_level-1;
         parentnode->_vchildren.push_back(clonenode);
         parentnode->_hasselfchild = 1;
-        int encclonelevel = _EncodeLevel(clonenode->_level);
-        if( encclonelevel >= (int)_vsetLevelNodes.size() ) {
-            _vsetLevelNodes.resize(encclonelevel+1);
-        }
-        _vsetLevelNodes.at(encclonelevel).insert(clonenode);
+        _AddNodeToLevel(clonenode);
         _numnodes +=1;
         parentnode = clonenode;
     }
@@ -591,11 +701,7 @@ bool CacheTree::_InsertDirectly(CacheTreeNodePtr nodein, CacheTreeNodePtr parent
         parentnode->_hasselfchild = 1;
     }
     nodein->_level = insertlevel;
-    int enclevel2 = _EncodeLevel(nodein->_level);
-    if( enclevel2 >= (int)_vsetLevelNodes.size() ) {
-        _vsetLevelNodes.resize(enclevel2+1);
-    }
-    _vsetLevelNodes.at(enclevel2).insert(nodein);
+    _AddNodeToLevel(nodein);
     parentnode->_vchildren.push_back(nodein);
 
     if( _minlevel > nodein->_level ) {
@@ -612,7 +718,7 @@ bool CacheTree::RemoveNode(CacheTreeNodeConstPtr _removenode)
 
     CacheTreeNodePtr removenode = const_cast<CacheTreeNodePtr>(_removenode);
 
-    CacheTreeNodePtr proot = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
+    CacheTreeNodePtr proot = _GetRootNode();
     if( _numnodes == 1 && removenode == proot ) {
         Reset();
         return true;
@@ -631,9 +737,13 @@ bool CacheTree::RemoveNode(CacheTreeNodeConstPtr _removenode)
     }
     if( removenode == proot ) {
         BOOST_ASSERT(_vvCacheNodes.at(0).size()==2); // instead of root, another node should have been added
-        BOOST_ASSERT(_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).size()==1);
-        //_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).clear();
-        _vsetLevelNodes.at(_EncodeLevel(_maxlevel)).erase(proot);
+        std::vector<CacheTreeNodePtr>& vrootnodes = _vvLevelNodes.at(_EncodeLevel(_maxlevel));
+        BOOST_ASSERT(vrootnodes.size()==1);
+        // proot is already deleted, so only compare the pointer
+        std::vector<CacheTreeNodePtr>::iterator itroot = find(vrootnodes.begin(), vrootnodes.end(), proot);
+        if( itroot != vrootnodes.end() ) {
+            vrootnodes.erase(itroot);
+        }
         bRemoved = true;
         _numnodes--;
     }
@@ -644,12 +754,11 @@ bool CacheTree::RemoveNode(CacheTreeNodeConstPtr _removenode)
 bool CacheTree::_Remove(CacheTreeNodePtr removenode, std::vector< std::vector<CacheTreeNodePtr> >& vvCoverSetNodes, int currentlevel, dReal fLevelBound2)
 {
     int enclevel = _EncodeLevel(currentlevel);
-    if( enclevel >= (int)_vsetLevelNodes.size() ) {
+    if( enclevel >= (int)_vvLevelNodes.size() ) {
         return false;
     }
 
     // build the level below
-    std::set<CacheTreeNodePtr>& setLevelRawChildren = _vsetLevelNodes.at(enclevel);
     int coverindex = _maxlevel-(currentlevel-1);
     if( coverindex >= (int)vvCoverSetNodes.size() ) {
         vvCoverSetNodes.resize(coverindex+(_maxlevel-_minlevel)+1);
@@ -660,7 +769,7 @@ bool CacheTree::_Remove(CacheTreeNodePtr removenode, std::vector< std::vector<Ca
     bool bfound = false;
     FOREACH(itcurrentnode, vvCoverSetNodes.at(coverindex-1)) {
         // only take the children whose distances are within the bound
-        if( setLevelRawChildren.find(*itcurrentnode) != setLevelRawChildren.end() ) {
+        if( _IsNodeInLevel(*itcurrentnode, enclevel) ) {
             std::vector<CacheTreeNodePtr>::iterator itchild = (*itcurrentnode)->_vchildren.begin();
             while(itchild != (*itcurrentnode)->_vchildren.end() ) {
                 dReal curdist = _ComputeDistance2(removenode->GetConfigurationState(), (*itchild)->GetConfigurationState());
@@ -710,11 +819,7 @@ bool CacheTree::_Remove(CacheTreeNodePtr removenode, std::vector< std::vector<Ca
                         clonenode->_level = nodechild->_level+1;
                         clonenode->_vchildren.push_back(nodechild);
                         clonenode->_hasselfchild = 1;
-                        int encclonelevel = _EncodeLevel(clonenode->_level);
-                        if( encclonelevel >= (int)_vsetLevelNodes.size() ) {
-                            _vsetLevelNodes.resize(encclonelevel+1);
-                        }
-                        _vsetLevelNodes.at(encclonelevel).insert(clonenode);
+                        _AddNodeToLevel(clonenode);
                         _numnodes +=1;
                         vvCoverSetNodes.at(_maxlevel-clonenode->_level).push_back(clonenode);
                         nodechild = clonenode;
@@ -738,13 +843,14 @@ bool CacheTree::_Remove(CacheTreeNodePtr removenode, std::vector< std::vector<Ca
             if( !closestNode ) {
                 BOOST_ASSERT(parentlevel>_maxlevel);
                 // occurs when root node is being removed and new children have no where to go?
-                _vsetLevelNodes.at(_EncodeLevel(_maxlevel)).insert(*itchild);
+                // the child keeps its level and _levelindex, see _IsNodeInLevel
+                (*itchild)->_isrootorphan = 1;
+                _vvLevelNodes.at(_EncodeLevel(_maxlevel)).push_back(*itchild);
                 vvCoverSetNodes.at(0).push_back(*itchild);
             }
         }
         // remove the node
-        size_t erased = setLevelRawChildren.erase(removenode);
-        BOOST_ASSERT(erased==1);
+        _RemoveNodeFromLevel(removenode);
         bRemoved = true;
         _numnodes--;
     }
@@ -757,7 +863,7 @@ void CacheTree::GetNodeValues(std::vector<dReal>& vals) const
     if( (int)vals.capacity() < _numnodes*_statedof) {
         vals.reserve(_numnodes*_statedof);
     }
-    FOREACH(itlevelnodes, _vsetLevelNodes) {
+    FOREACH(itlevelnodes, _vvLevelNodes) {
         FOREACH(itnode, *itlevelnodes) {
             vals.insert(vals.end(), (*itnode)->GetConfigurationState(), (*itnode)->GetConfigurationState()+_statedof);
         }
@@ -768,7 +874,7 @@ void CacheTree::GetNodeValuesList(std::vector<CacheTreeNodePtr>& lvals)
 {
     lvals.resize(0);
     if (_numnodes > 0) {
-        FOREACH(itlevelnodes, _vsetLevelNodes) {
+        FOREACH(itlevelnodes, _vvLevelNodes) {
             lvals.insert(lvals.end(), itlevelnodes->begin(), itlevelnodes->end());
         }
     }
@@ -778,7 +884,7 @@ int CacheTree::RemoveCollisionConfigurations()
 
     int nremoved=0;
     if (_numnodes > 0) {
-        FOREACH(itlevelnodes, _vsetLevelNodes) {
+        FOREACH(itlevelnodes, _vvLevelNodes) {
             FOREACH(itnode, *itlevelnodes) {
                 (*itnode)->SetType(CNT_Unknown);
                 nremoved += 1;
@@ -788,164 +894,373 @@ int CacheTree::RemoveCollisionConfigurations()
     return nremoved;
 }
 
-int CacheTree::SaveCache(std::string filename)
+static const char s_szCacheTreeFileMagic[8] = {'O','R','C','T','R','E','E','\0'};
+static const uint32_t s_nCacheTreeFileVersion = 1;
+
+/// \brief header of a binary cache file. It is followed by sections that each start on an 8 byte boundary:
+///
+/// validation hash (char[hashlength]), weights (dReal[statedof]), colliding bodies (numbodies x {uint32 namelength, uint32 hashlength, name, kinematics geometry hash}),
+/// nodes (CacheTreeFileNode[numrecords]), states (dReal[numrecords*statedof]), children (int32[numchildindices]), level sizes (int32[numlevels]), level nodes (int32[sum of level sizes])
+struct CacheTreeFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t realsize; ///< sizeof(dReal) of the writer
+    int32_t statedof;
+    int32_t maxlevel, minlevel;
+    int32_t numnodes; ///< CacheTree::_numnodes
+    int32_t numrecords; ///< number of CacheTreeFileNode records
+    int32_t numchildindices;
+    int32_t numlevels;
+    int32_t numbodies;
+    uint32_t hashlength;
+    uint32_t reserved;
+    dReal base, maxdistance, fMaxLevelBound;
+};
+
+/// \brief one node of the tree in a binary cache file
+struct CacheTreeFileNode
+{
+    int16_t level;
+    uint8_t hasselfchild;
+    uint8_t usenn;
+    int32_t conftype;
+    int32_t robotlinkindex;
+    int32_t collidingbodyindex; ///< index into the colliding bodies section, -1 if not in collision
+    int32_t collidinglinkindex;
+    int32_t childoffset; ///< offset of the first child into the children section
+    int32_t numchildren;
+};
+
+/// \brief bounds checked sequential access to the sections of a mapped cache file
+class CacheTreeFileReader
+{
+public:
+    CacheTreeFileReader(const uint8_t* pdata, size_t size) : _pcur(pdata), _pbegin(pdata), _pend(pdata+size) {
+    }
+
+    /// \brief returns a pointer to count consecutive elements of T, or NULL if the file is too short
+    template <typename T>
+    const T* Read(size_t count)
+    {
+        if( (size_t)(_pend - _pcur) < sizeof(T)*count ) {
+            return NULL;
+        }
+        const T* p = reinterpret_cast<const T*>(_pcur);
+        _pcur += sizeof(T)*count;
+        return p;
+    }
+
+    /// \brief moves to the next 8 byte boundary where every section starts
+    void Align()
+    {
+        size_t offset = (_pcur - _pbegin + 7) & ~(size_t)7;
+        _pcur = offset < (size_t)(_pend - _pbegin) ? _pbegin + offset : _pend;
+    }
+
+private:
+    const uint8_t* _pcur, *_pbegin, *_pend;
+};
+
+static void _WriteCacheTreeSection(std::ostream& f, const void* pdata, size_t size)
+{
+    if( size > 0 ) {
+        f.write(reinterpret_cast<const char*>(pdata), size);
+    }
+    static const char s_padding[8] = {0};
+    size_t offset = (size_t)f.tellp();
+    if( offset & 7 ) {
+        f.write(s_padding, 8 - (offset & 7));
+    }
+}
+
+int CacheTree::SaveCache(const std::string& filename, EnvironmentBaseConstPtr penv, const std::string& validationhash)
 {
-    //std::lock_guard<std::mutex> lock(_mutexpool);
+    // a node can be referenced by the root level without belonging to it, so only nodes owned by their level get a record
     _mapNodeIndices.clear();
-    int index=0;
-    int knownnodes=0;
-    FOREACH(itlevelnodes, _vsetLevelNodes) {
-        FOREACH(itnode, *itlevelnodes) {
-            if( (*itnode)->_conftype != CNT_Unknown) {
-                knownnodes++;
+    int numrecords = 0;
+    for(size_t ilevel = 0; ilevel < _vvLevelNodes.size(); ++ilevel) {
+        FOREACH(itnode, _vvLevelNodes[ilevel]) {
+            if( _EncodeLevel((*itnode)->_level) == (int)ilevel ) {
+                _mapNodeIndices[*itnode] = numrecords++;
             }
-            _mapNodeIndices[*itnode] = index++;
         }
     }
 
-    _numnodes = knownnodes;
-    _fulldirname = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
+    std::vector<CacheTreeFileNode> vrecords(numrecords);
+    std::vector<dReal> vstates(numrecords*_statedof);
+    std::vector<int32_t> vchildindices, vlevelsizes(_vvLevelNodes.size()), vlevelindices;
+    std::vector<KinBodyPtr> vcollidingbodies;
+    vchildindices.reserve(numrecords);
+    vlevelindices.reserve(numrecords);
+    for(size_t ilevel = 0; ilevel < _vvLevelNodes.size(); ++ilevel) {
+        vlevelsizes[ilevel] = (int32_t)_vvLevelNodes[ilevel].size();
+        FOREACH(itnode, _vvLevelNodes[ilevel]) {
+            CacheTreeNodePtr pnode = *itnode;
+            int index = _mapNodeIndices[pnode];
+            vlevelindices.push_back(index);
+            if( _EncodeLevel(pnode->_level) != (int)ilevel ) {
+                continue;
+            }
 
-    RAVELOG_DEBUG_FORMAT("Writing cache to %s, size=%d", _fulldirname%_numnodes);
-    
-    FILE* pfile;
-    pfile = fopen(_fulldirname.c_str(),"wb");
-
-    fwrite(&_statedof, sizeof(_statedof), 1, pfile);
-    fwrite(&_weights[0], sizeof(_weights[0])*_weights.size(), 1, pfile);
-    fwrite(&_base, sizeof(_base), 1, pfile);
-    fwrite(&_fBaseInv, sizeof(_fBaseInv), 1, pfile);
-    fwrite(&_fBaseInv2, sizeof(_fBaseInv2), 1, pfile);
-    fwrite(&_fBaseChildMult, sizeof(_fBaseChildMult), 1, pfile);
-    fwrite(&_maxdistance, sizeof(_maxdistance), 1, pfile);
-    fwrite(&_maxlevel, sizeof(_maxlevel), 1, pfile);
-    fwrite(&_minlevel, sizeof(_minlevel), 1, pfile);
-    fwrite(&_numnodes, sizeof(_numnodes), 1, pfile);
-    fwrite(&_fMaxLevelBound, sizeof(_fMaxLevelBound), 1, pfile);
-
-    FOREACH(itlevelnodes, _vsetLevelNodes) {
-        FOREACH(itnode, *itlevelnodes) {
-            _newnode = *itnode;
-            // TODO save only configuration != CNT_Unknown without losing the validity of the tree
-            if (true) { //_newnode->_conftype != CNT_Unknown) {
-                fwrite(&_newnode->_level, sizeof(_newnode->_level), 1, pfile);
-                fwrite(_newnode->GetConfigurationState(), sizeof(dReal)*_statedof, 1, pfile);
-                fwrite(&_newnode->_conftype, sizeof(_newnode->_conftype), 1, pfile);
-
-                if (_newnode->_conftype == CNT_Collision ) {
-                    // note, this assumes the colliding body name never changes across environments, which is a false assumption
-                    _collidingbodyname = _newnode->GetCollidingLink()->GetParent()->GetName();
-                    int namelength = _collidingbodyname.size();
-                    fwrite(&namelength, sizeof(namelength), 1, pfile);
-                    fwrite(_collidingbodyname.c_str(), _collidingbodyname.size(), 1, pfile);
-                    int linkindex = _newnode->GetCollidingLink()->GetIndex();
-                    fwrite(&linkindex, sizeof(linkindex), 1, pfile);
-                    fwrite(&_newnode->_robotlinkindex, sizeof(_newnode->_robotlinkindex), 1, pfile);
+            CacheTreeFileNode& record = vrecords[index];
+            record.level = pnode->_level;
+            record.hasselfchild = pnode->_hasselfchild;
+            record.usenn = pnode->_usenn;
+            record.conftype = pnode->_conftype;
+            record.robotlinkindex = pnode->_robotlinkindex;
+            record.collidingbodyindex = -1;
+            record.collidinglinkindex = -1;
+            if( pnode->_conftype == CNT_Collision ) {
+                KinBody::LinkConstPtr pcollidinglink = pnode->GetCollidingLink(penv);
+                if( !!pcollidinglink ) {
+                    KinBodyPtr pcollidingbody = pcollidinglink->GetParent();
+                    std::vector<KinBodyPtr>::iterator itbody = find(vcollidingbodies.begin(), vcollidingbodies.end(), pcollidingbody);
+                    record.collidingbodyindex = itbody - vcollidingbodies.begin();
+                    if( itbody == vcollidingbodies.end() ) {
+                        vcollidingbodies.push_back(pcollidingbody);
+                    }
+                    record.collidinglinkindex = pnode->_collidinglinkindex;
                 }
-
-                fwrite(&_newnode->_hasselfchild, sizeof(_newnode->_hasselfchild), 1, pfile);
-                fwrite(&_newnode->_usenn, sizeof(_newnode->_usenn), 1, pfile);
-                int numchildren = _newnode->_vchildren.size();
-                fwrite(&numchildren, sizeof(numchildren), 1, pfile);
-
-                FOREACHC(itchild, (*itnode)->_vchildren) {
-                    int cindex = _mapNodeIndices[*itchild];
-                    fwrite(&cindex, sizeof(cindex), 1, pfile);
+                else {
+                    // body is gone, so cannot restore the collision
+                    record.conftype = CNT_Unknown;
+                    record.usenn = 0;
                 }
             }
+            record.childoffset = (int32_t)vchildindices.size();
+            record.numchildren = (int32_t)pnode->_vchildren.size();
+            FOREACHC(itchild, pnode->_vchildren) {
+                vchildindices.push_back(_mapNodeIndices[*itchild]);
+            }
+            std::copy(pnode->GetConfigurationState(), pnode->GetConfigurationState()+_statedof, vstates.begin()+index*_statedof);
         }
     }
+    _mapNodeIndices.clear();
 
-    fclose(pfile);
+    CacheTreeFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, s_szCacheTreeFileMagic, sizeof(header.magic));
+    header.version = s_nCacheTreeFileVersion;
+    header.realsize = sizeof(dReal);
+    header.statedof = _statedof;
+    header.maxlevel = _maxlevel;
+    header.minlevel = _minlevel;
+    header.numnodes = _numnodes;
+    header.numrecords = numrecords;
+    header.numchildindices = (int32_t)vchildindices.size();
+    header.numlevels = (int32_t)vlevelsizes.size();
+    header.numbodies = (int32_t)vcollidingbodies.size();
+    header.hashlength = validationhash.size();
+    header.base = _base;
+    header.maxdistance = _maxdistance;
+    header.fMaxLevelBound = _fMaxLevelBound;
 
+    _fulldirname = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
+    RAVELOG_DEBUG_FORMAT("Writing cache to %s, size=%d", _fulldirname%_numnodes);
+
+    std::ofstream f(_fulldirname.c_str(), std::ios::binary|std::ios::trunc);
+    if( !f ) {
+        RAVELOG_WARN_FORMAT("failed to open %s for writing cache", _fulldirname);
+        return 0;
+    }
+    _WriteCacheTreeSection(f, &header, sizeof(header));
+    _WriteCacheTreeSection(f, validationhash.c_str(), validationhash.size());
+    _WriteCacheTreeSection(f, &_weights[0], sizeof(dReal)*_weights.size());
+    std::string bodytable;
+    FOREACHC(itbody, vcollidingbodies) {
+        // colliding bodies are matched by name when loading, the hash makes sure the geometry did not change in the meantime
+        const std::string& name = (*itbody)->GetName();
+        const std::string& hash = (*itbody)->GetKinematicsGeometryHash();
+        uint32_t lengths[2] = { (uint32_t)name.size(), (uint32_t)hash.size() };
+        bodytable.append(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+        bodytable += name;
+        bodytable += hash;
+    }
+    _WriteCacheTreeSection(f, bodytable.c_str(), bodytable.size());
+    _WriteCacheTreeSection(f, vrecords.size() > 0 ? &vrecords[0] : NULL, sizeof(CacheTreeFileNode)*vrecords.size());
+    _WriteCacheTreeSection(f, vstates.size() > 0 ? &vstates[0] : NULL, sizeof(dReal)*vstates.size());
+    _WriteCacheTreeSection(f, vchildindices.size() > 0 ? &vchildindices[0] : NULL, sizeof(int32_t)*vchildindices.size());
+    _WriteCacheTreeSection(f, vlevelsizes.size() > 0 ? &vlevelsizes[0] : NULL, sizeof(int32_t)*vlevelsizes.size());
+    _WriteCacheTreeSection(f, vlevelindices.size() > 0 ? &vlevelindices[0] : NULL, sizeof(int32_t)*vlevelindices.size());
+    if( !f ) {
+        RAVELOG_WARN_FORMAT("failed to write cache to %s", _fulldirname);
+        return 0;
+    }
     return 1;
 }
 
-int CacheTree::LoadCache(std::string filename, EnvironmentBasePtr penv)
+int CacheTree::LoadCache(const std::string& filename, EnvironmentBasePtr penv, const std::string& validationhash)
 {
-    //std::lock_guard<std::mutex> lock(_mutexpool);
     _fulldirname = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
 
-    FILE* pfile = fopen(_fulldirname.c_str(),"rb");
-    size_t outs;
+    boost::interprocess::file_mapping filemapping;
+    boost::interprocess::mapped_region region;
+    try {
+        filemapping = boost::interprocess::file_mapping(_fulldirname.c_str(), boost::interprocess::read_only);
+        region = boost::interprocess::mapped_region(filemapping, boost::interprocess::read_only);
+    }
+    catch(const boost::interprocess::interprocess_exception& ex) {
+        RAVELOG_VERBOSE_FORMAT("could not map cache file %s: %s", _fulldirname%ex.what());
+        return 0;
+    }
+    region.advise(boost::interprocess::mapped_region::advice_sequential);
 
-    if (!pfile) {
+    // validate everything before touching the current tree
+    CacheTreeFileReader reader(static_cast<const uint8_t*>(region.get_address()), region.get_size());
+    const CacheTreeFileHeader* pheader = reader.Read<CacheTreeFileHeader>(1);
+    if( !pheader || memcmp(pheader->magic, s_szCacheTreeFileMagic, sizeof(pheader->magic)) != 0 ) {
+        RAVELOG_WARN_FORMAT("%s is not a cache file, ignoring", _fulldirname);
+        return 0;
+    }
+    if( pheader->version != s_nCacheTreeFileVersion || pheader->realsize != sizeof(dReal) ) {
+        RAVELOG_WARN_FORMAT("cache file %s has version %d and real size %d, but expected %d and %d, ignoring", _fulldirname%pheader->version%pheader->realsize%s_nCacheTreeFileVersion%sizeof(dReal));
+        return 0;
+    }
+    if( pheader->statedof != _statedof || pheader->numrecords < 0 || pheader->numchildindices < 0 || pheader->numlevels < 0 || pheader->numbodies < 0 ) {
+        RAVELOG_WARN_FORMAT("cache file %s has %d dof, but tree has %d, ignoring", _fulldirname%pheader->statedof%_statedof);
+        return 0;
+    }
+    reader.Align();
+    const char* phash = reader.Read<char>(pheader->hashlength);
+    if( !phash || validationhash != std::string(phash, pheader->hashlength) ) {
+        RAVELOG_WARN_FORMAT("cache file %s was saved for a different robot, ignoring", _fulldirname);
         return 0;
     }
+    reader.Align();
+    const dReal* pweights = reader.Read<dReal>(pheader->statedof);
+    reader.Align();
+
+    std::vector<KinBodyPtr> vcollidingbodies(pheader->numbodies);
+    for(int ibody = 0; ibody < pheader->numbodies; ++ibody) {
+        const uint32_t* plengths = reader.Read<uint32_t>(2);
+        const char* pname = !plengths ? NULL : reader.Read<char>(plengths[0]);
+        const char* pbodyhash = !pname ? NULL : reader.Read<char>(plengths[1]);
+        if( !pbodyhash ) {
+            RAVELOG_WARN_FORMAT("cache file %s is truncated, ignoring", _fulldirname);
+            return 0;
+        }
+        _collidingbodyname.assign(pname, plengths[0]);
+        vcollidingbodies[ibody] = penv->GetKinBody(_collidingbodyname);
+        if( !vcollidingbodies[ibody] ) {
+            RAVELOG_WARN_FORMAT("loading cache %s expected colliding body %s, but none found, ignoring", _fulldirname%_collidingbodyname);
+            return 0;
+        }
+        if( vcollidingbodies[ibody]->GetKinematicsGeometryHash() != std::string(pbodyhash, plengths[1]) ) {
+            RAVELOG_WARN_FORMAT("loading cache %s, colliding body %s geometry changed, ignoring", _fulldirname%_collidingbodyname);
+            return 0;
+        }
+    }
+    reader.Align();
+    const CacheTreeFileNode* precords = reader.Read<CacheTreeFileNode>(pheader->numrecords);
+    reader.Align();
+    const dReal* pstates = reader.Read<dReal>(pheader->numrecords*pheader->statedof);
+    reader.Align();
+    const int32_t* pchildindices = reader.Read<int32_t>(pheader->numchildindices);
+    reader.Align();
+    const int32_t* plevelsizes = reader.Read<int32_t>(pheader->numlevels);
+    reader.Align();
+    // every node is referenced by its own level and at most once more by the root level, so the sizes cannot add up to more than twice the records
+    size_t numlevelindices = 0;
+    for(int ilevel = 0; !!plevelsizes && ilevel < pheader->numlevels; ++ilevel) {
+        if( plevelsizes[ilevel] < 0 || numlevelindices + plevelsizes[ilevel] > 2*(size_t)pheader->numrecords ) {
+            RAVELOG_WARN_FORMAT("cache file %s is corrupted, ignoring", _fulldirname);
+            return 0;
+        }
+        numlevelindices += plevelsizes[ilevel];
+    }
+    const int32_t* plevelindices = reader.Read<int32_t>(numlevelindices);
+    if( !pweights || !precords || !pstates || !pchildindices || !plevelsizes || !plevelindices ) {
+        RAVELOG_WARN_FORMAT("cache file %s is truncated, ignoring", _fulldirname);
+        return 0;
+    }
+    for(int irecord = 0; irecord < pheader->numrecords; ++irecord) {
+        const CacheTreeFileNode& record = precords[irecord];
+        bool bvalidcollision = record.conftype != CNT_Collision || (record.collidingbodyindex >= 0 && record.collidingbodyindex < pheader->numbodies);
+        if( record.childoffset < 0 || record.numchildren < 0 || record.childoffset+record.numchildren > pheader->numchildindices || !bvalidcollision ) {
+            RAVELOG_WARN_FORMAT("cache file %s is corrupted, ignoring", _fulldirname);
+            return 0;
+        }
+    }
+    for(int ichild = 0; ichild < pheader->numchildindices; ++ichild) {
+        if( pchildindices[ichild] < 0 || pchildindices[ichild] >= pheader->numrecords ) {
+            RAVELOG_WARN_FORMAT("cache file %s is corrupted, ignoring", _fulldirname);
+            return 0;
+        }
+    }
+    for(size_t iindex = 0; iindex < numlevelindices; ++iindex) {
+        if( plevelindices[iindex] < 0 || plevelindices[iindex] >= pheader->numrecords ) {
+            RAVELOG_WARN_FORMAT("cache file %s is corrupted, ignoring", _fulldirname);
+            return 0;
+        }
+    }
 
     Reset();
-    outs = fread(&_statedof, sizeof(_statedof), 1, pfile);
-
-    _weights.resize(_statedof,1.0);
+    _weights.assign(pweights, pweights+pheader->statedof);
     _curconf.resize(_statedof,1.0);
-    outs = fread(&_weights[0], sizeof(_weights[0])*_weights.size(), 1, pfile);
-
-    outs = fread(&_base, sizeof(_base), 1, pfile);
-    outs = fread(&_fBaseInv, sizeof(_fBaseInv), 1, pfile);
-    outs = fread(&_fBaseInv2, sizeof(_fBaseInv2), 1, pfile);
-    outs = fread(&_fBaseChildMult, sizeof(_fBaseChildMult), 1, pfile);
-    outs = fread(&_maxdistance, sizeof(_maxdistance), 1, pfile);
-    outs = fread(&_maxlevel, sizeof(_maxlevel), 1, pfile);
-    outs = fread(&_minlevel, sizeof(_minlevel), 1, pfile);
-    outs = fread(&_numnodes, sizeof(_numnodes), 1, pfile);
-    outs = fread(&_fMaxLevelBound, sizeof(_fMaxLevelBound), 1, pfile);
-
-    int maxenclevel = max(_EncodeLevel(_maxlevel), _EncodeLevel(_minlevel));
-    _vsetLevelNodes.resize(maxenclevel+1);
-
-    _vnodes.resize(_numnodes);
-    _dummycs.resize(_statedof, 0);
-
-    for(int i = 0; i < _numnodes; ++i) {
-        _vnodes[i] = _CreateCacheTreeNode(_dummycs, CollisionReportPtr());
-    }
-
-    for (int inode = 0; inode < _numnodes; ++inode)
-    {
-        _newnode = _vnodes.at(inode);
-        outs = fread(&_newnode->_level, sizeof(_newnode->_level), 1, pfile);
-        outs = fread(_newnode->_pcstate, sizeof(dReal)*_statedof, 1, pfile);
-        outs = fread(&_newnode->_conftype, sizeof(_newnode->_conftype), 1, pfile);
-
-        if( _newnode->_conftype == CNT_Collision ) {
-            int namelength;
-            outs = fread(&namelength, sizeof(namelength), 1, pfile);
-            _collidingbodyname.resize(namelength);
-            outs = fread(&_collidingbodyname[0], namelength, 1, pfile);
-            int collidinglinkindex;
-            outs = fread(&collidinglinkindex, sizeof(collidinglinkindex), 1, pfile);
-            _pcollidingbody = penv->GetKinBody(_collidingbodyname);
-            if( !_pcollidingbody ) {
-                RAVELOG_WARN_FORMAT("loading cache expected colliding body %s, but none found", _collidingbodyname);
+    _base = pheader->base;
+    _fBaseInv = 1/_base;
+    _fBaseInv2 = 1/Sqr(_base);
+    _fBaseChildMult = 1/(_base-1);
+    _maxdistance = pheader->maxdistance;
+    _maxlevel = pheader->maxlevel;
+    _minlevel = pheader->minlevel;
+    _fMaxLevelBound = pheader->fMaxLevelBound;
+
+    // the records are already in tree order, so the nodes are created straight from the mapped arrays without going through the insertion
+    _vnodes.resize(pheader->numrecords);
+    for(int irecord = 0; irecord < pheader->numrecords; ++irecord) {
+        const CacheTreeFileNode& record = precords[irecord];
+        void* pmemory = _poolNodes->malloc();
+        CacheTreeNodePtr pnode = new (pmemory) CacheTreeNode(pstates+irecord*_statedof, _statedof, NULL);
+#ifdef _DEBUG
+        pnode->id = s_CacheTreeId++;
+#endif
+        pnode->_level = record.level;
+        pnode->_hasselfchild = record.hasselfchild;
+        pnode->_usenn = record.usenn;
+        pnode->_conftype = (ConfigurationNodeType)record.conftype;
+        pnode->_robotlinkindex = record.robotlinkindex;
+        if( pnode->_conftype == CNT_Collision ) {
+            const KinBodyPtr& pcollidingbody = vcollidingbodies[record.collidingbodyindex];
+            if( record.collidinglinkindex >= 0 && record.collidinglinkindex < (int)pcollidingbody->GetLinks().size() ) {
+                pnode->_collidingbodyindex = pcollidingbody->GetEnvironmentBodyIndex();
+                pnode->_collidinglinkindex = record.collidinglinkindex;
             }
             else {
-                _newnode->_collidinglink = _pcollidingbody->GetLinks().at(collidinglinkindex);
+                pnode->SetType(CNT_Unknown);
             }
-            outs = fread(&_newnode->_robotlinkindex, sizeof(_newnode->_robotlinkindex), 1, pfile);
         }
-
-        outs = fread(&_newnode->_hasselfchild, sizeof(_newnode->_hasselfchild), 1, pfile);
-        outs = fread(&_newnode->_usenn, sizeof(_newnode->_usenn), 1, pfile);
-        int numchildren;
-        outs = fread(&numchildren, sizeof(numchildren), 1, pfile);
-        _newnode->_vchildren.resize(numchildren);
-
-        // create the copies of the children and insert them
-        for(int i = 0; i < numchildren; ++i) {
-            int childid;
-            outs = fread(&childid, sizeof(childid), 1, pfile);
-            _newnode->_vchildren[i] = _vnodes.at(childid);
+        _vnodes[irecord] = pnode;
+    }
+    for(int irecord = 0; irecord < pheader->numrecords; ++irecord) {
+        const CacheTreeFileNode& record = precords[irecord];
+        CacheTreeNodePtr pnode = _vnodes[irecord];
+        pnode->_vchildren.resize(record.numchildren);
+        for(int ichild = 0; ichild < record.numchildren; ++ichild) {
+            pnode->_vchildren[ichild] = _vnodes[pchildindices[record.childoffset+ichild]];
         }
-
-        _vsetLevelNodes.at(_EncodeLevel(_newnode->_level)).insert(_newnode);
     }
 
-    fclose(pfile);
-
+    _vvLevelNodes.resize(max((size_t)pheader->numlevels, _vvLevelNodes.size()));
+    const int32_t* plevelindex = plevelindices;
+    for(int ilevel = 0; ilevel < pheader->numlevels; ++ilevel) {
+        std::vector<CacheTreeNodePtr>& vlevelnodes = _vvLevelNodes[ilevel];
+        vlevelnodes.resize(plevelsizes[ilevel]);
+        for(int inode = 0; inode < plevelsizes[ilevel]; ++inode, ++plevelindex) {
+            CacheTreeNodePtr pnode = _vnodes[*plevelindex];
+            vlevelnodes[inode] = pnode;
+            if( _EncodeLevel(pnode->_level) == ilevel ) {
+                pnode->_levelindex = inode;
+            }
+            else {
+                pnode->_isrootorphan = 1;
+            }
+        }
+    }
+    // nodes are now owned by _vvLevelNodes
     _vnodes.resize(0);
-
-    int numloaded = GetNumKnownNodes();
-    OPENRAVE_ASSERT_OP(numloaded,==,_numnodes);
+    _numnodes = pheader->numnodes;
     return 1;
 }
 
@@ -953,10 +1268,11 @@ int CacheTree::UpdateCollisionConfigurations(KinBodyPtr pbody)
 {
     int nremoved=0;
     if (_numnodes > 0) {
-        FOREACH(itlevelnodes, _vsetLevelNodes) {
+        const int bodyindex = pbody->GetEnvironmentBodyIndex();
+        FOREACH(itlevelnodes, _vvLevelNodes) {
             FOREACH(itnode, *itlevelnodes) {
                 _newnode = *itnode;
-                if ((_newnode->GetType() == CNT_Collision) && (pbody == _newnode->GetCollidingLink()->GetParent())) {
+                if ((_newnode->GetType() == CNT_Collision) && (bodyindex == _newnode->GetCollidingBodyIndex())) {
                     _newnode->SetType(CNT_Unknown);
                     nremoved += 1;
                 }
@@ -973,7 +1289,7 @@ int CacheTree::UpdateFreeConfigurations(KinBodyPtr pbody) //todo only remove tho
     int nremoved=0;
     if (_numnodes > 0) {
 
-        FOREACH(itlevelnodes, _vsetLevelNodes) {
+        FOREACH(itlevelnodes, _vvLevelNodes) {
             FOREACH(itnode, *itlevelnodes) {
                 if (((*itnode)->GetType() == CNT_Free)) {
                     (*itnode)->SetType(CNT_Unknown);
@@ -993,7 +1309,7 @@ int CacheTree::RemoveFreeConfigurations()
 {
     int nremoved=0;
     if (_numnodes > 0) {
-        FOREACH(itlevelnodes, _vsetLevelNodes) {
+        FOREACH(itlevelnodes, _vvLevelNodes) {
             FOREACH(itnode, *itlevelnodes) {
                 if (!!(*itnode)) {
                     if (((*itnode)->GetType() == CNT_Free)) {
@@ -1015,7 +1331,7 @@ int CacheTree::GetNumKnownNodes()
 {
     int nknown=0;
     if (_numnodes > 0) {
-        FOREACH(itlevelnodes, _vsetLevelNodes) {
+        FOREACH(itlevelnodes, _vvLevelNodes) {
             FOREACH(itnode, *itlevelnodes) {
                 if (((*itnode)->GetType() != CNT_Unknown) ) {
                     nknown += 1;
@@ -1032,8 +1348,8 @@ bool CacheTree::Validate()
         return _numnodes==0;
     }
 
-    if( _vsetLevelNodes.at(_EncodeLevel(_maxlevel)).size() != 1 ) {
-        int nroots = _vsetLevelNodes.at(_EncodeLevel(_maxlevel)).size();
+    if( _vvLevelNodes.at(_EncodeLevel(_maxlevel)).size() != 1 ) {
+        int nroots = _vvLevelNodes.at(_EncodeLevel(_maxlevel)).size();
         RAVELOG_WARN_FORMAT("more than 1 root node (%d)\n",nroots);
         return false;
     }
@@ -1046,11 +1362,11 @@ bool CacheTree::Validate()
     dReal fEpsilon = g_fEpsilon*_maxdistance; // min distance
     for(int currentlevel = _maxlevel; currentlevel >= _minlevel; --currentlevel, fLevelBound *= _fBaseInv ) {
         int enclevel = _EncodeLevel(currentlevel);
-        if( enclevel >= (int)_vsetLevelNodes.size() ) {
+        if( enclevel >= (int)_vvLevelNodes.size() ) {
             continue;
         }
 
-        const std::set<CacheTreeNodePtr>& setLevelRawChildren = _vsetLevelNodes.at(enclevel);
+        const std::vector<CacheTreeNodePtr>& setLevelRawChildren = _vvLevelNodes.at(enclevel);
         FOREACHC(itnode, setLevelRawChildren) {
             FOREACH(itchild, (*itnode)->_vchildren) {
                 dReal curdist = RaveSqrt(_ComputeDistance2((*itnode)->GetConfigurationState(), (*itchild)->GetConfigurationState()));
@@ -1071,7 +1387,7 @@ bool CacheTree::Validate()
             if( currentlevel < _maxlevel ) {
                 // find its parents
                 int nfound = 0;
-                FOREACH(ittestnode, _vsetLevelNodes.at(_EncodeLevel(currentlevel+1))) {
+                FOREACH(ittestnode, _vvLevelNodes.at(_EncodeLevel(currentlevel+1))) {
                     if( find((*ittestnode)->_vchildren.begin(), (*ittestnode)->_vchildren.end(), *itnode) != (*ittestnode)->_vchildren.end() ) {
                         ++nfound;
                         mapNodeParents[*itnode] = *ittestnode;
@@ -1124,6 +1440,80 @@ bool CacheTree::Validate()
     return true;
 }
 
+SharedCacheTree::SharedCacheTree(const std::vector<dReal>& weights, dReal maxdistance, dReal base) : _cachetree(weights.size())
+{
+    _cachetree.Init(weights, maxdistance);
+    _cachetree.SetBase(base);
+}
+
+int SharedCacheTree::CheckCollision(const std::vector<dReal>& cs, dReal collisionthresh, dReal freespacethresh, std::vector< std::pair<CacheTreeNodePtr, dReal> >& vCurrentLevelNodes, std::vector< std::pair<CacheTreeNodePtr, dReal> >& vNextLevelNodes, int& robotlinkindex, int& collidingbodyindex, int& collidinglinkindex, dReal& closestdist) const
+{
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+    std::pair<CacheTreeNodeConstPtr, dReal> knn = _cachetree.FindNearestNode(cs, collisionthresh, freespacethresh, vCurrentLevelNodes, vNextLevelNodes);
+    if( !knn.first ) {
+        return -1;
+    }
+    closestdist = knn.second;
+    if( knn.first->IsInCollision() ) {
+        robotlinkindex = knn.first->GetRobotLinkIndex();
+        collidingbodyindex = knn.first->GetCollidingBodyIndex();
+        collidinglinkindex = knn.first->GetCollidingLinkIndex();
+        return 1;
+    }
+    return 0;
+}
+
+int SharedCacheTree::InsertNode(const std::vector<dReal>& cs, CollisionReportPtr report, dReal fMinSeparationDist)
+{
+    std::lock_guard<std::shared_timed_mutex> lock(_mutex);
+    return _cachetree.InsertNode(cs, report, fMinSeparationDist);
+}
+
+int SharedCacheTree::GetNumNodes() const
+{
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+    return _cachetree.GetNumNodes();
+}
+
+void SharedCacheTree::Reset()
+{
+    std::lock_guard<std::shared_timed_mutex> lock(_mutex);
+    _cachetree.Reset();
+}
+
+static const size_t s_nMaxSharedCacheTrees = 32; ///< max number of shared trees kept alive by the store
+static std::mutex s_mutexSharedCacheTrees; ///< protects s_listSharedCacheTrees
+static std::list< std::pair<std::string, SharedCacheTreePtr> > s_listSharedCacheTrees; ///< most recently used first
+
+SharedCacheTreePtr GetSharedCacheTree(const std::string& key, const std::vector<dReal>& weights, dReal maxdistance, dReal base)
+{
+    std::lock_guard<std::mutex> lock(s_mutexSharedCacheTrees);
+    for(std::list< std::pair<std::string, SharedCacheTreePtr> >::iterator it = s_listSharedCacheTrees.begin(); it != s_listSharedCacheTrees.end(); ++it) {
+        if( it->first == key ) {
+            s_listSharedCacheTrees.splice(s_listSharedCacheTrees.begin(), s_listSharedCacheTrees, it);
+            return s_listSharedCacheTrees.front().second;
+        }
+    }
+
+    SharedCacheTreePtr ptree(new SharedCacheTree(weights, maxdistance, base));
+    s_listSharedCacheTrees.emplace_front(key, ptree);
+    // evict the least recently used trees that nobody else holds
+    std::list< std::pair<std::string, SharedCacheTreePtr> >::iterator it = s_listSharedCacheTrees.end();
+    while( s_listSharedCacheTrees.size() > s_nMaxSharedCacheTrees && it != s_listSharedCacheTrees.begin() ) {
+        --it;
+        if( it->second.use_count() == 1 ) {
+            it = s_listSharedCacheTrees.erase(it);
+        }
+    }
+    return ptree;
+}
+
+void ResetSharedCacheTrees()
+{
+    std::lock_guard<std::mutex> lock(s_mutexSharedCacheTrees);
+    s_listSharedCacheTrees.clear();
+}
+
 ConfigurationCache::ConfigurationCache(RobotBasePtr pstaterobot, bool envupdates) : _cachetree(pstaterobot->GetDOF())
 {
     _userdatakey = std::string("configurationcache") + boost::lexical_cast<std::string>(this);
@@ -1315,7 +1705,7 @@ int ConfigurationCache::CheckCollision(const std::vector<dReal>& conf, KinBody::
             else{
                 robotlink = _pstaterobot->GetLinks().at(knn.first->GetRobotLinkIndex());
             }
-            collidinglink = knn.first->GetCollidingLink();
+            collidinglink = knn.first->GetCollidingLink(_penv);
             return 1;
         }
         return 0;
@@ -1340,6 +1730,16 @@ int ConfigurationCache::CheckCollision(KinBody::LinkConstPtr& robotlink, KinBody
     return CheckCollision(conf, robotlink, collidinglink, closestdist);
 }
 
+void ConfigurationCache::SaveCache(std::string filename)
+{
+    _cachetree.SaveCache(filename, _penv, _GetCacheValidationHash());
+}
+
+bool ConfigurationCache::LoadCache(std::string filename, EnvironmentBasePtr penv)
+{
+    return _cachetree.LoadCache(filename, penv, _GetCacheValidationHash()) == 1;
+}
+
 void ConfigurationCache::Reset()
 {
     RAVELOG_DEBUG("Resetting cache\n");
@@ -1441,4 +1841,16 @@ void ConfigurationCache::_UpdateRobotGrabbed()
     }
 }
 
+std::string ConfigurationCache::_GetCacheValidationHash()
+{
+    std::stringstream ss;
+    ss << _pstaterobot->GetKinematicsGeometryHash() << " " << _pstaterobot->GetDOF() << " ";
+    std::vector<KinBodyPtr> vgrabbedbodies;
+    _pstaterobot->GetGrabbed(vgrabbedbodies);
+    FOREACHC(itbody, vgrabbedbodies) {
+        ss << (*itbody)->GetKinematicsGeometryHash() << " ";
+    }
+    return utils::GetMD5HashString(ss.str());
+}
+
 }
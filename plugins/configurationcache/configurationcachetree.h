@@ -17,6 +17,8 @@
 
 #include "openraveplugindefs.h"
 #include <deque>
+#include <mutex>
+#include <shared_mutex>
 #include <boost/pool/pool.hpp>
 
 #define _(msgid) OpenRAVE::RaveGetLocalizedTextForDomain("openrave_plugins_configurationcache", msgid)
@@ -46,15 +48,18 @@ public:
     /// \brief sets the collision info with int values (used by the load/save)
     void SetCollisionInfo(int index, int type);
 
+    /// \brief returns the environment body index of the colliding body
+    inline int GetCollidingBodyIndex() const {
+        return _collidingbodyindex;
+    }
+
     /// \brief returns the index of the colliding link
     inline int GetCollidingLinkIndex() const {
-        return _collidinglink->GetIndex();
+        return _collidinglinkindex;
     }
 
-    /// \brief returns the colliding link
-    inline KinBody::LinkConstPtr GetCollidingLink() const {
-        return _collidinglink;
-    }
+    /// \brief returns the colliding link in penv, or an empty pointer if the body is gone
+    KinBody::LinkConstPtr GetCollidingLink(EnvironmentBaseConstPtr penv) const;
 
     /// \brief returns the robot link index in the collision report
     inline int GetRobotLinkIndex() const {
@@ -117,11 +122,12 @@ public:
     //void UpdateApproximates(dReal distance, CacheTreeNodePtr v);
 
 protected:
-    std::vector<CacheTreeNode*> _vchildren; ///< direct children of this node (for the next level down)
+    std::vector<CacheTreeNode*> _vchildren; ///< direct children of this node (for the next level down). Kept per node rather than as ranges into the next level's array, since insertion and removal would otherwise have to shift the ranges of every following node in the level. The binary cache file stores them as per-level ranges.
     ConfigurationNodeType _conftype; ///< configuration type for this node
-    KinBody::LinkConstPtr _collidinglink; ///< collidinglink in the collision report for this node
+    int _collidingbodyindex; ///< environment body index of the colliding link in the collision report for this node. Indices are kept instead of the link so that shared trees do not keep the bodies of other environments alive
+    int _collidinglinkindex; ///< index of the colliding link in its body
     Transform _collidinglinktrans; ///< the colliding link's transform. Valid if _conftype is CNT_Collision
-    int _robotlinkindex; ///< the robot link index that is colliding with _collidinglink. Valid if _conftype is CNT_Collision
+    int _robotlinkindex; ///< the robot link index that is colliding with the colliding link. Valid if _conftype is CNT_Collision
 
     // idea: keep k nearest neighbors and update k every now and then, k = (e + e/dim) * log(n+1) where n is the size of the tree?
     //std::map<int,std::vector<CacheTreeNodePtr> > _children; //maybe use a vector for each level somehow
@@ -129,7 +135,9 @@ protected:
     //std::pair<CacheTreeNodePtr, dReal> _approxnn; //nearest distance and neighbor seen so far (same type)
 
     int16_t _level; ///< the level the node belongs to
+    int _levelindex; ///< index of the node inside CacheTree::_vvLevelNodes[enc(_level)], kept so that removing a node from its level is O(1)
     uint8_t _hasselfchild; ///< if 1, then _vchildren has contains a clone of this node in the level below it.
+    uint8_t _isrootorphan; ///< if 1, the node lost its parent when the root was removed and is also referenced by the root level, see CacheTree::_Remove
     uint8_t _usenn; ///< if 1, then use part of the nearest neighbor search, otherwise ignore
     int _hitcount; /// number of cache hits
 
@@ -188,6 +196,9 @@ public:
     /// \param freespacethresh assumes > 0
     std::pair<CacheTreeNodeConstPtr, dReal> FindNearestNode(const std::vector<dReal>& cs, dReal collisionthresh, dReal freespacethresh) const;
 
+    /// \brief same as FindNearestNode(cs, collisionthresh, freespacethresh) except uses the caller's buffers and does not update the hit counts, so several threads can query the tree at the same time.
+    std::pair<CacheTreeNodeConstPtr, dReal> FindNearestNode(const std::vector<dReal>& cs, dReal collisionthresh, dReal freespacethresh, std::vector< std::pair<CacheTreeNodePtr, dReal> >& vCurrentLevelNodes, std::vector< std::pair<CacheTreeNodePtr, dReal> >& vNextLevelNodes) const;
+
     /// \brief inserts node in the tree. If node is too close to other nodes in the tree, then does not insert.
     ///
     /// \param[in] fMinSeparationDist the max distance a node should be separated from its closest neighbor. If node is collision, then only applies to collision neighbors, free neighbors are ignored.
@@ -258,11 +269,18 @@ public:
     /// \brief returns the number of configurations in the tree that are not CNT_Unknown
     int GetNumKnownNodes();
 
-    /// \brief save cache to disk
-    int SaveCache(std::string filename);
+    /// \brief save cache to disk in a versioned binary format storing the tree topology, so it can be loaded without inserting the nodes again
+    ///
+    /// \param penv the environment the colliding body indices of the nodes refer to
+    /// \param validationhash identifies what the cached configurations depend on (e.g. the robot kinematics), LoadCache rejects the file if it is different
+    /// \return 1 if the cache was written
+    int SaveCache(const std::string& filename, EnvironmentBaseConstPtr penv, const std::string& validationhash);
 
-    /// \brief load cache from disk
-    int LoadCache(std::string filename, EnvironmentBasePtr penv);
+    /// \brief load cache from disk, the file is memory mapped and the tree is rebuilt directly from its arrays
+    ///
+    /// the file is ignored and the tree is not touched if its format, dof or validationhash do not match, or if the geometry of a colliding body in penv changed since saving.
+    /// \return 1 if the cache was loaded
+    int LoadCache(const std::string& filename, EnvironmentBasePtr penv, const std::string& validationhash);
 
 private:
     /// \brief creates new node on the pool
@@ -277,6 +295,26 @@ private:
     /// note the distance metric has to satisfy triangle inequality
     dReal _ComputeDistance2(const dReal* cstatei, const dReal* cstatef) const;
 
+    /// \param bUpdateHitCount if true, increments the hit count of returned collision nodes
+    std::pair<CacheTreeNodeConstPtr, dReal> _FindNearestNode(const std::vector<dReal>& cs, dReal collisionthresh, dReal freespacethresh, std::vector< std::pair<CacheTreeNodePtr, dReal> >& vCurrentLevelNodes, std::vector< std::pair<CacheTreeNodePtr, dReal> >& vNextLevelNodes, bool bUpdateHitCount) const;
+
+    /// \brief same as _ComputeDistance2, except stops accumulating as soon as the distance exceeds bound2. In that case, the returned value is only guaranteed to be > bound2.
+    dReal _ComputeDistance2Bounded(const dReal* cstatei, const dReal* cstatef, dReal bound2) const;
+
+    /// \brief returns the root node, assumes _numnodes > 0
+    inline CacheTreeNodePtr _GetRootNode() const {
+        return _vvLevelNodes.at(_EncodeLevel(_maxlevel)).front();
+    }
+
+    /// \brief appends node to the flat array of its level
+    void _AddNodeToLevel(CacheTreeNodePtr node);
+
+    /// \brief removes node from the flat array of its level by swapping it with the last node of the level
+    void _RemoveNodeFromLevel(CacheTreeNodePtr node);
+
+    /// \brief returns true if node is in the flat array of the level enclevel
+    bool _IsNodeInLevel(CacheTreeNodeConstPtr node, int enclevel) const;
+
     /// \brief inserts a configuration into the cache tree
     ///
     /// \param[in] node the input node to insert
@@ -323,9 +361,9 @@ private:
     KinBodyPtr _pcollidingbody;
 
     std::map<CacheTreeNodePtr, int> _mapNodeIndices;
-    std::vector< std::set<CacheTreeNodePtr> > _vsetLevelNodes; ///< _vsetLevelNodes[enc(level)][node] holds the indices of the children of "node" of a given the level. enc(level) maps (-inf,inf) into [0,inf) so it can be indexed by the vector. Every node has an entry in a map here. If the node doesn't hold any children, then it is at the leaf of the tree. _vsetLevelNodes.at(_EncodeLevel(_maxlevel)) is the root.
+    std::vector< std::vector<CacheTreeNodePtr> > _vvLevelNodes; ///< _vvLevelNodes[enc(level)] is a flat array of all the nodes of a given level, node->_levelindex is the node's position in it. enc(level) maps (-inf,inf) into [0,inf) so it can be indexed by the vector. If a node doesn't hold any children, then it is at the leaf of the tree. _vvLevelNodes.at(_EncodeLevel(_maxlevel)) is the root.
 
-    OPENRAVE_SHARED_PTR<boost::pool<> > _poolNodes; ///< the dynamically growing memory pool of nodes. Since each node's size is determined during run-time, the pool constructor has to be called with the correct node size
+    OPENRAVE_SHARED_PTR<boost::pool<> > _poolNodes; ///< the dynamically growing memory pool of nodes. Since each node's size is determined during run-time, the pool constructor has to be called with the correct node size. Nodes are carved out of large blocks so that nodes inserted together are close in memory.
 
     dReal _maxdistance; ///< maximum possible distance between two states. used to balance the tree.
     dReal _base, _fBaseInv, _fBaseInv2, _fBaseChildMult; ///< a constant used to control the max level of traversion. _fBaseInv = 1/_base, _fBaseInv2=Sqr(_fBaseInv), _fBaseChildMult=1/(_base-1)
@@ -333,7 +371,7 @@ private:
     int _statedof; ///< the state space DOF tree is configured for
     int _maxlevel; ///< the maximum allowed levels in the tree, this is where the root node starts (inclusive)
     int _minlevel; ///< the minimum allowed levels in the tree (inclusive)
-    int _numnodes; ///< the number of nodes in the current tree starting at the root at _vsetLevelNodes.at(_EncodeLevel(_maxlevel))
+    int _numnodes; ///< the number of nodes in the current tree starting at the root at _vvLevelNodes.at(_EncodeLevel(_maxlevel))
     dReal _fMaxLevelBound; ///< pow(_base, _maxlevel)
 
     // cache cache
@@ -346,6 +384,45 @@ private:
 
 typedef OPENRAVE_SHARED_PTR<CacheTree> CacheTreePtr;
 
+/** Cache tree that several CacheCollisionChecker instances living in different environments (e.g. the clones of the planning threads) read and insert into at the same time.
+
+    Queries take a shared lock and insertions an exclusive lock on the tree. Queries copy the collision information out of the node, so the results stay valid after the lock is released.
+ */
+class SharedCacheTree
+{
+public:
+    SharedCacheTree(const std::vector<dReal>& weights, dReal maxdistance, dReal base);
+
+    /// \brief determine if cs is whithin collisionthresh of a collision in the cache or within freespacethresh of a free configuration
+    ///
+    /// \param[inout] vCurrentLevelNodes, vNextLevelNodes the caller's buffers for traversing the tree
+    /// \param[out] robotlinkindex the index of the robot link colliding
+    /// \param[out] collidingbodyindex, collidinglinkindex the environment body index and link index of the link colliding with the robot, -1 if unknown
+    /// \return 1 if in collision, 0 if not in collision, -1 if unknown
+    int CheckCollision(const std::vector<dReal>& cs, dReal collisionthresh, dReal freespacethresh, std::vector< std::pair<CacheTreeNodePtr, dReal> >& vCurrentLevelNodes, std::vector< std::pair<CacheTreeNodePtr, dReal> >& vNextLevelNodes, int& robotlinkindex, int& collidingbodyindex, int& collidinglinkindex, dReal& closestdist) const;
+
+    /// \brief inserts a configuration, see CacheTree::InsertNode. report->plink1 is expected to be the robot
+    int InsertNode(const std::vector<dReal>& cs, CollisionReportPtr report, dReal fMinSeparationDist);
+
+    int GetNumNodes() const;
+
+    void Reset();
+
+private:
+    CacheTree _cachetree;
+    mutable std::shared_timed_mutex _mutex; ///< protects _cachetree
+};
+
+typedef OPENRAVE_SHARED_PTR<SharedCacheTree> SharedCacheTreePtr;
+
+/// \brief returns the process-wide shared cache tree of key, creating it with weights, maxdistance and base if it does not exist. <b>[multi-thread safe]</b>
+///
+/// key has to identify everything the cached configurations depend on, e.g. the robot kinematics and the static state of the environment. Only the most recently used trees are kept.
+SharedCacheTreePtr GetSharedCacheTree(const std::string& key, const std::vector<dReal>& weights, dReal maxdistance, dReal base);
+
+/// \brief releases all the shared cache trees. Trees still used by a checker stay alive until the checker releases them. <b>[multi-thread safe]</b>
+void ResetSharedCacheTrees();
+
 /** Maintains an up-to-date cache tree synchronized to the openrave environment. Tracks bodies being added removed, states changing, etc.
    The state of cache consists of the active DOFs of the robot that is passed in at constructor time.
  */
@@ -445,6 +522,16 @@ public:
     /// \brief set weights
     void SetWeights(const std::vector<dReal>& weights);
 
+    /// \brief returns the weights of the distance metric
+    inline const std::vector<dReal>& GetWeights() const {
+        return _cachetree.GetWeights();
+    }
+
+    /// \brief returns the max distance between two configurations
+    inline dReal GetMaxDistance() const {
+        return _cachetree.GetMaxDistance();
+    }
+
     /// \brief the cache will not insert configuration if their distance from the nearest node in the tree is not larger than this value
     inline void SetInsertionDistanceMult(dReal indist)
     {
@@ -490,16 +577,12 @@ public:
     }
 
     /// \brief saves the cache to disk
-    inline void SaveCache(std::string filename)
-    {
-        _cachetree.SaveCache(filename);
-    }
+    void SaveCache(std::string filename);
 
-    /// \brief loads cache from disk
-    inline void LoadCache(std::string filename, EnvironmentBasePtr penv)
-    {
-        _cachetree.LoadCache(filename, penv);
-    }
+    /// \brief loads cache from disk, ignores it if it was saved for a different robot or colliding geometry
+    ///
+    /// \return true if the cache was loaded
+    bool LoadCache(std::string filename, EnvironmentBasePtr penv);
 
 private:
     /// \brief called when body has changed state.
@@ -514,6 +597,9 @@ private:
     /// \brief called when grabbeb bodies are updated
     void _UpdateRobotGrabbed();
 
+    /// \brief returns the hash the saved cache is validated with: the kinematics geometry of the robot and its grabbed bodies
+    std::string _GetCacheValidationHash();
+
     CacheTree _cachetree; ///< cache tree datastructure with configurations and their collision information
 
     RobotBasePtr _pstaterobot;
@@ -113,10 +113,56 @@ public:
 
     typedef boost::shared_ptr<CollisionCallbackData> CollisionCallbackDataPtr;
 
+    /// \brief minimum distance from one link to the rest of the environment, result of ComputeLinkDistances
+    class LinkDistance
+    {
+public:
+        LinkDistance() : distance(std::numeric_limits<dReal>::infinity()) {
+        }
+
+        LinkConstPtr plink; ///< the queried link
+        LinkConstPtr plinkOther; ///< closest link in the environment, empty if nothing was found
+        dReal distance; ///< minimum distance between plink and plinkOther, infinity if nothing was found
+        Vector point; ///< witness point on plink as returned by fcl
+        Vector pointOther; ///< witness point on plinkOther as returned by fcl
+    };
+
+    /// \brief closest geometry pair of a link found by the last distance query, used to warm start the next one
+    class NearestPairCache
+    {
+public:
+        NearestPairCache() : geomIndex(-1), otherBodyIndex(0), otherLinkIndex(-1), otherGeomIndex(-1) {
+        }
+
+        int geomIndex; ///< index into the LinkInfo::vgeoms of the queried link
+        int otherBodyIndex; ///< environment body index of the closest body, 0 if invalid
+        int otherLinkIndex;
+        int otherGeomIndex; ///< index into the LinkInfo::vgeoms of the closest link
+    };
+
+    /// \brief state of a distance query between one link and the environment manager
+    class LinkDistanceCallbackData : public CollisionCallbackData
+    {
+public:
+        LinkDistanceCallbackData(boost::shared_ptr<FCLCollisionChecker> pchecker, const std::vector<KinBodyConstPtr>& vbodyexcluded, const std::vector<LinkConstPtr>& vlinkexcluded, const FCLSpace::FCLKinBodyInfo::LinkInfo& linkinfo)
+            : CollisionCallbackData(pchecker, CollisionReportPtr(), vbodyexcluded, vlinkexcluded), _linkinfo(linkinfo), _fMinDistance(std::numeric_limits<fcl::FCL_REAL>::max())
+        {
+            _distanceRequest.enable_nearest_points = true;
+        }
+
+        const FCLSpace::FCLKinBodyInfo::LinkInfo& _linkinfo; ///< info of the queried link
+        fcl::FCL_REAL _fMinDistance; ///< smallest distance found so far, used as an upper bound to prune the broadphase and narrow phase
+        NearestPairCache _nearest; ///< geometry pair realizing _fMinDistance
+        LinkConstPtr _plinkOther;
+        fcl::Vec3f _point, _pointOther;
+    };
+
     FCLCollisionChecker(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput)
-        : OpenRAVE::CollisionCheckerBase(penv), _broadPhaseCollisionManagerAlgorithm("DynamicAABBTree2"), _bIsSelfCollisionChecker(true) // DynamicAABBTree2 should be slightly faster than Naive
+        : OpenRAVE::CollisionCheckerBase(penv), _broadPhaseCollisionManagerAlgorithm("DynamicAABBTree2"), _bodyBroadPhaseCollisionManagerAlgorithm("DynamicAABBTree2"), _bIsSelfCollisionChecker(true) // DynamicAABBTree2 should be slightly faster than Naive
     {
         _bParentlessCollisionObject = false;
+        _bIncrementalSelfCollision = true;
+        _bAutoTuneBroadphaseOnInit = false;
         _userdatakey = std::string("fclcollision") + boost::lexical_cast<std::string>(this);
         _fclspace.reset(new FCLSpace(penv, _userdatakey));
         _options = 0;
@@ -128,15 +174,26 @@ public:
         SETUP_STATISTICS(_statistics, _userdatakey, GetEnv()->GetId());
 
         // TODO : Consider removing these which could be more harmful than anything else
-        RegisterCommand("SetBroadphaseAlgorithm", boost::bind(&FCLCollisionChecker::SetBroadphaseAlgorithmCommand, this, _1, _2), "sets the broadphase algorithm (Naive, SaP, SSaP, IntervalTree, DynamicAABBTree, DynamicAABBTree_Array)");
+        RegisterCommand("SetBroadphaseAlgorithm", boost::bind(&FCLCollisionChecker::SetBroadphaseAlgorithmCommand, this, _1, _2), "sets the broadphase algorithm (Naive, SaP, SSaP, IntervalTree, DynamicAABBTree, DynamicAABBTree_Array) of the environment and body managers. Auto times the candidates on the current scene and picks the fastest");
+        RegisterCommand("SetEnvBroadphaseAlgorithm", boost::bind(&FCLCollisionChecker::SetEnvBroadphaseAlgorithmCommand, this, _1, _2), "sets the broadphase algorithm of the environment managers only");
+        RegisterCommand("SetBodyBroadphaseAlgorithm", boost::bind(&FCLCollisionChecker::SetBodyBroadphaseAlgorithmCommand, this, _1, _2), "sets the broadphase algorithm of the body managers. If a body name follows the algorithm, only sets it for that body. Passing \"Default\" with a body name removes its override");
+        RegisterCommand("GetBroadphaseAlgorithm", boost::bind(&FCLCollisionChecker::GetBroadphaseAlgorithmCommand, this, _1, _2), "returns the broadphase algorithm of the environment managers, the default one of the body managers, and the per-body overrides");
+        RegisterCommand("AutoTuneBroadphaseAlgorithm", boost::bind(&FCLCollisionChecker::AutoTuneBroadphaseAlgorithmCommand, this, _1, _2), "times body/environment queries on the current scene with each candidate broadphase algorithm and keeps the fastest. Input is the number of rounds and optionally the candidates. Outputs the time of each candidate and the chosen one");
         RegisterCommand("SetBVHRepresentation", boost::bind(&FCLCollisionChecker::_SetBVHRepresentation, this, _1, _2), "sets the Bouding Volume Hierarchy representation for meshes (AABB, OBB, OBBRSS, RSS, kIDS)");
+        RegisterCommand("GetLinkDistances", boost::bind(&FCLCollisionChecker::_GetLinkDistancesCommand, this, _1, _2), "returns the minimum distance of every enabled link of a body to the environment. Input is the body name, output is one line per link: linkname distance otherbodyname otherlinkname x y z otherx othery otherz");
+        RegisterCommand("SetIncrementalSelfCollision", boost::bind(&FCLCollisionChecker::_SetIncrementalSelfCollisionCommand, this, _1, _2), "if 1 (default), body self-collision only rechecks link pairs whose relative pose changed since the last self-collision free state");
 
         RAVELOG_VERBOSE_FORMAT("FCLCollisionChecker %s created in env %d", _userdatakey%penv->GetId());
 
         std::string broadphasealg, bvhrepresentation;
         sinput >> broadphasealg >> bvhrepresentation;
-        if( broadphasealg != "" ) {
+        if( broadphasealg == "Auto" ) {
+            // tuned in InitEnvironment once the bodies are known
+            _bAutoTuneBroadphaseOnInit = true;
+        }
+        else if( broadphasealg != "" ) {
             _SetBroadphaseAlgorithm(broadphasealg);
+            _SetBodyBroadphaseAlgorithm(broadphasealg);
         }
         if( bvhrepresentation != "" ) {
             _fclspace->SetBVHRepresentation(bvhrepresentation);
@@ -182,10 +239,15 @@ public:
         _fclspace->SetGeometryGroup(r->GetGeometryGroup());
         _fclspace->SetBVHRepresentation(r->GetBVHRepresentation());
         _SetBroadphaseAlgorithm(r->GetBroadphaseAlgorithm());
+        _SetBodyBroadphaseAlgorithm(r->_bodyBroadPhaseCollisionManagerAlgorithm);
+        _mapBodyBroadPhaseCollisionManagerAlgorithms = r->_mapBodyBroadPhaseCollisionManagerAlgorithms;
+        _bodymanagers.clear();
 
         // We don't want to clone _bIsSelfCollisionChecker since a self collision checker can be created by cloning a environment collision checker
         _options = r->_options;
         _numMaxContacts = r->_numMaxContacts;
+        _bIncrementalSelfCollision = r->_bIncrementalSelfCollision;
+        _bAutoTuneBroadphaseOnInit = r->_bAutoTuneBroadphaseOnInit;
         RAVELOG_VERBOSE(str(boost::format("FCL User data cloning env %d into env %d") % r->GetEnv()->GetId() % GetEnv()->GetId()));
     }
 
@@ -245,8 +307,151 @@ public:
     {
         std::string algorithm;
         sinput >> algorithm;
+        if( !sinput ) {
+            return false;
+        }
+        if( algorithm == "Auto" ) {
+            AutoTuneBroadphaseAlgorithm(_nAutoTuneRounds, std::vector<std::string>(), sout);
+            return true;
+        }
         _SetBroadphaseAlgorithm(algorithm);
-        return !!sinput;
+        _SetBodyBroadphaseAlgorithm(algorithm);
+        return true;
+    }
+
+    /// e.g. "SetEnvBroadphaseAlgorithm SaP"
+    bool SetEnvBroadphaseAlgorithmCommand(ostream& sout, istream& sinput)
+    {
+        std::string algorithm;
+        sinput >> algorithm;
+        if( !sinput ) {
+            return false;
+        }
+        _SetBroadphaseAlgorithm(algorithm);
+        return true;
+    }
+
+    /// e.g. "SetBodyBroadphaseAlgorithm Naive robotname"
+    bool SetBodyBroadphaseAlgorithmCommand(ostream& sout, istream& sinput)
+    {
+        std::string algorithm, bodyname;
+        sinput >> algorithm;
+        if( !sinput ) {
+            return false;
+        }
+        sinput >> bodyname;
+        if( bodyname.size() == 0 ) {
+            _SetBodyBroadphaseAlgorithm(algorithm);
+            return true;
+        }
+
+        if( algorithm == "Default" ) {
+            _mapBodyBroadPhaseCollisionManagerAlgorithms.erase(bodyname);
+        }
+        else {
+            _CreateManagerFromBroadphaseAlgorithm(algorithm); // throws if the algorithm is unknown
+            _mapBodyBroadPhaseCollisionManagerAlgorithms[bodyname] = algorithm;
+        }
+        KinBodyPtr pbody = GetEnv()->GetKinBody(bodyname);
+        if( !!pbody ) {
+            _bodymanagers.erase(std::make_pair(pbody.get(), (int)0));
+            _bodymanagers.erase(std::make_pair(pbody.get(), (int)1));
+        }
+        return true;
+    }
+
+    bool GetBroadphaseAlgorithmCommand(ostream& sout, istream& sinput)
+    {
+        sout << _broadPhaseCollisionManagerAlgorithm << " " << _bodyBroadPhaseCollisionManagerAlgorithm;
+        FOREACHC(it, _mapBodyBroadPhaseCollisionManagerAlgorithms) {
+            sout << " " << it->first << " " << it->second;
+        }
+        return true;
+    }
+
+    /// e.g. "AutoTuneBroadphaseAlgorithm 10 DynamicAABBTree2 SaP"
+    bool AutoTuneBroadphaseAlgorithmCommand(ostream& sout, istream& sinput)
+    {
+        int nRounds = _nAutoTuneRounds;
+        sinput >> nRounds;
+        std::vector<std::string> vcandidates;
+        std::string candidate;
+        while( sinput >> candidate ) {
+            vcandidates.push_back(candidate);
+        }
+        AutoTuneBroadphaseAlgorithm(nRounds, vcandidates, sout);
+        return true;
+    }
+
+    /// \brief times the body/environment queries of all the bodies in the scene with every candidate algorithm and keeps the fastest for the environment and body managers.
+    ///
+    /// \param vcandidates the algorithms to try, if empty uses DynamicAABBTree2, DynamicAABBTree, SaP, SSaP and IntervalTree
+    /// \param sout receives one line per candidate with its total time in seconds, followed by the chosen algorithm
+    /// \return the chosen algorithm
+    std::string AutoTuneBroadphaseAlgorithm(int nRounds, const std::vector<std::string>& vcandidates, std::ostream& sout)
+    {
+        static const char* s_defaultCandidates[] = {"DynamicAABBTree2", "DynamicAABBTree", "SaP", "SSaP", "IntervalTree"};
+        std::vector<std::string> vtested = vcandidates;
+        if( vtested.size() == 0 ) {
+            vtested.assign(s_defaultCandidates, s_defaultCandidates + sizeof(s_defaultCandidates)/sizeof(s_defaultCandidates[0]));
+        }
+
+        std::vector<KinBodyPtr> vbodies;
+        GetEnv()->GetBodies(vbodies);
+        const std::string initialalgorithm = _broadPhaseCollisionManagerAlgorithm, initialbodyalgorithm = _bodyBroadPhaseCollisionManagerAlgorithm;
+        std::string bestalgorithm = initialalgorithm;
+        if( vbodies.size() == 0 || nRounds <= 0 ) {
+            RAVELOG_DEBUG_FORMAT("env=%s, no bodies to tune the broadphase algorithm with, keeping %s", GetEnv()->GetNameId()%bestalgorithm);
+            sout << bestalgorithm;
+            return bestalgorithm;
+        }
+
+        // distance queries need a report
+        CollisionReportPtr preport;
+        if( _options & OpenRAVE::CO_Distance ) {
+            preport.reset(new CollisionReport());
+        }
+        const std::vector<KinBodyConstPtr> vbodyexcluded;
+        const std::vector<LinkConstPtr> vlinkexcluded;
+        double fBestTime = std::numeric_limits<double>::infinity();
+        FOREACHC(italgorithm, vtested) {
+            try {
+                _SetBroadphaseAlgorithm(*italgorithm);
+                _SetBodyBroadphaseAlgorithm(*italgorithm);
+            }
+            catch(const OpenRAVE::OpenRAVEException& ex) {
+                RAVELOG_WARN_FORMAT("env=%s, skipping broadphase algorithm %s: %s", GetEnv()->GetNameId()%(*italgorithm)%ex.what());
+                continue;
+            }
+            // first round builds the managers, so do not time it
+            FOREACHC(itbody, vbodies) {
+                CheckCollision(*itbody, vbodyexcluded, vlinkexcluded, preport);
+            }
+            FCLTimer timer;
+            for(int iround = 0; iround < nRounds; ++iround) {
+                FOREACHC(itbody, vbodies) {
+                    CheckCollision(*itbody, vbodyexcluded, vlinkexcluded, preport);
+                }
+            }
+            const double fTime = timer.GetElapsed();
+            sout << *italgorithm << " " << fTime << std::endl;
+            if( fTime < fBestTime ) {
+                fBestTime = fTime;
+                bestalgorithm = *italgorithm;
+            }
+        }
+
+        if( fBestTime == std::numeric_limits<double>::infinity() ) {
+            bestalgorithm = initialalgorithm;
+            _SetBodyBroadphaseAlgorithm(initialbodyalgorithm);
+        }
+        else {
+            _SetBodyBroadphaseAlgorithm(bestalgorithm);
+        }
+        _SetBroadphaseAlgorithm(bestalgorithm);
+        RAVELOG_DEBUG_FORMAT("env=%s, auto-tuned broadphase algorithm is %s (%fs for %d rounds of %d bodies)", GetEnv()->GetNameId()%bestalgorithm%fBestTime%nRounds%vbodies.size());
+        sout << bestalgorithm;
+        return bestalgorithm;
     }
 
     void _SetBroadphaseAlgorithm(const std::string &algorithm)
@@ -254,13 +459,35 @@ public:
         if(_broadPhaseCollisionManagerAlgorithm == algorithm) {
             return;
         }
+        _CreateManagerFromBroadphaseAlgorithm(algorithm); // throws if the algorithm is unknown
         _broadPhaseCollisionManagerAlgorithm = algorithm;
 
         // clear all the current cached managers
-        _bodymanagers.clear();
         _envmanagers.clear();
     }
 
+    void _SetBodyBroadphaseAlgorithm(const std::string &algorithm)
+    {
+        if(_bodyBroadPhaseCollisionManagerAlgorithm == algorithm) {
+            return;
+        }
+        _CreateManagerFromBroadphaseAlgorithm(algorithm); // throws if the algorithm is unknown
+        _bodyBroadPhaseCollisionManagerAlgorithm = algorithm;
+        _bodymanagers.clear();
+    }
+
+    /// \brief returns the broadphase algorithm to use for the managers of the body
+    const std::string& _GetBodyBroadphaseAlgorithm(const KinBody& body) const
+    {
+        if( _mapBodyBroadPhaseCollisionManagerAlgorithms.size() > 0 ) {
+            std::map<std::string, std::string>::const_iterator it = _mapBodyBroadPhaseCollisionManagerAlgorithms.find(body.GetName());
+            if( it != _mapBodyBroadPhaseCollisionManagerAlgorithms.end() ) {
+                return it->second;
+            }
+        }
+        return _bodyBroadPhaseCollisionManagerAlgorithm;
+    }
+
     const std::string & GetBroadphaseAlgorithm() const {
         return _broadPhaseCollisionManagerAlgorithm;
     }
@@ -326,6 +553,19 @@ public:
         return _fclspace->GetBVHRepresentation();
     }
 
+    /// Enables or disables incremental self-collision checking
+    /// e.g. "SetIncrementalSelfCollision 0"
+    bool _SetIncrementalSelfCollisionCommand(ostream& sout, istream& sinput)
+    {
+        int bIncremental = 1;
+        sinput >> bIncremental;
+        if( !sinput ) {
+            return false;
+        }
+        _bIncrementalSelfCollision = !!bIncremental;
+        return true;
+    }
+
 
     virtual bool InitEnvironment()
     {
@@ -337,6 +577,10 @@ public:
         FOREACHC(itbody, vbodies) {
             InitKinBody(*itbody);
         }
+        if( _bAutoTuneBroadphaseOnInit ) {
+            std::stringstream sstiming;
+            AutoTuneBroadphaseAlgorithm(_nAutoTuneRounds, std::vector<std::string>(), sstiming);
+        }
         return true;
     }
 
@@ -344,6 +588,7 @@ public:
     {
         RAVELOG_VERBOSE(str(boost::format("FCL User data destroying %s in env %d") % _userdatakey % GetEnv()->GetId()));
         _fclspace->DestroyEnvironment();
+        _mapNearestPairCache.clear();
     }
 
     virtual bool InitKinBody(OpenRAVE::KinBodyPtr pbody)
@@ -388,6 +633,7 @@ public:
         if (numErased > 0) {
             RAVELOG_INFO_FORMAT("env=%s, erased %d element(s) from _envmanagers containing envBodyIndex=%d(\"%s\"), now %d remaining", GetEnv()->GetNameId()%numErased%envBodyIndex%body.GetName()%_envmanagers.size());
         }
+        _mapNearestPairCache.erase(_mapNearestPairCache.lower_bound(std::make_pair(envBodyIndex, std::numeric_limits<int>::min())), _mapNearestPairCache.lower_bound(std::make_pair(envBodyIndex+1, std::numeric_limits<int>::min())));
         _fclspace->RemoveUserData(pbody);
     }
 
@@ -798,6 +1044,86 @@ public:
         return query._bCollision;
     }
 
+    /// \brief computes the minimum distance of every enabled link of pbody to the rest of the environment.
+    ///
+    /// Bodies attached to pbody are ignored. The closest geometry pair of every link is cached and its distance is used as an initial upper bound for the next query, so that the broadphase and narrow phase can prune most of the other objects when the scene changes little between calls.
+    void ComputeLinkDistances(KinBodyConstPtr pbody, const std::vector<KinBodyConstPtr>& vbodyexcluded, const std::vector<LinkConstPtr>& vlinkexcluded, std::vector<LinkDistance>& vlinkdistances)
+    {
+        START_TIMING_OPT(_statistics, "LinkDistances",_options,pbody->IsRobot());
+        vlinkdistances.resize(0);
+        if( pbody->GetLinks().size() == 0 ) {
+            return;
+        }
+
+        _fclspace->Synchronize();
+        pbody->GetAttachedEnvironmentBodyIndices(_attachedBodyIndicesCache);
+        FCLCollisionManagerInstance& envManager = _GetEnvManager(_attachedBodyIndicesCache);
+        FCLKinBodyInfoPtr pinfo = _fclspace->GetInfo(*pbody);
+        if( !pinfo ) {
+            return;
+        }
+        ADD_TIMING(_statistics);
+
+        const int bodyIndex = pbody->GetEnvironmentBodyIndex();
+        vlinkdistances.reserve(pbody->GetLinks().size());
+        FOREACHC(itlink, pbody->GetLinks()) {
+            const KinBody::LinkPtr& plink = *itlink;
+            if( !plink->IsEnabled() || IsIn<LinkConstPtr>(plink, vlinkexcluded) ) {
+                continue;
+            }
+            const FCLSpace::FCLKinBodyInfo::LinkInfo& linkinfo = *pinfo->vlinks.at(plink->GetIndex());
+            if( !linkinfo.linkBV.second || linkinfo.vgeoms.size() == 0 ) {
+                continue;
+            }
+
+            LinkDistanceCallbackData query(shared_checker(), vbodyexcluded, vlinkexcluded, linkinfo);
+            NearestPairCache& nearestcache = _mapNearestPairCache[std::make_pair(bodyIndex, plink->GetIndex())];
+            _WarmStartLinkDistance(query, nearestcache);
+            envManager.GetManager()->distance(linkinfo.linkBV.second.get(), &query, &FCLCollisionChecker::CheckNarrowPhaseLinkDistance);
+
+            vlinkdistances.push_back(LinkDistance());
+            LinkDistance& linkdistance = vlinkdistances.back();
+            linkdistance.plink = plink;
+            if( !!query._plinkOther ) {
+                linkdistance.plinkOther = query._plinkOther;
+                linkdistance.distance = query._fMinDistance;
+                linkdistance.point = ConvertVectorFromFCL(query._point);
+                linkdistance.pointOther = ConvertVectorFromFCL(query._pointOther);
+            }
+            nearestcache = query._nearest;
+        }
+    }
+
+    /// Returns the minimum distance of all the enabled links of a body to the environment
+    /// e.g. "GetLinkDistances robotname"
+    bool _GetLinkDistancesCommand(ostream& sout, istream& sinput)
+    {
+        std::string bodyname;
+        sinput >> bodyname;
+        if( !sinput ) {
+            return false;
+        }
+        KinBodyPtr pbody = GetEnv()->GetKinBody(bodyname);
+        if( !pbody ) {
+            RAVELOG_WARN_FORMAT("env=%s, body '%s' does not exist", GetEnv()->GetNameId()%bodyname);
+            return false;
+        }
+        std::vector<LinkDistance> vlinkdistances;
+        ComputeLinkDistances(pbody, std::vector<KinBodyConstPtr>(), std::vector<LinkConstPtr>(), vlinkdistances);
+        sout << std::setprecision(std::numeric_limits<dReal>::digits10+1);
+        FOREACHC(itlinkdistance, vlinkdistances) {
+            sout << itlinkdistance->plink->GetName() << " " << itlinkdistance->distance << " ";
+            if( !!itlinkdistance->plinkOther ) {
+                sout << itlinkdistance->plinkOther->GetParent()->GetName() << " " << itlinkdistance->plinkOther->GetName();
+            }
+            else {
+                sout << "None None";
+            }
+            sout << " " << itlinkdistance->point.x << " " << itlinkdistance->point.y << " " << itlinkdistance->point.z << " " << itlinkdistance->pointOther.x << " " << itlinkdistance->pointOther.y << " " << itlinkdistance->pointOther.z << std::endl;
+        }
+        return true;
+    }
+
     virtual bool CheckStandaloneSelfCollision(KinBodyConstPtr pbody, CollisionReportPtr report = CollisionReportPtr())
     {
         START_TIMING_OPT(_statistics, "BodySelf",_options,pbody->IsRobot());
@@ -828,8 +1154,25 @@ public:
         boost::shared_ptr<void> onexit((void*) 0, boost::bind(&FCLCollisionChecker::_PrintCollisionManagerInstanceSelf, this, boost::ref(*pbody)));
 #endif
         FCLKinBodyInfoPtr pinfo = _fclspace->GetInfo(*pbody);
+
+        // distance queries need every pair, and collision callbacks could change their answer between calls, so only use the cache for plain collision queries
+        const bool bIncremental = _bIncrementalSelfCollision && !(_options & OpenRAVE::CO_Distance) && !query._bHasCallbacks;
+        bool bUseSelfCollisionCache = false;
+        if( bIncremental ) {
+            pbody->GetDOFValues(_vCachedDOFValues);
+            bUseSelfCollisionCache = _ComputeChangedDOFsSinceSelfCollisionFree(*pinfo, *pbody, adjacentOptions, nonadjacent, _vCachedDOFValues, _vCachedChangedDOFIndices);
+            if( bUseSelfCollisionCache && pbody->GetUpdateStamp() == pinfo->selfcollisioncache.nBodyUpdateStamp ) {
+                // nothing moved since the verified self-collision free state
+                return false;
+            }
+        }
+
         FOREACH(itset, nonadjacent) {
             size_t index1 = *itset&0xffff, index2 = *itset>>16;
+            if( bUseSelfCollisionCache && !_HasLinkPairMoved(*pbody, pinfo->selfcollisioncache, index1, index2, _vCachedChangedDOFIndices) ) {
+                // relative pose is the same as in the verified self-collision free state
+                continue;
+            }
             // We don't need to check if the links are enabled since we got adjacency information with AO_Enabled
             const FCLSpace::FCLKinBodyInfo::LinkInfo& pLINK1 = *pinfo->vlinks.at(index1);
             const FCLSpace::FCLKinBodyInfo::LinkInfo& pLINK2 = *pinfo->vlinks.at(index2);
@@ -855,6 +1198,9 @@ public:
                 }
             }
         }
+        if( bIncremental && !query._bCollision ) {
+            _SetSelfCollisionFreeState(*pinfo, *pbody, adjacentOptions, nonadjacent, _vCachedDOFValues);
+        }
         return query._bCollision;
     }
 
@@ -1241,6 +1587,96 @@ private:
         return false;
     }
 
+    /// \brief computes the distance of the link to the closest geometry pair of the previous query to get an initial upper bound
+    void _WarmStartLinkDistance(LinkDistanceCallbackData& query, const NearestPairCache& nearestcache)
+    {
+        if( nearestcache.otherBodyIndex <= 0 || nearestcache.geomIndex < 0 || nearestcache.geomIndex >= (int)query._linkinfo.vgeoms.size() ) {
+            return;
+        }
+        if( std::find(_attachedBodyIndicesCache.begin(), _attachedBodyIndicesCache.end(), nearestcache.otherBodyIndex) != _attachedBodyIndicesCache.end() ) {
+            return;
+        }
+        const std::vector<KinBodyConstPtr>& vbodies = _fclspace->GetEnvBodies();
+        if( nearestcache.otherBodyIndex >= (int)vbodies.size() || !vbodies[nearestcache.otherBodyIndex] ) {
+            return;
+        }
+        const KinBodyConstPtr& potherbody = vbodies[nearestcache.otherBodyIndex];
+        const FCLKinBodyInfoPtr& potherinfo = _fclspace->GetInfo(*potherbody);
+        if( !potherinfo || nearestcache.otherLinkIndex < 0 || nearestcache.otherLinkIndex >= (int)potherinfo->vlinks.size() ) {
+            return;
+        }
+        const FCLSpace::FCLKinBodyInfo::LinkInfo& otherlinkinfo = *potherinfo->vlinks[nearestcache.otherLinkIndex];
+        const LinkConstPtr plinkOther = potherbody->GetLinks().at(nearestcache.otherLinkIndex);
+        if( nearestcache.otherGeomIndex < 0 || nearestcache.otherGeomIndex >= (int)otherlinkinfo.vgeoms.size() || !_IsDistanceLinkValid(plinkOther, query) ) {
+            return;
+        }
+        _UpdateLinkDistance(query, nearestcache.geomIndex, otherlinkinfo, plinkOther, nearestcache.otherBodyIndex, nearestcache.otherGeomIndex);
+    }
+
+    inline bool _IsDistanceLinkValid(const LinkConstPtr& plink, const LinkDistanceCallbackData& query) const
+    {
+        return plink->IsEnabled() && !IsIn<KinBodyConstPtr>(plink->GetParent(), query._vbodyexcluded) && !IsIn<LinkConstPtr>(plink, query._vlinkexcluded);
+    }
+
+    /// \brief computes the narrow phase distance of one geometry pair and updates the query if it is closer than everything found so far
+    void _UpdateLinkDistance(LinkDistanceCallbackData& query, int geomIndex, const FCLSpace::FCLKinBodyInfo::LinkInfo& otherlinkinfo, const LinkConstPtr& plinkOther, int otherBodyIndex, int otherGeomIndex)
+    {
+        fcl::CollisionObject* pgeom = query._linkinfo.vgeoms[geomIndex].second.get();
+        fcl::CollisionObject* potherGeom = otherlinkinfo.vgeoms[otherGeomIndex].second.get();
+        if( pgeom->getAABB().distance(potherGeom->getAABB()) >= query._fMinDistance ) {
+            return;
+        }
+        query._distanceResult.clear();
+        fcl::distance(pgeom, potherGeom, query._distanceRequest, query._distanceResult);
+        if( query._distanceResult.min_distance < query._fMinDistance ) {
+            query._fMinDistance = query._distanceResult.min_distance;
+            query._nearest.geomIndex = geomIndex;
+            query._nearest.otherBodyIndex = otherBodyIndex;
+            query._nearest.otherLinkIndex = plinkOther->GetIndex();
+            query._nearest.otherGeomIndex = otherGeomIndex;
+            query._plinkOther = plinkOther;
+            query._point = query._distanceResult.nearest_points[0];
+            query._pointOther = query._distanceResult.nearest_points[1];
+        }
+    }
+
+    static bool CheckNarrowPhaseLinkDistance(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data, fcl::FCL_REAL& dist)
+    {
+        LinkDistanceCallbackData* pcb = static_cast<LinkDistanceCallbackData *>(data);
+        return pcb->_pchecker->CheckNarrowPhaseLinkDistance(o1, o2, pcb, dist);
+    }
+
+    bool CheckNarrowPhaseLinkDistance(fcl::CollisionObject *o1, fcl::CollisionObject *o2, LinkDistanceCallbackData* pcb, fcl::FCL_REAL& dist)
+    {
+        // always give the best distance so far to the manager so that it can prune with it
+        dist = pcb->_fMinDistance;
+
+        fcl::CollisionObject* pquery = pcb->_linkinfo.linkBV.second.get();
+        fcl::CollisionObject* pother = o1 == pquery ? o2 : o1;
+        if( pquery->getAABB().distance(pother->getAABB()) >= pcb->_fMinDistance ) {
+            return false;
+        }
+
+        std::pair<FCLSpace::FCLKinBodyInfo::LinkInfo*, LinkConstPtr> otherinfo = GetCollisionLink(*pother);
+        if( !otherinfo.first || !otherinfo.second ) {
+            // standalone objects are ignored like in CheckNarrowPhaseDistance
+            return false;
+        }
+        const LinkConstPtr& plinkOther = otherinfo.second;
+        if( !_IsDistanceLinkValid(plinkOther, *pcb) ) {
+            return false;
+        }
+
+        const int otherBodyIndex = plinkOther->GetParent()->GetEnvironmentBodyIndex();
+        for(int igeom = 0; igeom < (int)pcb->_linkinfo.vgeoms.size(); ++igeom) {
+            for(int iothergeom = 0; iothergeom < (int)otherinfo.first->vgeoms.size(); ++iothergeom) {
+                _UpdateLinkDistance(*pcb, igeom, *otherinfo.first, plinkOther, otherBodyIndex, iothergeom);
+            }
+        }
+        dist = pcb->_fMinDistance;
+        return false;
+    }
+
 #ifdef NARROW_COLLISION_CACHING
     static CollisionPair MakeCollisionPair(fcl::CollisionObject* o1, fcl::CollisionObject* o2)
     {
@@ -1303,7 +1739,7 @@ private:
         _bParentlessCollisionObject = false;
         BODYMANAGERSMAP::iterator it = _bodymanagers.find(std::make_pair(pbody.get(), (int)bactiveDOFs));
         if( it == _bodymanagers.end() ) {
-            FCLCollisionManagerInstancePtr p(new FCLCollisionManagerInstance(*_fclspace, _CreateManager()));
+            FCLCollisionManagerInstancePtr p(new FCLCollisionManagerInstance(*_fclspace, _CreateManagerFromBroadphaseAlgorithm(_GetBodyBroadphaseAlgorithm(*pbody))));
             p->InitBodyManager(pbody, bactiveDOFs);
             it = _bodymanagers.insert(BODYMANAGERSMAP::value_type(std::make_pair(pbody.get(), (int)bactiveDOFs), p)).first;
             
@@ -1413,6 +1849,66 @@ private:
         }
     }
 
+    /// \brief checks if the last self-collision free state of the body can be used for the current query and computes the DOFs that changed since then.
+    ///
+    /// \return true if the cached state is valid. In that case only the link pairs moved by vChangedDOFIndices need to be checked.
+    bool _ComputeChangedDOFsSinceSelfCollisionFree(const FCLSpace::FCLKinBodyInfo& info, const KinBody& body, int adjacentOptions, const std::vector<int>& nonadjacent, const std::vector<dReal>& vDOFValues, std::vector<int>& vChangedDOFIndices) const
+    {
+        vChangedDOFIndices.resize(0);
+        const FCLSpace::FCLKinBodyInfo::SelfCollisionCache& cache = info.selfcollisioncache;
+        if( !cache.bValid || cache.adjacentOptions != adjacentOptions || cache.nLinkUpdateStamp != info.nLinkUpdateStamp || cache.nGeometryUpdateStamp != info.nGeometryUpdateStamp || cache.nActiveDOFUpdateStamp != info.nActiveDOFUpdateStamp ) {
+            return false;
+        }
+        if( cache.vDOFValues.size() != vDOFValues.size() || cache.vLinkTransforms.size() != body.GetLinks().size() || cache.vNonAdjacentLinks != nonadjacent ) {
+            return false;
+        }
+        for(size_t idof = 0; idof < vDOFValues.size(); ++idof) {
+            // compare exactly so that the result is identical to a full check
+            if( cache.vDOFValues[idof] != vDOFValues[idof] ) {
+                vChangedDOFIndices.push_back(idof);
+            }
+        }
+        return true;
+    }
+
+    /// \brief returns true if the relative pose of the two links can have changed since the verified self-collision free state
+    inline bool _HasLinkPairMoved(const KinBody& body, const FCLSpace::FCLKinBodyInfo::SelfCollisionCache& cache, int linkindex1, int linkindex2, const std::vector<int>& vChangedDOFIndices) const
+    {
+        FOREACHC(itdofindex, vChangedDOFIndices) {
+            // if a dof moves both links (or none of them), their relative pose is unchanged
+            if( (body.DoesDOFAffectLink(*itdofindex, linkindex1) == 0) != (body.DoesDOFAffectLink(*itdofindex, linkindex2) == 0) ) {
+                return true;
+            }
+        }
+
+        // links can also be moved without going through the DOFs (SetLinkTransformations, physics), so also compare their relative transform
+        const Transform& tlink1 = body.GetLinks()[linkindex1]->GetTransform();
+        const Transform& tlink2 = body.GetLinks()[linkindex2]->GetTransform();
+        const Transform& tcachedlink1 = cache.vLinkTransforms[linkindex1];
+        const Transform& tcachedlink2 = cache.vLinkTransforms[linkindex2];
+        if( tlink1 == tcachedlink1 && tlink2 == tcachedlink2 ) {
+            return false;
+        }
+        // only allow for the rounding of moving both links with the same transform
+        return (tlink1.inverse()*tlink2).CompareTransform(tcachedlink1.inverse()*tcachedlink2, 1e-10);
+    }
+
+    void _SetSelfCollisionFreeState(FCLSpace::FCLKinBodyInfo& info, const KinBody& body, int adjacentOptions, const std::vector<int>& nonadjacent, const std::vector<dReal>& vDOFValues)
+    {
+        FCLSpace::FCLKinBodyInfo::SelfCollisionCache& cache = info.selfcollisioncache;
+        cache.bValid = true;
+        cache.adjacentOptions = adjacentOptions;
+        cache.nLinkUpdateStamp = info.nLinkUpdateStamp;
+        cache.nGeometryUpdateStamp = info.nGeometryUpdateStamp;
+        cache.nActiveDOFUpdateStamp = info.nActiveDOFUpdateStamp;
+        cache.nBodyUpdateStamp = body.GetUpdateStamp();
+        cache.vDOFValues = vDOFValues;
+        body.GetLinkTransformations(cache.vLinkTransforms);
+        if( cache.vNonAdjacentLinks != nonadjacent ) {
+            cache.vNonAdjacentLinks = nonadjacent;
+        }
+    }
+
     inline bool _IsEnabled(const KinBody& body)
     {
         if( body.IsEnabled() ) {
@@ -1434,7 +1930,11 @@ private:
     boost::shared_ptr<FCLSpace> _fclspace;
     int _numMaxContacts;
     std::string _userdatakey;
-    std::string _broadPhaseCollisionManagerAlgorithm; ///< broadphase algorithm to use to create a manager. tested: Naive, DynamicAABBTree2
+    std::string _broadPhaseCollisionManagerAlgorithm; ///< broadphase algorithm to use to create an environment manager. tested: Naive, DynamicAABBTree2
+    std::string _bodyBroadPhaseCollisionManagerAlgorithm; ///< broadphase algorithm to use to create a body manager when the body has no override
+    std::map<std::string, std::string> _mapBodyBroadPhaseCollisionManagerAlgorithms; ///< maps body name to the broadphase algorithm to use for its managers, overrides _bodyBroadPhaseCollisionManagerAlgorithm
+    bool _bAutoTuneBroadphaseOnInit; ///< if true, InitEnvironment times the candidate broadphase algorithms on the scene and keeps the fastest
+    static const int _nAutoTuneRounds = 10; ///< default number of timed rounds for auto-tuning the broadphase algorithm
 
     typedef std::map< std::pair<const void*, int>, FCLCollisionManagerInstancePtr> BODYMANAGERSMAP; ///< Maps pairs of (body, bactiveDOFs) to oits manager
     BODYMANAGERSMAP _bodymanagers; ///< managers for each of the individual bodies. each manager should be called with InitBodyManager. Cannot use KinBodyPtr here since that will maintain a reference to the body!
@@ -1464,11 +1964,16 @@ private:
     std::vector<fcl::Vec3f> _fclPointsCache;
     std::vector<fcl::Triangle> _fclTrianglesCache;
     std::vector<KinBodyPtr> _vCachedGrabbedBodies;
+    std::vector<dReal> _vCachedDOFValues;
+    std::vector<int> _vCachedChangedDOFIndices;
 
     std::vector<int> _attachedBodyIndicesCache;
 
+    std::map< std::pair<int, int>, NearestPairCache > _mapNearestPairCache; ///< maps (environment body index, link index) to the closest geometry pair found by the last ComputeLinkDistances
+
     bool _bIsSelfCollisionChecker; // Currently not used
     bool _bParentlessCollisionObject; ///< if set to true, the last collision command ran into colliding with an unknown object
+    bool _bIncrementalSelfCollision; ///< if true, CheckStandaloneSelfCollision(body) only checks the link pairs that moved relative to each other since the last self-collision free state
 };
 
 } // fclrave
@@ -153,6 +153,30 @@ public:
             bool bFromKinBodyLink; ///< if true, then from kinbodylink. Otherwise from standalone object that does not have any KinBody associations
         };
 
+        /// \brief state of the body the last time its standalone self-collision was verified to be free
+        ///
+        /// Link pairs whose relative pose did not change since then cannot be in collision, so only the pairs where one of the changed DOFs affects exactly one of the two links, or whose relative link transform differs, need to be rechecked.
+        class SelfCollisionCache
+        {
+public:
+            SelfCollisionCache() : bValid(false), adjacentOptions(0), nLinkUpdateStamp(0), nGeometryUpdateStamp(0), nActiveDOFUpdateStamp(0), nBodyUpdateStamp(0) {
+            }
+
+            inline void Reset() {
+                bValid = false;
+            }
+
+            bool bValid; ///< if true, the body was self-collision free when its DOF values were vDOFValues
+            int adjacentOptions; ///< adjacent options used for GetNonAdjacentLinks when the state was verified
+            int nLinkUpdateStamp; ///< FCLKinBodyInfo::nLinkUpdateStamp when the state was verified
+            int nGeometryUpdateStamp; ///< FCLKinBodyInfo::nGeometryUpdateStamp when the state was verified
+            int nActiveDOFUpdateStamp; ///< FCLKinBodyInfo::nActiveDOFUpdateStamp when the state was verified
+            int nBodyUpdateStamp; ///< KinBody::GetUpdateStamp when the state was verified
+            std::vector<dReal> vDOFValues; ///< DOF values of the verified self-collision free state
+            std::vector<Transform> vLinkTransforms; ///< link transforms of the verified self-collision free state, since links can also be moved without changing the DOF values
+            std::vector<int> vNonAdjacentLinks; ///< the non-adjacent link pairs that were checked for the verified state
+        };
+
         FCLKinBodyInfo() : nLastStamp(0), nLinkUpdateStamp(0), nGeometryUpdateStamp(0), nAttachedBodiesUpdateStamp(0), nActiveDOFUpdateStamp(0)
         {
         }
@@ -167,6 +191,7 @@ public:
                 (*itlink)->Reset();
             }
             vlinks.resize(0);
+            selfcollisioncache.Reset();
             _geometrycallback.reset();
             _geometrygroupcallback.reset();
             _linkenablecallback.reset();
@@ -185,6 +210,7 @@ public:
         int nActiveDOFUpdateStamp; ///< update stamp for when active dofs change of this body
 
         vector< boost::shared_ptr<LinkInfo> > vlinks; ///< info for every link of the kinbody
+        SelfCollisionCache selfcollisioncache; ///< last verified self-collision free state, used by incremental self-collision checking
 
         OpenRAVE::UserDataPtr _bodyAttachedCallback; ///< handle for the callback called when a body is attached or detached
         OpenRAVE::UserDataPtr _activeDOFsCallback; ///< handle for the callback called when a the activeDOFs have changed
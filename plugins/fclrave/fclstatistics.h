@@ -2,6 +2,33 @@
 #ifndef OPENRAVE_FCL_STATISTICS
 #define OPENRAVE_FCL_STATISTICS
 
+#include <chrono>
+
+namespace fclrave {
+
+typedef std::chrono::time_point<std::chrono::high_resolution_clock> time_point;
+typedef std::chrono::duration<double> duration;
+
+/// \brief wall clock timer that is available even when FCLUSESTATISTICS is not defined, used for tuning the checker at runtime
+class FCLTimer {
+public:
+    FCLTimer() : _start(std::chrono::high_resolution_clock::now()) {
+    }
+
+    void Restart() {
+        _start = std::chrono::high_resolution_clock::now();
+    }
+
+    /// \brief returns the number of seconds since construction or the last Restart
+    double GetElapsed() const {
+        return duration(std::chrono::high_resolution_clock::now() - _start).count();
+    }
+
+private:
+    time_point _start;
+};
+
+} // fclrave
 
 #ifdef FCLUSESTATISTICS
 
@@ -16,8 +43,6 @@ class FCLStatistics;
 
 static std::vector<boost::weak_ptr<FCLStatistics> > globalStatistics;
 static EnvironmentMutex log_out_mutex;
-typedef std::chrono::time_point<std::chrono::high_resolution_clock> time_point;
-typedef std::chrono::duration<double> duration;
 
 class FCLStatistics {
 public:
@@ -139,6 +139,13 @@ public:
                 }
                 RAVELOG_DEBUG("Setting QuickStep iterations to: %d\n",_physics->_num_iterations);
             }
+            else if( name == "islandthreads") {
+                int temp=0;
+                _ss >> temp;
+                if( !!_ss ) {
+                    _physics->SetIslandThreads(temp);
+                }
+            }
             else if( name == "surfacelayer") {
                 float temp=0;
                 _ss >> temp;
@@ -170,8 +177,8 @@ public:
             }
         }
 
-        static const boost::array<string, 11>& GetTags() {
-            static const boost::array<string, 11> tags = {{"friction","selfcollision", "gravity", "contact", "erp", "cfm", "elastic_reduction_parameter", "constraint_force_mixing", "dcontactapprox", "numiterations", "surfacelayer" }};
+        static const boost::array<string, 12>& GetTags() {
+            static const boost::array<string, 12> tags = {{"friction","selfcollision", "gravity", "contact", "erp", "cfm", "elastic_reduction_parameter", "constraint_force_mixing", "dcontactapprox", "numiterations", "surfacelayer", "islandthreads" }};
             return tags;
         }
 
@@ -199,9 +206,10 @@ It is possible to set ODE physics engine and its properties inside the <environm
       <selfcollision>1</selfcollision>\n\
       <dcontactapprox>1</dcontactapprox>\n\
       <numiterations>1</numiterations>\n\
+      <islandthreads>4</islandthreads>\n\
     </odeproperties>\n\
   </physicsengine>\n\n\
-The possible properties that can be set are: ";
+**islandthreads** steps the independent islands of bodies (groups connected by joints or contacts) on a pool of threads, 0 steps everything on the simulation thread. The possible properties that can be set are: ";
         FOREACHC(it, PhysicsPropertiesXMLReader::GetTags()) {
             ss << "**" << *it << "**, ";
         }
@@ -216,6 +224,13 @@ The possible properties that can be set are: ";
         _surface_mode = 0;
         _surfacelayer = 0.001;
         _options = OpenRAVE::PEO_SelfCollisions;
+        _numislandthreads = 0;
+#ifdef ODE_HAVE_THREADING_IMPL
+        _threading = NULL;
+        _threadpool = NULL;
+#endif
+        RegisterCommand("SetIslandThreads",boost::bind(&ODEPhysicsEngine::_SetIslandThreadsCommand,this,_1,_2),
+                        "Set the number of threads stepping independent islands of bodies, 0 to step on the simulation thread.");
 
         memset(_jointadd, 0, sizeof(_jointadd));
         _jointadd[dJointTypeBall] = DummyAddForce;
@@ -235,6 +250,7 @@ The possible properties that can be set are: ";
         _jointgetvel[dJointTypeHinge2].push_back(dJointGetHinge2Angle2Rate);
     }
     virtual ~ODEPhysicsEngine() {
+        _DestroyIslandThreading();
         _odespace->Destroy();
     }
 
@@ -260,11 +276,13 @@ The possible properties that can be set are: ";
         dWorldSetCFM(_odespace->GetWorld(),_globalcfm);
         dWorldSetQuickStepNumIterations (_odespace->GetWorld(), _num_iterations);
         dWorldSetContactSurfaceLayer(_odespace->GetWorld(), _surfacelayer);
+        _InitIslandThreading();
         return true;
     }
 
     virtual void DestroyEnvironment()
     {
+        _DestroyIslandThreading();
         _listcallbacks.clear();
         _report.reset();
         _odespace->DestroyEnvironment();
@@ -326,6 +344,36 @@ The possible properties that can be set are: ";
             dWorldSetCFM(_odespace->GetWorld(),_globalcfm);
             dWorldSetQuickStepNumIterations (_odespace->GetWorld(), _num_iterations);
         }
+        SetIslandThreads(r->_numislandthreads);
+    }
+
+    /// \brief sets the number of threads stepping independent islands of bodies.
+    ///
+    /// ODE splits the bodies into islands that are connected by joints or by the contacts found in the broadphase, and
+    /// islands do not interact during a step, so they can be stepped in parallel inside the same world. 0 steps all
+    /// islands on the simulation thread.
+    void SetIslandThreads(int numthreads)
+    {
+        numthreads = max(0, numthreads);
+        if( numthreads == _numislandthreads ) {
+            return;
+        }
+#ifndef ODE_HAVE_THREADING_IMPL
+        if( numthreads > 0 ) {
+            RAVELOG_WARN_FORMAT("env=%s, ODE was not compiled with threading support, cannot step islands on %d threads", GetEnv()->GetNameId()%numthreads);
+            return;
+        }
+#endif
+        _DestroyIslandThreading();
+        _numislandthreads = numthreads;
+        if( !!_odespace && _odespace->IsInitialized() ) {
+            _InitIslandThreading();
+        }
+    }
+
+    int GetIslandThreads() const
+    {
+        return _numislandthreads;
     }
 
     virtual bool SetLinkVelocity(KinBody::LinkPtr plink, const Vector& _linearvel, const Vector& angularvel)
@@ -503,7 +551,7 @@ The possible properties that can be set are: ";
 
         dSpaceCollide (_odespace->GetSpace(),this,nearCallback);
 
-        vector<KinBodyPtr> vbodies;
+        vector<KinBodyPtr>& vbodies = _vcachebodies;
         GetEnv()->GetBodies(vbodies);
 
         if( _options & OpenRAVE::PEO_SelfCollisions ) {
@@ -524,7 +572,9 @@ The possible properties that can be set are: ";
             ODESpace::KinBodyInfoPtr pinfo = _odespace->GetInfo(*itbody);
             BOOST_ASSERT( pinfo->vlinks.size() == (*itbody)->GetLinks().size());
             if( (*itbody)->IsEnabled() ) {
-                vector<Transform> vtrans(pinfo->vlinks.size());
+                vector<Transform>& vtrans = _vcachetransforms;
+                // start from the current transforms so that links with an invalid rotation keep their pose instead of one left over from another body
+                (*itbody)->GetLinkTransformations(vtrans);
                 for(size_t i = 0; i < pinfo->vlinks.size(); ++i) {
                     const dReal* prot = dBodyGetQuaternion(pinfo->vlinks[i]->body);
                     Vector vrot(prot[0],prot[1],prot[2],prot[3]);
@@ -545,10 +595,56 @@ The possible properties that can be set are: ";
         }
 
         _listcallbacks.clear();
+        vbodies.clear(); // do not hold on to the bodies
     }
 
 
 private:
+    bool _SetIslandThreadsCommand(ostream& sout, istream& sinput)
+    {
+        int numthreads = 0;
+        sinput >> numthreads;
+        if( !sinput ) {
+            return false;
+        }
+        SetIslandThreads(numthreads);
+        return _numislandthreads == max(0, numthreads);
+    }
+
+    /// \brief attaches a thread pool to the current world if island threads were requested
+    void _InitIslandThreading()
+    {
+#ifdef ODE_HAVE_THREADING_IMPL
+        if( _numislandthreads <= 0 || !!_threading ) {
+            return;
+        }
+        _threading = dThreadingAllocateMultiThreadedImplementation();
+        _threadpool = dThreadingAllocateThreadPool(_numislandthreads, 0, dAllocateFlagBasicData, NULL);
+        dThreadingThreadPoolServeMultiThreadedImplementation(_threadpool, _threading);
+        dWorldSetStepIslandsProcessingMaxThreadCount(_odespace->GetWorld(), _numislandthreads);
+        dWorldSetStepThreadingImplementation(_odespace->GetWorld(), dThreadingImplementationGetFunctions(_threading), _threading);
+        RAVELOG_DEBUG_FORMAT("env=%s, stepping ode islands on %d threads", GetEnv()->GetNameId()%_numislandthreads);
+#endif
+    }
+
+    /// \brief detaches the thread pool from the world, has to be called before the world is destroyed
+    void _DestroyIslandThreading()
+    {
+#ifdef ODE_HAVE_THREADING_IMPL
+        if( !_threading ) {
+            return;
+        }
+        if( !!_odespace && _odespace->IsInitialized() ) {
+            dWorldSetStepThreadingImplementation(_odespace->GetWorld(), NULL, NULL);
+        }
+        dThreadingImplementationShutdownProcessing(_threading);
+        dThreadingFreeThreadPool(_threadpool);
+        dThreadingFreeImplementation(_threading);
+        _threadpool = NULL;
+        _threading = NULL;
+#endif
+    }
+
     static void nearCallback(void *data, dGeomID o1, dGeomID o2)
     {
         ((ODEPhysicsEngine*)data)->_nearCallback(o1,o2);
@@ -706,6 +802,16 @@ private:
     vector<JointGetFn> _jointgetvel[12];
     std::list<EnvironmentBase::CollisionCallbackFn> _listcallbacks;
     CollisionReportPtr _report;
+
+    int _numislandthreads; ///< number of threads stepping islands, 0 if stepping on the simulation thread
+#ifdef ODE_HAVE_THREADING_IMPL
+    dThreadingImplementationID _threading;
+    dThreadingThreadPoolID _threadpool;
+#endif
+
+    // cached to avoid allocations every step
+    vector<KinBodyPtr> _vcachebodies;
+    vector<Transform> _vcachetransforms;
 };
 
 #endif
@@ -531,6 +531,7 @@ public:
         std::vector<dReal> &velLimits = _cacheVellimits, &accelLimits = _cacheAccelLimits, &jerkLimits = _cacheJerkLimits;
         std::vector<PiecewisePolynomials::Chunk>& tempChunks = _cacheInterpolatedChunks; // for storing interpolation result
         std::vector<PiecewisePolynomials::Chunk>& vChunksOut = _cacheCheckedChunks; // for storing chunks from CheckAllChunksAllConstraints results
+        _chunkPool.ResetStats(); // only count what the shortcut loop itself needs
         std::vector<dReal> &vVelLowerBound = _cacheVelLowerBound, &vAccelLowerBound = _cacheAccelLowerBound; // lower bounds of how much we can scale down velocity/acceleration limits in a certain shortcutting iteration
 
         //
@@ -1074,6 +1075,7 @@ public:
         }
         RAVELOG_DEBUG_FORMAT("env=%d, Finished at shortcut iter=%d/%d (%s), successful=%d; numSlowDowns=%d; duration: %.15e -> %.15e; diff=%.15e", _envId%iter%numIters%ss.str()%numShortcuts%numSlowDowns%tOriginal%tTotal%(tOriginal - tTotal));
         _DumpPiecewisePolynomialTrajectory(pwptraj, "aftershortcut", _dumpLevel);
+        RAVELOG_DEBUG_FORMAT("env=%d, Shortcut chunk pool: acquired=%d; allocations=%d", _envId%_chunkPool.GetNumAcquired()%_chunkPool.GetNumAllocations());
 #ifdef JERK_LIMITED_SMOOTHER_PROGRESS_DEBUG
         ss.str(""); ss.clear();
         GetShortcutStatusString(ss);
@@ -1101,7 +1103,7 @@ public:
             return checkret;
         }
 
-        vChunksOut.resize(0);
+        _chunkPool.Resize(vChunksOut, 0);
 
         std::vector<PiecewisePolynomials::Chunk>& vIntermediateChunks = _vIntermediateChunks; // will be resized in CheckChunkAllConstraints
         for( std::vector<PiecewisePolynomials::Chunk>::const_iterator itchunk = vChunksIn.begin(); itchunk != vChunksIn.end(); ++itchunk ) {
@@ -1110,7 +1112,9 @@ public:
                 return checkret;
             }
 
-            vChunksOut.insert(vChunksOut.end(), vIntermediateChunks.begin(), vIntermediateChunks.end());
+            FOREACHC(itIntermediateChunk, vIntermediateChunks) {
+                _chunkPool.Append(vChunksOut) = *itIntermediateChunk;
+            }
         }
 
 #ifdef JERK_LIMITED_SMOOTHER_VALIDATE
@@ -1169,7 +1173,7 @@ protected:
         _maskinterpolation = IT_Cubic;
     }
 
-    virtual PiecewisePolynomials::CheckReturn _ProcessConstraintReturnIntoChunks(ConstraintFilterReturnPtr contraintReturn, const PiecewisePolynomials::Chunk chunkIn,
+    virtual PiecewisePolynomials::CheckReturn _ProcessConstraintReturnIntoChunks(ConstraintFilterReturnPtr contraintReturn, const PiecewisePolynomials::Chunk& chunkIn,
                                                                                  const bool bMarkConstraintChecked,
                                                                                  std::vector<dReal>& x0Vect, std::vector<dReal>& x1Vect,
                                                                                  std::vector<dReal>& v0Vect, std::vector<dReal>& v1Vect,
@@ -1181,7 +1185,11 @@ protected:
             vChunksOut.reserve(_constraintReturn->_configurationtimes.size());
         }
 
-        PiecewisePolynomials::Polynomial tempPolynomial; // for use in the following loop
+        PiecewisePolynomials::Polynomial& tempPolynomial = _cacheTempPolynomial; // for use in the following loop
+        std::vector<PiecewisePolynomials::Polynomial>& vpolynomials = _cacheTempPolynomials;
+        vpolynomials.resize(_ndof);
+        std::vector<dReal>& vCubicCoeffs = _cacheCubicCoeffs;
+        vCubicCoeffs.resize(4);
 
         std::vector<dReal>::const_iterator itConfigLowerLimit = _parameters->_vConfigLowerLimit.begin();
         std::vector<dReal>::const_iterator itConfigUpperLimit = _parameters->_vConfigUpperLimit.begin();
@@ -1197,8 +1205,6 @@ protected:
             const dReal ideltaTime = 1.0/deltaTime;
             if( deltaTime > PiecewisePolynomials::g_fPolynomialEpsilon ) {
 
-                std::vector<PiecewisePolynomials::Polynomial> vpolynomials(_ndof); // TODO: cache this
-
                 for( size_t idof = 0; idof < _ndof; ++idof ) {
                     /*
                        p(t) = a*t^3 + b*t^2 + c*t + d
@@ -1219,7 +1225,11 @@ protected:
                     const dReal c = v0Vect[idof];
                     const dReal b = 0.5*a0Vect[idof];
                     const dReal a = (((x1Vect[idof] - x0Vect[idof])*ideltaTime - c)*ideltaTime - b)*ideltaTime;
-                    tempPolynomial.Initialize(deltaTime, std::vector<dReal>({d, c, b, a}));
+                    vCubicCoeffs[0] = d;
+                    vCubicCoeffs[1] = c;
+                    vCubicCoeffs[2] = b;
+                    vCubicCoeffs[3] = a;
+                    tempPolynomial.Initialize(deltaTime, vCubicCoeffs);
                     PolynomialCheckReturn limitsret = _limitsChecker.CheckPolynomialLimits(tempPolynomial, *(itConfigLowerLimit + idof), *(itConfigUpperLimit + idof), *(itVelocityLimit + idof), *(itAccelerationLimit + idof), *(itJerkLimit + idof));
                     if( limitsret != PiecewisePolynomials::PCR_Normal ) {
                         RAVELOG_VERBOSE_FORMAT("env=%d, the output chunk is invalid: idof=%d; itime=%d/%d; t=%f/%f; ret=%s", _envId%idof%itime%_constraintReturn->_configurationtimes.size()%curTime%chunkIn.duration%PiecewisePolynomials::GetPolynomialCheckReturnString(limitsret));
@@ -1232,8 +1242,7 @@ protected:
                     vpolynomials[idof] = tempPolynomial;
                 } // end for idof
 
-                PiecewisePolynomials::Chunk tempChunk(deltaTime, vpolynomials);
-                vChunksOut.push_back(tempChunk);
+                _chunkPool.Append(vChunksOut).Initialize(deltaTime, vpolynomials);
                 vChunksOut.back().constraintChecked = bMarkConstraintChecked;
 
                 curTime = _constraintReturn->_configurationtimes[itime];
@@ -1345,6 +1354,9 @@ private:
 
     // For use during CheckX process
     std::vector<PiecewisePolynomials::Chunk> _vIntermediateChunks;
+    PiecewisePolynomials::Polynomial _cacheTempPolynomial; ///< for use in ProcessConstraintReturnIntoChunks
+    std::vector<PiecewisePolynomials::Polynomial> _cacheTempPolynomials; ///< for use in ProcessConstraintReturnIntoChunks
+    std::vector<dReal> _cacheCubicCoeffs; ///< for use in ProcessConstraintReturnIntoChunks
 
     const bool REMOVE_STARTTIMEMULT=true; // do not keep track of fStartTimeVelMult and fStartTimeAccelMult of successful shortcut iterations
     const bool CORRECT_VELACCELMULT=true; // correct the formula for computing new scaled-down vel/accel limits
@@ -38,6 +38,75 @@ namespace PiecewisePolynomials = PiecewisePolynomialsInternal;
 
 using PiecewisePolynomials::PolynomialCheckReturn;
 
+/// \brief Keeps the chunks dropped by rejected shortcut attempts so that later attempts can reuse the coefficient
+///        storage they own instead of going back to the heap. Chunks are moved in and out of the pool, so neither
+///        releasing nor acquiring a chunk copies its polynomials. Once the pool has warmed up, a shortcut attempt
+///        should not allocate at all; the counters are there to verify that.
+class ChunkPool
+{
+public:
+    /// \brief Resize vchunks to n elements. Trailing chunks are returned to the pool and new chunks are taken from it.
+    void Resize(std::vector<PiecewisePolynomials::Chunk>& vchunks, size_t n)
+    {
+        while( vchunks.size() > n ) {
+            if( _vfreechunks.size() == _vfreechunks.capacity() ) {
+                ++_numAllocations;
+            }
+            _vfreechunks.push_back(std::move(vchunks.back()));
+            vchunks.pop_back();
+        }
+        while( vchunks.size() < n ) {
+            Append(vchunks);
+        }
+    }
+
+    /// \brief Append a chunk to vchunks, reusing a released chunk whenever one is available. The returned chunk has to
+    ///        be initialized (or assigned to) by the caller.
+    PiecewisePolynomials::Chunk& Append(std::vector<PiecewisePolynomials::Chunk>& vchunks)
+    {
+        ++_numAcquired;
+        if( vchunks.size() == vchunks.capacity() ) {
+            ++_numAllocations;
+        }
+        if( _vfreechunks.empty() ) {
+            ++_numAllocations;
+            vchunks.emplace_back();
+        }
+        else {
+            vchunks.emplace_back(std::move(_vfreechunks.back()));
+            _vfreechunks.pop_back();
+        }
+        PiecewisePolynomials::Chunk& chunk = vchunks.back();
+        chunk.constraintChecked = false;
+        chunk._iteration = -1;
+        return chunk;
+    }
+
+    /// \brief Reset the counters. The pooled chunks are kept.
+    inline void ResetStats()
+    {
+        _numAcquired = 0;
+        _numAllocations = 0;
+    }
+
+    /// \brief Number of chunks handed out since the last ResetStats.
+    inline size_t GetNumAcquired() const
+    {
+        return _numAcquired;
+    }
+
+    /// \brief Number of times a chunk could not be taken from the pool or a chunk vector had to grow since the last ResetStats.
+    inline size_t GetNumAllocations() const
+    {
+        return _numAllocations;
+    }
+
+private:
+    std::vector<PiecewisePolynomials::Chunk> _vfreechunks; ///< chunks released by previous attempts. their polynomials keep their storage.
+    size_t _numAcquired = 0;
+    size_t _numAllocations = 0;
+}; // end class ChunkPool
+
 class JerkLimitedSmootherBase : public PlannerBase {
 public:
     JerkLimitedSmootherBase(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv)
@@ -213,7 +282,7 @@ public:
         const bool bMarkConstraintChecked = (options & requiredCheckOptions) == requiredCheckOptions;
 
         if( chunkIn.duration <= g_fEpsilon ) {
-            vChunksOut.resize(1);
+            _chunkPool.Resize(vChunksOut, 1);
             vChunksOut[0].SetConstant(x0Vect, 0, 5);
             // TODO: correcrtly handle this case. Should we actually store boundary conditions (v0,
             // v1, a0, a1) directly in Chunk?
@@ -221,7 +290,7 @@ public:
             return PiecewisePolynomials::CheckReturn(0);
         }
 
-        vChunksOut.resize(0);
+        _chunkPool.Resize(vChunksOut, 0);
 
         if( _bUsePerturbation ) {
             options |= CFO_CheckWithPerturbation;
@@ -373,7 +442,7 @@ public:
             }
         }
         else {
-            vChunksOut.resize(1);
+            _chunkPool.Resize(vChunksOut, 1);
             vChunksOut[0] = chunkIn;
             vChunksOut[0].constraintChecked = bMarkConstraintChecked;
         }
@@ -503,7 +572,7 @@ protected:
     /// \param[in] a1Vect for holding intermediate values
     /// \param[out] vChunksOut the resulting chunks reconstructed from constraintReturn
     /// \return CheckReturn struct containing check result.
-    virtual PiecewisePolynomials::CheckReturn _ProcessConstraintReturnIntoChunks(ConstraintFilterReturnPtr contraintReturn, const PiecewisePolynomials::Chunk chunkIn,
+    virtual PiecewisePolynomials::CheckReturn _ProcessConstraintReturnIntoChunks(ConstraintFilterReturnPtr contraintReturn, const PiecewisePolynomials::Chunk& chunkIn,
                                                                                  const bool bMarkConstraintChecked,
                                                                                  std::vector<dReal>& x0Vect, std::vector<dReal>& x1Vect,
                                                                                  std::vector<dReal>& v0Vect, std::vector<dReal>& v1Vect,
@@ -1087,6 +1156,7 @@ protected:
 
     std::vector<PiecewisePolynomials::Chunk> _cacheInterpolatedChunks; ///< for storing interpolation results
     std::vector<PiecewisePolynomials::Chunk> _cacheCheckedChunks; ///< for storing results from CheckChunkAllConstraints
+    ChunkPool _chunkPool; ///< recycles the chunks produced while checking shortcut attempts. lives as long as the planner.
 
     // for use in CheckChunkAllConstraints.
     std::vector<dReal> _cacheX0Vect2, _cacheX1Vect2, _cacheV0Vect2, _cacheV1Vect2, _cacheA0Vect2, _cacheA1Vect2;
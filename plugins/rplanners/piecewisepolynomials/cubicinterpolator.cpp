@@ -88,62 +88,69 @@ PolynomialCheckReturn CubicInterpolator::Compute1DTrajectoryZeroTimeDerivativesO
     const dReal j = startWithNegativeBounds ? -jm : jm;
     std::vector<Polynomial> vpolynomials; // resulting trajectory
     vpolynomials.reserve(7);
-    Polynomial poly; // for temporarily holding the polynomial for each segment
+    CubicPolynomial segment; // for temporarily holding the polynomial for each segment. evaluated in place without allocating derivative coefficients.
 
     dReal prevPosition, prevVelocity, prevAcceleration;
     const dReal constantJerk = j/6.0; // segments that have non-zero jerk use this value.
 
     // Segment1
-    poly.Initialize(tj, std::vector<dReal>({x0, 0, 0, constantJerk}));
-    vpolynomials.push_back(poly);
-    prevPosition = poly.Eval(poly.duration);
-    prevVelocity = poly.Evald1(poly.duration);
-    prevAcceleration = poly.Evald2(poly.duration);
+    segment.Initialize(tj, {{x0, 0, 0, constantJerk}});
+    vpolynomials.emplace_back();
+    segment.ToPolynomial(vpolynomials.back());
+    prevPosition = segment.Eval(segment.duration);
+    prevVelocity = segment.Evald1(segment.duration);
+    prevAcceleration = segment.Evald2(segment.duration);
 
     // Segment2
     if( ta > 0 ) {
-        poly.Initialize(ta, std::vector<dReal>({prevPosition, prevVelocity, 0.5*a, 0.0}));
-        vpolynomials.push_back(poly);
-        prevPosition = poly.Eval(poly.duration);
-        prevVelocity = poly.Evald1(poly.duration);
+        segment.Initialize(ta, {{prevPosition, prevVelocity, 0.5*a, 0.0}});
+        vpolynomials.emplace_back();
+        segment.ToPolynomial(vpolynomials.back());
+        prevPosition = segment.Eval(segment.duration);
+        prevVelocity = segment.Evald1(segment.duration);
         prevAcceleration = a;
     }
 
     // Segment3
-    poly.Initialize(tj, std::vector<dReal>({prevPosition, prevVelocity, 0.5*prevAcceleration, -constantJerk}));
-    vpolynomials.push_back(poly);
-    prevPosition = poly.Eval(poly.duration);
-    prevVelocity = poly.Evald1(poly.duration);
+    segment.Initialize(tj, {{prevPosition, prevVelocity, 0.5*prevAcceleration, -constantJerk}});
+    vpolynomials.emplace_back();
+    segment.ToPolynomial(vpolynomials.back());
+    prevPosition = segment.Eval(segment.duration);
+    prevVelocity = segment.Evald1(segment.duration);
     prevAcceleration = 0; // segment 3 ends with zero acceleration
 
     // Segment4
     if( tv > 0 ) {
-        poly.Initialize(tv, std::vector<dReal>({prevPosition, v, 0.0, 0.0}));
-        vpolynomials.push_back(poly);
-        prevPosition = poly.Eval(poly.duration);
+        segment.Initialize(tv, {{prevPosition, v, 0.0, 0.0}});
+        vpolynomials.emplace_back();
+        segment.ToPolynomial(vpolynomials.back());
+        prevPosition = segment.Eval(segment.duration);
         prevVelocity = v;
         prevAcceleration = 0;
     }
 
     // Segment5
-    poly.Initialize(tj, std::vector<dReal>({prevPosition, prevVelocity, 0.0, -constantJerk}));
-    vpolynomials.push_back(poly);
-    prevPosition = poly.Eval(poly.duration);
-    prevVelocity = poly.Evald1(poly.duration);
-    prevAcceleration = poly.Evald2(poly.duration);
+    segment.Initialize(tj, {{prevPosition, prevVelocity, 0.0, -constantJerk}});
+    vpolynomials.emplace_back();
+    segment.ToPolynomial(vpolynomials.back());
+    prevPosition = segment.Eval(segment.duration);
+    prevVelocity = segment.Evald1(segment.duration);
+    prevAcceleration = segment.Evald2(segment.duration);
 
     // Segment6
     if( ta > 0 ) {
-        poly.Initialize(ta, std::vector<dReal>({prevPosition, prevVelocity, -0.5*a, 0.0}));
-        vpolynomials.push_back(poly);
-        prevPosition = poly.Eval(poly.duration);
-        prevVelocity = poly.Evald1(poly.duration);
+        segment.Initialize(ta, {{prevPosition, prevVelocity, -0.5*a, 0.0}});
+        vpolynomials.emplace_back();
+        segment.ToPolynomial(vpolynomials.back());
+        prevPosition = segment.Eval(segment.duration);
+        prevVelocity = segment.Evald1(segment.duration);
         prevAcceleration = -a;
     }
 
     // Segment7
-    poly.Initialize(tj, std::vector<dReal>({prevPosition, prevVelocity, 0.5*prevAcceleration, constantJerk}));
-    vpolynomials.push_back(poly);
+    segment.Initialize(tj, {{prevPosition, prevVelocity, 0.5*prevAcceleration, constantJerk}});
+    vpolynomials.emplace_back();
+    segment.ToPolynomial(vpolynomials.back());
 
     pwpoly.Initialize(vpolynomials);
 
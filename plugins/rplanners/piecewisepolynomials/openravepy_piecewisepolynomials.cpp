@@ -1063,6 +1063,49 @@ public:
 
 }; // end class PyPolynomialChecker
 
+/// \brief wraps FindRealRootsInRange. coeffs is weakest term first and has degree at most four.
+py::list FindRealRootsInRange(const py::object ocoeffs, const dReal tmin, const dReal tmax)
+{
+    std::vector<dReal> coeffs = openravepy::ExtractArray<dReal>(ocoeffs);
+    if( coeffs.size() < 1 || coeffs.size() > 5 ) {
+        throw OPENRAVE_EXCEPTION_FORMAT("expected 1 to 5 coefficients, got %d", coeffs.size(), ORE_InvalidArguments);
+    }
+    dReal roots[4];
+    int numroots = 0;
+    piecewisepolynomials::FindRealRootsInRange((int)coeffs.size() - 1, &coeffs[0], tmin, tmax, roots, numroots);
+    py::list oroots;
+    for( int iroot = 0; iroot < numroots; ++iroot ) {
+        oroots.append(roots[iroot]);
+    }
+    return oroots;
+}
+
+/// \brief returns the real roots found by the general iterative solver used for higher degrees. coeffs is weakest term first.
+py::list PolyRoots(const py::object ocoeffs)
+{
+    std::vector<dReal> coeffs = openravepy::ExtractArray<dReal>(ocoeffs);
+    while( coeffs.size() > 0 && coeffs.back() == 0 ) {
+        coeffs.pop_back();
+    }
+    py::list oroots;
+    if( coeffs.size() < 2 ) {
+        return oroots;
+    }
+    const int degree = (int)coeffs.size() - 1;
+    std::vector<dReal> roots(degree);
+    int numroots = 0;
+#ifdef PIECEWISE_POLY_POLY_COMMON_H_USE_EIGEN
+    piecewisepolynomials::polyrealroots(degree, &coeffs[0], &roots[0], numroots);
+#else
+    std::vector<dReal> rawcoeffs(coeffs.rbegin(), coeffs.rend()); // strongest term first
+    piecewisepolynomials::polyroots(degree, &rawcoeffs[0], &roots[0], numroots);
+#endif
+    for( int iroot = 0; iroot < numroots; ++iroot ) {
+        oroots.append(roots[iroot]);
+    }
+    return oroots;
+}
+
 } // end namespace piecewisepolynomialspy
 
 #ifndef USE_PYBIND11_PYTHON_BINDINGS
@@ -1298,4 +1341,12 @@ OPENRAVE_PYTHON_MODULE(openravepy_piecewisepolynomials)
     .value("PCR_DurationTooLong", piecewisepolynomials::PCR_DurationTooLong)
     .value("PCR_GenericError", piecewisepolynomials::PCR_GenericError)
     ;
+
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    m.def("FindRealRootsInRange", piecewisepolynomialspy::FindRealRootsInRange, PY_ARGS("coeffs", "tmin", "tmax") "Return the real roots in [tmin, tmax] of a polynomial of degree at most four, coefficients weakest term first.");
+    m.def("PolyRoots", piecewisepolynomialspy::PolyRoots, PY_ARGS("coeffs") "Return the real roots of a polynomial found by the general iterative solver, coefficients weakest term first.");
+#else
+    def("FindRealRootsInRange", piecewisepolynomialspy::FindRealRootsInRange, PY_ARGS("coeffs", "tmin", "tmax") "Return the real roots in [tmin, tmax] of a polynomial of degree at most four, coefficients weakest term first.");
+    def("PolyRoots", piecewisepolynomialspy::PolyRoots, PY_ARGS("coeffs") "Return the real roots of a polynomial found by the general iterative solver, coefficients weakest term first.");
+#endif
 }
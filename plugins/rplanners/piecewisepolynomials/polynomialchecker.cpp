@@ -66,7 +66,11 @@ PolynomialCheckReturn PolynomialChecker::CheckPolynomialValues(const Polynomial&
 #endif
         return PCR_DurationDiscrepancy;
     }
-    dReal pos = p.Eval(t);
+    return _CheckValueDiscrepancies(t, p.Eval(t), p.Evald1(t), p.Evald2(t), x, v, a);
+}
+
+PolynomialCheckReturn PolynomialChecker::_CheckValueDiscrepancies(const dReal t, const dReal pos, const dReal vel, const dReal accel, const dReal x, const dReal v, const dReal a)
+{
     if( !FuzzyEquals(pos, x, epsilonForPositionDiscrepancyChecking) ) {
 #ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
         _failedPoint = t;
@@ -76,7 +80,6 @@ PolynomialCheckReturn PolynomialChecker::CheckPolynomialValues(const Polynomial&
         return PCR_PositionDiscrepancy;
     }
 
-    dReal vel = p.Evald1(t);
     if( !FuzzyEquals(vel, v, epsilonForVelocityDiscrepancyChecking) ) {
 #ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
         _failedPoint = t;
@@ -86,7 +89,6 @@ PolynomialCheckReturn PolynomialChecker::CheckPolynomialValues(const Polynomial&
         return PCR_VelocityDiscrepancy;
     }
 
-    dReal accel = p.Evald2(t);
     if( !FuzzyEquals(accel, a, epsilonForAccelerationDiscrepancyChecking) ) {
 #ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
         _failedPoint = t;
@@ -101,170 +103,156 @@ PolynomialCheckReturn PolynomialChecker::CheckPolynomialValues(const Polynomial&
 
 PolynomialCheckReturn PolynomialChecker::CheckPolynomialLimits(const Polynomial& p, const dReal xmin, const dReal xmax, const dReal vm, const dReal am, const dReal jm)
 {
-    std::vector<Coordinate>& vcoords = _cacheCoordsVect;
+    const dReal T = p.duration;
+    return _CheckPolynomialLimits(p, xmin, xmax, vm, am, jm,
+                                  p.Eval(0), p.Eval(T), p.Evald1(0), p.Evald1(T), p.Evald2(0), p.Evald2(T), p.Evald3(0), p.Evald3(T));
+}
+
+PolynomialCheckReturn PolynomialChecker::_CheckPolynomialLimits(const Polynomial& p, const dReal xmin, const dReal xmax, const dReal vm, const dReal am, const dReal jm,
+                                                                const dReal x0, const dReal x1, const dReal v0, const dReal v1,
+                                                                const dReal a0, const dReal a1, const dReal j0, const dReal j1)
+{
     const dReal T = p.duration;
     const bool bCheckVelocity = p.degree > 0 && vm > g_fPolynomialEpsilon;
     const bool bCheckAcceleration = p.degree > 1 && am > g_fPolynomialEpsilon;
     const bool bCheckJerk = p.degree > 2 && jm > g_fPolynomialEpsilon;
 
-    dReal val; // for holding a temporary value
+    PolynomialCheckReturn ret;
 
     // Check position limits at boundaries
-    val = p.Eval(0);
-    if( val > xmax + g_fPolynomialEpsilon || val < xmin - g_fPolynomialEpsilon ) {
-#ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
-        _failedPoint = 0;
-        _failedValue = val;
-        _expectedValue = val > xmax ? xmax : xmin;
-#endif
-        return PCR_PositionLimitsViolation;
+    ret = _CheckValueLimits(0, x0, xmin, xmax, g_fPolynomialEpsilon, PCR_PositionLimitsViolation);
+    if( ret != PCR_Normal ) {
+        return ret;
     }
-    val = p.Eval(T);
-    if( val > xmax + g_fPolynomialEpsilon || val < xmin - g_fPolynomialEpsilon ) {
-#ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
-        _failedPoint = T;
-        _failedValue = val;
-        _expectedValue = val > xmax ? xmax : xmin;
-#endif
-        return PCR_PositionLimitsViolation;
+    ret = _CheckValueLimits(T, x1, xmin, xmax, g_fPolynomialEpsilon, PCR_PositionLimitsViolation);
+    if( ret != PCR_Normal ) {
+        return ret;
     }
 
     // Check velocity limits at boundaries
     if( bCheckVelocity ) {
-        val = p.Evald1(0);
-        if( val > vm + g_fPolynomialEpsilon || val < -vm - g_fPolynomialEpsilon ) {
-#ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
-            _failedPoint = 0;
-            _failedValue = val;
-            _expectedValue = val > vm ? vm : -vm;
-#endif
-            return PCR_VelocityLimitsViolation;
+        ret = _CheckValueLimits(0, v0, -vm, vm, g_fPolynomialEpsilon, PCR_VelocityLimitsViolation);
+        if( ret != PCR_Normal ) {
+            return ret;
         }
-        val = p.Evald1(T);
-        if( val > vm + g_fPolynomialEpsilon || val < -vm - g_fPolynomialEpsilon ) {
-#ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
-            _failedPoint = T;
-            _failedValue = val;
-            _expectedValue = val > vm ? vm : -vm;
-#endif
-            return PCR_VelocityLimitsViolation;
+        ret = _CheckValueLimits(T, v1, -vm, vm, g_fPolynomialEpsilon, PCR_VelocityLimitsViolation);
+        if( ret != PCR_Normal ) {
+            return ret;
         }
     }
 
     // Check acceleration limits at boundaries
     if( bCheckAcceleration ) {
-        val = p.Evald2(0);
-        if( val > am + g_fPolynomialEpsilon || val < -am - g_fPolynomialEpsilon ) {
-#ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
-            _failedPoint = 0;
-            _failedValue = val;
-            _expectedValue = val > am ? am : -am;
-#endif
-            return PCR_AccelerationLimitsViolation;
+        ret = _CheckValueLimits(0, a0, -am, am, g_fPolynomialEpsilon, PCR_AccelerationLimitsViolation);
+        if( ret != PCR_Normal ) {
+            return ret;
         }
-        val = p.Evald2(T);
-        if( val > am + g_fPolynomialEpsilon || val < -am - g_fPolynomialEpsilon ) {
-#ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
-            _failedPoint = T;
-            _failedValue = val;
-            _expectedValue = val > am ? am : -am;
-#endif
-            return PCR_AccelerationLimitsViolation;
+        ret = _CheckValueLimits(T, a1, -am, am, g_fPolynomialEpsilon, PCR_AccelerationLimitsViolation);
+        if( ret != PCR_Normal ) {
+            return ret;
         }
     }
 
     // Check jerk limits at boundaries
     if( bCheckJerk ) {
-        val = p.Evald3(0);
-        if( val > jm + epsilonForJerkLimitsChecking || val < -jm - epsilonForJerkLimitsChecking ) {
-#ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
-            _failedPoint = 0;
-            _failedValue = val;
-            _expectedValue = val > jm ? jm : -jm;
-#endif
-            return PCR_JerkLimitsViolation;
+        ret = _CheckValueLimits(0, j0, -jm, jm, epsilonForJerkLimitsChecking, PCR_JerkLimitsViolation);
+        if( ret != PCR_Normal ) {
+            return ret;
         }
-        val = p.Evald3(T);
-        if( val > jm + epsilonForJerkLimitsChecking || val < -jm - epsilonForJerkLimitsChecking ) {
-#ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
-            _failedPoint = T;
-            _failedValue = val;
-            _expectedValue = val > jm ? jm : -jm;
-#endif
-            return PCR_JerkLimitsViolation;
+        ret = _CheckValueLimits(T, j1, -jm, jm, epsilonForJerkLimitsChecking, PCR_JerkLimitsViolation);
+        if( ret != PCR_Normal ) {
+            return ret;
         }
     }
 
     // Now bounadries are ok. Check in-between values.
-    // Check position limits
-    for( std::vector<Coordinate>::const_iterator it = p.GetExtrema().begin(); it != p.GetExtrema().end(); ++it ) {
-        if( it->point >= -g_fPolynomialEpsilon && it->point <= T + g_fPolynomialEpsilon ) {
-            // This extremum occurs in the range
-            if( it->value > xmax + g_fPolynomialEpsilon || it->value < xmin - g_fPolynomialEpsilon ) {
-#ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
-                _failedPoint = it->point;
-                _failedValue = it->value;
-                _expectedValue = it->value > xmax ? xmax : xmin;
-#endif
-                return PCR_PositionLimitsViolation;
-            }
-        }
+    ret = _CheckCriticalPointLimits(p, 0, xmin, xmax, g_fPolynomialEpsilon, PCR_PositionLimitsViolation);
+    if( ret != PCR_Normal ) {
+        return ret;
     }
-
-    // Check velocity limits
     if( bCheckVelocity ) {
-        p.FindAllLocalExtrema(1, vcoords);
-        for( std::vector<Coordinate>::const_iterator it = vcoords.begin(); it != vcoords.end(); ++it ) {
-            if( it->point >= -g_fPolynomialEpsilon && it->point <= T + g_fPolynomialEpsilon ) {
-                // This extremum occurs in the range
-                if( it->value > vm + g_fPolynomialEpsilon || it->value < -vm - g_fPolynomialEpsilon ) {
-#ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
-                    _failedPoint = it->point;
-                    _failedValue = it->value;
-                    _expectedValue = it->value > vm ? vm : -vm;
-#endif
-                    return PCR_VelocityLimitsViolation;
-                }
-            }
+        ret = _CheckCriticalPointLimits(p, 1, -vm, vm, g_fPolynomialEpsilon, PCR_VelocityLimitsViolation);
+        if( ret != PCR_Normal ) {
+            return ret;
         }
     }
-
-    // Check acceleration limits
     if( bCheckAcceleration ) {
-        p.FindAllLocalExtrema(2, vcoords);
-        for( std::vector<Coordinate>::const_iterator it = vcoords.begin(); it != vcoords.end(); ++it ) {
-            if( it->point >= -g_fPolynomialEpsilon && it->point <= T + g_fPolynomialEpsilon ) {
-                // This extremum occurs in the range
-                if( it->value > am + g_fPolynomialEpsilon || it->value < -am - g_fPolynomialEpsilon ) {
+        ret = _CheckCriticalPointLimits(p, 2, -am, am, g_fPolynomialEpsilon, PCR_AccelerationLimitsViolation);
+        if( ret != PCR_Normal ) {
+            return ret;
+        }
+    }
+    if( bCheckJerk ) {
+        ret = _CheckCriticalPointLimits(p, 3, -jm, jm, epsilonForJerkLimitsChecking, PCR_JerkLimitsViolation);
+        if( ret != PCR_Normal ) {
+            return ret;
+        }
+    }
+
+    return PCR_Normal;
+}
+
+PolynomialCheckReturn PolynomialChecker::_CheckValueLimits(const dReal t, const dReal val, const dReal lower, const dReal upper, const dReal epsilon, const PolynomialCheckReturn failret)
+{
+    if( val > upper + epsilon || val < lower - epsilon ) {
 #ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
-                    _failedPoint = it->point;
-                    _failedValue = it->value;
-                    _expectedValue = it->value > am ? am : -am;
+        _failedPoint = t;
+        _failedValue = val;
+        _expectedValue = val > upper ? upper : lower;
 #endif
-                    return PCR_AccelerationLimitsViolation;
-                }
-            }
-        }
+        return failret;
     }
+    return PCR_Normal;
+}
 
-    // Check jerk limits
-    if( bCheckJerk ) {
-        p.FindAllLocalExtrema(3, vcoords);
+PolynomialCheckReturn PolynomialChecker::_CheckCriticalPointLimits(const Polynomial& p, const size_t ideriv, const dReal lower, const dReal upper, const dReal epsilon, const PolynomialCheckReturn failret)
+{
+    if( p.degree < ideriv + 2 ) {
+        // The ideriv-th derivative is at most linear so its extrema are at the boundaries, which are already checked.
+        return PCR_Normal;
+    }
+    const dReal T = p.duration;
+    const size_t derivdegree = p.degree - ideriv;
+    if( derivdegree - 1 > 4 ) {
+        // The critical points are roots of a polynomial of degree higher than four. Go through the general extrema computation.
+        std::vector<Coordinate>& vcoords = _cacheCoordsVect;
+        if( ideriv == 0 ) {
+            vcoords = p.GetExtrema();
+        }
+        else {
+            p.FindAllLocalExtrema(ideriv, vcoords);
+        }
         for( std::vector<Coordinate>::const_iterator it = vcoords.begin(); it != vcoords.end(); ++it ) {
             if( it->point >= -g_fPolynomialEpsilon && it->point <= T + g_fPolynomialEpsilon ) {
                 // This extremum occurs in the range
-                if( it->value > jm + epsilonForJerkLimitsChecking || it->value < -jm - epsilonForJerkLimitsChecking ) {
-#ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
-                    _failedPoint = it->point;
-                    _failedValue = it->value;
-                    _expectedValue = it->value > jm ? jm : -jm;
-#endif
-                    return PCR_JerkLimitsViolation;
+                PolynomialCheckReturn ret = _CheckValueLimits(it->point, it->value, lower, upper, epsilon, failret);
+                if( ret != PCR_Normal ) {
+                    return ret;
                 }
             }
         }
+        return PCR_Normal;
     }
 
+    // Coefficients (weakest term first) of the ideriv-th derivative and of the one after it.
+    dReal derivcoeffs[6], dderivcoeffs[5], criticalpoints[4];
+    for( size_t icoeff = 0; icoeff <= derivdegree; ++icoeff ) {
+        derivcoeffs[icoeff] = FallingFactorial(icoeff + ideriv, ideriv)*p.vcoeffs[icoeff + ideriv];
+    }
+    for( size_t icoeff = 0; icoeff < derivdegree; ++icoeff ) {
+        dderivcoeffs[icoeff] = (icoeff + 1)*derivcoeffs[icoeff + 1];
+    }
+    // Every critical point in the range is checked, not only the local extrema. A critical point that is not an extremum
+    // still has a value attained by the polynomial inside the range, so this does not change the result.
+    int numcriticalpoints = 0;
+    FindRealRootsInRange((int)derivdegree - 1, dderivcoeffs, -g_fPolynomialEpsilon, T + g_fPolynomialEpsilon, criticalpoints, numcriticalpoints);
+    for( int icritical = 0; icritical < numcriticalpoints; ++icritical ) {
+        const dReal val = EvalPolynomial((int)derivdegree, derivcoeffs, criticalpoints[icritical]);
+        PolynomialCheckReturn ret = _CheckValueLimits(criticalpoints[icritical], val, lower, upper, epsilon, failret);
+        if( ret != PCR_Normal ) {
+            return ret;
+        }
+    }
     return PCR_Normal;
 }
 
@@ -346,7 +334,10 @@ PolynomialCheckReturn PolynomialChecker::CheckChunk(const Chunk& c, const std::v
     bool bHasVelocityLimits = vmVect.size() == ndof;
     bool bHasAccelerationLimits = amVect.size() == ndof;
     bool bHasJerkLimits = jmVect.size() == ndof;
-    PolynomialCheckReturn ret;
+    PolynomialCheckReturn ret = PCR_Normal;
+    // Evaluate the boundary values of all dofs at once instead of going through each polynomial separately.
+    c.EvalAll(0, _cacheX0Vect, _cacheV0Vect, _cacheA0Vect, _cacheJ0Vect);
+    c.EvalAll(c.duration, _cacheX1Vect, _cacheV1Vect, _cacheA1Vect, _cacheJ1Vect);
     for( size_t idof = 0; idof < ndof; ++idof ) {
         if( bHasVelocityLimits ) {
             vm = vmVect[idof];
@@ -367,8 +358,16 @@ PolynomialCheckReturn PolynomialChecker::CheckChunk(const Chunk& c, const std::v
 #endif
             return PCR_DurationDiscrepancy;
         }
-        ret = CheckPolynomial(c.vpolynomials[idof], xminVect[idof], xmaxVect[idof], vm, am, jm,
-                              x0Vect[idof], x1Vect[idof], v0Vect[idof], v1Vect[idof], a0Vect[idof], a1Vect[idof]);
+        // Same sequence of checks as CheckPolynomial
+        ret = _CheckValueDiscrepancies(0, _cacheX0Vect[idof], _cacheV0Vect[idof], _cacheA0Vect[idof], x0Vect[idof], v0Vect[idof], a0Vect[idof]);
+        if( ret == PCR_Normal ) {
+            ret = _CheckValueDiscrepancies(c.duration, _cacheX1Vect[idof], _cacheV1Vect[idof], _cacheA1Vect[idof], x1Vect[idof], v1Vect[idof], a1Vect[idof]);
+        }
+        if( ret == PCR_Normal ) {
+            ret = _CheckPolynomialLimits(c.vpolynomials[idof], xminVect[idof], xmaxVect[idof], vm, am, jm,
+                                         _cacheX0Vect[idof], _cacheX1Vect[idof], _cacheV0Vect[idof], _cacheV1Vect[idof],
+                                         _cacheA0Vect[idof], _cacheA1Vect[idof], _cacheJ0Vect[idof], _cacheJ1Vect[idof]);
+        }
         if( ret != PCR_Normal ) {
 #ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
             _failedDOF = idof;
@@ -399,9 +398,14 @@ PolynomialCheckReturn PolynomialChecker::CheckChunkValues(const Chunk& c, dReal
 PolynomialCheckReturn PolynomialChecker::CheckChunkLimits(const Chunk& c, const std::vector<dReal>& xminVect, const std::vector<dReal>& xmaxVect,
                                                           const std::vector<dReal>& vmVect, const std::vector<dReal>& amVect, const std::vector<dReal>& jmVect)
 {
+    // Evaluate the boundary values of all dofs at once. The per-dof checks below then only need to look for critical points.
+    c.EvalAll(0, _cacheX0Vect, _cacheV0Vect, _cacheA0Vect, _cacheJ0Vect);
+    c.EvalAll(c.duration, _cacheX1Vect, _cacheV1Vect, _cacheA1Vect, _cacheJ1Vect);
     PolynomialCheckReturn ret = PCR_Normal;
     for( size_t idof = 0; idof < ndof; ++idof ) {
-        ret = CheckPolynomialLimits(c.vpolynomials[idof], xminVect[idof], xmaxVect[idof], vmVect[idof], amVect[idof], jmVect[idof]);
+        ret = _CheckPolynomialLimits(c.vpolynomials[idof], xminVect[idof], xmaxVect[idof], vmVect[idof], amVect[idof], jmVect[idof],
+                                     _cacheX0Vect[idof], _cacheX1Vect[idof], _cacheV0Vect[idof], _cacheV1Vect[idof],
+                                     _cacheA0Vect[idof], _cacheA1Vect[idof], _cacheJ0Vect[idof], _cacheJ1Vect[idof]);
         if( ret != PCR_Normal ) {
 #ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
             _failedDOF = idof;
@@ -514,9 +518,7 @@ PolynomialCheckReturn PolynomialChecker::CheckChunks(const std::vector<Chunk>& v
 
         if( (itchunk + 1) != vchunks.end() ) {
             // Evaluate final values, preparing for validation of the next chunk
-            itchunk->Eval(itchunk->duration, prevXVect);
-            itchunk->Evald1(itchunk->duration, prevVVect);
-            itchunk->Evald2(itchunk->duration, prevAVect);
+            itchunk->EvalAll(itchunk->duration, prevXVect, prevVVect, prevAVect);
         }
     }
     return PCR_Normal;
@@ -147,6 +147,7 @@ public:
 
     std::vector<Coordinate> _cacheCoordsVect;
     std::vector<dReal> _cacheXVect, _cacheVVect, _cacheAVect;
+    std::vector<dReal> _cacheX0Vect, _cacheX1Vect, _cacheV0Vect, _cacheV1Vect, _cacheA0Vect, _cacheA1Vect, _cacheJ0Vect, _cacheJ1Vect; ///< boundary values of all dofs of the chunk being checked
 
 #ifdef JERK_LIMITED_POLY_CHECKER_DEBUG
     dReal _failedPoint;
@@ -157,6 +158,23 @@ public:
 #endif
 
 private:
+    /// \brief Check the given values of a polynomial at time t against the expected values.
+    PolynomialCheckReturn _CheckValueDiscrepancies(const dReal t, const dReal pos, const dReal vel, const dReal accel, const dReal x, const dReal v, const dReal a);
+
+    /// \brief Same as CheckPolynomialLimits but with the boundary values (position, velocity, acceleration, and jerk at
+    ///        t = 0 and t = p.duration) already evaluated, which lets chunk checks evaluate them for all dofs at once.
+    PolynomialCheckReturn _CheckPolynomialLimits(const Polynomial& p, const dReal xmin, const dReal xmax, const dReal vm, const dReal am, const dReal jm,
+                                                 const dReal x0, const dReal x1, const dReal v0, const dReal v1,
+                                                 const dReal a0, const dReal a1, const dReal j0, const dReal j1);
+
+    /// \brief Return failret if val is not within [lower - epsilon, upper + epsilon]. Otherwise, return PCR_Normal.
+    PolynomialCheckReturn _CheckValueLimits(const dReal t, const dReal val, const dReal lower, const dReal upper, const dReal epsilon, const PolynomialCheckReturn failret);
+
+    /// \brief Check the values of the ideriv-th derivative of p at its critical points in [0, p.duration]. For
+    ///        derivatives whose critical points are roots of a polynomial of degree at most four, the roots are found
+    ///        with FindRealRootsInRange instead of the general polynomial root finder.
+    PolynomialCheckReturn _CheckCriticalPointLimits(const Polynomial& p, const size_t ideriv, const dReal lower, const dReal upper, const dReal epsilon, const PolynomialCheckReturn failret);
+
     // Specific tolerance for checking discrepancies.
     dReal epsilonForPositionDiscrepancyChecking = g_fPolynomialEpsilon;
     dReal epsilonForVelocityDiscrepancyChecking = g_fPolynomialEpsilon;
@@ -147,6 +147,166 @@ inline bool ClampValueToLimit(dReal& x, const dReal ul, const dReal epsilon)
     return true;
 }
 
+/// \brief Evaluate the polynomial of the given degree at x. Weakest coefficient first.
+inline dReal EvalPolynomial(const int degree, const dReal* coeffs, const dReal x)
+{
+    dReal val = coeffs[degree];
+    for( int i = degree - 1; i >= 0; --i ) {
+        val = val*x + coeffs[i];
+    }
+    return val;
+}
+
+/// \brief Find the root of a polynomial that is monotonic on [a, b] and changes sign there, fa = p(a) and fb =
+///        p(b). Newton steps are taken whenever they stay inside the current bracket, bisection otherwise.
+inline dReal _PolishBracketedRoot(const int degree, const dReal* coeffs, dReal a, dReal b, dReal fa)
+{
+    const dReal tol = 4*std::numeric_limits<dReal>::epsilon();
+    dReal x = 0.5*(a + b);
+    for( int step = 0; step < 100; ++step ) {
+        // Evaluate the polynomial and its derivative together.
+        dReal fx = coeffs[degree], dfx = 0;
+        for( int i = degree - 1; i >= 0; --i ) {
+            dfx = dfx*x + fx;
+            fx = fx*x + coeffs[i];
+        }
+        if( fx == 0 ) {
+            break;
+        }
+        if( (fx < 0) == (fa < 0) ) {
+            a = x;
+            fa = fx;
+        }
+        else {
+            b = x;
+        }
+        dReal xnext = dfx != 0 ? x - fx/dfx : a;
+        if( !(xnext > a && xnext < b) ) {
+            xnext = 0.5*(a + b);
+        }
+        const bool bConverged = RaveFabs(xnext - x) <= tol*(1 + RaveFabs(x));
+        x = xnext;
+        if( bConverged ) {
+            break;
+        }
+    }
+    return x;
+}
+
+/// \brief Find the real roots in [tmin, tmax] of a polynomial of degree at most four. Weakest coefficient first. The
+///        roots are returned in increasing order. Linear and quadratic polynomials are solved in closed form. Cubic and
+///        quartic polynomials are reduced to them: the roots of the derivative split [tmin, tmax] into pieces where the
+///        polynomial is monotonic, so each piece contains at most one root, which is then polished from its bracket.
+///        Unlike polyroots, there is no complex arithmetic and no iteration over all roots at once.
+///
+/// \param roots must be able to hold degree values.
+inline void FindRealRootsInRange(int degree, const dReal* coeffs, const dReal tmin, const dReal tmax, dReal* roots, int& numroots)
+{
+    numroots = 0;
+    while( degree > 0 && coeffs[degree] == 0 ) {
+        --degree;
+    }
+    BOOST_ASSERT(degree <= 4);
+    if( degree <= 0 ) {
+        // Constant polynomials do not have isolated roots.
+        return;
+    }
+    if( degree == 1 ) {
+        const dReal root = -coeffs[0]/coeffs[1];
+        if( root >= tmin && root <= tmax ) {
+            roots[numroots++] = root;
+        }
+        return;
+    }
+    if( degree == 2 ) {
+        // Same treatment as in Polynomial::_FindAllLocalExtrema
+        const dReal a = coeffs[2], b = coeffs[1], c = coeffs[0];
+        const dReal det = b*b - 4*a*c;
+        const dReal tol = 64.0*std::numeric_limits<dReal>::epsilon();
+        if( det < -tol ) {
+            return;
+        }
+        dReal r0, r1;
+        if( det <= tol ) {
+            r0 = r1 = -0.5*b/a;
+        }
+        else {
+            const dReal temp = b >= 0 ? -0.5*(b + RaveSqrt(det)) : -0.5*(b - RaveSqrt(det));
+            r0 = temp/a;
+            r1 = c/temp;
+            if( r0 > r1 ) {
+                Swap(r0, r1);
+            }
+        }
+        if( r0 >= tmin && r0 <= tmax ) {
+            roots[numroots++] = r0;
+        }
+        if( r1 != r0 && r1 >= tmin && r1 <= tmax ) {
+            roots[numroots++] = r1;
+        }
+        return;
+    }
+
+    dReal dcoeffs[4];
+    for( int i = 0; i < degree; ++i ) {
+        dcoeffs[i] = (i + 1)*coeffs[i + 1];
+    }
+    dReal criticalpoints[3];
+    int numcriticalpoints = 0;
+    FindRealRootsInRange(degree - 1, dcoeffs, tmin, tmax, criticalpoints, numcriticalpoints);
+
+    dReal a = tmin;
+    dReal fa = EvalPolynomial(degree, coeffs, a);
+    for( int i = 0; i <= numcriticalpoints; ++i ) {
+        const dReal b = i < numcriticalpoints ? criticalpoints[i] : tmax;
+        dReal fb = EvalPolynomial(degree, coeffs, b);
+        if( i < numcriticalpoints && fb != 0 ) {
+            // A repeated root is a critical point where the polynomial touches zero without changing sign, so the
+            // rounding error of the evaluation decides whether it is found. Accept values within that error.
+            dReal fScale = 0, fPower = 1;
+            for( int j = 0; j <= degree; ++j ) {
+                fScale += RaveFabs(coeffs[j])*fPower;
+                fPower *= RaveFabs(b);
+            }
+            if( RaveFabs(fb) <= 64.0*std::numeric_limits<dReal>::epsilon()*fScale ) {
+                fb = 0;
+            }
+        }
+        if( fa == 0 ) {
+            if( numroots == 0 || roots[numroots - 1] != a ) {
+                roots[numroots++] = a;
+            }
+        }
+        else if( fb != 0 && (fa < 0) != (fb < 0) ) {
+            roots[numroots++] = _PolishBracketedRoot(degree, coeffs, a, b, fa);
+        }
+        a = b;
+        fa = fb;
+    }
+    if( fa == 0 && (numroots == 0 || roots[numroots - 1] != a) ) {
+        roots[numroots++] = a;
+    }
+}
+
+/// \brief Find all real roots of a polynomial of degree at most four. Weakest coefficient first. See FindRealRootsInRange.
+inline void FindRealRoots(int degree, const dReal* coeffs, dReal* roots, int& numroots)
+{
+    numroots = 0;
+    while( degree > 0 && coeffs[degree] == 0 ) {
+        --degree;
+    }
+    if( degree <= 0 ) {
+        return;
+    }
+    // Cauchy's bound: all roots lie within |x| <= 1 + max_i |coeffs[i]/coeffs[degree]|
+    dReal fBound = 0;
+    for( int i = 0; i < degree; ++i ) {
+        fBound = Max(fBound, RaveFabs(coeffs[i]/coeffs[degree]));
+    }
+    fBound += 1;
+    FindRealRootsInRange(degree, coeffs, -fBound, fBound, roots, numroots);
+}
+
 #ifdef PIECEWISE_POLY_POLY_COMMON_H_USE_EIGEN
 // Weakest coeff first. This eigenvalue-method, however, is prone to numerical errors in some cases,
 // for example, when there are repeating roots. According to my test, solving x^3 - 3x^2 + 3x - 1 =
@@ -197,9 +357,11 @@ inline void polyroots(const int degree, const dReal* rawcoeffs, dReal* rawroots,
     complex<dReal> roots[degree];
     dReal err[degree];
     roots[0] = complex<dReal>(1,0);
-    roots[1] = complex<dReal>(0.4,0.9); // any complex number not a root of unity works
     err[0] = 1.0;
-    err[1] = 1.0;
+    if( degree > 1 ) {
+        roots[1] = complex<dReal>(0.4,0.9); // any complex number not a root of unity works
+        err[1] = 1.0;
+    }
     for(int i = 2; i < degree; ++i) {
         roots[i] = roots[i - 1]*roots[1];
         err[i] = 1.0;
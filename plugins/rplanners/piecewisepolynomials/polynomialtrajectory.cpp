@@ -415,6 +415,12 @@ void Polynomial::_FindAllLocalExtrema() const
         }
         rawroots.resize(numroots);
     }
+    else if( degree - 1 - iNonZeroLeadCoeff <= 4 ) {
+        // Low-degree derivatives (in particular those of cubic and quintic polynomials) do not need the iterative
+        // solver. vcoeffsd is weakest term first, so the vanishing leading terms are simply left out.
+        FindRealRoots((int)degree - 1 - iNonZeroLeadCoeff, &vcoeffsd[0], &rawroots[0], numroots);
+        rawroots.resize(numroots);
+    }
     else {
         polyroots((int)degree - 1 - iNonZeroLeadCoeff, &rawcoeffs[iNonZeroLeadCoeff], &rawroots[0], numroots);
         rawroots.resize(numroots);
@@ -907,6 +913,56 @@ void Chunk::Evaldn(dReal t, size_t n, std::vector<dReal>& res) const
     }
 }
 
+void Chunk::EvalAll(dReal t, std::vector<dReal>& xVect, std::vector<dReal>& vVect, std::vector<dReal>& aVect) const
+{
+    _EvalAll(t, xVect, vVect, aVect, NULL);
+}
+
+void Chunk::EvalAll(dReal t, std::vector<dReal>& xVect, std::vector<dReal>& vVect, std::vector<dReal>& aVect, std::vector<dReal>& jVect) const
+{
+    _EvalAll(t, xVect, vVect, aVect, &jVect);
+}
+
+void Chunk::_EvalAll(dReal t, std::vector<dReal>& xVect, std::vector<dReal>& vVect, std::vector<dReal>& aVect, std::vector<dReal>* pjVect) const
+{
+    xVect.resize(dof);
+    vVect.resize(dof);
+    aVect.resize(dof);
+    if( !!pjVect ) {
+        pjVect->resize(dof);
+    }
+    if( t < 0 ) {
+        t = 0;
+    }
+    else if( t > duration ) {
+        t = duration;
+    }
+    for( size_t idof = 0; idof < dof; ++idof ) {
+        // Horner's method for the position and its first three derivatives at once, from the strongest term down
+        const std::vector<dReal>& vcoeffs = vpolynomials[idof].vcoeffs;
+        dReal x = 0, v = 0, a = 0, j = 0;
+        for( size_t ipower = vcoeffs.size(); ipower-- > 0; ) {
+            const dReal coeff = vcoeffs[ipower];
+            x = x*t + coeff;
+            if( ipower >= 1 ) {
+                v = v*t + ipower*coeff;
+            }
+            if( ipower >= 2 ) {
+                a = a*t + FallingFactorial(ipower, 2)*coeff;
+            }
+            if( ipower >= 3 ) {
+                j = j*t + FallingFactorial(ipower, 3)*coeff;
+            }
+        }
+        xVect[idof] = x;
+        vVect[idof] = v;
+        aVect[idof] = a;
+        if( !!pjVect ) {
+            (*pjVect)[idof] = j;
+        }
+    }
+}
+
 void Chunk::Serialize(std::ostream& O) const
 {
     O << duration;
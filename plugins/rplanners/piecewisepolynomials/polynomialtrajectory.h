@@ -14,6 +14,7 @@
 #ifndef PIECEWISE_POLY_TRAJECTORY_H
 #define PIECEWISE_POLY_TRAJECTORY_H
 
+#include <array>
 #include <vector>
 #include <openrave/openrave.h>
 #include "polynomialcommon.h"
@@ -160,6 +161,92 @@ private:
     mutable std::vector<dReal> _vcurcoeffs;
 }; // end class Polynomial
 
+/// \brief Return k*(k - 1)*...*(k - n + 1), the factor the coefficient of t**k gets when differentiating n times.
+inline dReal FallingFactorial(size_t k, size_t n)
+{
+    dReal fMult = 1;
+    for( size_t i = 0; i < n; ++i ) {
+        fMult *= (dReal)(k - i);
+    }
+    return fMult;
+}
+
+/// \brief Polynomial of compile-time degree N with inline coefficient storage.
+///
+/// Derivatives are evaluated directly from the coefficients, so initializing and evaluating never allocates. Used for
+/// intermediate computations in the interpolators; call ToPolynomial when a Polynomial is needed.
+template <size_t N>
+class FixedDegreePolynomial {
+public:
+    FixedDegreePolynomial() : duration(0)
+    {
+        vcoeffs.fill(0);
+    }
+    FixedDegreePolynomial(const dReal T, const std::array<dReal, N + 1>& c) : vcoeffs(c), duration(T)
+    {
+    }
+
+    /// \brief Initialize this polynomial with the given coefficients (weakest term first).
+    inline void Initialize(const dReal T, const std::array<dReal, N + 1>& c)
+    {
+        vcoeffs = c;
+        duration = T;
+    }
+
+    /// \brief Evaluate the n-th derivative of this polynomial at time t. t is clamped to [0, duration].
+    inline dReal Evaldn(dReal t, size_t n) const
+    {
+        if( n > N ) {
+            return 0;
+        }
+        if( t < 0 ) {
+            t = 0;
+        }
+        else if( t > duration ) {
+            t = duration;
+        }
+        dReal val = FallingFactorial(N, n)*vcoeffs[N];
+        for( size_t icoeff = N; icoeff-- > n; ) {
+            val = val*t + FallingFactorial(icoeff, n)*vcoeffs[icoeff];
+        }
+        return val;
+    }
+
+    inline dReal Eval(dReal t) const
+    {
+        return Evaldn(t, 0);
+    }
+
+    inline dReal Evald1(dReal t) const
+    {
+        return Evaldn(t, 1);
+    }
+
+    inline dReal Evald2(dReal t) const
+    {
+        return Evaldn(t, 2);
+    }
+
+    inline dReal Evald3(dReal t) const
+    {
+        return Evaldn(t, 3);
+    }
+
+    /// \brief Initialize p with the coefficients and duration of this polynomial. Reuses the storage of p.
+    inline void ToPolynomial(Polynomial& p) const
+    {
+        p.vcoeffs.assign(vcoeffs.begin(), vcoeffs.end());
+        p.duration = duration;
+        p.Initialize();
+    }
+
+    std::array<dReal, N + 1> vcoeffs; ///< coefficients of this polynomial (weakest term first)
+    dReal duration; ///< the polynomial is valid for t \in [0, duration]
+}; // end class FixedDegreePolynomial
+
+typedef FixedDegreePolynomial<3> CubicPolynomial;
+typedef FixedDegreePolynomial<5> QuinticPolynomial;
+
 class PiecewisePolynomial {
 public:
     /*
@@ -269,9 +356,13 @@ public:
     {
     }
     Chunk(const dReal duration, const std::vector<Polynomial>& vpolynomials);
+    Chunk(const Chunk& r) = default;
+    Chunk(Chunk&& r) = default; ///< moving hands over the coefficient storage so that chunks can be recycled without copying polynomials
     ~Chunk()
     {
     }
+    Chunk& operator=(const Chunk& r) = default;
+    Chunk& operator=(Chunk&& r) = default;
 
     //
     // Functions
@@ -307,6 +398,12 @@ public:
     /// \brief Evaluate the n-th derivatives of all polynomials at time t.
     void Evaldn(dReal t, size_t n, std::vector<dReal>& res) const;
 
+    /// \brief Evaluate the positions, velocities and accelerations of all polynomials at time t. Each polynomial is evaluated in one Horner pass over its own coefficients, without computing the coefficients of its derivatives.
+    void EvalAll(dReal t, std::vector<dReal>& xVect, std::vector<dReal>& vVect, std::vector<dReal>& aVect) const;
+
+    /// \brief Evaluate the positions, velocities, accelerations and jerks of all polynomials at time t. See the EvalAll above.
+    void EvalAll(dReal t, std::vector<dReal>& xVect, std::vector<dReal>& vVect, std::vector<dReal>& aVect, std::vector<dReal>& jVect) const;
+
     /// \brief Serialize this chunk into stringstream.
     void Serialize(std::ostream& O) const;
 
@@ -327,6 +424,10 @@ public:
     mutable bool constraintChecked = false; ///< TODO: write a description for this parameter (similar to that of RampND)
     mutable int _iteration = -1; /// for debugging only. keeps track of the shortcut iteration from which this chunk is introduced into the final trajectory.
 
+private:
+    /// \brief Evaluate up to the third derivatives of each polynomial in one pass over its coefficients. pjVect can be NULL.
+    void _EvalAll(dReal t, std::vector<dReal>& xVect, std::vector<dReal>& vVect, std::vector<dReal>& aVect, std::vector<dReal>* pjVect) const;
+
 }; // end class Chunk
 
 class PiecewisePolynomialTrajectory {
@@ -17,6 +17,23 @@ namespace OpenRAVE {
 
 namespace PiecewisePolynomialsInternal {
 
+/// \brief Compute the quintic polynomial of duration T that satisfies the given boundary conditions.
+static void ComputeQuinticFixedDuration(const dReal x0, const dReal x1, const dReal v0, const dReal v1, const dReal a0, const dReal a1, const dReal T, QuinticPolynomial& quintic)
+{
+    const dReal T2 = T*T;
+    const dReal T3 = T2*T;
+    const dReal T4 = T3*T;
+    const dReal T5 = T4*T;
+    quintic.Initialize(T, {{
+        x0,
+        v0,
+        0.5*a0,
+        (T2*(a1 - 3.0*a0) - T*(12.0*v0 + 8.0*v1) + 20.0*(x1 - x0))/(2*T3),
+        (T2*(3.0*a0 - 2.0*a1) + T*(16.0*v0 + 14.0*v1) + 30.0*(x0 - x1))/(2*T4),
+        (T2*(a1 - a0) - 6.0*T*(v1 + v0) + 12.0*(x1 - x0))/(2*T5)
+    }});
+}
+
 QuinticInterpolator::QuinticInterpolator(size_t ndof_, int envid_)
 {
     __description = ":Interface Author: Puttichai Lertkultanon\n\nRoutines for quintic polynomial interpolation with specified boundary conditions.";
@@ -128,21 +145,11 @@ PolynomialCheckReturn QuinticInterpolator::Compute1DTrajectoryArbitraryTimeDeriv
                                                                                                     const dReal xmin, const dReal xmax, const dReal vm, const dReal am, const dReal jm,
                                                                                                     PiecewisePolynomial& pwpoly)
 {
-    dReal T2 = T*T;
-    dReal T3 = T2*T;
-    dReal T4 = T3*T;
-    dReal T5 = T4*T;
-
-    std::vector<dReal>& vcoeffs = _cache1DCoeffs;
-    vcoeffs[0] = x0;
-    vcoeffs[1] = v0;
-    vcoeffs[2] = 0.5*a0;
-    vcoeffs[3] = (T2*(a1 - 3.0*a0) - T*(12.0*v0 + 8.0*v1) + 20.0*(x1 - x0))/(2*T3);
-    vcoeffs[4] = (T2*(3.0*a0 - 2.0*a1) + T*(16.0*v0 + 14.0*v1) + 30.0*(x0 - x1))/(2*T4);
-    vcoeffs[5] = (T2*(a1 - a0) - 6.0*T*(v1 + v0) + 12.0*(x1 - x0))/(2*T5);
+    QuinticPolynomial quintic;
+    ComputeQuinticFixedDuration(x0, x1, v0, v1, a0, a1, T, quintic);
 
     Polynomial& polynomial = _cachePolynomial;
-    polynomial.Initialize(T, vcoeffs);
+    quintic.ToPolynomial(polynomial);
     pwpoly.Initialize(polynomial);
     return checker.CheckPolynomial(pwpoly.GetPolynomial(0), xmin, xmax, vm, am, jm, x0, x1, v0, v1, a0, a1);
 }
@@ -216,12 +223,12 @@ PolynomialCheckReturn QuinticInterpolator::ComputeNDTrajectoryArbitraryTimeDeriv
     OPENRAVE_ASSERT_OP(a0Vect.size(), ==, ndof);
     OPENRAVE_ASSERT_OP(a1Vect.size(), ==, ndof);
 
-    PiecewisePolynomial& resultPWPolynomial = _cachePWPolynomial;
+    // the whole chunk is checked below, so compute the coefficients directly instead of going through the checked 1D routine
     std::vector<Polynomial>& finalPolynomials = _cachePolynomials; // should already have size=ndof
+    QuinticPolynomial quintic;
     for( size_t idof = 0; idof < ndof; ++idof ) {
-        Compute1DTrajectoryArbitraryTimeDerivativesFixedDuration(x0Vect[idof], x1Vect[idof], v0Vect[idof], v1Vect[idof], a0Vect[idof], a1Vect[idof], T,
-                                                                 xminVect[idof], xmaxVect[idof], vmVect[idof], amVect[idof], jmVect[idof], resultPWPolynomial);
-        finalPolynomials[idof] = resultPWPolynomial.GetPolynomial(0); // can do this since for this quintic interpolator, resultPWPolynomial always has one polynomial
+        ComputeQuinticFixedDuration(x0Vect[idof], x1Vect[idof], v0Vect[idof], v1Vect[idof], a0Vect[idof], a1Vect[idof], T, quintic);
+        quintic.ToPolynomial(finalPolynomials[idof]);
     }
     chunks.resize(1);
     chunks[0].Initialize(T, finalPolynomials);
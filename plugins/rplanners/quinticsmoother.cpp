@@ -391,6 +391,7 @@ public:
         std::vector<dReal> &velLimits = _cacheVellimits, &accelLimits = _cacheAccelLimits, &jerkLimits = _cacheJerkLimits;
         std::vector<PiecewisePolynomials::Chunk>& tempChunks = _cacheInterpolatedChunks; // for storing interpolation result
         std::vector<PiecewisePolynomials::Chunk>& vChunksOut = _cacheCheckedChunks; // for storing chunks from CheckAllChunksAllConstraints results
+        _chunkPool.ResetStats(); // only count what the shortcut loop itself needs
 
         //
         // Main shortcut loop
@@ -688,6 +689,7 @@ public:
         }
         RAVELOG_DEBUG_FORMAT("env=%d, Finished at shortcut iter=%d/%d (%s), successful=%d; numSlowDowns=%d; duration: %.15e -> %.15e; diff=%.15e", _envId%iter%numIters%ss.str()%numShortcuts%numSlowDowns%tOriginal%tTotal%(tOriginal - tTotal));
         _DumpPiecewisePolynomialTrajectory(pwptraj, "aftershortcut", _dumpLevel);
+        RAVELOG_DEBUG_FORMAT("env=%d, Shortcut chunk pool: acquired=%d; allocations=%d", _envId%_chunkPool.GetNumAcquired()%_chunkPool.GetNumAllocations());
 
         return numShortcuts;
     }
@@ -719,7 +721,7 @@ protected:
         _maskinterpolation = IT_Quintic;
     }
 
-    virtual PiecewisePolynomials::CheckReturn _ProcessConstraintReturnIntoChunks(ConstraintFilterReturnPtr contraintReturn, const PiecewisePolynomials::Chunk chunkIn,
+    virtual PiecewisePolynomials::CheckReturn _ProcessConstraintReturnIntoChunks(ConstraintFilterReturnPtr contraintReturn, const PiecewisePolynomials::Chunk& chunkIn,
                                                                                  const bool bMarkConstraintChecked,
                                                                                  std::vector<dReal>& x0Vect, std::vector<dReal>& x1Vect,
                                                                                  std::vector<dReal>& v0Vect, std::vector<dReal>& v1Vect,
@@ -791,7 +793,7 @@ protected:
                 }
 
                 FOREACH(itchunk, tempChunks) {
-                    vChunksOut.push_back(*itchunk);
+                    _chunkPool.Append(vChunksOut) = *itchunk;
                     vChunksOut.back().constraintChecked = bMarkConstraintChecked;
                 }
                 curTime = _constraintReturn->_configurationtimes[itime];
@@ -68,6 +68,9 @@ protected:
 
     CollisionAction _CollisionCallback(object fncallback, CollisionReportPtr preport, bool bFromPhysics);
 
+    /// \brief converts a published body state to a python dict
+    object _ConvertBodyStateToPython(const KinBody::BodyState& bodystate);
+
 public:
     PyEnvironmentBase(int options=ECO_StartSimulationThread);
     PyEnvironmentBase(const std::string& name, int options=ECO_StartSimulationThread);
@@ -120,6 +123,8 @@ public:
 
     object CheckCollisionRays(py::numeric::array rays, PyKinBodyPtr pbody,bool bFrontFacingOnly=false);
 
+    object CheckCollisionConfigurations(PyKinBodyPtr pbody, py::numeric::array configurations, object odofindices=py::none_(), bool bSelfCollision=true);
+
     bool CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray);
 
     bool CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray, PyCollisionReportPtr pReport);
@@ -195,6 +200,8 @@ public:
     bool HasRegisteredCollisionCallbacks();
 
     void StepSimulation(dReal timeStep);
+    /// \brief returns a dict with numsteps, simulationtime and elapsedtime in microseconds, stepspersecond and realtimefactor
+    object StepSimulationBatch(int numsteps, dReal timeStep);
     void StartSimulation(dReal fDeltaTime, bool bRealTime=true);
     void StopSimulation(int shutdownthread=1);
     uint64_t GetSimulationTime();
@@ -277,6 +284,8 @@ public:
 
     object GetPublishedBodyTransformsMatchingPrefix(const std::string &prefix, uint64_t timeout=0);
 
+    object GetPublishedBodiesChangedSince(uint64_t generation=0);
+
     object Triangulate(PyKinBodyPtr pbody);
 
     object TriangulateScene(const int options, const std::string &name);
@@ -297,6 +306,7 @@ public:
 
     object ExtractInfo() const;
     object UpdateFromInfo(PyEnvironmentBaseInfoPtr info, UpdateFromInfoMode updateMode);
+    object GetUpdateFromInfoCounters() const;
 
     int GetRevision() const;
 
@@ -338,5 +348,30 @@ public:
     EnvironmentBasePtr GetEnv() const;
 };
 
+class PyEnvironmentStateSaver
+{
+    PyEnvironmentBasePtr _pyenv;
+    EnvironmentBase::EnvironmentStateSaver _state;
+public:
+    PyEnvironmentStateSaver(PyEnvironmentBasePtr pyenv);
+    PyEnvironmentStateSaver(PyEnvironmentBasePtr pyenv, object options);
+    virtual ~PyEnvironmentStateSaver();
+
+    PyEnvironmentBasePtr GetEnv() const;
+
+    void Restore();
+
+    void Release();
+
+    size_t GetBufferSize() const;
+
+    void __enter__();
+    void __exit__(object type, object value, object traceback);
+
+    std::string __str__();
+    object __unicode__();
+};
+typedef OPENRAVE_SHARED_PTR<PyEnvironmentStateSaver> PyEnvironmentStateSaverPtr;
+
 } // namespace openravepy
 #endif // OPENRAVEPY_INTERNAL_ENVIRONMENTBASE_H
@@ -230,6 +230,74 @@ private:
 
 typedef OPENRAVE_SHARED_PTR<PythonThreadSaver> PythonThreadSaverPtr;
 
+/// \brief validates that oout is a writeable C-contiguous dReal numpy array of numvalues elements and returns its data.
+///
+/// Used by functions taking preallocated output arrays so that polling loops do not allocate a new array every call.
+inline dReal* ExtractOutputArray(const py::object& oout, size_t numvalues)
+{
+    if( !PyArray_Check(oout.ptr()) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT0(_("out needs to be a numpy array"), ORE_InvalidArguments);
+    }
+    PyArrayObject* pyarr = reinterpret_cast<PyArrayObject*>(oout.ptr());
+    if( PyArray_TYPE(pyarr) != select_npy_type<dReal>::type || !PyArray_ISCARRAY(pyarr) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT0(_("out needs to be a writeable C-contiguous float64 numpy array"), ORE_InvalidArguments);
+    }
+    if( (size_t)PyArray_SIZE(pyarr) != numvalues ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("out has %d elements, but %d are needed"), PyArray_SIZE(pyarr)%numvalues, ORE_InvalidArguments);
+    }
+    return reinterpret_cast<dReal*>(PyArray_DATA(pyarr));
+}
+
+inline void _DestroyArrayViewOwner(PyObject* pycapsule)
+{
+    delete reinterpret_cast<OPENRAVE_SHARED_PTR<void const>*>(PyCapsule_GetPointer(pycapsule, NULL));
+}
+
+/// \brief returns a read-only numpy array viewing pdata without copying it.
+///
+/// The array keeps powner alive through its base object. The view is only valid as long as the memory of pdata is not reallocated by the owner, so it should not be kept across modifications of the owner.
+template <typename T>
+inline py::object toPyArrayView(const T* pdata, int nd, npy_intp* dims, npy_intp* strides, OPENRAVE_SHARED_PTR<void const> powner)
+{
+    // no NPY_ARRAY_WRITEABLE flag so that python cannot modify the internal data
+    PyObject* pyarr = PyArray_New(&PyArray_Type, nd, dims, select_npy_type<T>::type, strides, const_cast<T*>(pdata), 0, NPY_ARRAY_ALIGNED, NULL);
+    if( !pyarr ) {
+        throw OPENRAVE_EXCEPTION_FORMAT0(_("failed to create numpy array view"), ORE_Assert);
+    }
+    PyObject* pycapsule = PyCapsule_New(new OPENRAVE_SHARED_PTR<void const>(powner), NULL, &_DestroyArrayViewOwner);
+    PyArray_SetBaseObject(reinterpret_cast<PyArrayObject*>(pyarr), pycapsule); // steals pycapsule
+    return py::handle_to_object(pyarr);
+}
+
+/// \brief returns (vertices, indices) read-only views of the trimesh buffers. vertices is Nx3 (strided over the 4 components of Vector), indices is Mx3.
+inline py::object toPyTriMeshView(const TriMesh& mesh, OPENRAVE_SHARED_PTR<void const> powner)
+{
+    npy_intp vertexdims[] = { npy_intp(mesh.vertices.size()), 3 };
+    npy_intp vertexstrides[] = { npy_intp(sizeof(Vector)), npy_intp(sizeof(dReal)) };
+    npy_intp indexdims[] = { npy_intp(mesh.indices.size()/3), 3 };
+    npy_intp indexstrides[] = { npy_intp(3*sizeof(int32_t)), npy_intp(sizeof(int32_t)) };
+    return py::make_tuple(toPyArrayView<dReal>(mesh.vertices.size() > 0 ? &mesh.vertices[0].x : NULL, 2, vertexdims, vertexstrides, powner),
+                          toPyArrayView<int32_t>(mesh.indices.size() > 0 ? &mesh.indices[0] : NULL, 2, indexdims, indexstrides, powner));
+}
+
+/// \brief returns (positions, indices) read-only views of a compact mesh buffer. positions is Nx3 float32, indices is Mx3 uint16 or int32 depending on TriMeshBuffer::Has16BitIndices.
+inline py::object toPyTriMeshBufferView(const TriMeshBufferConstPtr& pmesh)
+{
+    npy_intp positiondims[] = { npy_intp(pmesh->GetNumVertices()), 3 };
+    npy_intp positionstrides[] = { npy_intp(3*sizeof(float)), npy_intp(sizeof(float)) };
+    npy_intp indexdims[] = { npy_intp(pmesh->GetNumIndices()/3), 3 };
+    py::object oindices;
+    if( pmesh->Has16BitIndices() ) {
+        npy_intp indexstrides[] = { npy_intp(3*sizeof(uint16_t)), npy_intp(sizeof(uint16_t)) };
+        oindices = toPyArrayView<uint16_t>(pmesh->GetIndices16(), 2, indexdims, indexstrides, pmesh);
+    }
+    else {
+        npy_intp indexstrides[] = { npy_intp(3*sizeof(int32_t)), npy_intp(sizeof(int32_t)) };
+        oindices = toPyArrayView<int32_t>(pmesh->GetIndices32(), 2, indexdims, indexstrides, pmesh);
+    }
+    return py::make_tuple(toPyArrayView<float>(pmesh->GetPositions(), 2, positiondims, positionstrides, pmesh), oindices);
+}
+
 inline RaveVector<float> ExtractFloat3(const py::object& o)
 {
     return RaveVector<float>(py::extract<float>(o[py::to_object(0)]), py::extract<float>(o[py::to_object(1)]), py::extract<float>(o[py::to_object(2)]));
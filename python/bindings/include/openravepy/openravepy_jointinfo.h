@@ -237,6 +237,8 @@ public:
         uint8_t GetSideWallExists() const;
 
         object GetCollisionMesh();
+        object GetCollisionMeshView() const;
+        object CreateCollisionMeshBuffer() const;
         object ComputeAABB(object otransform) const;
         void SetDraw(bool bDraw);
         bool SetVisible(bool visible);
@@ -297,6 +299,7 @@ public:
     bool IsParentLink(OPENRAVE_SHARED_PTR<PyLink> pylink) const;
 
     object GetCollisionData();
+    object GetCollisionDataView() const;
     object ComputeLocalAABB() const;
 
     object ComputeAABB() const;
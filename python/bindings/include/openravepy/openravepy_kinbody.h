@@ -174,6 +174,8 @@ protected:
 protected:
     KinBodyPtr _pbody;
     std::list<OPENRAVE_SHARED_PTR<void> > _listStateSavers;
+    mutable std::vector<dReal> _vCachedDOFValues; ///< cache for filling preallocated output arrays without allocating
+    mutable std::vector<int> _vCachedDOFIndices; ///< cache for filling preallocated output arrays without allocating
 
 public:
     PyKinBody(KinBodyPtr pbody, PyEnvironmentBasePtr pyenv);
@@ -203,6 +205,7 @@ public:
     int GetDOF() const;
     py::object GetDOFValues() const;
     py::object GetDOFValues(py::object oindices) const;
+    py::object GetDOFValues(py::object oindices, py::object oout) const;
     py::object GetDOFVelocities() const;
     py::object GetDOFVelocities(py::object oindices) const;
     py::object GetDOFLimits() const;
@@ -245,6 +248,7 @@ public:
     py::object GetTransform() const;
     py::object GetTransformPose() const;
     py::object GetLinkTransformations(bool returndoflastvlaues=false) const;
+    py::object GetLinkTransformPoses(py::object oout=py::none_()) const;
     void SetLinkTransformations(py::object transforms, py::object odoflastvalues=py::none_());
     void SetLinkVelocities(py::object ovelocities);
     py::object GetLinkEnableStates() const;
@@ -204,6 +204,7 @@ public:
         PyCameraSensorData(OPENRAVE_SHARED_PTR<SensorBase::CameraGeomData const> pgeom);
         virtual ~PyCameraSensorData();
         object imagedata = py::none_();
+        object depthdata = py::none_();
         object KK = py::none_();
         PyCameraIntrinsics intrinsics;
     };
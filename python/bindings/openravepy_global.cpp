@@ -1439,6 +1439,16 @@ void init_openravepy_global()
     .value("OnlySpecifiedBodiesExact", UFIM_OnlySpecifiedBodiesExact)
     ;
 
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    enum_<InfoSerializeOption>(m, "InfoSerializeOption", py::arithmetic() DOXY_ENUM(InfoSerializeOption))
+#else
+    enum_<InfoSerializeOption>("InfoSerializeOption" DOXY_ENUM(InfoSerializeOption))
+#endif
+    .value("ReferenceUriHint",ISO_ReferenceUriHint)
+    .value("BinaryMeshBlobs",ISO_BinaryMeshBlobs)
+    .value("ContentHash",ISO_ContentHash)
+    ;
+
 
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
     enum_<InterfaceType>(m, "InterfaceType", py::arithmetic() DOXY_ENUM(InterfaceType))
@@ -1678,6 +1678,117 @@ object PyEnvironmentBase::CheckCollisionRays(py::numeric::array rays, PyKinBodyP
 #endif // USE_PYBIND11_PYTHON_BINDINGS
 }
 
+object PyEnvironmentBase::CheckCollisionConfigurations(PyKinBodyPtr pbody, py::numeric::array configurations, object odofindices, bool bSelfCollision)
+{
+    KinBodyPtr pkinbody = openravepy::GetKinBody(pbody);
+    if( !pkinbody ) {
+        throw OPENRAVE_EXCEPTION_FORMAT0(_("CheckCollisionConfigurations needs a valid body"),ORE_InvalidArguments);
+    }
+    std::vector<int> vdofindices;
+    if( !IS_PYTHONOBJECT_NONE(odofindices) ) {
+        vdofindices = ExtractArray<int>(odofindices);
+    }
+    const int nDOF = vdofindices.size() > 0 ? (int)vdofindices.size() : pkinbody->GetDOF();
+
+    CollisionCheckerBasePtr pchecker = _penv->GetCollisionChecker();
+    const bool bComputeDistance = !!pchecker && (pchecker->GetCollisionOptions() & CO_Distance);
+
+    object shape = configurations.attr("shape");
+    const int nConfigurations = extract<int>(shape[0]);
+    if( nConfigurations == 0 ) {
+        if( bComputeDistance ) {
+            return py::make_tuple(py::empty_array_astype<bool>(), py::empty_array_astype<dReal>());
+        }
+        return py::empty_array_astype<bool>();
+    }
+    if( extract<int>(shape[py::to_object(1)]) != nDOF ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("configurations object needs to be a Nx%d array"), nDOF, ORE_InvalidArguments);
+    }
+
+    PyArrayObject *pPyConfigurations = PyArray_GETCONTIGUOUS(reinterpret_cast<PyArrayObject*>(configurations.ptr()));
+    AutoPyArrayObjectDereferencer pyderef(pPyConfigurations);
+
+    if( !PyArray_ISFLOAT(pPyConfigurations) ) {
+        throw OpenRAVEException(_("configurations has to be a float array\n"));
+    }
+
+    const bool isFloat = PyArray_ITEMSIZE(pPyConfigurations) == sizeof(float); // or double
+    const float *pConfigurationsFloat = isFloat ? reinterpret_cast<const float*>(PyArray_DATA(pPyConfigurations)) : NULL;
+    const double *pConfigurationsDouble = isFloat ? NULL : reinterpret_cast<const double*>(PyArray_DATA(pPyConfigurations));
+
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    // collision
+    py::array_t<bool> pycollision(nConfigurations);
+    py::buffer_info bufcollision = pycollision.request();
+    bool* pcollision = (bool*) bufcollision.ptr;
+    memset(pcollision, 0, sizeof(bool)*nConfigurations);
+
+    // distance
+    py::array_t<dReal> pydistance(bComputeDistance ? nConfigurations : 0);
+    py::buffer_info bufdistance = pydistance.request();
+    dReal* pdistance = (dReal*) bufdistance.ptr;
+#else // USE_PYBIND11_PYTHON_BINDINGS
+    npy_intp dims[] = { nConfigurations };
+    PyObject* pycollision = PyArray_SimpleNew(1,dims, PyArray_BOOL);
+    // numpy bool = uint8_t
+    uint8_t* pcollision = (uint8_t*)PyArray_DATA(pycollision);
+    std::memset(pcollision, 0, nConfigurations * sizeof(uint8_t));
+    npy_intp distancedims[] = { bComputeDistance ? nConfigurations : 0 };
+    PyObject *pydistance = PyArray_SimpleNew(1,distancedims, sizeof(dReal) == sizeof(double) ? PyArray_DOUBLE : PyArray_FLOAT);
+    dReal* pdistance = (dReal*)PyArray_DATA(pydistance);
+#endif // USE_PYBIND11_PYTHON_BINDINGS
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentLock lockenv(_penv->GetMutex());
+        KinBody::KinBodyStateSaver saver(pkinbody, KinBody::Save_LinkTransformation);
+
+        CollisionReport report, selfreport;
+        CollisionReportPtr preport, pselfreport;
+        if( bComputeDistance ) {
+            preport.reset(&report,null_deleter());
+            pselfreport.reset(&selfreport,null_deleter());
+        }
+        std::vector<dReal> vvalues(nDOF);
+        for(int i = 0; i < nConfigurations; ++i) {
+            if( isFloat ) {
+                std::copy(pConfigurationsFloat, pConfigurationsFloat + nDOF, vvalues.begin());
+                pConfigurationsFloat += nDOF;
+            }
+            else {
+                std::copy(pConfigurationsDouble, pConfigurationsDouble + nDOF, vvalues.begin());
+                pConfigurationsDouble += nDOF;
+            }
+            pkinbody->SetDOFValues(vvalues, KinBody::CLA_CheckLimits, vdofindices);
+
+            bool bCollision = _penv->CheckCollision(KinBodyConstPtr(pkinbody), preport);
+            dReal fMinDistance = bComputeDistance ? report.minDistance : dReal(0);
+            // with distance queries, always run the self-collision check so that its distance is taken into account
+            if( bSelfCollision && (!bCollision || bComputeDistance) ) {
+                bCollision |= pkinbody->CheckSelfCollision(pselfreport);
+                if( bComputeDistance && selfreport.minDistance < fMinDistance ) {
+                    fMinDistance = selfreport.minDistance;
+                }
+            }
+            pcollision[i] = bCollision;
+            if( bComputeDistance ) {
+                pdistance[i] = fMinDistance;
+            }
+        }
+    }
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    if( bComputeDistance ) {
+        return py::make_tuple(pycollision, pydistance);
+    }
+    return pycollision;
+#else // USE_PYBIND11_PYTHON_BINDINGS
+    if( bComputeDistance ) {
+        return py::make_tuple(py::to_array_astype<bool>(pycollision), py::to_array_astype<dReal>(pydistance));
+    }
+    Py_DECREF(pydistance);
+    return py::to_array_astype<bool>(pycollision);
+#endif // USE_PYBIND11_PYTHON_BINDINGS
+}
+
 bool PyEnvironmentBase::CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray)
 {
     return _penv->CheckCollision(pyray->r);
@@ -2138,6 +2249,16 @@ bool PyEnvironmentBase::HasRegisteredCollisionCallbacks()
 void PyEnvironmentBase::StepSimulation(dReal timeStep) {
     _penv->StepSimulation(timeStep);
 }
+object PyEnvironmentBase::StepSimulationBatch(int numsteps, dReal timeStep) {
+    EnvironmentBase::SimulationBatchStats stats = _penv->StepSimulationBatch(numsteps, timeStep);
+    py::dict ostats;
+    ostats["numsteps"] = stats.numsteps;
+    ostats["simulationtime"] = stats.simulationtime;
+    ostats["elapsedtime"] = stats.elapsedtime;
+    ostats["stepspersecond"] = stats.GetStepsPerSecond();
+    ostats["realtimefactor"] = stats.GetRealTimeFactor();
+    return ostats;
+}
 void PyEnvironmentBase::StartSimulation(dReal fDeltaTime, bool bRealTime) {
     _penv->StartSimulation(fDeltaTime,bRealTime);
 }
@@ -2642,45 +2763,12 @@ void PyEnvironmentBase::UpdatePublishedBodies()
     _penv->UpdatePublishedBodies();
 }
 
-object PyEnvironmentBase::GetPublishedBodies(uint64_t timeout)
+object PyEnvironmentBase::_ConvertBodyStateToPython(const KinBody::BodyState& bodystate)
 {
-    std::vector<KinBody::BodyState> vbodystates;
-    _penv->GetPublishedBodies(vbodystates, timeout);
-    py::list ostates;
-    FOREACH(itstate, vbodystates) {
-        py::dict ostate;
-        ostate["body"] = toPyKinBody(itstate->pbody, shared_from_this());
-        py::list olinktransforms;
-        FOREACH(ittransform, itstate->vectrans) {
-            olinktransforms.append(ReturnTransform(*ittransform));
-        }
-        ostate["linktransforms"] = olinktransforms;
-        ostate["jointvalues"] = toPyArray(itstate->jointvalues);
-        ostate["linkEnableStates"] = toPyArray(itstate->vLinkEnableStates);
-        ostate["connectedBodyActiveStates"] = toPyArray(itstate->vConnectedBodyActiveStates);
-        ostate["name"] = ConvertStringToUnicode(itstate->strname);
-        ostate["uri"] = ConvertStringToUnicode(itstate->uri);
-        ostate["updatestamp"] = itstate->updatestamp;
-        ostate["environmentid"] = itstate->environmentid;
-        ostate["activeManipulatorName"] = itstate->activeManipulatorName;
-        ostate["activeManipulatorTransform"] = ReturnTransform(itstate->activeManipulatorTransform);
-        ostate["numGrabbedInfos"] = itstate->vGrabbedInfos.size();
-        ostates.append(ostate);
-    }
-    return ostates;
-}
-
-object PyEnvironmentBase::GetPublishedBody(const std::string &name, uint64_t timeout)
-{
-    KinBody::BodyState bodystate;
-    if( !_penv->GetPublishedBody(name, bodystate, timeout) ) {
-        return py::none_();
-    }
-
     py::dict ostate;
     ostate["body"] = toPyKinBody(bodystate.pbody, shared_from_this());
     py::list olinktransforms;
-    FOREACH(ittransform, bodystate.vectrans) {
+    FOREACHC(ittransform, bodystate.vectrans) {
         olinktransforms.append(ReturnTransform(*ittransform));
     }
     ostate["linktransforms"] = olinktransforms;
@@ -2698,6 +2786,38 @@ object PyEnvironmentBase::GetPublishedBody(const std::string &name, uint64_t tim
     return ostate;
 }
 
+object PyEnvironmentBase::GetPublishedBodies(uint64_t timeout)
+{
+    std::vector<KinBody::BodyState> vbodystates;
+    _penv->GetPublishedBodies(vbodystates, timeout);
+    py::list ostates;
+    FOREACH(itstate, vbodystates) {
+        ostates.append(_ConvertBodyStateToPython(*itstate));
+    }
+    return ostates;
+}
+
+object PyEnvironmentBase::GetPublishedBody(const std::string &name, uint64_t timeout)
+{
+    KinBody::BodyState bodystate;
+    if( !_penv->GetPublishedBody(name, bodystate, timeout) ) {
+        return py::none_();
+    }
+    return _ConvertBodyStateToPython(bodystate);
+}
+
+object PyEnvironmentBase::GetPublishedBodiesChangedSince(uint64_t generation)
+{
+    std::vector<KinBody::BodyState> vbodystates;
+    std::vector<int> vEnvironmentBodyIndices;
+    const uint64_t newgeneration = _penv->GetPublishedBodiesChangedSince(generation, vbodystates, vEnvironmentBodyIndices);
+    py::list ostates;
+    FOREACH(itstate, vbodystates) {
+        ostates.append(_ConvertBodyStateToPython(*itstate));
+    }
+    return py::make_tuple(newgeneration, ostates, toPyArray(vEnvironmentBodyIndices));
+}
+
 object PyEnvironmentBase::GetPublishedBodyJointValues(const std::string &name, uint64_t timeout)
 {
     std::vector<dReal> jointValues;
@@ -2806,6 +2926,67 @@ object PyEnvironmentBase::UpdateFromInfo(PyEnvironmentBaseInfoPtr info, UpdateFr
     return py::make_tuple(createdBodies, modifiedBodies, removedBodies);
 }
 
+object PyEnvironmentBase::GetUpdateFromInfoCounters() const
+{
+    const UpdateFromInfoCounters counters = _penv->GetUpdateFromInfoCounters();
+    py::dict ocounters;
+    ocounters["numCreatedBodies"] = counters.numCreatedBodies;
+    ocounters["numModifiedBodies"] = counters.numModifiedBodies;
+    ocounters["numRemovedBodies"] = counters.numRemovedBodies;
+    ocounters["numUnchangedBodies"] = counters.numUnchangedBodies;
+    ocounters["numSkippedBodyStructures"] = counters.numSkippedBodyStructures;
+    ocounters["numComparedLinks"] = counters.numComparedLinks;
+    ocounters["numSkippedLinks"] = counters.numSkippedLinks;
+    ocounters["numComparedGeometries"] = counters.numComparedGeometries;
+    ocounters["numSkippedGeometries"] = counters.numSkippedGeometries;
+    return ocounters;
+}
+
+PyEnvironmentStateSaver::PyEnvironmentStateSaver(PyEnvironmentBasePtr pyenv) : _pyenv(pyenv), _state(pyenv->GetEnv()) {
+    // python should not support restoring on destruction since there's garbage collection
+    _state.SetRestoreOnDestructor(false);
+}
+PyEnvironmentStateSaver::PyEnvironmentStateSaver(PyEnvironmentBasePtr pyenv, object options) : _pyenv(pyenv), _state(pyenv->GetEnv(), pyGetIntFromPy(options, 0)) {
+    // python should not support restoring on destruction since there's garbage collection
+    _state.SetRestoreOnDestructor(false);
+}
+PyEnvironmentStateSaver::~PyEnvironmentStateSaver() {
+    _state.Release();
+}
+
+PyEnvironmentBasePtr PyEnvironmentStateSaver::GetEnv() const {
+    return _pyenv;
+}
+
+void PyEnvironmentStateSaver::Restore() {
+    _state.Restore();
+}
+
+void PyEnvironmentStateSaver::Release() {
+    _state.Release();
+}
+
+size_t PyEnvironmentStateSaver::GetBufferSize() const {
+    return _state.GetBufferSize();
+}
+
+void PyEnvironmentStateSaver::__enter__() {
+}
+
+void PyEnvironmentStateSaver::__exit__(object type, object value, object traceback) {
+    _state.Restore();
+}
+
+std::string PyEnvironmentStateSaver::__str__() {
+    if( !_state.GetEnv() ) {
+        return "state empty";
+    }
+    return boost::str(boost::format("state for env=%s")%_state.GetEnv()->GetNameId());
+}
+object PyEnvironmentStateSaver::__unicode__() {
+    return ConvertStringToUnicode(__str__());
+}
+
 int PyEnvironmentBase::GetRevision() const
 {
     return _penv->GetRevision();
@@ -3006,6 +3187,7 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(StopSimulation_overloads, StopSimulation,
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SetViewer_overloads, SetViewer, 1, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SetDefaultViewer_overloads, SetDefaultViewer, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckCollisionRays_overloads, CheckCollisionRays, 2, 3)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckCollisionConfigurations_overloads, CheckCollisionConfigurations, 2, 4)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(plot3_overloads, plot3, 2, 4)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(drawlinestrip_overloads, drawlinestrip, 2, 4)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(drawlinelist_overloads, drawlinelist, 2, 4)
@@ -3024,6 +3206,7 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetPublishedBody_overloads, GetPublishedB
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetPublishedBodies_overloads, GetPublishedBodies, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetPublishedBodyJointValues_overloads, GetPublishedBodyJointValues, 1, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetPublishedBodyTransformsMatchingPrefix_overloads, GetPublishedBodyTransformsMatchingPrefix, 1, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetPublishedBodiesChangedSince_overloads, GetPublishedBodiesChangedSince, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(PyEnvironmentBaseInfo_SerializeJSON_overloads, SerializeJSON, 0, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(PyEnvironmentBaseInfo_DeserializeJSON_overloads, DeserializeJSON, 1, 3)
 
@@ -3306,6 +3489,25 @@ Because race conditions can pop up when trying to lock the openrave environment
 #endif
     ;
 
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    object environmentstatesaver = class_<PyEnvironmentStateSaver, OPENRAVE_SHARED_PTR<PyEnvironmentStateSaver> >(m, "EnvironmentStateSaver", DOXY_CLASS(EnvironmentBase::EnvironmentStateSaver))
+                                   .def(init<PyEnvironmentBasePtr>(), "env"_a)
+                                   .def(init<PyEnvironmentBasePtr,object>(), "env"_a, "options"_a)
+#else
+    object environmentstatesaver = class_<PyEnvironmentStateSaver, OPENRAVE_SHARED_PTR<PyEnvironmentStateSaver> >("EnvironmentStateSaver", DOXY_CLASS(EnvironmentBase::EnvironmentStateSaver), no_init)
+                                   .def(init<PyEnvironmentBasePtr>(py::args("env")))
+                                   .def(init<PyEnvironmentBasePtr,object>(py::args("env","options")))
+#endif
+                                   .def("GetEnv",&PyEnvironmentStateSaver::GetEnv, DOXY_FN(EnvironmentBase::EnvironmentStateSaver, GetEnv))
+                                   .def("Restore",&PyEnvironmentStateSaver::Restore, DOXY_FN(EnvironmentBase::EnvironmentStateSaver, Restore))
+                                   .def("Release",&PyEnvironmentStateSaver::Release, DOXY_FN(EnvironmentBase::EnvironmentStateSaver, Release))
+                                   .def("GetBufferSize",&PyEnvironmentStateSaver::GetBufferSize, DOXY_FN(EnvironmentBase::EnvironmentStateSaver, GetBufferSize))
+                                   .def("__enter__",&PyEnvironmentStateSaver::__enter__)
+                                   .def("__exit__",&PyEnvironmentStateSaver::__exit__,"restores the saved state")
+                                   .def("__str__",&PyEnvironmentStateSaver::__str__)
+                                   .def("__unicode__",&PyEnvironmentStateSaver::__unicode__)
+    ;
+
     {
         void (PyEnvironmentBase::*pclone)(PyEnvironmentBasePtr, int) = &PyEnvironmentBase::Clone;
         void (PyEnvironmentBase::*pclonename)(PyEnvironmentBasePtr, const std::string&, int) = &PyEnvironmentBase::Clone;
@@ -3415,6 +3617,19 @@ Because race conditions can pop up when trying to lock the openrave environment
                           CheckCollisionRays_overloads(PY_ARGS("rays","body","front_facing_only")
                                                        "Check if any rays hit the body and returns their contact points along with a vector specifying if a collision occured or not. Rays is a Nx6 array, first 3 columsn are position, last 3 are direction*range."))
 #endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+                     .def("CheckCollisionConfigurations",&PyEnvironmentBase::CheckCollisionConfigurations,
+                          "body"_a,
+                          "configurations"_a,
+                          "dofindices"_a = py::none_(),
+                          "selfcollision"_a = true,
+                          "Sets every row of the NxDOF configurations array to the body and checks it for environment (and optionally self) collision with the GIL released. Returns a boolean array of size N. If the collision checker has CO_Distance set, returns a tuple of the boolean array and the minimum distance of every row. The body state is restored afterwards."
+                          )
+#else
+                     .def("CheckCollisionConfigurations",&PyEnvironmentBase::CheckCollisionConfigurations,
+                          CheckCollisionConfigurations_overloads(PY_ARGS("body","configurations","dofindices","selfcollision")
+                                                                 "Sets every row of the NxDOF configurations array to the body and checks it for environment (and optionally self) collision with the GIL released. Returns a boolean array of size N. If the collision checker has CO_Distance set, returns a tuple of the boolean array and the minimum distance of every row. The body state is restored afterwards."))
+#endif
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
                      .def("LoadURI", &PyEnvironmentBase::LoadURI,
                           "filename"_a,
@@ -3522,6 +3737,7 @@ Because race conditions can pop up when trying to lock the openrave environment
                      .def("RegisterCollisionCallback",&PyEnvironmentBase::RegisterCollisionCallback, PY_ARGS("callback") DOXY_FN(EnvironmentBase,RegisterCollisionCallback))
                      .def("HasRegisteredCollisionCallbacks",&PyEnvironmentBase::HasRegisteredCollisionCallbacks,DOXY_FN(EnvironmentBase,HasRegisteredCollisionCallbacks))
                      .def("StepSimulation",&PyEnvironmentBase::StepSimulation, PY_ARGS("timestep") DOXY_FN(EnvironmentBase,StepSimulation))
+                     .def("StepSimulationBatch",&PyEnvironmentBase::StepSimulationBatch, PY_ARGS("numsteps","timestep") DOXY_FN(EnvironmentBase,StepSimulationBatch))
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
                      .def("StartSimulation", &PyEnvironmentBase::StartSimulation,
                           "timestep"_a,
@@ -3670,6 +3886,9 @@ Because race conditions can pop up when trying to lock the openrave environment
                           "prefix"_a,
                           "timeout"_a = 0,
                           DOXY_FN(EnvironmentBase,GetPublishedBodyTransformsMatchingPrefix))
+                     .def("GetPublishedBodiesChangedSince", &PyEnvironmentBase::GetPublishedBodiesChangedSince,
+                          "generation"_a = 0,
+                          DOXY_FN(EnvironmentBase,GetPublishedBodiesChangedSince))
 #else
                      .def("GetPublishedBody",&PyEnvironmentBase::GetPublishedBody, GetPublishedBody_overloads(PY_ARGS("name", "timeout") DOXY_FN(EnvironmentBase,GetPublishedBody)))
                      .def("GetPublishedBodies",&PyEnvironmentBase::GetPublishedBodies, GetPublishedBodies_overloads(PY_ARGS("timeout") DOXY_FN(EnvironmentBase,GetPublishedBodies)))
@@ -3677,6 +3896,8 @@ Because race conditions can pop up when trying to lock the openrave environment
                      .def("GetPublishedBodyJointValues",&PyEnvironmentBase::GetPublishedBodyJointValues, GetPublishedBodyJointValues_overloads(PY_ARGS("name", "timeout") DOXY_FN(EnvironmentBase,GetPublishedBodyJointValues)))
 
                      .def("GetPublishedBodyTransformsMatchingPrefix",&PyEnvironmentBase::GetPublishedBodyTransformsMatchingPrefix, GetPublishedBodyTransformsMatchingPrefix_overloads(PY_ARGS("prefix", "timeout") DOXY_FN(EnvironmentBase,GetPublishedBodyTransformsMatchingPrefix)))
+
+                     .def("GetPublishedBodiesChangedSince",&PyEnvironmentBase::GetPublishedBodiesChangedSince, GetPublishedBodiesChangedSince_overloads(PY_ARGS("generation") DOXY_FN(EnvironmentBase,GetPublishedBodiesChangedSince)))
 #endif
                      .def("Triangulate",&PyEnvironmentBase::Triangulate, PY_ARGS("body") DOXY_FN(EnvironmentBase,Triangulate))
                      .def("TriangulateScene",&PyEnvironmentBase::TriangulateScene, PY_ARGS("options","name") DOXY_FN(EnvironmentBase,TriangulateScene))
@@ -3692,6 +3913,7 @@ Because race conditions can pop up when trying to lock the openrave environment
                      .def("GetRevision", &PyEnvironmentBase::GetRevision, DOXY_FN(EnvironmentBase, GetRevision))
                      .def("ExtractInfo",&PyEnvironmentBase::ExtractInfo, DOXY_FN(EnvironmentBase,ExtractInfo))
                      .def("UpdateFromInfo",&PyEnvironmentBase::UpdateFromInfo, PY_ARGS("info", "updateMode") DOXY_FN(EnvironmentBase,UpdateFromInfo))
+                     .def("GetUpdateFromInfoCounters",&PyEnvironmentBase::GetUpdateFromInfoCounters, DOXY_FN(EnvironmentBase,GetUpdateFromInfoCounters))
                      .def("GetName", &PyEnvironmentBase::GetName, DOXY_FN(EnvironmentBase,GetName))
                      .def("GetNameId", &PyEnvironmentBase::GetNameId, DOXY_FN(EnvironmentBase,GetNameId))
                      .def("SetDescription", &PyEnvironmentBase::SetDescription, PY_ARGS("sceneDescription") DOXY_FN(EnvironmentBase,SetDescription))
@@ -1211,6 +1211,12 @@ uint8_t PyLink::PyGeometry::GetSideWallExists() const {
 object PyLink::PyGeometry::GetCollisionMesh() {
     return toPyTriMesh(_pgeometry->GetCollisionMesh());
 }
+object PyLink::PyGeometry::GetCollisionMeshView() const {
+    return toPyTriMeshView(_pgeometry->GetCollisionMesh(), _pgeometry);
+}
+object PyLink::PyGeometry::CreateCollisionMeshBuffer() const {
+    return toPyTriMeshBufferView(_pgeometry->CreateCollisionMeshBuffer());
+}
 object PyLink::PyGeometry::ComputeAABB(object otransform) const {
     return toPyAABB(_pgeometry->ComputeAABB(ExtractTransform(otransform)));
 }
@@ -1393,6 +1399,9 @@ bool PyLink::IsParentLink(OPENRAVE_SHARED_PTR<PyLink> pylink) const {
 object PyLink::GetCollisionData() {
     return toPyTriMesh(_plink->GetCollisionData());
 }
+object PyLink::GetCollisionDataView() const {
+    return toPyTriMeshView(_plink->GetCollisionData(), _plink);
+}
 object PyLink::ComputeLocalAABB() const { // TODO object otransform=py::none_()
     //if( IS_PYTHONOBJECT_NONE(otransform) ) {
     return toPyAABB(_plink->ComputeLocalAABB());
@@ -2642,6 +2651,28 @@ object PyKinBody::GetDOFValues(object oindices) const
     _pbody->GetDOFValues(values,vindices);
     return toPyArray(values);
 }
+object PyKinBody::GetDOFValues(object oindices, object oout) const
+{
+    if( IS_PYTHONOBJECT_NONE(oout) ) {
+        return IS_PYTHONOBJECT_NONE(oindices) ? GetDOFValues() : GetDOFValues(oindices);
+    }
+    _vCachedDOFIndices.resize(0);
+    if( !IS_PYTHONOBJECT_NONE(oindices) ) {
+        const size_t numindices = len(oindices);
+        _vCachedDOFIndices.resize(numindices);
+        for(size_t i = 0; i < numindices; ++i) {
+            _vCachedDOFIndices[i] = py::extract<int>(oindices[py::to_object(i)]);
+        }
+        if( numindices == 0 ) {
+            ExtractOutputArray(oout, 0);
+            return oout;
+        }
+    }
+    _pbody->GetDOFValues(_vCachedDOFValues, _vCachedDOFIndices);
+    dReal* pout = ExtractOutputArray(oout, _vCachedDOFValues.size());
+    std::copy(_vCachedDOFValues.begin(), _vCachedDOFValues.end(), pout);
+    return oout;
+}
 
 object PyKinBody::GetDOFVelocities() const
 {
@@ -3103,6 +3134,39 @@ object PyKinBody::GetLinkTransformations(bool returndoflastvlaues) const
     return otransforms;
 }
 
+object PyKinBody::GetLinkTransformPoses(object oout) const
+{
+    const std::vector<KinBody::LinkPtr>& vlinks = _pbody->GetLinks();
+    dReal* pposes = NULL;
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    py::array_t<dReal> pyposes;
+    if( IS_PYTHONOBJECT_NONE(oout) ) {
+        pyposes = py::array_t<dReal>({(int)vlinks.size(), 7});
+        py::buffer_info buf = pyposes.request();
+        pposes = (dReal*) buf.ptr;
+        oout = pyposes;
+    }
+#else // USE_PYBIND11_PYTHON_BINDINGS
+    if( IS_PYTHONOBJECT_NONE(oout) ) {
+        npy_intp dims[] = { npy_intp(vlinks.size()), 7 };
+        PyObject *pyposes = PyArray_SimpleNew(2,dims, sizeof(dReal)==8 ? PyArray_DOUBLE : PyArray_FLOAT);
+        pposes = (dReal*)PyArray_DATA(pyposes);
+        // already of dReal type, so take ownership without astype, which would copy the array before it is filled
+        oout = py::handle_to_object(pyposes);
+    }
+#endif // USE_PYBIND11_PYTHON_BINDINGS
+    else {
+        pposes = ExtractOutputArray(oout, 7*vlinks.size());
+    }
+    for(const KinBody::LinkPtr& plink : vlinks) {
+        const Transform& t = plink->GetTransform();
+        pposes[0] = t.rot.x; pposes[1] = t.rot.y; pposes[2] = t.rot.z; pposes[3] = t.rot.w;
+        pposes[4] = t.trans.x; pposes[5] = t.trans.y; pposes[6] = t.trans.z;
+        pposes += 7;
+    }
+    return oout;
+}
+
 void PyKinBody::SetLinkTransformations(object transforms, object odoflastvalues)
 {
     size_t numtransforms = len(transforms);
@@ -4526,6 +4590,7 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetInstantaneousTorqueLimits_overloads, G
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetNominalTorqueLimits_overloads, GetNominalTorqueLimits, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetMaxInertia_overloads, GetMaxInertia, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetLinkTransformations_overloads, GetLinkTransformations, 0, 1)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetLinkTransformPoses_overloads, GetLinkTransformPoses, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SetLinkTransformations_overloads, SetLinkTransformations, 1, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SetDOFLimits_overloads, SetDOFLimits, 2, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SubtractDOFValues_overloads, SubtractDOFValues, 2, 3)
@@ -5213,6 +5278,7 @@ void init_openravepy_kinbody()
         void (PyKinBody::*psetdofvalues3)(object,object,uint32_t) = &PyKinBody::SetDOFValues;
         object (PyKinBody::*getdofvalues1)() const = &PyKinBody::GetDOFValues;
         object (PyKinBody::*getdofvalues2)(object) const = &PyKinBody::GetDOFValues;
+        object (PyKinBody::*getdofvalues3)(object, object) const = &PyKinBody::GetDOFValues;
         object (PyKinBody::*getdofvelocities1)() const = &PyKinBody::GetDOFVelocities;
         object (PyKinBody::*getdofvelocities2)(object) const = &PyKinBody::GetDOFVelocities;
         object (PyKinBody::*getdoflimits1)() const = &PyKinBody::GetDOFLimits;
@@ -5332,6 +5398,7 @@ void init_openravepy_kinbody()
                          .def("GetDOF",&PyKinBody::GetDOF,DOXY_FN(KinBody,GetDOF))
                          .def("GetDOFValues",getdofvalues1,DOXY_FN(KinBody,GetDOFValues))
                          .def("GetDOFValues",getdofvalues2,PY_ARGS("indices") DOXY_FN(KinBody,GetDOFValues))
+                         .def("GetDOFValues",getdofvalues3,PY_ARGS("indices","out") "Same as GetDOFValues(indices), but writes the values into the preallocated float64 numpy array out (if not None) and returns it.")
                          .def("GetDOFVelocities",getdofvelocities1, DOXY_FN(KinBody,GetDOFVelocities))
                          .def("GetDOFVelocities",getdofvelocities2, PY_ARGS("indices") DOXY_FN(KinBody,GetDOFVelocities))
                          .def("GetDOFLimits",getdoflimits1, DOXY_FN(KinBody,GetDOFLimits))
@@ -5408,6 +5475,14 @@ void init_openravepy_kinbody()
                               )
 #else
                          .def("GetLinkTransformations",&PyKinBody::GetLinkTransformations, GetLinkTransformations_overloads(PY_ARGS("returndoflastvlaues") DOXY_FN(KinBody,GetLinkTransformations)))
+#endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+                         .def("GetLinkTransformPoses", &PyKinBody::GetLinkTransformPoses,
+                              "out"_a = py::none_(),
+                              "Returns the poses [qw,qx,qy,qz,x,y,z] of all links as a Nx7 array. If out is a preallocated Nx7 float64 numpy array, the poses are written into it without allocating."
+                              )
+#else
+                         .def("GetLinkTransformPoses",&PyKinBody::GetLinkTransformPoses, GetLinkTransformPoses_overloads(PY_ARGS("out") "Returns the poses [qw,qx,qy,qz,x,y,z] of all links as a Nx7 array. If out is a preallocated Nx7 float64 numpy array, the poses are written into it without allocating."))
 #endif
                          .def("GetBodyTransformations",&PyKinBody::GetLinkTransformations, DOXY_FN(KinBody,GetLinkTransformations))
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
@@ -5751,6 +5826,7 @@ void init_openravepy_kinbody()
                           .def("GetParentLinks",&PyLink::GetParentLinks, DOXY_FN(KinBody::Link,GetParentLinks))
                           .def("IsParentLink",&PyLink::IsParentLink, DOXY_FN(KinBody::Link,IsParentLink))
                           .def("GetCollisionData",&PyLink::GetCollisionData, DOXY_FN(KinBody::Link,GetCollisionData))
+                          .def("GetCollisionDataView",&PyLink::GetCollisionDataView, "Returns (vertices, indices) read-only numpy views of the link collision data without copying. The views keep the link alive, but become invalid when the link geometries change.")
                           .def("ComputeAABB",&PyLink::ComputeAABB, DOXY_FN(KinBody::Link,ComputeAABB))
                           .def("ComputeAABBFromTransform",&PyLink::ComputeAABBFromTransform, PY_ARGS("transform") DOXY_FN(KinBody::Link,ComputeAABB))
                           .def("ComputeLocalAABB",&PyLink::ComputeLocalAABB, DOXY_FN(KinBody::Link,ComputeLocalAABB))
@@ -5840,6 +5916,8 @@ void init_openravepy_kinbody()
 #endif
                                   .def("SetCollisionMesh",&PyLink::PyGeometry::SetCollisionMesh,PY_ARGS("trimesh") DOXY_FN(KinBody::Link::Geometry,SetCollisionMesh))
                                   .def("GetCollisionMesh",&PyLink::PyGeometry::GetCollisionMesh, DOXY_FN(KinBody::Link::Geometry,GetCollisionMesh))
+                                  .def("GetCollisionMeshView",&PyLink::PyGeometry::GetCollisionMeshView, "Returns (vertices, indices) read-only numpy views of the collision mesh without copying. The views keep the geometry alive, but become invalid when its collision mesh changes.")
+                                  .def("CreateCollisionMeshBuffer",&PyLink::PyGeometry::CreateCollisionMeshBuffer, DOXY_FN(KinBody::Link::Geometry,CreateCollisionMeshBuffer))
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
                                   .def("InitCollisionMesh", &PyLink::PyGeometry::InitCollisionMesh,
                                        "tesselation"_a = 1.0,
@@ -354,11 +354,15 @@ PySensorBase::PyCameraSensorData::PyCameraSensorData(OPENRAVE_SHARED_PTR<SensorB
 {
     const std::vector<uint8_t>& vimagedata = pdata->vimagedata;
     const size_t numel = pgeom->height * pgeom->width * 3;
-    if( vimagedata.size() != numel ) {
+    if( !vimagedata.empty() && vimagedata.size() != numel ) {
         throw openrave_exception(_("bad image data"));
     }
+    if( !pdata->vdepthdata.empty() && pdata->vdepthdata.size() != numel/3 ) {
+        throw openrave_exception(_("bad depth data"));
+    }
 
-    {
+    // depth only cameras do not fill the image
+    if( !vimagedata.empty() ) {
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
         py::array_t<uint8_t> pyimagedata = toPyArray(vimagedata);
         pyimagedata.resize({pgeom->height, pgeom->width, 3});
@@ -366,10 +370,20 @@ PySensorBase::PyCameraSensorData::PyCameraSensorData(OPENRAVE_SHARED_PTR<SensorB
 #else // USE_PYBIND11_PYTHON_BINDINGS
         npy_intp dims[] = {npy_intp(pgeom->height), npy_intp(pgeom->width), npy_intp(3)};
         PyObject *pyvalues = PyArray_SimpleNew(3, dims, PyArray_UINT8);
-        if( !vimagedata.empty() ) {
-            memcpy(PyArray_DATA(pyvalues), vimagedata.data(), numel);
-        }
+        memcpy(PyArray_DATA(pyvalues), vimagedata.data(), numel);
         imagedata = py::to_array_astype<uint8_t>(pyvalues);
+#endif // USE_PYBIND11_PYTHON_BINDINGS
+    }
+    if( !pdata->vdepthdata.empty() ) {
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+        py::array_t<float> pydepthdata = toPyArray(pdata->vdepthdata);
+        pydepthdata.resize({pgeom->height, pgeom->width});
+        depthdata = pydepthdata;
+#else // USE_PYBIND11_PYTHON_BINDINGS
+        npy_intp dims[] = {npy_intp(pgeom->height), npy_intp(pgeom->width)};
+        PyObject *pyvalues = PyArray_SimpleNew(2, dims, PyArray_FLOAT);
+        memcpy(PyArray_DATA(pyvalues), pdata->vdepthdata.data(), pdata->vdepthdata.size()*sizeof(float));
+        depthdata = py::to_array_astype<float>(pyvalues);
 #endif // USE_PYBIND11_PYTHON_BINDINGS
     }
 }
@@ -809,6 +823,7 @@ void init_openravepy_sensor()
 #endif
         .def_readonly("transform",&PySensorBase::PyCameraSensorData::transform)
         .def_readonly("imagedata",&PySensorBase::PyCameraSensorData::imagedata)
+        .def_readonly("depthdata",&PySensorBase::PyCameraSensorData::depthdata)
         .def_readonly("KK",&PySensorBase::PyCameraSensorData::KK)
         .def_readonly("intrinsics",&PySensorBase::PyCameraSensorData::intrinsics)
         ;
@@ -25,7 +25,9 @@
 #include <boost/filesystem/operations.hpp>
 #endif
 
+#include <atomic>
 #include <chrono>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <thread>
@@ -231,6 +233,17 @@ protected:
     friend class BodyCallbackData;
     typedef boost::shared_ptr<BodyCallbackData> BodyCallbackDataPtr;
 
+    /// \brief immutable generation of the published bodies. UpdatePublishedBodies fills a new generation and swaps it in atomically, so readers never wait on the publisher.
+    class PublishedBodiesSnapshot
+    {
+public:
+        std::vector<KinBody::BodyState> vBodies; ///< sorted by environment body index
+        std::vector<uint64_t> vBodyGenerations; ///< for every element of vBodies, the generation where its state last changed
+        uint64_t generation = 0;
+    };
+    typedef std::shared_ptr<PublishedBodiesSnapshot> PublishedBodiesSnapshotPtr;
+    typedef std::shared_ptr<PublishedBodiesSnapshot const> PublishedBodiesSnapshotConstPtr;
+
 public:
     Environment() : EnvironmentBase()
     {
@@ -382,7 +395,7 @@ public:
                 ExclusiveLock lock874(_mutexInterfaces);
                 vecbodies.swap(_vecbodies);
                 listSensors.swap(_listSensors);
-                _vPublishedBodies.clear();
+                _ClearPublishedBodies();
                 _nBodiesModifiedStamp++;
                 _listModules.clear();
                 _listViewers.clear();
@@ -460,7 +473,7 @@ public:
             _mapBodyNameIndex.clear();
             _mapBodyIdIndex.clear();
 
-            _vPublishedBodies.clear();
+            _ClearPublishedBodies();
             _nBodiesModifiedStamp++;
 
             _environmentIndexRecyclePool.clear();
@@ -2533,22 +2546,16 @@ public:
 
     virtual void GetPublishedBodies(std::vector<KinBody::BodyState>& vbodies, uint64_t timeout)
     {
-        TimedSharedLock lock452(_mutexInterfaces, timeout);
-        if (!lock452) {
-            throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
-        }
-        vbodies = _vPublishedBodies;
+        PublishedBodiesSnapshotConstPtr psnapshot = _GetPublishedBodiesSnapshot();
+        vbodies = psnapshot->vBodies;
     }
 
     virtual bool GetPublishedBody(const std::string &name, KinBody::BodyState& bodystate, uint64_t timeout=0)
     {
-        TimedSharedLock lock306(_mutexInterfaces, timeout);
-        if (!lock306) {
-            throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
-        }
-        for ( size_t ibody = 0; ibody < _vPublishedBodies.size(); ++ibody) {
-            if ( _vPublishedBodies[ibody].strname == name) {
-                bodystate = _vPublishedBodies[ibody];
+        PublishedBodiesSnapshotConstPtr psnapshot = _GetPublishedBodiesSnapshot();
+        for(const KinBody::BodyState& state : psnapshot->vBodies) {
+            if ( state.strname == name) {
+                bodystate = state;
                 return true;
             }
         }
@@ -2558,13 +2565,10 @@ public:
 
     virtual bool GetPublishedBodyJointValues(const std::string& name, std::vector<dReal> &jointValues, uint64_t timeout=0)
     {
-        TimedSharedLock lock118(_mutexInterfaces, timeout);
-        if (!lock118) {
-            throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
-        }
-        for ( size_t ibody = 0; ibody < _vPublishedBodies.size(); ++ibody) {
-            if ( _vPublishedBodies[ibody].strname == name) {
-                jointValues = _vPublishedBodies[ibody].jointvalues;
+        PublishedBodiesSnapshotConstPtr psnapshot = _GetPublishedBodiesSnapshot();
+        for(const KinBody::BodyState& state : psnapshot->vBodies) {
+            if ( state.strname == name) {
+                jointValues = state.jointvalues;
                 return true;
             }
         }
@@ -2574,39 +2578,73 @@ public:
 
     void GetPublishedBodyTransformsMatchingPrefix(const std::string& prefix, std::vector<std::pair<std::string, Transform> >& nameTransfPairs, uint64_t timeout = 0)
     {
-        TimedSharedLock lock079(_mutexInterfaces, timeout);
-        if (!lock079) {
-            throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
-        }
+        PublishedBodiesSnapshotConstPtr psnapshot = _GetPublishedBodiesSnapshot();
+        const std::vector<KinBody::BodyState>& vPublishedBodies = psnapshot->vBodies;
 
         nameTransfPairs.resize(0);
-        if( nameTransfPairs.capacity() < _vPublishedBodies.size() ) {
-            nameTransfPairs.reserve(_vPublishedBodies.size());
+        if( nameTransfPairs.capacity() < vPublishedBodies.size() ) {
+            nameTransfPairs.reserve(vPublishedBodies.size());
         }
-        for ( size_t ibody = 0; ibody < _vPublishedBodies.size(); ++ibody) {
-            if ( strncmp(_vPublishedBodies[ibody].strname.c_str(), prefix.c_str(), prefix.size()) == 0 ) {
-                nameTransfPairs.emplace_back(_vPublishedBodies[ibody].strname,  _vPublishedBodies[ibody].vectrans.at(0));
+        for(const KinBody::BodyState& state : vPublishedBodies) {
+            if ( strncmp(state.strname.c_str(), prefix.c_str(), prefix.size()) == 0 ) {
+                nameTransfPairs.emplace_back(state.strname, state.vectrans.at(0));
             }
         }
     }
 
+    virtual uint64_t GetPublishedBodiesChangedSince(uint64_t generation, std::vector<KinBody::BodyState>& vChangedBodies, std::vector<int>& vEnvironmentBodyIndices)
+    {
+        PublishedBodiesSnapshotConstPtr psnapshot = _GetPublishedBodiesSnapshot();
+        const std::vector<KinBody::BodyState>& vPublishedBodies = psnapshot->vBodies;
+        vChangedBodies.resize(0);
+        vEnvironmentBodyIndices.resize(vPublishedBodies.size());
+        for(size_t ibody = 0; ibody < vPublishedBodies.size(); ++ibody) {
+            vEnvironmentBodyIndices[ibody] = vPublishedBodies[ibody].environmentid;
+            if( psnapshot->vBodyGenerations[ibody] > generation ) {
+                vChangedBodies.push_back(vPublishedBodies[ibody]);
+            }
+        }
+        return psnapshot->generation;
+    }
+
     virtual void UpdatePublishedBodies(uint64_t timeout=0)
     {
         EnvironmentLock lockenv(GetMutex());
-        TimedExclusiveLock lock152(_mutexInterfaces, timeout);
+        // only reading _vecbodies, readers of the published bodies do not lock _mutexInterfaces
+        TimedSharedLock lock152(_mutexInterfaces, timeout);
         if (!lock152) {
             throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
         }
         _UpdatePublishedBodies();
     }
 
-    /// assumes GetMutex() and _mutexInterfaces are both exclusively locked
+    /// \brief fills a new generation of the published bodies and swaps it in.
+    ///
+    /// The generation is written into the buffer of the generation before the current one if no reader holds it anymore, so that steady state publishing does not allocate.
+    /// assumes GetMutex() is exclusively locked and _mutexInterfaces is at least shared locked
     virtual void _UpdatePublishedBodies()
     {
-        // updated the published bodies, resize dynamically in case an exception occurs
-        // when creating an item and bad data is left inside _vPublishedBodies
-        _vPublishedBodies.resize(_GetNumBodies());
+        PublishedBodiesSnapshotPtr pprevsnapshot = std::atomic_load(&_pPublishedBodies);
+        PublishedBodiesSnapshotPtr psnapshot;
+        if( !!_pPublishedBodiesSpare && _pPublishedBodiesSpare.use_count() == 1 ) {
+            // use_count is a relaxed load. readers drop their reference with a release decrement, so the acquire fence
+            // makes all their reads of the spare happen before it is overwritten below.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            psnapshot.swap(_pPublishedBodiesSpare);
+        }
+        else {
+            _pPublishedBodiesSpare.reset();
+            psnapshot = std::make_shared<PublishedBodiesSnapshot>();
+        }
+        const uint64_t generation = ++_nPublishedBodiesGeneration;
+        psnapshot->generation = generation;
+
+        // resize dynamically in case an exception occurs when creating an item and bad data is left inside vBodies
+        std::vector<KinBody::BodyState>& vPublishedBodies = psnapshot->vBodies;
+        vPublishedBodies.resize(_GetNumBodies());
+        psnapshot->vBodyGenerations.resize(vPublishedBodies.size());
         int iwritten = 0;
+        size_t iprevbody = 0; // both generations are sorted by environment body index
 
         std::vector<dReal> vdoflastsetvalues;
         for(const KinBodyPtr& pbody : _vecbodies) {
@@ -2618,7 +2656,7 @@ public:
                 continue;
             }
 
-            KinBody::BodyState& state = _vPublishedBodies.at(iwritten);
+            KinBody::BodyState& state = vPublishedBodies.at(iwritten);
             state.Reset();
             state.pbody = pbody;
             pbody->GetLinkTransformations(state.vectrans, vdoflastsetvalues);
@@ -2640,12 +2678,65 @@ public:
                     probot->GetConnectedBodyActiveStates(state.vConnectedBodyActiveStates);
                 }
             }
+
+            // keep the generation of the previous state if the body did not change
+            uint64_t bodygeneration = generation;
+            if( !!pprevsnapshot ) {
+                const std::vector<KinBody::BodyState>& vPrevBodies = pprevsnapshot->vBodies;
+                while( iprevbody < vPrevBodies.size() && vPrevBodies[iprevbody].environmentid < state.environmentid ) {
+                    ++iprevbody;
+                }
+                if( iprevbody < vPrevBodies.size() && _IsSamePublishedBodyState(vPrevBodies[iprevbody], state) ) {
+                    bodygeneration = pprevsnapshot->vBodyGenerations[iprevbody];
+                }
+            }
+            psnapshot->vBodyGenerations[iwritten] = bodygeneration;
             ++iwritten;
         }
 
-        if( iwritten < (int)_vPublishedBodies.size() ) {
-            _vPublishedBodies.resize(iwritten);
+        if( iwritten < (int)vPublishedBodies.size() ) {
+            vPublishedBodies.resize(iwritten);
+            psnapshot->vBodyGenerations.resize(iwritten);
+        }
+
+        std::atomic_store(&_pPublishedBodies, psnapshot);
+        // readers might still hold the previous generation, it is only reused once they release it
+        _pPublishedBodiesSpare = pprevsnapshot;
+    }
+
+    /// \brief publishes an empty generation
+    void _ClearPublishedBodies()
+    {
+        PublishedBodiesSnapshotPtr psnapshot = std::make_shared<PublishedBodiesSnapshot>();
+        psnapshot->generation = ++_nPublishedBodiesGeneration;
+        std::atomic_store(&_pPublishedBodies, psnapshot);
+        // the spare generation holds references to the bodies, which hold the environment
+        _pPublishedBodiesSpare.reset();
+    }
+
+    inline PublishedBodiesSnapshotConstPtr _GetPublishedBodiesSnapshot() const
+    {
+        return std::atomic_load(&_pPublishedBodies);
+    }
+
+    /// \brief returns true if the published states are of the same body and nothing observable changed between them
+    static bool _IsSamePublishedBodyState(const KinBody::BodyState& prevstate, const KinBody::BodyState& state)
+    {
+        if( prevstate.pbody != state.pbody || prevstate.environmentid != state.environmentid || prevstate.updatestamp != state.updatestamp ) {
+            return false;
+        }
+        if( prevstate.strname != state.strname || prevstate.vLinkEnableStates != state.vLinkEnableStates || prevstate.vConnectedBodyActiveStates != state.vConnectedBodyActiveStates || prevstate.activeManipulatorName != state.activeManipulatorName ) {
+            return false;
+        }
+        if( prevstate.vGrabbedInfos.size() != state.vGrabbedInfos.size() ) {
+            return false;
+        }
+        for(size_t igrabbed = 0; igrabbed < state.vGrabbedInfos.size(); ++igrabbed) {
+            if( prevstate.vGrabbedInfos[igrabbed]._grabbedname != state.vGrabbedInfos[igrabbed]._grabbedname || prevstate.vGrabbedInfos[igrabbed]._robotlinkname != state.vGrabbedInfos[igrabbed]._robotlinkname ) {
+                return false;
+            }
         }
+        return true;
     }
 
     virtual std::pair<std::string, dReal> GetUnit() const
@@ -2706,6 +2797,8 @@ public:
 
         EnvironmentLock lockenv(GetMutex());
         std::vector<dReal> vDOFValues;
+        uint64_t starttimeus = utils::GetMonotonicTime();
+        _updateFromInfoCounters.Reset();
 
         if( updateMode != UFIM_OnlySpecifiedBodiesExact ) {
             // copy basic info into EnvironmentBase
@@ -2745,6 +2838,10 @@ public:
         }
         std::vector<int> vUsedBodyIndices; // used indices of vBodies
 
+        // bodies that cannot match anything in vBodies will be newly created, so build them up front in parallel. Only their AddKinBody has to be serialized below.
+        std::vector<KinBodyPtr> vPreparedNewBodies;
+        _PrepareNewBodiesFromInfo(info, vBodies, vPreparedNewBodies);
+
         // internally manipulates _vecbodies using _AddKinBody/_AddRobot/_RemoveKinBodyFromIterator
         for(int inputBodyIndex = 0; inputBodyIndex < (int)info._vBodyInfos.size(); ++inputBodyIndex) {
             const KinBody::KinBodyInfoConstPtr& pKinBodyInfo = info._vBodyInfos[inputBodyIndex];
@@ -2878,8 +2975,10 @@ public:
                 } else {
                     updateFromInfoResult = pMatchExistingBody->UpdateFromKinBodyInfo(*pKinBodyInfo);
                 }
+                _updateFromInfoCounters += pMatchExistingBody->GetUpdateFromInfoCounters();
                 RAVELOG_VERBOSE_FORMAT("env=%s, update body %s from info result %d", GetNameId()%pMatchExistingBody->_id%updateFromInfoResult);
                 if (updateFromInfoResult == UFIR_NoChange) {
+                    _updateFromInfoCounters.numUnchangedBodies++;
                     continue;
                 }
                 vModifiedBodies.push_back(pMatchExistingBody);
@@ -2958,11 +3057,16 @@ public:
                 }
                 else {
                     RAVELOG_VERBOSE_FORMAT("add new kinbody %s", pKinBodyInfo->_id);
-                    pNewBody = RaveCreateKinBody(shared_from_this(), pKinBodyInfo->_interfaceType);
-                    if( !pNewBody ) {
-                        pNewBody = RaveCreateKinBody(shared_from_this(), "");
+                    if( inputBodyIndex < (int)vPreparedNewBodies.size() && !!vPreparedNewBodies[inputBodyIndex] ) {
+                        pNewBody = vPreparedNewBodies[inputBodyIndex];
+                    }
+                    else {
+                        pNewBody = RaveCreateKinBody(shared_from_this(), pKinBodyInfo->_interfaceType);
+                        if( !pNewBody ) {
+                            pNewBody = RaveCreateKinBody(shared_from_this(), "");
+                        }
+                        pNewBody->InitFromKinBodyInfo(*pKinBodyInfo);
                     }
-                    pNewBody->InitFromKinBodyInfo(*pKinBodyInfo);
                     pInitBody = pNewBody;
                     _AddKinBody(pNewBody, IAM_AllowRenaming);
                 }
@@ -3076,9 +3180,18 @@ public:
             }
         }
 
+        _updateFromInfoCounters.numCreatedBodies = vCreatedBodies.size();
+        _updateFromInfoCounters.numModifiedBodies = vModifiedBodies.size();
+        _updateFromInfoCounters.numRemovedBodies = vRemovedBodies.size();
+        RAVELOG_DEBUG_FORMAT("env=%s, updated from info in %u[us]: bodies created=%d, modified=%d, removed=%d, unchanged=%d, skipped structures=%d; links compared=%d, skipped=%d; geometries compared=%d, skipped=%d", GetNameId()%(utils::GetMonotonicTime()-starttimeus)%_updateFromInfoCounters.numCreatedBodies%_updateFromInfoCounters.numModifiedBodies%_updateFromInfoCounters.numRemovedBodies%_updateFromInfoCounters.numUnchangedBodies%_updateFromInfoCounters.numSkippedBodyStructures%_updateFromInfoCounters.numComparedLinks%_updateFromInfoCounters.numSkippedLinks%_updateFromInfoCounters.numComparedGeometries%_updateFromInfoCounters.numSkippedGeometries);
         UpdatePublishedBodies();
     }
 
+    UpdateFromInfoCounters GetUpdateFromInfoCounters() const override {
+        EnvironmentLock lockenv(GetMutex());
+        return _updateFromInfoCounters;
+    }
+
     int GetRevision() const override {
         EnvironmentLock lockenv(GetMutex());
         return _revision;
@@ -3195,6 +3308,8 @@ protected:
         _bInit = false;
         _bEnableSimulation = true;     // need to start by default
         _unit = std::make_pair("meter",1.0); //default unit settings
+        _nPublishedBodiesGeneration = 0;
+        _ClearPublishedBodies();
 
         _vRapidJsonLoadBuffer.resize(4000000);
         _prLoadEnvAlloc.reset(new rapidjson::MemoryPoolAllocator<>(&_vRapidJsonLoadBuffer[0], _vRapidJsonLoadBuffer.size()));
@@ -3330,7 +3445,7 @@ protected:
                 _mapBodyIdIndex.clear();
                 _environmentIndexRecyclePool.clear();
 
-                _vPublishedBodies.clear();
+                _ClearPublishedBodies();
             }
         }
 
@@ -3689,6 +3804,58 @@ protected:
         }
     }
 
+    /// \brief creates and initializes the non-robot bodies of info that cannot match any of vBodies, so UpdateFromInfo only has to add them.
+    ///
+    /// Creation is sequential, InitFromKinBodyInfo (link, geometry and collision mesh setup) runs in parallel since the bodies are not in the environment yet.
+    /// Robots are skipped since initializing their sensors and connected bodies can reach into the environment.
+    /// \param[out] vPreparedNewBodies indexed by info._vBodyInfos. empty entries have to be handled by the caller.
+    void _PrepareNewBodiesFromInfo(const EnvironmentBaseInfo& info, const std::vector<KinBodyPtr>& vBodies, std::vector<KinBodyPtr>& vPreparedNewBodies)
+    {
+        vPreparedNewBodies.clear();
+        std::set<std::string> setExistingIds, setExistingNames;
+        FOREACHC(itbody, vBodies) {
+            if( !!*itbody ) {
+                if( !(*itbody)->_id.empty() ) {
+                    setExistingIds.insert((*itbody)->_id);
+                }
+                if( !(*itbody)->_name.empty() ) {
+                    setExistingNames.insert((*itbody)->_name);
+                }
+            }
+        }
+
+        std::vector<int> vInfoIndices;
+        for(int inputBodyIndex = 0; inputBodyIndex < (int)info._vBodyInfos.size(); ++inputBodyIndex) {
+            const KinBody::KinBodyInfo& kinBodyInfo = *info._vBodyInfos[inputBodyIndex];
+            if( kinBodyInfo._isRobot ) {
+                continue;
+            }
+            if( (!kinBodyInfo._id.empty() && setExistingIds.count(kinBodyInfo._id)) || (!kinBodyInfo._name.empty() && setExistingNames.count(kinBodyInfo._name)) ) {
+                continue;
+            }
+            vInfoIndices.push_back(inputBodyIndex);
+        }
+        if( vInfoIndices.size() < 2 ) {
+            return; // not worth spawning threads
+        }
+
+        vPreparedNewBodies.resize(info._vBodyInfos.size());
+        FOREACHC(itindex, vInfoIndices) {
+            KinBodyPtr pNewBody = RaveCreateKinBody(shared_from_this(), info._vBodyInfos[*itindex]->_interfaceType);
+            if( !pNewBody ) {
+                pNewBody = RaveCreateKinBody(shared_from_this(), "");
+            }
+            vPreparedNewBodies[*itindex] = pNewBody;
+        }
+
+        uint64_t starttimeus = utils::GetMonotonicTime();
+        utils::ParallelForEachIndex((int)vInfoIndices.size(), [&info, &vInfoIndices, &vPreparedNewBodies](int index) {
+            const int inputBodyIndex = vInfoIndices[index];
+            vPreparedNewBodies[inputBodyIndex]->InitFromKinBodyInfo(*info._vBodyInfos[inputBodyIndex]);
+        });
+        RAVELOG_VERBOSE_FORMAT("env=%s, initialized %d new bodies in %u[us]", GetNameId()%vInfoIndices.size()%(utils::GetMonotonicTime()-starttimeus));
+    }
+
     /// \brief adds pbody to _vecbodies and other internal data structures
     /// \param pbody kin body to be added to the environment
     /// \param envBodyIndex environment body index of the pbody
@@ -4225,7 +4392,9 @@ protected:
 
     mutable std::mutex _mutexInit;     ///< lock for destroying the environment
 
-    vector<KinBody::BodyState> _vPublishedBodies; ///< protected by _mutexInterfaces
+    PublishedBodiesSnapshotPtr _pPublishedBodies; ///< current generation, only accessed through std::atomic_load/std::atomic_store
+    PublishedBodiesSnapshotPtr _pPublishedBodiesSpare; ///< previous generation, reused by the publisher once readers release it. protected by GetMutex()
+    std::atomic<uint64_t> _nPublishedBodiesGeneration; ///< last generation handed out
     string _homedirectory;
     std::pair<std::string, dReal> _unit; ///< unit name mm, cm, inches, m and the conversion for meters
 
@@ -4237,6 +4406,7 @@ protected:
     std::list<UserDataWeakPtr> _listRegisteredBodyCallbacks;     ///< see EnvironmentBase::RegisterBodyCallback
 
     std::map<std::string, uint64_t> _mapUInt64Parameters; ///< a custom user-driven parameters
+    UpdateFromInfoCounters _updateFromInfoCounters; ///< \see GetUpdateFromInfoCounters
     std::vector<uint8_t> _vRapidJsonLoadBuffer;
     boost::shared_ptr<rapidjson::MemoryPoolAllocator<> > _prLoadEnvAlloc; ///< allocator used for loading environments
 
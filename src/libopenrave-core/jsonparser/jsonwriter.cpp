@@ -27,7 +27,8 @@ namespace OpenRAVE {
 class EnvironmentJSONWriter
 {
 public:
-    EnvironmentJSONWriter(const AttributesList& atts, rapidjson::Value& rEnvironment, rapidjson::Document::AllocatorType& allocator) : _rEnvironment(rEnvironment), _allocator(allocator) {
+    /// \param bAllowBinaryMeshBlobs if false, the binaryMeshBlobs attribute is ignored. JSON text writers pass false since text cannot hold raw bytes.
+    EnvironmentJSONWriter(const AttributesList& atts, rapidjson::Value& rEnvironment, rapidjson::Document::AllocatorType& allocator, bool bAllowBinaryMeshBlobs=true) : _rEnvironment(rEnvironment), _allocator(allocator) {
         _serializeOptions = 0;
         FOREACHC(itatt,atts) {
             if( itatt->first == "openravescheme" ) {
@@ -35,7 +36,17 @@ public:
             }
             else if( itatt->first == "uriHint" ) {
                 if( itatt->second == "1" ) {
-                    _serializeOptions = ISO_ReferenceUriHint;
+                    _serializeOptions |= ISO_ReferenceUriHint;
+                }
+            }
+            else if( itatt->first == "binaryMeshBlobs" ) {
+                if( itatt->second == "1" ) {
+                    if( bAllowBinaryMeshBlobs ) {
+                        _serializeOptions |= ISO_BinaryMeshBlobs;
+                    }
+                    else {
+                        RAVELOG_WARN("binaryMeshBlobs is only supported when writing msgpack, so writing meshes as number arrays\n");
+                    }
                 }
             }
         }
@@ -93,7 +104,7 @@ protected:
                         KinBody::KinBodyInfo info;
                         pBody->ExtractInfo(info);
                         info._referenceUri = _CanonicalizeURI(info._referenceUri);
-                        info.SerializeJSON(bodyValue, _allocator, fUnitScale);
+                        info.SerializeJSON(bodyValue, _allocator, fUnitScale, _serializeOptions);
                     } else {
                         RobotBasePtr pRobot = RaveInterfaceCast<RobotBase>(pBody);
                         RobotBase::RobotBaseInfo info;
@@ -218,7 +229,7 @@ void RaveWriteJSONFile(EnvironmentBasePtr penv, const std::string& filename, con
     std::ofstream ofstream(filename.c_str());
     rapidjson::Document doc(&alloc);
 
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), false);
     jsonwriter.Write(penv);
     OpenRAVE::orjson::DumpJson(doc, ofstream);
 }
@@ -228,7 +239,7 @@ void RaveWriteJSONFile(KinBodyPtr pbody, const std::string& filename, const Attr
     std::ofstream ofstream(filename.c_str());
     rapidjson::Document doc(&alloc);
 
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), false);
     jsonwriter.Write(pbody);
     OpenRAVE::orjson::DumpJson(doc, ofstream);
 }
@@ -238,7 +249,7 @@ void RaveWriteJSONFile(const std::list<KinBodyPtr>& listbodies, const std::strin
     std::ofstream ofstream(filename.c_str());
     rapidjson::Document doc(&alloc);
 
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), false);
     jsonwriter.Write(listbodies);
     OpenRAVE::orjson::DumpJson(doc, ofstream);
 }
@@ -246,7 +257,7 @@ void RaveWriteJSONFile(const std::list<KinBodyPtr>& listbodies, const std::strin
 void RaveWriteJSONStream(EnvironmentBasePtr penv, ostream& os, const AttributesList& atts, rapidjson::Document::AllocatorType& alloc)
 {
     rapidjson::Document doc(&alloc);
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), false);
     jsonwriter.Write(penv);
     OpenRAVE::orjson::DumpJson(doc, os);
 }
@@ -254,7 +265,7 @@ void RaveWriteJSONStream(EnvironmentBasePtr penv, ostream& os, const AttributesL
 void RaveWriteJSONStream(KinBodyPtr pbody, ostream& os, const AttributesList& atts, rapidjson::Document::AllocatorType& alloc)
 {
     rapidjson::Document doc(&alloc);
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), false);
     jsonwriter.Write(pbody);
     OpenRAVE::orjson::DumpJson(doc, os);
 }
@@ -262,7 +273,7 @@ void RaveWriteJSONStream(KinBodyPtr pbody, ostream& os, const AttributesList& at
 void RaveWriteJSONStream(const std::list<KinBodyPtr>& listbodies, ostream& os, const AttributesList& atts, rapidjson::Document::AllocatorType& alloc)
 {
     rapidjson::Document doc(&alloc);
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), false);
     jsonwriter.Write(listbodies);
     OpenRAVE::orjson::DumpJson(doc, os);
 }
@@ -270,7 +281,7 @@ void RaveWriteJSONStream(const std::list<KinBodyPtr>& listbodies, ostream& os, c
 void RaveWriteJSONMemory(EnvironmentBasePtr penv, std::vector<char>& output, const AttributesList& atts, rapidjson::Document::AllocatorType& alloc)
 {
     rapidjson::Document doc(&alloc);
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), false);
     jsonwriter.Write(penv);
     OpenRAVE::orjson::DumpJson(doc, output);
 }
@@ -278,7 +289,7 @@ void RaveWriteJSONMemory(EnvironmentBasePtr penv, std::vector<char>& output, con
 void RaveWriteJSONMemory(KinBodyPtr pbody, std::vector<char>& output, const AttributesList& atts, rapidjson::Document::AllocatorType& alloc)
 {
     rapidjson::Document doc(&alloc);
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), false);
     jsonwriter.Write(pbody);
     OpenRAVE::orjson::DumpJson(doc, output);
 }
@@ -286,7 +297,7 @@ void RaveWriteJSONMemory(KinBodyPtr pbody, std::vector<char>& output, const Attr
 void RaveWriteJSONMemory(const std::list<KinBodyPtr>& listbodies, std::vector<char>& output, const AttributesList& atts, rapidjson::Document::AllocatorType& alloc)
 {
     rapidjson::Document doc(&alloc);
-    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator());
+    EnvironmentJSONWriter jsonwriter(atts, doc, doc.GetAllocator(), false);
     jsonwriter.Write(listbodies);
     OpenRAVE::orjson::DumpJson(doc, output);
 }
@@ -16,6 +16,11 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "libopenrave.h"
 
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 EnvironmentBase::EnvironmentBaseInfo::EnvironmentBaseInfo()
 {
     _gravity = Vector(0,0,-9.797930195020351);
@@ -164,6 +169,11 @@ void EnvironmentBase::EnvironmentBaseInfo::DeserializeJSONWithMapping(const rapi
     if (rEnvInfo.HasMember("bodies")) {
         _vBodyInfos.reserve(_vBodyInfos.size() + rEnvInfo["bodies"].Size());
         const rapidjson::Value& rBodies = rEnvInfo["bodies"];
+
+        // infos of new bodies are appended to _vBodyInfos right away so that the order is preserved, but their json is decoded
+        // in parallel in _DeserializePendingBodyInfos. decoding only has to be flushed early if a later entry updates a pending info.
+        std::vector<PendingBodyInfo> vPendingBodyInfos;
+        std::set<const KinBody::KinBodyInfo*> setPendingBodyInfos;
         for(int iInputBodyIndex = 0; iInputBodyIndex < (int)rBodies.Size(); ++iInputBodyIndex) {
             const rapidjson::Value& rKinBodyInfo = rBodies[iInputBodyIndex];
 
@@ -187,6 +197,19 @@ void EnvironmentBase::EnvironmentBaseInfo::DeserializeJSONWithMapping(const rapi
                 }
             }
 
+            if( itExistingBodyInfo != _vBodyInfos.end() ) {
+                if( setPendingBodyInfos.count(itExistingBodyInfo->get()) ) {
+                    // flushing erases pending infos without a name from _vBodyInfos, which invalidates the iterator, so find the info again.
+                    // if the matched info itself was erased, this entry creates a new body just like when the first entry was never added.
+                    const KinBody::KinBodyInfo* pExistingBodyInfo = itExistingBodyInfo->get();
+                    _DeserializePendingBodyInfos(vPendingBodyInfos, fUnitScale, options);
+                    setPendingBodyInfos.clear();
+                    itExistingBodyInfo = _vBodyInfos.begin();
+                    while( itExistingBodyInfo != _vBodyInfos.end() && itExistingBodyInfo->get() != pExistingBodyInfo ) {
+                        ++itExistingBodyInfo;
+                    }
+                }
+            }
             if( itExistingBodyInfo != _vBodyInfos.end() ) {
                 isExistingRobot = !!OPENRAVE_DYNAMIC_POINTER_CAST<RobotBase::RobotBaseInfo>(*itExistingBodyInfo);
                 RAVELOG_VERBOSE_FORMAT("found existing body '%s' with id='%s', isRobot = %d", (*itExistingBodyInfo)->_name%id%isExistingRobot);
@@ -203,14 +226,10 @@ void EnvironmentBase::EnvironmentBaseInfo::DeserializeJSONWithMapping(const rapi
                     // in case no such id
                     if (!isDeleted) {
                         RobotBase::RobotBaseInfoPtr pRobotBaseInfo(new RobotBase::RobotBaseInfo());
-                        pRobotBaseInfo->DeserializeJSON(rKinBodyInfo, fUnitScale, options);
-                        if (!pRobotBaseInfo->_name.empty()) {
-                            pRobotBaseInfo->_id = id;
-                            _vBodyInfos.push_back(pRobotBaseInfo);
-                            RAVELOG_VERBOSE_FORMAT("created new robot id='%s'", id);
-                        } else {
-                            RAVELOG_WARN_FORMAT("new robot id='%s' does not have a name, so skip creating", id);
-                        }
+                        pRobotBaseInfo->_id = id;
+                        _vBodyInfos.push_back(pRobotBaseInfo);
+                        vPendingBodyInfos.push_back(PendingBodyInfo(pRobotBaseInfo, &rKinBodyInfo, id));
+                        setPendingBodyInfos.insert(pRobotBaseInfo.get());
                     }
                     continue;
                 }
@@ -239,14 +258,10 @@ void EnvironmentBase::EnvironmentBaseInfo::DeserializeJSONWithMapping(const rapi
                     // in case no such id
                     if (!isDeleted) {
                         KinBody::KinBodyInfoPtr pKinBodyInfo(new KinBody::KinBodyInfo());
-                        pKinBodyInfo->DeserializeJSON(rKinBodyInfo, fUnitScale, options);
-                        if (!pKinBodyInfo->_name.empty()) {
-                            pKinBodyInfo->_id = id;
-                            _vBodyInfos.push_back(pKinBodyInfo);
-                            RAVELOG_VERBOSE_FORMAT("created new body id='%s'", id);
-                        } else {
-                            RAVELOG_WARN_FORMAT("new body id='%s' does not have a name, so skip creating", id);
-                        }
+                        pKinBodyInfo->_id = id;
+                        _vBodyInfos.push_back(pKinBodyInfo);
+                        vPendingBodyInfos.push_back(PendingBodyInfo(pKinBodyInfo, &rKinBodyInfo, id));
+                        setPendingBodyInfos.insert(pKinBodyInfo.get());
                     }
                     continue;
                 }
@@ -270,5 +285,299 @@ void EnvironmentBase::EnvironmentBaseInfo::DeserializeJSONWithMapping(const rapi
                 pKinBodyInfo->_id = id;
             }
         }
+
+        _DeserializePendingBodyInfos(vPendingBodyInfos, fUnitScale, options);
+    }
+}
+
+void EnvironmentBase::EnvironmentBaseInfo::_DeserializePendingBodyInfos(std::vector<PendingBodyInfo>& vPendingBodyInfos, dReal fUnitScale, int options)
+{
+    if( vPendingBodyInfos.empty() ) {
+        return;
+    }
+
+    // each body info only touches its own data, so can decode them concurrently
+    utils::ParallelForEachIndex((int)vPendingBodyInfos.size(), [&vPendingBodyInfos, fUnitScale, options](int index) {
+        PendingBodyInfo& pending = vPendingBodyInfos[index];
+        pending.pinfo->DeserializeJSON(*pending.prInfo, fUnitScale, options);
+        pending.pinfo->_id = pending.id;
+    });
+
+    FOREACH(itpending, vPendingBodyInfos) {
+        const char* pbodytype = !!OPENRAVE_DYNAMIC_POINTER_CAST<RobotBase::RobotBaseInfo>(itpending->pinfo) ? "robot" : "body";
+        if( itpending->pinfo->_name.empty() ) {
+            RAVELOG_WARN_FORMAT("new %s id='%s' does not have a name, so skip creating", pbodytype%itpending->id);
+            std::vector<KinBody::KinBodyInfoPtr>::iterator itBodyInfo = std::find(_vBodyInfos.begin(), _vBodyInfos.end(), itpending->pinfo);
+            if( itBodyInfo != _vBodyInfos.end() ) {
+                _vBodyInfos.erase(itBodyInfo);
+            }
+        }
+        else {
+            RAVELOG_VERBOSE_FORMAT("created new %s id='%s'", pbodytype%itpending->id);
+        }
+    }
+    vPendingBodyInfos.clear();
+}
+
+uint64_t EnvironmentBase::GetPublishedBodiesChangedSince(uint64_t generation, std::vector<KinBody::BodyState>& vChangedBodies, std::vector<int>& vEnvironmentBodyIndices)
+{
+    GetPublishedBodies(vChangedBodies);
+    vEnvironmentBodyIndices.resize(vChangedBodies.size());
+    for(size_t ibody = 0; ibody < vChangedBodies.size(); ++ibody) {
+        vEnvironmentBodyIndices[ibody] = vChangedBodies[ibody].environmentid;
+    }
+    return 0;
+}
+
+UpdateFromInfoCounters EnvironmentBase::GetUpdateFromInfoCounters() const
+{
+    return UpdateFromInfoCounters();
+}
+
+EnvironmentBase::SimulationBatchStats EnvironmentBase::StepSimulationBatch(int numsteps, dReal timestep)
+{
+    EnvironmentLock lockenv(GetMutex());
+    if( IsSimulationRunning() ) {
+        RAVELOG_WARN_FORMAT("env=%s, internal simulation thread is running while stepping a batch of %d steps", GetNameId()%numsteps);
+    }
+    SimulationBatchStats stats;
+    const uint64_t starttime = utils::GetMicroTime();
+    const uint64_t startsimtime = GetSimulationTime();
+    for(int istep = 0; istep < numsteps; ++istep) {
+        StepSimulation(timestep);
+    }
+    stats.numsteps = numsteps > 0 ? numsteps : 0;
+    stats.simulationtime = GetSimulationTime() - startsimtime;
+    stats.elapsedtime = utils::GetMicroTime() - starttime;
+    RAVELOG_DEBUG_FORMAT("env=%s, stepped %d times in %.3fs (%.1f steps/s, %.1fx real time)", GetNameId()%stats.numsteps%(1e-6*stats.elapsedtime)%stats.GetStepsPerSecond()%stats.GetRealTimeFactor());
+    return stats;
+}
+
+void EnvironmentBase::StepSimulationBatches(const std::vector<EnvironmentBasePtr>& venvs, int numsteps, dReal timestep, std::vector<SimulationBatchStats>& vstats, int numthreads)
+{
+    vstats.clear();
+    vstats.resize(venvs.size());
+    if( numthreads <= 0 ) {
+        numthreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    numthreads = std::min(numthreads, (int)venvs.size());
+
+    std::atomic<size_t> nextenv(0);
+    std::mutex mutexexception;
+    std::exception_ptr firstexception;
+    auto runbatches = [&]() {
+        for(size_t ienv = nextenv++; ienv < venvs.size(); ienv = nextenv++) {
+            try {
+                vstats[ienv] = venvs[ienv]->StepSimulationBatch(numsteps, timestep);
+            }
+            catch(...) {
+                std::lock_guard<std::mutex> lock(mutexexception);
+                if( !firstexception ) {
+                    firstexception = std::current_exception();
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> vthreads;
+    vthreads.reserve(numthreads);
+    for(int ithread = 1; ithread < numthreads; ++ithread) {
+        vthreads.emplace_back(runbatches);
+    }
+    runbatches();
+    for(std::thread& thread : vthreads) {
+        thread.join();
+    }
+    if( !!firstexception ) {
+        std::rethrow_exception(firstexception);
+    }
+}
+
+EnvironmentBase::EnvironmentStateSaver::EnvironmentStateSaver(EnvironmentBasePtr penv, int options) : _penv(penv), _options(options), _bRestoreOnDestructor(true)
+{
+    std::vector<KinBodyPtr> vbodies;
+    _penv->GetBodies(vbodies);
+    _vSavedBodyStates.resize(vbodies.size());
+
+    // size the shared buffers first so that each body only appends
+    size_t numLinks = 0, numDOFs = 0, numEnableMasks = 0;
+    FOREACHC(itbody, vbodies) {
+        numLinks += (*itbody)->GetLinks().size();
+        numDOFs += (*itbody)->GetDOF();
+        numEnableMasks += (*itbody)->GetLinkEnableStatesMasks().size();
+    }
+    if( _options & KinBody::Save_LinkTransformation ) {
+        _vLinkTransforms.reserve(numLinks);
+        _vDOFLastSetValues.reserve(numDOFs);
+    }
+    if( _options & KinBody::Save_LinkEnable ) {
+        _vLinkEnableMasks.reserve(numEnableMasks);
+    }
+
+    for(size_t ibody = 0; ibody < vbodies.size(); ++ibody) {
+        const KinBodyPtr& pbody = vbodies[ibody];
+        SavedBodyState& savedstate = _vSavedBodyStates[ibody];
+        savedstate.pbody = pbody;
+        savedstate.environmentBodyIndex = pbody->GetEnvironmentBodyIndex();
+        if( _options & KinBody::Save_LinkTransformation ) {
+            savedstate.linkOffset = _vLinkTransforms.size();
+            savedstate.dofOffset = _vDOFLastSetValues.size();
+            pbody->GetLinkTransformations(_vTempTransforms, _vTempDOFValues);
+            savedstate.numLinks = _vTempTransforms.size();
+            savedstate.numDOFs = _vTempDOFValues.size();
+            _vLinkTransforms.insert(_vLinkTransforms.end(), _vTempTransforms.begin(), _vTempTransforms.end());
+            _vDOFLastSetValues.insert(_vDOFLastSetValues.end(), _vTempDOFValues.begin(), _vTempDOFValues.end());
+        }
+        if( _options & KinBody::Save_LinkEnable ) {
+            const std::vector<uint64_t>& vLinkEnableMasks = pbody->GetLinkEnableStatesMasks();
+            savedstate.enableMaskOffset = _vLinkEnableMasks.size();
+            savedstate.numEnableMasks = vLinkEnableMasks.size();
+            _vLinkEnableMasks.insert(_vLinkEnableMasks.end(), vLinkEnableMasks.begin(), vLinkEnableMasks.end());
+        }
+        if( _options & KinBody::Save_GrabbedBodies ) {
+            pbody->GetGrabbed(_vTempGrabbedBodies);
+            if( _vTempGrabbedBodies.size() > 0 ) {
+                savedstate.grabbedIndex = _vGrabbedBodySavers.size();
+                KinBody::KinBodyStateSaverPtr pgrabbedsaver(new KinBody::KinBodyStateSaver(pbody, KinBody::Save_GrabbedBodies));
+                pgrabbedsaver->SetRestoreOnDestructor(false);
+                _vGrabbedBodySavers.push_back(pgrabbedsaver);
+            }
+        }
+        if( (_options & (KinBody::Save_ActiveDOF|KinBody::Save_ActiveManipulator)) && pbody->IsRobot() ) {
+            RobotBasePtr probot = RaveInterfaceCast<RobotBase>(pbody);
+            savedstate.robotIndex = _vRobotStates.size();
+            _vRobotStates.push_back(SavedRobotState());
+            SavedRobotState& robotstate = _vRobotStates.back();
+            if( _options & KinBody::Save_ActiveDOF ) {
+                robotstate.vActiveDOFIndices = probot->GetActiveDOFIndices();
+                robotstate.affineDOFs = probot->GetAffineDOF();
+                robotstate.rotationAxis = probot->GetAffineRotationAxis();
+            }
+            if( _options & KinBody::Save_ActiveManipulator ) {
+                RobotBase::ManipulatorConstPtr pmanip = probot->GetActiveManipulator();
+                if( !!pmanip ) {
+                    robotstate.activeManipulatorName = pmanip->GetName();
+                }
+            }
+        }
+        savedstate.updateStamp = pbody->GetUpdateStamp();
+    }
+}
+
+EnvironmentBase::EnvironmentStateSaver::~EnvironmentStateSaver()
+{
+    if( _bRestoreOnDestructor && !!_penv ) {
+        try {
+            Restore();
+        }
+        catch(const std::exception& ex) {
+            RAVELOG_WARN_FORMAT("env=%s, failed to restore environment state: %s", _penv->GetNameId()%ex.what());
+        }
+    }
+}
+
+void EnvironmentBase::EnvironmentStateSaver::Restore()
+{
+    if( !_penv ) {
+        return;
+    }
+    // restoring grabbed bodies has to happen first since their grabbers' link transforms update them
+    FOREACH(itsavedstate, _vSavedBodyStates) {
+        KinBodyPtr pbody = itsavedstate->pbody.lock();
+        if( !pbody || pbody->GetEnvironmentBodyIndex() != itsavedstate->environmentBodyIndex ) {
+            continue;
+        }
+        if( _options & KinBody::Save_GrabbedBodies ) {
+            if( itsavedstate->grabbedIndex < 0 ) {
+                pbody->GetGrabbed(_vTempGrabbedBodies);
+                if( _vTempGrabbedBodies.size() > 0 ) {
+                    pbody->ReleaseAllGrabbed();
+                }
+            }
+            else {
+                // the same bodies could have been released and grabbed again with a different link or relative pose, so always restore the saved grabs
+                _vGrabbedBodySavers.at(itsavedstate->grabbedIndex)->Restore();
+            }
+        }
+    }
+    FOREACH(itsavedstate, _vSavedBodyStates) {
+        _RestoreBody(*itsavedstate);
+    }
+}
+
+void EnvironmentBase::EnvironmentStateSaver::_RestoreBody(SavedBodyState& savedstate)
+{
+    KinBodyPtr pbody = savedstate.pbody.lock();
+    if( !pbody || pbody->GetEnvironmentBodyIndex() != savedstate.environmentBodyIndex ) {
+        return;
+    }
+
+    if( _options & KinBody::Save_LinkEnable ) {
+        const std::vector<uint64_t>& vLinkEnableMasks = pbody->GetLinkEnableStatesMasks();
+        if( vLinkEnableMasks.size() != savedstate.numEnableMasks ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("env=%s, body '%s' has %d links, which does not match the saved state"), _penv->GetNameId()%pbody->GetName()%pbody->GetLinks().size(), ORE_InvalidState);
+        }
+        if( !std::equal(vLinkEnableMasks.begin(), vLinkEnableMasks.end(), _vLinkEnableMasks.begin() + savedstate.enableMaskOffset) ) {
+            _vTempEnableStates.resize(pbody->GetLinks().size());
+            for(size_t ilink = 0; ilink < _vTempEnableStates.size(); ++ilink) {
+                _vTempEnableStates[ilink] = (_vLinkEnableMasks.at(savedstate.enableMaskOffset + (ilink >> 6)) >> (ilink & 0x3f)) & 1;
+            }
+            pbody->SetLinkEnableStates(_vTempEnableStates);
+        }
+    }
+
+    // the update stamp changes with every transform change, so an equal stamp means the transforms are still the saved ones
+    if( (_options & KinBody::Save_LinkTransformation) && pbody->GetUpdateStamp() != savedstate.updateStamp ) {
+        if( pbody->GetLinks().size() != savedstate.numLinks ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("env=%s, body '%s' has %d links, but saved state has %d"), _penv->GetNameId()%pbody->GetName()%pbody->GetLinks().size()%savedstate.numLinks, ORE_InvalidState);
+        }
+        _vTempTransforms.assign(_vLinkTransforms.begin() + savedstate.linkOffset, _vLinkTransforms.begin() + savedstate.linkOffset + savedstate.numLinks);
+        _vTempDOFValues.assign(_vDOFLastSetValues.begin() + savedstate.dofOffset, _vDOFLastSetValues.begin() + savedstate.dofOffset + savedstate.numDOFs);
+        pbody->SetLinkTransformations(_vTempTransforms, _vTempDOFValues);
+    }
+
+    if( savedstate.robotIndex >= 0 ) {
+        RobotBasePtr probot = RaveInterfaceCast<RobotBase>(pbody);
+        const SavedRobotState& robotstate = _vRobotStates.at(savedstate.robotIndex);
+        if( _options & KinBody::Save_ActiveDOF ) {
+            if( probot->GetActiveDOFIndices() != robotstate.vActiveDOFIndices || probot->GetAffineDOF() != robotstate.affineDOFs || probot->GetAffineRotationAxis() != robotstate.rotationAxis ) {
+                probot->SetActiveDOFs(robotstate.vActiveDOFIndices, robotstate.affineDOFs, robotstate.rotationAxis);
+            }
+        }
+        if( _options & KinBody::Save_ActiveManipulator ) {
+            RobotBase::ManipulatorConstPtr pmanip = probot->GetActiveManipulator();
+            const std::string& activeManipulatorName = !!pmanip ? pmanip->GetName() : std::string();
+            if( activeManipulatorName != robotstate.activeManipulatorName ) {
+                if( robotstate.activeManipulatorName.empty() ) {
+                    probot->SetActiveManipulator(RobotBase::ManipulatorConstPtr());
+                }
+                else {
+                    probot->SetActiveManipulator(robotstate.activeManipulatorName);
+                }
+            }
+        }
+    }
+
+    // a second restore without intermediate changes can skip this body
+    savedstate.updateStamp = pbody->GetUpdateStamp();
+}
+
+void EnvironmentBase::EnvironmentStateSaver::Release()
+{
+    _penv.reset();
+}
+
+void EnvironmentBase::EnvironmentStateSaver::SetRestoreOnDestructor(bool restore)
+{
+    _bRestoreOnDestructor = restore;
+}
+
+size_t EnvironmentBase::EnvironmentStateSaver::GetBufferSize() const
+{
+    size_t size = _vSavedBodyStates.size()*sizeof(SavedBodyState) + _vLinkTransforms.size()*sizeof(Transform) + _vDOFLastSetValues.size()*sizeof(dReal) + _vLinkEnableMasks.size()*sizeof(uint64_t);
+    FOREACHC(itrobotstate, _vRobotStates) {
+        size += sizeof(SavedRobotState) + itrobotstate->vActiveDOFIndices.size()*sizeof(int) + itrobotstate->activeManipulatorName.size();
     }
+    size += _vGrabbedBodySavers.size()*sizeof(KinBody::KinBodyStateSaver);
+    return size;
 }
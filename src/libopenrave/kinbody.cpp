@@ -131,6 +131,7 @@ void KinBody::KinBodyInfo::Reset()
     _vJointInfos.clear();
     _mReadableInterfaces.clear();
     _prAssociatedFileEntries.reset();
+    _contentHash.clear();
     _isRobot = false;
     _isPartial = true;
 }
@@ -220,6 +221,20 @@ void KinBody::KinBodyInfo::SerializeJSON(rapidjson::Value& rKinBodyInfo, rapidjs
         rKinBodyInfo.AddMember("joints", rJointInfoValues, allocator);
     }
 
+    if( options & ISO_ContentHash ) {
+        // only covers links and joints, the state of the body changes too often to be part of it
+        std::string structure;
+        if( rKinBodyInfo.HasMember("links") ) {
+            structure += orjson::DumpJson(rKinBodyInfo["links"]);
+        }
+        if( rKinBodyInfo.HasMember("joints") ) {
+            structure += orjson::DumpJson(rKinBodyInfo["joints"]);
+        }
+        if( !structure.empty() ) {
+            orjson::SetJsonValueByKey(rKinBodyInfo, "contentHash", utils::GetMD5HashString(structure), allocator);
+        }
+    }
+
     if (_mReadableInterfaces.size() > 0) {
         rapidjson::Value rReadableInterfaces;
         rReadableInterfaces.SetObject();
@@ -257,6 +272,7 @@ void KinBody::KinBodyInfo::DeserializeJSON(const rapidjson::Value& value, dReal
     }
     orjson::LoadJsonValueByKey(value, "name", _name);
     orjson::LoadJsonValueByKey(value, "id", _id);
+    _contentHash = orjson::GetStringJsonValueByKey(value, "contentHash"); // partial updates do not carry a hash, so always reset it
 
     if( !(options & IDO_IgnoreReferenceUri) ) {
         if (value.HasMember("referenceUri")) {
@@ -434,6 +450,9 @@ KinBody::KinBody(InterfaceType type, EnvironmentBasePtr penv) : InterfaceBase(ty
     _environmentBodyIndex = 0;
     _nNonAdjacentLinkCache = 0x80000000;
     _nUpdateStampId = 0;
+    _nStructureStamp = 0;
+    _nInfoContentHashStamp = -1;
+    _bUseInfoContentHash = false;
     _bAreAllJoints1DOFAndNonCircular = false;
 }
 
@@ -5714,6 +5733,9 @@ void KinBody::Clone(InterfaceBaseConstPtr preference, int cloningoptions)
 void KinBody::_PostprocessChangedParameters(uint32_t parameters)
 {
     _nUpdateStampId++;
+    if( parameters & ~(Prop_LinkTransforms|Prop_RobotGrabbed|Prop_RobotActiveDOFs) ) {
+        _nStructureStamp++; // state changes aside, invalidates the recorded info content hashes
+    }
     if( _nHierarchyComputed == 1 ) {
         _nParametersChanged |= parameters;
         return;
@@ -5965,6 +5987,7 @@ void KinBody::_InitAndAddJoint(JointPtr pjoint)
 void KinBody::ExtractInfo(KinBodyInfo& info)
 {
     info._modifiedFields = 0;
+    info._contentHash.clear();
     info._id = _id;
     info._uri = GetURI();
     info._name = _name;
@@ -6076,6 +6099,32 @@ void KinBody::ExtractInfo(KinBodyInfo& info)
 }
 
 UpdateFromInfoResult KinBody::UpdateFromKinBodyInfo(const KinBodyInfo& info)
+{
+    _updateFromInfoCounters.Reset();
+    // recorded hashes can only be trusted if nothing modified the body since they were recorded
+    _bUseInfoContentHash = _nInfoContentHashStamp == _nStructureStamp;
+    UpdateFromInfoResult updateFromInfoResult = UFIR_NoChange;
+    try {
+        updateFromInfoResult = _UpdateFromKinBodyInfo(info);
+    }
+    catch(...) {
+        _bUseInfoContentHash = false;
+        _nInfoContentHashStamp = -1;
+        throw;
+    }
+    _bUseInfoContentHash = false;
+    if( updateFromInfoResult == UFIR_NoChange || updateFromInfoResult == UFIR_Success ) {
+        // the links, joints and geometries now match info, so the hashes they recorded hold until the body is modified again
+        _infoContentHash = info._contentHash;
+        _nInfoContentHashStamp = _nStructureStamp;
+    }
+    else {
+        _nInfoContentHashStamp = -1;
+    }
+    return updateFromInfoResult;
+}
+
+UpdateFromInfoResult KinBody::_UpdateFromKinBodyInfo(const KinBodyInfo& info)
 {
     UpdateFromInfoResult updateFromInfoResult = UFIR_NoChange;
     if(_id != info._id) {
@@ -6093,85 +6142,91 @@ UpdateFromInfoResult KinBody::UpdateFromKinBodyInfo(const KinBodyInfo& info)
         updateFromInfoResult = UFIR_Success;
     }
 
-    // need to avoid checking links and joints belonging to connected bodies
-    std::vector<bool> isConnectedLink(_veclinks.size(), false);  // indicate which link comes from connectedbody
-    std::vector<bool> isConnectedJoint(_vecjoints.size(), false); // indicate which joint comes from connectedbody
-    std::vector<bool> isConnectedPassiveJoint(_vPassiveJoints.size(), false); // indicate which passive joint comes from connectedbody
-
-    if (IsRobot()) {
-        RobotBasePtr pRobot = RaveInterfaceCast<RobotBase>(shared_from_this());
-        std::vector<KinBody::LinkPtr> resolvedLinks;
-        std::vector<KinBody::JointPtr> resolvedJoints;
-        FOREACHC(itConnectedBody, pRobot->GetConnectedBodies()) {
-            (*itConnectedBody)->GetResolvedLinks(resolvedLinks);
-            (*itConnectedBody)->GetResolvedJoints(resolvedJoints);
-            KinBody::JointPtr resolvedDummyJoint = (*itConnectedBody)->GetResolvedDummyPassiveJoint();
-
-            FOREACHC(itLink, _veclinks) {
-                if (std::find(resolvedLinks.begin(), resolvedLinks.end(), *itLink) != resolvedLinks.end()) {
-                    isConnectedLink[itLink-_veclinks.begin()] = true;
+    if( _bUseInfoContentHash && !info._contentHash.empty() && info._contentHash == _infoContentHash ) {
+        // links and joints did not change since the last update, only the state and the body fields below can differ
+        _updateFromInfoCounters.numSkippedBodyStructures++;
+    }
+    else {
+        // need to avoid checking links and joints belonging to connected bodies
+        std::vector<bool> isConnectedLink(_veclinks.size(), false);  // indicate which link comes from connectedbody
+        std::vector<bool> isConnectedJoint(_vecjoints.size(), false); // indicate which joint comes from connectedbody
+        std::vector<bool> isConnectedPassiveJoint(_vPassiveJoints.size(), false); // indicate which passive joint comes from connectedbody
+
+        if (IsRobot()) {
+            RobotBasePtr pRobot = RaveInterfaceCast<RobotBase>(shared_from_this());
+            std::vector<KinBody::LinkPtr> resolvedLinks;
+            std::vector<KinBody::JointPtr> resolvedJoints;
+            FOREACHC(itConnectedBody, pRobot->GetConnectedBodies()) {
+                (*itConnectedBody)->GetResolvedLinks(resolvedLinks);
+                (*itConnectedBody)->GetResolvedJoints(resolvedJoints);
+                KinBody::JointPtr resolvedDummyJoint = (*itConnectedBody)->GetResolvedDummyPassiveJoint();
+
+                FOREACHC(itLink, _veclinks) {
+                    if (std::find(resolvedLinks.begin(), resolvedLinks.end(), *itLink) != resolvedLinks.end()) {
+                        isConnectedLink[itLink-_veclinks.begin()] = true;
+                    }
                 }
-            }
-            FOREACHC(itJoint, _vecjoints) {
-                if (std::find(resolvedJoints.begin(), resolvedJoints.end(), *itJoint) != resolvedJoints.end()) {
-                    isConnectedJoint[itJoint-_vecjoints.begin()] = true;
+                FOREACHC(itJoint, _vecjoints) {
+                    if (std::find(resolvedJoints.begin(), resolvedJoints.end(), *itJoint) != resolvedJoints.end()) {
+                        isConnectedJoint[itJoint-_vecjoints.begin()] = true;
+                    }
                 }
-            }
-            FOREACHC(itPassiveJoint, _vPassiveJoints) {
-                if (std::find(resolvedJoints.begin(), resolvedJoints.end(), *itPassiveJoint) != resolvedJoints.end()) {
-                    isConnectedPassiveJoint[itPassiveJoint-_vPassiveJoints.begin()] = true;
-                } else if (resolvedDummyJoint == *itPassiveJoint) {
-                    isConnectedPassiveJoint[itPassiveJoint-_vPassiveJoints.begin()] = true;
+                FOREACHC(itPassiveJoint, _vPassiveJoints) {
+                    if (std::find(resolvedJoints.begin(), resolvedJoints.end(), *itPassiveJoint) != resolvedJoints.end()) {
+                        isConnectedPassiveJoint[itPassiveJoint-_vPassiveJoints.begin()] = true;
+                    } else if (resolvedDummyJoint == *itPassiveJoint) {
+                        isConnectedPassiveJoint[itPassiveJoint-_vPassiveJoints.begin()] = true;
+                    }
                 }
             }
         }
-    }
 
-    // build vectors of links and joints that we will deal with
-    std::vector<KinBody::LinkPtr> vLinks; vLinks.reserve(_veclinks.size());
-    std::vector<KinBody::JointPtr> vJoints; vJoints.reserve(_vecjoints.size() + _vPassiveJoints.size());
-    for (size_t iLink = 0; iLink < _veclinks.size(); ++iLink) {
-        if (!isConnectedLink[iLink]) {
-            vLinks.push_back(_veclinks[iLink]);
+        // build vectors of links and joints that we will deal with
+        std::vector<KinBody::LinkPtr> vLinks; vLinks.reserve(_veclinks.size());
+        std::vector<KinBody::JointPtr> vJoints; vJoints.reserve(_vecjoints.size() + _vPassiveJoints.size());
+        for (size_t iLink = 0; iLink < _veclinks.size(); ++iLink) {
+            if (!isConnectedLink[iLink]) {
+                vLinks.push_back(_veclinks[iLink]);
+            }
         }
-    }
-    for(size_t iJoint = 0; iJoint < _vecjoints.size(); iJoint++) {
-        if (!isConnectedJoint[iJoint]) {
-            vJoints.push_back(_vecjoints[iJoint]);
+        for(size_t iJoint = 0; iJoint < _vecjoints.size(); iJoint++) {
+            if (!isConnectedJoint[iJoint]) {
+                vJoints.push_back(_vecjoints[iJoint]);
+            }
         }
-    }
-    for(size_t iPassiveJoint = 0; iPassiveJoint < _vPassiveJoints.size(); iPassiveJoint++) {
-        if (!isConnectedPassiveJoint[iPassiveJoint]) {
-            vJoints.push_back(_vPassiveJoints[iPassiveJoint]);
+        for(size_t iPassiveJoint = 0; iPassiveJoint < _vPassiveJoints.size(); iPassiveJoint++) {
+            if (!isConnectedPassiveJoint[iPassiveJoint]) {
+                vJoints.push_back(_vPassiveJoints[iPassiveJoint]);
+            }
         }
-    }
 
-    {
-        // in order for link transform comparision to make sense, have to change the kinbody to the identify.
-        // First check if any of the link infos have modified transforms
-        KinBody::KinBodyStateSaverPtr stateSaver;
-        FOREACHC(itLinkInfo, info._vLinkInfos) {
-            // if any link has its transform field set, we need to set zero configuration before comparison
-            if( (*itLinkInfo)->IsModifiedField(KinBody::LinkInfo::LIF_Transform) ) {
-                stateSaver.reset(new KinBody::KinBodyStateSaver(shared_kinbody(), Save_LinkTransformation));
-                SetTransform(Transform());
-                vector<dReal> vZeros(GetDOF(), 0);
-                SetDOFValues(vZeros, KinBody::CLA_Nothing);
-                break;
+        {
+            // in order for link transform comparision to make sense, have to change the kinbody to the identify.
+            // First check if any of the link infos have modified transforms
+            KinBody::KinBodyStateSaverPtr stateSaver;
+            FOREACHC(itLinkInfo, info._vLinkInfos) {
+                // if any link has its transform field set, we need to set zero configuration before comparison
+                if( (*itLinkInfo)->IsModifiedField(KinBody::LinkInfo::LIF_Transform) ) {
+                    stateSaver.reset(new KinBody::KinBodyStateSaver(shared_kinbody(), Save_LinkTransformation));
+                    SetTransform(Transform());
+                    vector<dReal> vZeros(GetDOF(), 0);
+                    SetDOFValues(vZeros, KinBody::CLA_Nothing);
+                    break;
+                }
+            }
+
+            // links
+            if (!UpdateChildrenFromInfo(info._vLinkInfos, vLinks, updateFromInfoResult)) {
+                return updateFromInfoResult;
             }
         }
 
-        // links
-        if (!UpdateChildrenFromInfo(info._vLinkInfos, vLinks, updateFromInfoResult)) {
+        // joints
+        if (!UpdateChildrenFromInfo(info._vJointInfos, vJoints, updateFromInfoResult)) {
             return updateFromInfoResult;
         }
     }
 
-    // joints
-    if (!UpdateChildrenFromInfo(info._vJointInfos, vJoints, updateFromInfoResult)) {
-        return updateFromInfoResult;
-    }
-
     // name
     if (GetName() != info._name) {
         OPENRAVE_ASSERT_OP(info._name.size(), >, 0);
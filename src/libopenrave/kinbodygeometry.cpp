@@ -802,6 +802,7 @@ void KinBody::GeometryInfo::Reset()
     _type = GT_None;
     _id.clear();
     _name.clear();
+    _contentHash.clear();
     _filenamerender.clear();
     _filenamecollision.clear();
     _vRenderScale = Vector(1,1,1);
@@ -895,15 +896,30 @@ void KinBody::GeometryInfo::SerializeJSON(rapidjson::Value& rGeometryInfo, rapid
         rapidjson::Value rTriMesh;
         rTriMesh.SetObject();
         rapidjson::Value rVertices;
-        rVertices.SetArray();
-        rVertices.Reserve(_meshcollision.vertices.size()*3, allocator);
-        for(size_t ivertex = 0; ivertex < _meshcollision.vertices.size(); ++ivertex) {
-            rVertices.PushBack(_meshcollision.vertices[ivertex][0]*fUnitScale, allocator);
-            rVertices.PushBack(_meshcollision.vertices[ivertex][1]*fUnitScale, allocator);
-            rVertices.PushBack(_meshcollision.vertices[ivertex][2]*fUnitScale, allocator);
-        }
-        rTriMesh.AddMember("vertices", rVertices, allocator);
-        orjson::SetJsonValueByKey(rTriMesh, "indices", _meshcollision.indices, allocator);
+        if( options & ISO_BinaryMeshBlobs ) {
+            std::vector<double> vpositions(_meshcollision.vertices.size()*3);
+            for(size_t ivertex = 0; ivertex < _meshcollision.vertices.size(); ++ivertex) {
+                vpositions[3*ivertex+0] = _meshcollision.vertices[ivertex][0]*fUnitScale;
+                vpositions[3*ivertex+1] = _meshcollision.vertices[ivertex][1]*fUnitScale;
+                vpositions[3*ivertex+2] = _meshcollision.vertices[ivertex][2]*fUnitScale;
+            }
+            orjson::SetJsonBinaryBlob(rVertices, vpositions, allocator);
+            rTriMesh.AddMember("vertices", rVertices, allocator);
+            rapidjson::Value rIndices;
+            orjson::SetJsonBinaryBlob(rIndices, _meshcollision.indices, allocator);
+            rTriMesh.AddMember("indices", rIndices, allocator);
+        }
+        else {
+            rVertices.SetArray();
+            rVertices.Reserve(_meshcollision.vertices.size()*3, allocator);
+            for(size_t ivertex = 0; ivertex < _meshcollision.vertices.size(); ++ivertex) {
+                rVertices.PushBack(_meshcollision.vertices[ivertex][0]*fUnitScale, allocator);
+                rVertices.PushBack(_meshcollision.vertices[ivertex][1]*fUnitScale, allocator);
+                rVertices.PushBack(_meshcollision.vertices[ivertex][2]*fUnitScale, allocator);
+            }
+            rTriMesh.AddMember("vertices", rVertices, allocator);
+            orjson::SetJsonValueByKey(rTriMesh, "indices", _meshcollision.indices, allocator);
+        }
         rGeometryInfo.AddMember(rapidjson::Document::StringRefType("mesh"), rTriMesh, allocator);
         break;
     }
@@ -932,12 +948,16 @@ void KinBody::GeometryInfo::SerializeJSON(rapidjson::Value& rGeometryInfo, rapid
     orjson::SetJsonValueByKey(rGeometryInfo, "diffuseColor", _vDiffuseColor, allocator);
     orjson::SetJsonValueByKey(rGeometryInfo, "ambientColor", _vAmbientColor, allocator);
     orjson::SetJsonValueByKey(rGeometryInfo, "modifiable", _bModifiable, allocator);
+    if( options & ISO_ContentHash ) {
+        SetContentHashJSON(rGeometryInfo, allocator);
+    }
 }
 
 void KinBody::GeometryInfo::DeserializeJSON(const rapidjson::Value &value, const dReal fUnitScale, int options)
 {
     orjson::LoadJsonValueByKey(value, "id", _id);
     orjson::LoadJsonValueByKey(value, "name", _name);
+    _contentHash = orjson::GetStringJsonValueByKey(value, "contentHash"); // partial updates do not carry a hash, so always reset it
 
     if (value.HasMember("transform")) {
         Transform tnew;
@@ -1405,6 +1425,11 @@ void KinBody::Geometry::serialize(std::ostream& o, int options) const
     }
 }
 
+TriMeshBufferConstPtr KinBody::Geometry::CreateCollisionMeshBuffer() const
+{
+    return TriMeshBufferConstPtr(new TriMeshBuffer(_info._meshcollision));
+}
+
 void KinBody::Geometry::SetCollisionMesh(const TriMesh& mesh)
 {
     OPENRAVE_ASSERT_FORMAT0(_info._bModifiable, "geometry cannot be modified", ORE_Failed);
@@ -1584,6 +1609,7 @@ void KinBody::Geometry::ExtractInfo(KinBody::GeometryInfo& info) const
 {
     info = _info;
     info._modifiedFields = 0;
+    info._contentHash.clear(); // only describes what the geometry was last updated with
 }
 
 UpdateFromInfoResult KinBody::Geometry::UpdateFromInfo(const KinBody::GeometryInfo& info)
@@ -1591,6 +1617,17 @@ UpdateFromInfoResult KinBody::Geometry::UpdateFromInfo(const KinBody::GeometryIn
     if(!info._id.empty() && _info._id != info._id) {
         throw OPENRAVE_EXCEPTION_FORMAT("Do not allow updating link '%s' geometry '%s' (id='%s') with a different info id='%s'", _parent.lock()->GetName()%GetName()%_info._id%info._id, ORE_Assert);
     }
+
+    KinBody::LinkPtr parentlink = _parent.lock();
+    if( !!parentlink ) {
+        KinBody& parentbody = *parentlink->GetParent();
+        if( parentbody._bUseInfoContentHash && !info._contentHash.empty() && info._contentHash == _info._contentHash ) {
+            parentbody._updateFromInfoCounters.numSkippedGeometries++;
+            return UFIR_NoChange;
+        }
+        parentbody._updateFromInfoCounters.numComparedGeometries++;
+    }
+
     UpdateFromInfoResult updateFromInfoResult = UFIR_NoChange;
 
     if (GetName() != info._name) {
@@ -1686,6 +1723,7 @@ UpdateFromInfoResult KinBody::Geometry::UpdateFromInfo(const KinBody::GeometryIn
         updateFromInfoResult = UFIR_Success;
     }
 
+    _info._contentHash = info._contentHash;
     return updateFromInfoResult;
 }
 
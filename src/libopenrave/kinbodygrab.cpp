@@ -18,6 +18,28 @@
 
 namespace OpenRAVE {
 
+/// \brief appends the raw bytes of num values to a cache key
+template <typename T>
+static inline void _AppendToCacheKey(std::string& key, const T* pvalues, size_t num)
+{
+    if( num > 0 ) {
+        key.append(reinterpret_cast<const char*>(pvalues), num*sizeof(T));
+    }
+}
+
+/// \brief appends the kinematics-geometry hash and dof values of body, and its pose in the frame tinv, to a cache key
+static void _AppendBodyStateToCacheKey(std::string& key, const KinBody& body, const Transform& tinv, std::vector<dReal>& vdofvalues)
+{
+    key += body.GetKinematicsGeometryHash();
+    body.GetDOFValues(vdofvalues);
+    const uint32_t dof = vdofvalues.size();
+    _AppendToCacheKey(key, &dof, 1);
+    _AppendToCacheKey(key, vdofvalues.data(), vdofvalues.size());
+    const Transform t = tinv * body.GetTransform();
+    _AppendToCacheKey(key, &t.rot.x, 4);
+    _AppendToCacheKey(key, &t.trans.x, 3);
+}
+
 Grabbed::Grabbed(KinBodyPtr pGrabbedBody, KinBody::LinkPtr pGrabbingLink)
 {
     _pGrabbedBody = pGrabbedBody;
@@ -45,6 +67,31 @@ Grabbed::Grabbed(KinBodyPtr pGrabbedBody, KinBody::LinkPtr pGrabbingLink)
         _pGrabberSaver.reset(new KinBody::KinBodyStateSaver(pGrabber, defaultGrabberSaveOptions));
     }
     _pGrabberSaver->SetRestoreOnDestructor(false); // This is very important!
+
+    // Snapshot everything that the collision checks of ComputeListNonCollidingLinks depend on. Poses are relative to the
+    // grabbing link, so grabbing again with the same configuration at a different place gives the same key. Bodies that
+    // are not added to an environment yet (e.g. while cloning) do not have hashes, the result is not cached for them.
+    if( pGrabber->_nHierarchyComputed == 2 && pGrabbedBody->_nHierarchyComputed == 2 ) {
+        const Transform tGrabbingLinkInv = _pGrabbingLink->GetTransform().inverse();
+        std::vector<dReal> vdofvalues;
+        const int32_t grabbingLinkIndex = _pGrabbingLink->GetIndex();
+        _AppendToCacheKey(_nonCollidingCacheKey, &grabbingLinkIndex, 1);
+        _AppendBodyStateToCacheKey(_nonCollidingCacheKey, *pGrabber, tGrabbingLinkInv, vdofvalues);
+        _AppendBodyStateToCacheKey(_nonCollidingCacheKey, *pGrabbedBody, tGrabbingLinkInv, vdofvalues);
+        for( const GrabbedPtr& pOtherGrabbed : pGrabber->_vGrabbedBodies ) {
+            KinBodyPtr pOtherGrabbedBody = pOtherGrabbed->_pGrabbedBody.lock();
+            if( !pOtherGrabbedBody || pOtherGrabbedBody == pGrabbedBody ) {
+                continue;
+            }
+            if( pOtherGrabbedBody->_nHierarchyComputed != 2 ) {
+                _nonCollidingCacheKey.clear();
+                break;
+            }
+            const int32_t otherIndices[2] = {pOtherGrabbedBody->GetEnvironmentBodyIndex(), pOtherGrabbed->_pGrabbingLink->GetIndex()};
+            _AppendToCacheKey(_nonCollidingCacheKey, otherIndices, 2);
+            _AppendBodyStateToCacheKey(_nonCollidingCacheKey, *pOtherGrabbedBody, tGrabbingLinkInv, vdofvalues);
+        }
+    }
 } // end Grabbed
 
 void Grabbed::AddMoreIgnoreLinks(const std::set<int>& setAdditionalGrabberLinksToIgnore)
@@ -66,9 +113,25 @@ void Grabbed::ComputeListNonCollidingLinks()
         return;
     }
 
-    // Save the current state before proceeding with the computation
     KinBodyPtr pGrabbedBody(_pGrabbedBody);
     KinBodyPtr pGrabber = RaveInterfaceCast<KinBody>(_pGrabbingLink->GetParent());
+
+    // The ignored links are skipped by the checks below, so they are part of the key.
+    std::string cachekey;
+    if( !_nonCollidingCacheKey.empty() ) {
+        cachekey = _nonCollidingCacheKey;
+        const uint32_t numIgnored = _setGrabberLinkIndicesToIgnore.size();
+        _AppendToCacheKey(cachekey, &numIgnored, 1);
+        for( int ignoredLinkIndex : _setGrabberLinkIndicesToIgnore ) {
+            _AppendToCacheKey(cachekey, &ignoredLinkIndex, 1);
+        }
+        if( _LoadListNonCollidingLinksFromCache(pGrabber, cachekey) ) {
+            _listNonCollidingIsValid = true;
+            return;
+        }
+    }
+
+    // Save the current state before proceeding with the computation
     KinBody::KinBodyStateSaverPtr pCurrentGrabbedSaver, pCurrentGrabberSaver;
     int defaultSaveOptions = KinBody::Save_LinkTransformation|KinBody::Save_LinkEnable|KinBody::Save_LinkVelocities|KinBody::Save_JointLimits|KinBody::Save_GrabbedBodies;
     if( pGrabbedBody->IsRobot() ) {
@@ -181,6 +244,9 @@ void Grabbed::ComputeListNonCollidingLinks()
     }
 
     _listNonCollidingIsValid = true;
+    if( !cachekey.empty() ) {
+        _SaveListNonCollidingLinksToCache(pGrabber, cachekey);
+    }
     // if( 1 ) {
     //     std::stringstream ssdebug;
     //     ssdebug << "grabbedBody='" << pGrabbedBody->GetName() << "'; listNonCollidingLinks=[";
@@ -192,6 +258,50 @@ void Grabbed::ComputeListNonCollidingLinks()
     // }
 }
 
+bool Grabbed::_LoadListNonCollidingLinksFromCache(KinBodyPtr pGrabber, const std::string& cachekey)
+{
+    std::map<std::string, KinBody::GrabbedNonCollidingLinks>::const_iterator itcache = pGrabber->_mapGrabbedNonCollidingLinksCache.find(cachekey);
+    if( itcache == pGrabber->_mapGrabbedNonCollidingLinksCache.end() ) {
+        return false;
+    }
+    const KinBody::GrabbedNonCollidingLinks& nonCollidingLinks = itcache->second;
+    std::list<KinBody::LinkConstPtr> listNonCollidingLinks;
+    for( int linkIndex : nonCollidingLinks.vGrabberLinkIndices ) {
+        listNonCollidingLinks.push_back(pGrabber->GetLinks().at(linkIndex));
+    }
+    EnvironmentBasePtr penv = pGrabber->GetEnv();
+    for( const std::pair<int, int>& otherLink : nonCollidingLinks.vOtherGrabbedLinks ) {
+        // the key contains the environment body indices and geometry hashes of the other grabbed bodies, so this only fails if a body was replaced in between
+        KinBodyPtr pOtherGrabbedBody = penv->GetBodyFromEnvironmentBodyIndex(otherLink.first);
+        if( !pOtherGrabbedBody || otherLink.second >= (int)pOtherGrabbedBody->GetLinks().size() ) {
+            return false;
+        }
+        listNonCollidingLinks.push_back(pOtherGrabbedBody->GetLinks()[otherLink.second]);
+    }
+    _listNonCollidingLinksWhenGrabbed.swap(listNonCollidingLinks);
+    return true;
+}
+
+void Grabbed::_SaveListNonCollidingLinksToCache(KinBodyPtr pGrabber, const std::string& cachekey) const
+{
+    static const size_t s_maxCacheSize = 64;
+    if( pGrabber->_mapGrabbedNonCollidingLinksCache.size() >= s_maxCacheSize ) {
+        // entries of old geometries or configurations are never looked up again, so just start over
+        pGrabber->_mapGrabbedNonCollidingLinksCache.clear();
+    }
+    KinBody::GrabbedNonCollidingLinks& nonCollidingLinks = pGrabber->_mapGrabbedNonCollidingLinksCache[cachekey];
+    nonCollidingLinks.vGrabberLinkIndices.clear();
+    nonCollidingLinks.vOtherGrabbedLinks.clear();
+    for( const KinBody::LinkConstPtr& pLink : _listNonCollidingLinksWhenGrabbed ) {
+        if( pLink->GetParent().get() == pGrabber.get() ) {
+            nonCollidingLinks.vGrabberLinkIndices.push_back(pLink->GetIndex());
+        }
+        else {
+            nonCollidingLinks.vOtherGrabbedLinks.emplace_back(pLink->GetParent()->GetEnvironmentBodyIndex(), pLink->GetIndex());
+        }
+    }
+}
+
 bool KinBody::Grab(KinBodyPtr pGrabbedBody, LinkPtr pGrabbingLink, const rapidjson::Value& rGrabbedUserData)
 {
     // always ignore links that are statically attached to plink (ie assume they are always colliding with the body)
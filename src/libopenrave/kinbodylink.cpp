@@ -26,6 +26,7 @@ void KinBody::LinkInfo::Reset()
     _mapExtraGeometries.clear();
     _id.clear();
     _name.clear();
+    _contentHash.clear();
     _t = Transform();
     _tMassFrame = Transform();
     _mass = 1e-10; // to avoid divide by 0 for inverse dynamics/physics computations
@@ -215,12 +216,16 @@ void KinBody::LinkInfo::SerializeJSON(rapidjson::Value &value, rapidjson::Docume
 
     orjson::SetJsonValueByKey(value, "isStatic", _bStatic, allocator);
     orjson::SetJsonValueByKey(value, "isEnabled", _bIsEnabled, allocator);
+    if( options & ISO_ContentHash ) {
+        SetContentHashJSON(value, allocator);
+    }
 }
 
 void KinBody::LinkInfo::DeserializeJSON(const rapidjson::Value &value, dReal fUnitScale, int options)
 {
     orjson::LoadJsonValueByKey(value, "id", _id);
     orjson::LoadJsonValueByKey(value, "name", _name);
+    _contentHash = orjson::GetStringJsonValueByKey(value, "contentHash"); // partial updates do not carry a hash, so always reset it
 
     if (value.HasMember("transform")) {
         orjson::LoadJsonValueByKey(value, "transform", _t);
@@ -975,6 +980,7 @@ void KinBody::Link::ExtractInfo(KinBody::LinkInfo& info) const
 {
     info = _info;
     info._modifiedFields = 0;
+    info._contentHash.clear(); // only describes what the link was last updated with
     info._vgeometryinfos.resize(_vGeometries.size());
     for (size_t i = 0; i < info._vgeometryinfos.size(); ++i) {
         info._vgeometryinfos[i].reset(new KinBody::GeometryInfo());
@@ -988,6 +994,13 @@ UpdateFromInfoResult KinBody::Link::UpdateFromInfo(const KinBody::LinkInfo& info
         throw OPENRAVE_EXCEPTION_FORMAT("Do not allow updating body '%s' link '%s' (id='%s') with a different info id='%s'", GetParent()->GetName()%GetName()%_info._id%info._id, ORE_Assert);
     }
 
+    KinBody& parentbody = *GetParent();
+    if( parentbody._bUseInfoContentHash && !info._contentHash.empty() && info._contentHash == _info._contentHash ) {
+        parentbody._updateFromInfoCounters.numSkippedLinks++;
+        return UFIR_NoChange;
+    }
+    parentbody._updateFromInfoCounters.numComparedLinks++;
+
     UpdateFromInfoResult updateFromInfoResult = UFIR_NoChange;
 
     std::vector<KinBody::Link::GeometryPtr> vGeometries = _vGeometries;
@@ -1091,6 +1104,7 @@ UpdateFromInfoResult KinBody::Link::UpdateFromInfo(const KinBody::LinkInfo& info
         updateFromInfoResult = UFIR_Success;
     }
 
+    _info._contentHash = info._contentHash;
     return updateFromInfoResult;
 }
 
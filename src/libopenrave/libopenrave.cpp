@@ -443,10 +443,6 @@ public:
             RAVELOG_WARN("failed to set to C locale: %s\n",e.what());
         }
 
-        // since initialization depends on _pdatabase, have pdatabase be local until it is complete
-        boost::shared_ptr<RaveDatabase> pdatabase = boost::make_shared<DynamicRaveDatabase>();
-        pdatabase->Init();
-
         char* phomedir = getenv("OPENRAVE_HOME"); // getenv not thread-safe?
         if( phomedir == NULL ) {
 #ifndef _WIN32
@@ -464,6 +460,18 @@ public:
         CreateDirectory(_homedirectory.c_str(),NULL);
 #endif
 
+        // the plugin manifest lets startup skip dlopening plugins until one of their interfaces is created.
+        // OPENRAVE_PLUGINS_MANIFEST overrides its location, setting it to an empty string disables it.
+        std::string pluginmanifestfilename = _homedirectory + s_filesep + "pluginmanifest.json";
+        const char* pOPENRAVE_PLUGINS_MANIFEST = getenv("OPENRAVE_PLUGINS_MANIFEST"); // getenv not thread-safe?
+        if( pOPENRAVE_PLUGINS_MANIFEST != NULL ) {
+            pluginmanifestfilename = pOPENRAVE_PLUGINS_MANIFEST;
+        }
+
+        // since initialization depends on _pdatabase, have pdatabase be local until it is complete
+        boost::shared_ptr<RaveDatabase> pdatabase = boost::make_shared<DynamicRaveDatabase>(pluginmanifestfilename);
+        pdatabase->Init();
+
 #ifdef _WIN32
         const char* delim = ";";
 #else
@@ -2402,6 +2410,27 @@ std::istream& operator>>(std::istream& I, TriMesh& trimesh)
 }
 
 
+TriMeshBuffer::TriMeshBuffer(const TriMesh& mesh)
+{
+    _vpositions.resize(3*mesh.vertices.size());
+    for(size_t i = 0; i < mesh.vertices.size(); ++i) {
+        _vpositions[3*i+0] = mesh.vertices[i].x;
+        _vpositions[3*i+1] = mesh.vertices[i].y;
+        _vpositions[3*i+2] = mesh.vertices[i].z;
+    }
+    _b16BitIndices = mesh.vertices.size() <= 0x10000;
+    if( _b16BitIndices ) {
+        _vindices16.resize(mesh.indices.size());
+        for(size_t i = 0; i < mesh.indices.size(); ++i) {
+            OPENRAVE_ASSERT_OP_FORMAT(mesh.indices[i], <, (int32_t)mesh.vertices.size(), "index %d is out of bounds", i, ORE_InvalidArguments);
+            _vindices16[i] = (uint16_t)mesh.indices[i];
+        }
+    }
+    else {
+        _vindices32 = mesh.indices;
+    }
+}
+
 // Dummy Reader
 DummyXMLReader::DummyXMLReader(const std::string& fieldname, const std::string& pparentname, boost::shared_ptr<std::ostream> osrecord) : _fieldname(fieldname), _osrecord(osrecord)
 {
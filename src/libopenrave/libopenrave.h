@@ -532,6 +532,12 @@ void UpdateOrCreateInfoWithNameCheck(const rapidjson::Value& value, std::vector<
     vInfos.push_back(pNewInfo);
 }
 
+/// \brief sets "contentHash" of a serialized info to the md5 of what has been serialized so far, see ISO_ContentHash
+inline void SetContentHashJSON(rapidjson::Value& rInfo, rapidjson::Document::AllocatorType& allocator)
+{
+    OpenRAVE::orjson::SetJsonValueByKey(rInfo, "contentHash", utils::GetMD5HashString(OpenRAVE::orjson::DumpJson(rInfo)), allocator);
+}
+
 /// \brief Recursively call UpdateFromInfo on children. If children need to be added or removed, require re-init. Returns false if update fails and caller should not continue with other parts of the update.
 template<typename InfoPtrType, typename PtrType>
 bool UpdateChildrenFromInfo(const std::vector<InfoPtrType>& vInfos, std::vector<PtrType>& vPointers, UpdateFromInfoResult& result)
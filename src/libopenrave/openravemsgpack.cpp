@@ -98,6 +98,10 @@ struct pack< rapidjson::GenericValue<Encoding, Allocator> > {
                 return o.pack_true();
             case rapidjson::kObjectType:
             {
+                if (OpenRAVE::orjson::IsJsonBinaryBlob(v)) {
+                    const rapidjson::GenericValue<Encoding, Allocator>& rData = v.MemberBegin()->value;
+                    return o.pack_bin(rData.GetStringLength()).pack_bin_body(rData.GetString(), rData.GetStringLength());
+                }
                 o.pack_map(v.MemberCount());
                 typename rapidjson::GenericValue<Encoding, Allocator>::ConstMemberIterator i = v.MemberBegin(), END = v.MemberEnd();
                 for (; i != END; ++i)
@@ -161,6 +165,16 @@ struct object_with_zone< rapidjson::GenericValue<Encoding, Allocator> > {
                 break;
             case rapidjson::kObjectType:
             {
+                if (OpenRAVE::orjson::IsJsonBinaryBlob(v)) {
+                    const rapidjson::GenericValue<Encoding, Allocator>& rData = v.MemberBegin()->value;
+                    o.type = type::BIN;
+                    size_t size = rData.GetStringLength();
+                    char* ptr = (char*)o.zone.allocate_align(size);
+                    memcpy(ptr, rData.GetString(), size);
+                    o.via.bin.ptr = ptr;
+                    o.via.bin.size = size;
+                    break;
+                }
                 o.type = type::MAP;
                 if (v.ObjectEmpty()) {
                     o.via.map.ptr = NULL;
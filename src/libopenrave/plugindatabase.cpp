@@ -16,7 +16,10 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <cstdarg>
 #include <cstring>
+#include <cstdio>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <mutex>
 
 #include <openrave/openraveexception.h>
@@ -36,7 +39,7 @@ namespace fs = boost::filesystem;
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
-
+#include <unistd.h>
 #endif
 
 #ifdef _WIN32
@@ -110,7 +113,115 @@ void* DynamicRaveDatabase::DynamicLibrary::LoadSymbol(const std::string& name, s
 #endif
 }
 
-DynamicRaveDatabase::DynamicRaveDatabase()
+/// \brief Stands in for a plugin whose interfaces are known from the manifest.
+///
+/// The shared object is dlopened the first time one of its interfaces is created, so startup only has to stat the plugin files.
+class DynamicRaveDatabase::LazyPlugin final : public RavePlugin
+{
+public:
+    LazyPlugin(const std::string& strpath, const PluginManifestEntry& entry, boost::weak_ptr<DynamicRaveDatabase> pdatabase) : _pluginname(entry.pluginname), _interfaces(entry.interfaces), _pdatabase(pdatabase)
+    {
+        SetPluginPath(strpath);
+    }
+
+    void OnRaveInitialized() override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _bRaveInitialized = true;
+        if( !!_plugin ) {
+            _plugin->OnRaveInitialized();
+        }
+    }
+
+    void OnRavePreDestroy() override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _bRaveInitialized = false;
+        if( !!_plugin ) {
+            _plugin->OnRavePreDestroy();
+        }
+    }
+
+    void Destroy() override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if( !!_plugin ) {
+            _plugin->Destroy();
+        }
+    }
+
+    const InterfaceMap& GetInterfaces() const override
+    {
+        return _interfaces;
+    }
+
+    const std::string& GetPluginName() const override
+    {
+        return _pluginname;
+    }
+
+protected:
+    InterfaceBasePtr CreateInterface(InterfaceType type, const std::string& interfacename, std::istream& sinput, EnvironmentBasePtr penv) override
+    {
+        PluginPtr plugin = _Load();
+        if( !plugin ) {
+            return InterfaceBasePtr();
+        }
+        // reassemble the name with its creation parameters, the loaded plugin parses it again
+        std::string name = interfacename;
+        name.append(std::istreambuf_iterator<char>(sinput), std::istreambuf_iterator<char>());
+        return plugin->OpenRAVECreateInterface(type, name, RaveGetInterfaceHash(type), OPENRAVE_ENVIRONMENT_HASH, penv);
+    }
+
+private:
+    PluginPtr _Load()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if( !!_plugin || _bLoadFailed ) {
+            return _plugin;
+        }
+        const std::string& strpath = GetPluginPath();
+        _pdylib.reset(new DynamicLibrary(strpath));
+        RavePlugin* plugin = _CreatePluginFromLibrary(*_pdylib, strpath);
+        if( !plugin ) {
+            RAVELOG_WARN_FORMAT("Failed to load plugin %s at %s listed in the plugin manifest", _pluginname % strpath);
+            _bLoadFailed = true;
+            _RemoveManifestEntry(strpath);
+            return _plugin;
+        }
+        _plugin.reset(plugin);
+        _plugin->SetPluginPath(strpath);
+        if( _plugin->GetInterfaces() != _interfaces ) {
+            RAVELOG_WARN_FORMAT("Plugin %s at %s offers different interfaces than its manifest entry, the manifest will be refreshed on the next start", _pluginname % strpath);
+            _RemoveManifestEntry(strpath);
+        }
+        if( _bRaveInitialized ) {
+            _plugin->OnRaveInitialized();
+        }
+        RAVELOG_DEBUG_FORMAT("Loaded %s at %s on demand.", _pluginname % strpath);
+        return _plugin;
+    }
+
+    /// \brief drops the entry of the shared object from the manifest so that the next start scans it again
+    void _RemoveManifestEntry(const std::string& strpath)
+    {
+        boost::shared_ptr<DynamicRaveDatabase> pdatabase = _pdatabase.lock();
+        if( !!pdatabase ) {
+            pdatabase->_RemovePluginManifestEntry(strpath);
+        }
+    }
+
+    std::mutex _mutex; ///< protects the loaded plugin
+    std::string _pluginname;
+    InterfaceMap _interfaces; ///< interfaces from the manifest
+    std::unique_ptr<DynamicLibrary> _pdylib;
+    PluginPtr _plugin; ///< the real plugin, empty until the first CreateInterface
+    boost::weak_ptr<DynamicRaveDatabase> _pdatabase; ///< owner of the manifest, notified when the entry turns out to be stale
+    bool _bRaveInitialized = false; ///< true if OnRaveInitialized was received before the plugin was loaded
+    bool _bLoadFailed = false;
+};
+
+DynamicRaveDatabase::DynamicRaveDatabase(const std::string& manifestfilename) : _manifestfilename(manifestfilename)
 {
 }
 
@@ -186,10 +297,30 @@ void DynamicRaveDatabase::Init()
         }
         _vPluginDirs.emplace_back(std::move(entry));
     }
+    {
+        std::lock_guard<std::mutex> lock(_mutexManifest);
+        _ReadPluginManifest();
+    }
     for (const std::string& entry : _vPluginDirs) {
         RAVELOG_DEBUG_FORMAT("Looking for plugins in %s", entry);
         _LoadPluginsFromPath(entry);
     }
+    // drop entries of plugins that were removed
+    std::lock_guard<std::mutex> lock(_mutexManifest);
+    for (std::map<std::string, PluginManifestEntry>::iterator it = _mapPluginManifest.begin(); it != _mapPluginManifest.end(); ) {
+        if( _setSeenPluginPaths.count(it->first) == 0 ) {
+            it = _mapPluginManifest.erase(it);
+            _bPluginManifestModified = true;
+        }
+        else {
+            ++it;
+        }
+    }
+    _setSeenPluginPaths.clear();
+    if( _bPluginManifestModified ) {
+        _WritePluginManifest();
+        _bPluginManifestModified = false;
+    }
 }
 
 void DynamicRaveDatabase::ReloadPlugins()
@@ -246,7 +377,7 @@ void DynamicRaveDatabase::_LoadPluginsFromPath(const std::string& strpath, bool
     } else if (fs::is_regular_file(path)) {
         // Check that the file has a platform-appropriate extension
         if (0 == strpath.compare(strpath.size() - PLUGIN_EXT.size(), PLUGIN_EXT.size(), PLUGIN_EXT)) {
-            _LoadPlugin(path.string());
+            _LoadPluginFromManifest(path.string());
         }
     } else {
         RAVELOG_WARN_FORMAT("Path is not a valid directory or file: %s", strpath);
@@ -284,7 +415,7 @@ void DynamicRaveDatabase::_LoadPluginsFromPath(const std::string& strpath, bool
         }
         ::closedir(dirptr);
     } else if (S_ISREG(sb.st_mode)) {
-        _LoadPlugin(strpath);
+        _LoadPluginFromManifest(strpath);
     } else {
         // Not a directory or file, ignore it
     }
@@ -298,15 +429,76 @@ void DynamicRaveDatabase::_LoadPluginsFromPath(const std::string& strpath, bool
 bool DynamicRaveDatabase::_LoadPlugin(const std::string& strpath)
 {
     DynamicLibrary dylib(strpath);
+    RavePlugin* plugin = _CreatePluginFromLibrary(dylib, strpath);
+    if (!plugin) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _mapLibraryHandles.emplace(strpath, std::move(dylib)); // Keep the library handle around in case we need it
+    _vPlugins.emplace_back(PluginPtr(plugin)); // Ownership passed to the shared_ptr
+    _vPlugins.back()->SetPluginPath(strpath);
+    RAVELOG_DEBUG_FORMAT("Found %s at %s.", _vPlugins.back()->GetPluginName() % strpath);
+    return true;
+}
+
+bool DynamicRaveDatabase::_LoadPluginFromManifest(const std::string& strpath)
+{
+    int64_t mtime = 0, size = 0;
+    if( _manifestfilename.empty() || !_GetFileStamp(strpath, mtime, size) ) {
+        return _LoadPlugin(strpath);
+    }
+    {
+        std::lock_guard<std::mutex> lockmanifest(_mutexManifest);
+        _setSeenPluginPaths.insert(strpath);
+        std::map<std::string, PluginManifestEntry>::const_iterator itentry = _mapPluginManifest.find(strpath);
+        if( itentry != _mapPluginManifest.end() && itentry->second.mtime == mtime && itentry->second.size == size ) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _vPlugins.emplace_back(boost::make_shared<LazyPlugin>(strpath, itentry->second, boost::weak_ptr<DynamicRaveDatabase>(shared_from_this())));
+            RAVELOG_VERBOSE_FORMAT("Found %s at %s in plugin manifest.", itentry->second.pluginname % strpath);
+            return true;
+        }
+    }
+
+    if( !_LoadPlugin(strpath) ) {
+        // not cached, the shared object might only be missing a dependency that becomes available later
+        std::lock_guard<std::mutex> lockmanifest(_mutexManifest);
+        if( _mapPluginManifest.erase(strpath) > 0 ) {
+            _bPluginManifestModified = true;
+        }
+        return false;
+    }
+    std::lock_guard<std::mutex> lockmanifest(_mutexManifest);
+    PluginManifestEntry& entry = _mapPluginManifest[strpath];
+    entry.mtime = mtime;
+    entry.size = size;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        entry.pluginname = _vPlugins.back()->GetPluginName();
+        entry.interfaces = _vPlugins.back()->GetInterfaces();
+    }
+    _bPluginManifestModified = true;
+    return true;
+}
+
+void DynamicRaveDatabase::_RemovePluginManifestEntry(const std::string& strpath)
+{
+    std::lock_guard<std::mutex> lock(_mutexManifest);
+    if( _mapPluginManifest.erase(strpath) > 0 ) {
+        _WritePluginManifest();
+    }
+}
+
+RavePlugin* DynamicRaveDatabase::_CreatePluginFromLibrary(const DynamicLibrary& dylib, const std::string& strpath)
+{
     if (!dylib) {
         RAVELOG_DEBUG_FORMAT("Failed to load shared object %s", strpath);
-        return false;
+        return nullptr;
     }
     std::string errstr;
     void* psym = dylib.LoadSymbol("CreatePlugin", errstr);
     if (!psym) {
         RAVELOG_DEBUG_FORMAT("%s, might not be an OpenRAVE plugin.", errstr);
-        return false;
+        return nullptr;
     }
     RavePlugin* plugin = nullptr;
     try {
@@ -314,15 +506,147 @@ bool DynamicRaveDatabase::_LoadPlugin(const std::string& strpath)
     } catch (const std::exception& e) {
         RAVELOG_WARN_FORMAT("Failed to construct a RavePlugin from %s: %s", strpath % e.what());
     }
-    if (!plugin) {
+    return plugin;
+}
+
+bool DynamicRaveDatabase::_GetFileStamp(const std::string& strpath, int64_t& mtime, int64_t& size)
+{
+#ifdef HAVE_BOOST_FILESYSTEM
+    boost::system::error_code ec;
+    const fs::path path(strpath);
+    const std::time_t writetime = fs::last_write_time(path, ec);
+    if (!!ec) {
         return false;
     }
-    std::lock_guard<std::mutex> lock(_mutex);
-    _mapLibraryHandles.emplace(strpath, std::move(dylib)); // Keep the library handle around in case we need it
-    _vPlugins.emplace_back(PluginPtr(plugin)); // Ownership passed to the shared_ptr
-    _vPlugins.back()->SetPluginPath(strpath);
-    RAVELOG_DEBUG_FORMAT("Found %s at %s.", _vPlugins.back()->GetPluginName() % strpath);
+    const boost::uintmax_t filesize = fs::file_size(path, ec);
+    if (!!ec) {
+        return false;
+    }
+    mtime = static_cast<int64_t>(writetime);
+    size = static_cast<int64_t>(filesize);
+    return true;
+#else
+    struct stat sb;
+    if (::stat(strpath.c_str(), &sb) != 0) {
+        return false;
+    }
+    mtime = static_cast<int64_t>(sb.st_mtime);
+    size = static_cast<int64_t>(sb.st_size);
     return true;
+#endif
+}
+
+void DynamicRaveDatabase::_ReadPluginManifest()
+{
+    _mapPluginManifest.clear();
+    _bPluginManifestModified = false;
+    if( _manifestfilename.empty() ) {
+        return;
+    }
+    std::ifstream ifs(_manifestfilename.c_str());
+    if( !ifs ) {
+        _bPluginManifestModified = true; // create it
+        return;
+    }
+    try {
+        rapidjson::Document doc;
+        orjson::ParseJson(doc, ifs);
+        int version = 0;
+        std::string pluginInfoHash;
+        orjson::LoadJsonValueByKey(doc, "version", version);
+        orjson::LoadJsonValueByKey(doc, "pluginInfoHash", pluginInfoHash);
+        if( version != OPENRAVE_VERSION || pluginInfoHash != OPENRAVE_PLUGININFO_HASH ) {
+            RAVELOG_DEBUG_FORMAT("plugin manifest %s was written by a different openrave version, ignoring it", _manifestfilename);
+            _bPluginManifestModified = true;
+            return;
+        }
+        std::map<std::string, InterfaceType> mapTypes;
+        FOREACHC(ittype, RaveGetInterfaceNamesMap()) {
+            mapTypes[ittype->second] = ittype->first;
+        }
+        rapidjson::Value::ConstMemberIterator itplugins = doc.FindMember("plugins");
+        if( itplugins == doc.MemberEnd() || !itplugins->value.IsArray() ) {
+            _bPluginManifestModified = true;
+            return;
+        }
+        for (const rapidjson::Value& rPlugin : itplugins->value.GetArray()) {
+            std::string path;
+            orjson::LoadJsonValueByKey(rPlugin, "path", path);
+            if( path.empty() ) {
+                continue;
+            }
+            PluginManifestEntry entry;
+            orjson::LoadJsonValueByKey(rPlugin, "mtime", entry.mtime);
+            orjson::LoadJsonValueByKey(rPlugin, "size", entry.size);
+            orjson::LoadJsonValueByKey(rPlugin, "name", entry.pluginname);
+            std::map<std::string, std::vector<std::string> > mapInterfaces;
+            orjson::LoadJsonValueByKey(rPlugin, "interfaces", mapInterfaces);
+            FOREACHC(itinterface, mapInterfaces) {
+                std::map<std::string, InterfaceType>::const_iterator ittype = mapTypes.find(itinterface->first);
+                if( ittype != mapTypes.end() ) {
+                    entry.interfaces[ittype->second] = itinterface->second;
+                }
+            }
+            _mapPluginManifest[path] = std::move(entry);
+        }
+    }
+    catch (const std::exception& ex) {
+        RAVELOG_WARN_FORMAT("failed to read plugin manifest %s, rebuilding it: %s", _manifestfilename % ex.what());
+        _mapPluginManifest.clear();
+        _bPluginManifestModified = true;
+    }
+}
+
+void DynamicRaveDatabase::_WritePluginManifest() const
+{
+    if( _manifestfilename.empty() ) {
+        return;
+    }
+    rapidjson::Document doc;
+    doc.SetObject();
+    orjson::SetJsonValueByKey(doc, "version", (int)OPENRAVE_VERSION);
+    orjson::SetJsonValueByKey(doc, "pluginInfoHash", std::string(OPENRAVE_PLUGININFO_HASH));
+    rapidjson::Value rPlugins(rapidjson::kArrayType);
+    FOREACHC(itentry, _mapPluginManifest) {
+        rapidjson::Value rPlugin(rapidjson::kObjectType);
+        orjson::SetJsonValueByKey(rPlugin, "path", itentry->first, doc.GetAllocator());
+        orjson::SetJsonValueByKey(rPlugin, "mtime", itentry->second.mtime, doc.GetAllocator());
+        orjson::SetJsonValueByKey(rPlugin, "size", itentry->second.size, doc.GetAllocator());
+        orjson::SetJsonValueByKey(rPlugin, "name", itentry->second.pluginname, doc.GetAllocator());
+        std::map<std::string, std::vector<std::string> > mapInterfaces;
+        FOREACHC(itinterface, itentry->second.interfaces) {
+            mapInterfaces[RaveGetInterfaceName(itinterface->first)] = itinterface->second;
+        }
+        orjson::SetJsonValueByKey(rPlugin, "interfaces", mapInterfaces, doc.GetAllocator());
+        rPlugins.PushBack(rPlugin, doc.GetAllocator());
+    }
+    doc.AddMember("plugins", rPlugins, doc.GetAllocator());
+
+    // write to a temporary file and rename it so that concurrent processes never read a partial manifest
+    const std::string tempfilename = str(boost::format("%s.%d.tmp")%_manifestfilename%
+#ifdef _WIN32
+                                                 GetCurrentProcessId()
+#else
+                                                 getpid()
+#endif
+                                                 );
+    {
+        std::ofstream ofs(tempfilename.c_str());
+        if( !ofs ) {
+            RAVELOG_DEBUG_FORMAT("failed to write plugin manifest %s", tempfilename);
+            return;
+        }
+        orjson::DumpJson(doc, ofs);
+        if( !ofs ) {
+            RAVELOG_DEBUG_FORMAT("failed to write plugin manifest %s", tempfilename);
+            std::remove(tempfilename.c_str());
+            return;
+        }
+    }
+    if( std::rename(tempfilename.c_str(), _manifestfilename.c_str()) != 0 ) {
+        RAVELOG_DEBUG_FORMAT("failed to write plugin manifest %s", _manifestfilename);
+        std::remove(tempfilename.c_str());
+    }
 }
 
 } // namespace OpenRAVE
@@ -30,7 +30,8 @@ namespace OpenRAVE {
 
 class DynamicRaveDatabase final : public RaveDatabase, public boost::enable_shared_from_this<DynamicRaveDatabase> {
 public:
-    DynamicRaveDatabase();
+    /// \param manifestfilename file caching the interfaces offered by each plugin shared object. When set, plugins whose manifest entry is up to date are only dlopened the first time one of their interfaces is created. Empty disables the cache.
+    DynamicRaveDatabase(const std::string& manifestfilename = std::string());
     DynamicRaveDatabase(const DynamicRaveDatabase&) = delete; // Copying not allowed
     DynamicRaveDatabase(DynamicRaveDatabase&&) = default;
     ~DynamicRaveDatabase() override;
@@ -56,11 +57,37 @@ private:
         void* _handle;
     };
 
+    /// \brief What a plugin shared object offers, cached on disk so that startup does not have to dlopen it.
+    struct PluginManifestEntry
+    {
+        int64_t mtime = 0; ///< modification time of the shared object when the entry was recorded
+        int64_t size = 0; ///< size in bytes of the shared object when the entry was recorded
+        std::string pluginname;
+        RavePlugin::InterfaceMap interfaces;
+    };
+
+    class LazyPlugin; ///< proxy registered from a manifest entry, dlopens the shared object on first CreateInterface
+
     void _LoadPluginsFromPath(const std::string&, bool recurse = false);
     bool _LoadPlugin(const std::string&); ///< Attempts to load a RavePlugin from a shared object, fails liberally if the right symbols cannot be found. Locks _mutex.
+    bool _LoadPluginFromManifest(const std::string&); ///< Registers a LazyPlugin if the manifest entry of the shared object is up to date, otherwise calls _LoadPlugin and records its interfaces. Locks _mutexManifest and _mutex.
+    void _RemovePluginManifestEntry(const std::string&); ///< Drops a stale entry found by a LazyPlugin and rewrites the manifest. Locks _mutexManifest.
+
+    /// \brief dlopens strpath and calls its CreatePlugin export. Returns NULL if it is not a valid plugin.
+    static RavePlugin* _CreatePluginFromLibrary(const DynamicLibrary& dylib, const std::string& strpath);
+    static bool _GetFileStamp(const std::string& strpath, int64_t& mtime, int64_t& size);
+
+    void _ReadPluginManifest();
+    void _WritePluginManifest() const;
 
     std::vector<std::string> _vPluginDirs; ///< List of plugin directories
     std::unordered_map<std::string, DynamicLibrary> _mapLibraryHandles; ///< A map of paths to *open* shared object handles.
+
+    std::string _manifestfilename; ///< empty if the manifest cache is disabled
+    std::mutex _mutexManifest; ///< protects _mapPluginManifest, _setSeenPluginPaths and _bPluginManifestModified, LazyPlugin can drop entries from any thread
+    std::map<std::string, PluginManifestEntry> _mapPluginManifest; ///< manifest entries keyed by shared object path. Entries read from disk are replaced by the ones found during Init.
+    std::set<std::string> _setSeenPluginPaths; ///< shared objects found during Init, used to prune stale manifest entries
+    bool _bPluginManifestModified = false; ///< true if _mapPluginManifest differs from the file on disk
 };
 
 } // end namespace OpenRAVE
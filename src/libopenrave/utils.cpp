@@ -19,6 +19,11 @@
 
 #include "md5.h"
 
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 namespace OpenRAVE {
 namespace utils {
 
@@ -121,5 +126,56 @@ std::string GetFilenameUntilSeparator(std::istream& sinput, char separator)
     return filename.substr( startpos, endpos-startpos+1 );
 }
 
+void ParallelForEachIndex(int count, const boost::function<void(int)>& fn, int maxthreads)
+{
+    if( count <= 0 ) {
+        return;
+    }
+    int numthreads = maxthreads > 0 ? maxthreads : (int)std::thread::hardware_concurrency();
+    numthreads = std::min(numthreads, count);
+    if( numthreads <= 1 ) {
+        for(int index = 0; index < count; ++index) {
+            fn(index);
+        }
+        return;
+    }
+
+    std::atomic<int> nextindex(0);
+    std::atomic<bool> bAbort(false);
+    std::exception_ptr pexception;
+    std::mutex mutexexception;
+    auto worker = [&]() {
+        while( !bAbort ) {
+            const int index = nextindex++;
+            if( index >= count ) {
+                break;
+            }
+            try {
+                fn(index);
+            }
+            catch(...) {
+                std::lock_guard<std::mutex> lock(mutexexception);
+                if( !pexception ) {
+                    pexception = std::current_exception();
+                }
+                bAbort = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> vthreads;
+    vthreads.reserve(numthreads-1);
+    for(int ithread = 0; ithread+1 < numthreads; ++ithread) {
+        vthreads.emplace_back(worker);
+    }
+    worker(); // calling thread also does work
+    FOREACH(itthread, vthreads) {
+        itthread->join();
+    }
+    if( !!pexception ) {
+        std::rethrow_exception(pexception);
+    }
+}
+
 } // utils
 } // OpenRAVE
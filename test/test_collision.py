@@ -67,6 +67,39 @@ class RunCollision(EnvironmentSetup):
                     assert(check==robot.CheckSelfCollision())
                 env.Remove(robot)
 
+    def test_checkcollisionconfigurations(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot = env.GetRobots()[0]
+        with env:
+            lower,upper = robot.GetDOFLimits()
+            configurations = array([random.rand(robot.GetDOF())*(upper-lower)+lower for i in range(20)])
+            initialvalues = robot.GetDOFValues()
+            collisions = env.CheckCollisionConfigurations(robot, configurations)
+            assert(len(collisions)==len(configurations))
+            assert(transdist(robot.GetDOFValues(),initialvalues) <= g_epsilon)
+            for i,values in enumerate(configurations):
+                robot.SetDOFValues(values)
+                assert(collisions[i]==(env.CheckCollision(robot) or robot.CheckSelfCollision()))
+            robot.SetDOFValues(initialvalues)
+
+            armindices = robot.GetActiveManipulator().GetArmIndices()
+            collisions = env.CheckCollisionConfigurations(robot, configurations[:,armindices], armindices, False)
+            for i,values in enumerate(configurations):
+                robot.SetDOFValues(values[armindices],armindices)
+                assert(collisions[i]==env.CheckCollision(robot))
+
+            # no configurations still return the same types as when there are some
+            assert(len(env.CheckCollisionConfigurations(robot, zeros((0,robot.GetDOF())))) == 0)
+            checker = env.GetCollisionChecker()
+            oldoptions = checker.GetCollisionOptions()
+            checker.SetCollisionOptions(CollisionOptions.Distance)
+            try:
+                collisions, distances = env.CheckCollisionConfigurations(robot, zeros((0,robot.GetDOF())))
+                assert(len(collisions) == 0 and len(distances) == 0)
+            finally:
+                checker.SetCollisionOptions(oldoptions)
+
     def test_selfcollision(self):
         with self.env:
             self.LoadEnv('data/lab1.env.xml')
@@ -278,6 +311,89 @@ class test_fcl(RunCollision):
     def __init__(self):
         RunCollision.__init__(self, 'fcl_')
 
+    def test_linkdistances(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot = env.GetRobots()[0]
+        checker = env.GetCollisionChecker()
+        with env:
+            lower,upper = robot.GetDOFLimits()
+            for i in range(5):
+                robot.SetDOFValues(random.rand(robot.GetDOF())*(upper-lower)+lower)
+                # query twice so that the second one is warm started
+                output0 = checker.SendCommand('GetLinkDistances %s'%robot.GetName())
+                output1 = checker.SendCommand('GetLinkDistances %s'%robot.GetName())
+                distances0 = [float(line.split()[1]) for line in output0.splitlines()]
+                distances1 = [float(line.split()[1]) for line in output1.splitlines()]
+                assert(len(distances0) == len(distances1))
+                assert(transdist(distances0,distances1) <= g_epsilon)
+
+                # every distance has to agree with a link/environment distance query
+                oldoptions = checker.GetCollisionOptions()
+                checker.SetCollisionOptions(CollisionOptions.Distance)
+                try:
+                    for line in output1.splitlines():
+                        linkname, distance, otherbodyname = line.split()[0:3]
+                        report = CollisionReport()
+                        if env.CheckCollision(robot.GetLink(linkname), report=report) or otherbodyname == 'None':
+                            continue
+                        assert(abs(report.minDistance-float(distance)) <= 1e-4)
+                finally:
+                    checker.SetCollisionOptions(oldoptions)
+
+    def test_incrementalselfcollision(self):
+        env=self.env
+        with env:
+            robot=env.ReadRobotURI('robots/barrettwam.robot.xml')
+            env.Add(robot)
+            checker = env.GetCollisionChecker()
+            lower,upper = robot.GetDOFLimits()
+            wristindices = range(robot.GetDOF()-3,robot.GetDOF())
+            for i in range(20):
+                v = random.rand()*(upper-lower)+lower
+                robot.SetDOFValues(v)
+                checker.SendCommand('SetIncrementalSelfCollision 0')
+                check=robot.CheckSelfCollision()
+                checker.SendCommand('SetIncrementalSelfCollision 1')
+                assert(check==robot.CheckSelfCollision())
+                # only move the wrist so that the incremental path is used
+                for j in range(5):
+                    v[wristindices] = (random.rand(len(wristindices))*(upper-lower)+lower)[wristindices]
+                    robot.SetDOFValues(v)
+                    check=robot.CheckSelfCollision()
+                    checker.SendCommand('SetIncrementalSelfCollision 0')
+                    assert(check==robot.CheckSelfCollision())
+                    checker.SendCommand('SetIncrementalSelfCollision 1')
+
+            # moving links without changing the DOF values has to be detected too
+            robot.SetDOFValues(zeros(robot.GetDOF()))
+            checker.SendCommand('SetIncrementalSelfCollision 1')
+            assert(not robot.CheckSelfCollision())
+            transforms = robot.GetLinkTransformations()
+            transforms[-1] = transforms[1]
+            robot.SetLinkTransformations(transforms, robot.GetDOFValues())
+            check=robot.CheckSelfCollision()
+            checker.SendCommand('SetIncrementalSelfCollision 0')
+            assert(check==robot.CheckSelfCollision())
+            assert(check)
+
+    def test_broadphasealgorithm(self):
+        env=self.env
+        with env:
+            env.Load('data/lab1.env.xml')
+            robot=env.GetRobots()[0]
+            checker = env.GetCollisionChecker()
+            expected = [body.CheckEnvironmentCollision() for body in env.GetBodies()]
+            checker.SendCommand('SetEnvBroadphaseAlgorithm SaP')
+            checker.SendCommand('SetBodyBroadphaseAlgorithm Naive %s'%robot.GetName())
+            algorithms = checker.SendCommand('GetBroadphaseAlgorithm').split()
+            assert(algorithms[0] == 'SaP' and algorithms[2:] == [robot.GetName(), 'Naive'])
+            assert([body.CheckEnvironmentCollision() for body in env.GetBodies()] == expected)
+            chosen = checker.SendCommand('AutoTuneBroadphaseAlgorithm 2 DynamicAABBTree2 SaP').split()[-1]
+            assert(chosen in ['DynamicAABBTree2', 'SaP'])
+            assert(checker.SendCommand('GetBroadphaseAlgorithm').split()[0] == chosen)
+            assert([body.CheckEnvironmentCollision() for body in env.GetBodies()] == expected)
+
 # class test_bullet(RunCollision):
 #     def __init__(self):
 #         RunCollision.__init__(self, 'bullet')
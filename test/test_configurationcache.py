@@ -13,6 +13,7 @@
 # limitations under the License.
 from common_test_openrave import *
 from openravepy import openravepy_configurationcache
+import threading
 
 class TestConfigurationCache(EnvironmentSetup):
     def setup(self):
@@ -135,6 +136,13 @@ class TestConfigurationCache(EnvironmentSetup):
             self.log.info('writing cache to file...')
             cachechecker.SendCommand('SaveCache')
 
+            # loading the saved tree restores the same nodes without reinserting them
+            cachechecker.SendCommand('ResetSelfCache')
+            cachechecker.SendCommand('LoadCache')
+            selfcachedcollisions, selfcachedcollisionhits, selfcachedfreehits, loadedselfcachesize = cachechecker.SendCommand('GetSelfCacheStatistics').split()
+            assert(int(loadedselfcachesize) == int(selfcachesize))
+            assert(int(cachechecker.SendCommand('ValidateSelfCache')) == 1)
+
     def test_find_insert(self):
 
         self.LoadEnv('data/lab1.env.xml')
@@ -161,6 +169,7 @@ class TestConfigurationCache(EnvironmentSetup):
                      assert(inserted == 1)
                      cache.SetFreeSpaceThresh(1)
 
+             assert(cache.Validate())
              self.log.info('exhaustive insertion test passed')
 
     def test_updates(self):
@@ -215,6 +224,97 @@ class TestConfigurationCache(EnvironmentSetup):
             assert(int(cachechecker.SendCommand('ValidateSelfCache')) == 1)
             self.log.info('valid tests passed')
 
+    def test_sharedcache(self):
+        env = self.env
+        self.LoadEnv('data/hironxtable.env.xml')
+        with env:
+            robot = env.GetRobots()[0]
+            manip = robot.SetActiveManipulator('leftarm_torso')
+            robot.SetActiveDOFs(manip.GetArmIndices())
+
+            cachechecker = RaveCreateCollisionChecker(env,'CacheChecker')
+            success=cachechecker.SendCommand('TrackRobotState %s'%robot.GetName())
+            assert(success is not None)
+            cachechecker.SendCommand('SetSharedCache 1')
+            env.SetCollisionChecker(cachechecker)
+
+            lower, upper = robot.GetActiveDOFLimits()
+            vconfigs = [lower + (upper-lower)*random.rand(len(lower)) for i in range(50)]
+            for values in vconfigs:
+                robot.SetActiveDOFValues(values)
+                env.CheckCollision(robot)
+
+        clonedenv = env.CloneSelf(CloningOptions.Bodies)
+        try:
+            with clonedenv:
+                clonedrobot = clonedenv.GetRobot(robot.GetName())
+                clonedchecker = clonedenv.GetCollisionChecker()
+                clonedchecker.SendCommand('GetCacheStatistics')
+                for values in vconfigs:
+                    clonedrobot.SetActiveDOFValues(values)
+                    clonedenv.CheckCollision(clonedrobot)
+                cachedcollisions, cachedcollisionhits, cachedfreehits, cachesize = clonedchecker.SendCommand('GetCacheStatistics').split()
+                # every configuration was inserted by the original environment
+                assert(int(cachedcollisionhits)+int(cachedfreehits) == int(cachedcollisions) == len(vconfigs))
+        finally:
+            clonedenv.Destroy()
+            cachechecker.SendCommand('ResetSharedCache')
+
+    def test_sharedcache_multithreaded(self):
+        env = self.env
+        self.LoadEnv('data/hironxtable.env.xml')
+        numthreads = 4
+        with env:
+            robot = env.GetRobots()[0]
+            manip = robot.SetActiveManipulator('leftarm_torso')
+            robot.SetActiveDOFs(manip.GetArmIndices())
+            lower, upper = robot.GetActiveDOFLimits()
+            vconfigs = [lower + (upper-lower)*random.rand(len(lower)) for i in range(100)]
+            # results of the regular checker, with all links and with a disabled link
+            disabledlink = manip.GetEndEffector()
+            vexpected = []
+            for enable in [True, False]:
+                disabledlink.Enable(enable)
+                vexpected.append([])
+                for values in vconfigs:
+                    robot.SetActiveDOFValues(values)
+                    vexpected[-1].append(env.CheckCollision(robot))
+            disabledlink.Enable(True)
+
+            cachechecker = RaveCreateCollisionChecker(env,'CacheChecker')
+            assert(cachechecker.SendCommand('TrackRobotState %s'%robot.GetName()) is not None)
+            cachechecker.SendCommand('SetSharedCache 1')
+            env.SetCollisionChecker(cachechecker)
+
+        vclonedenvs = [env.CloneSelf(CloningOptions.Bodies) for i in range(numthreads)]
+        verrors = []
+        def CheckConfigs(clonedenv, ithread):
+            try:
+                with clonedenv:
+                    clonedrobot = clonedenv.GetRobot(robot.GetName())
+                    # every other environment disables a link, so it has to use another tree than the rest
+                    clonedlink = clonedrobot.GetLink(disabledlink.GetName())
+                    clonedlink.Enable(ithread % 2 == 0)
+                    vclonedexpected = vexpected[ithread % 2]
+                    for i in range(len(vconfigs)):
+                        index = (i + ithread*len(vconfigs)//numthreads) % len(vconfigs)
+                        clonedrobot.SetActiveDOFValues(vconfigs[index])
+                        if clonedenv.CheckCollision(clonedrobot) != vclonedexpected[index]:
+                            verrors.append((ithread, index))
+            except Exception as e:
+                verrors.append((ithread, e))
+        try:
+            vthreads = [threading.Thread(target=CheckConfigs, args=(clonedenv, ithread)) for ithread, clonedenv in enumerate(vclonedenvs)]
+            for thread in vthreads:
+                thread.start()
+            for thread in vthreads:
+                thread.join()
+            assert(len(verrors) == 0)
+        finally:
+            for clonedenv in vclonedenvs:
+                clonedenv.Destroy()
+            cachechecker.SendCommand('ResetSharedCache')
+
     def test_planning(self):
             env = self.env
             with env:
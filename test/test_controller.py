@@ -65,6 +65,36 @@ class test_ideal(RunController):
     def __init__(self):
         RunController.__init__(self, 'IdealController')
 
+    def test_prefetch(self):
+        self.log.debug('prefetched trajectory samples have to match the trajectory when the time step changes')
+        robot=self.LoadRobot('robots/schunk-lwa3.zae')
+        env=self.env
+        with env:
+            initvalues = robot.GetActiveDOFValues()
+            waypoint=zeros(robot.GetActiveDOF())
+            waypoint[0] = 0.5
+            waypoint[1] = 0.5
+            traj=RaveCreateTrajectory(env, '')
+            traj.Init(robot.GetActiveConfigurationSpecification('quadratic'))
+            traj.Insert(0,r_[initvalues,waypoint])
+            ret=planningutils.RetimeActiveDOFTrajectory(traj,robot,False, 1, 1, 'ParabolicTrajectoryRetimer2')
+            assert(ret.statusCode==PlannerStatusCode.HasSolution)
+            spec = traj.GetConfigurationSpecification()
+            for prefetch in [1, 0]:
+                assert(robot.GetController().SendCommand('SetPrefetch %d 64'%prefetch) is not None)
+                robot.SetActiveDOFValues(initvalues)
+                robot.GetController().SetPath(traj)
+                time = 0
+                numsteps = 0
+                while not robot.GetController().IsDone():
+                    timestep = 0.005 if numsteps % 50 < 25 else 0.01
+                    env.StepSimulation(timestep)
+                    expectedvalues = spec.ExtractJointValues(traj.Sample(min(time,traj.GetDuration())),robot,robot.GetActiveDOFIndices())
+                    assert(transdist(robot.GetActiveDOFValues(),expectedvalues) <= g_epsilon)
+                    time += timestep
+                    numsteps += 1
+                assert(transdist(robot.GetActiveDOFValues(),waypoint) <= g_epsilon)
+
 # class test_bullet(RunController):
 #     def __init__(self):
 #         RunController.__init__(self, 'bullet')
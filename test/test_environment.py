@@ -15,6 +15,7 @@ from common_test_openrave import *
 from subprocess import Popen, PIPE
 import shutil
 import threading
+import gc
 
 class TestEnvironment(EnvironmentSetup):
     def test_load(self):
@@ -209,6 +210,45 @@ class TestEnvironment(EnvironmentSetup):
         for t in threads:
             t.join()
 
+    def test_publishedbodies(self):
+        env=self.env
+        with env:
+            env.Load('data/lab1.env.xml')
+            robot=env.GetRobots()[0]
+            env.UpdatePublishedBodies()
+            generation,states,environmentids = env.GetPublishedBodiesChangedSince()
+            assert(len(states) == len(env.GetBodies()) and len(environmentids) == len(states))
+            assert(env.GetPublishedBody(robot.GetName())['updatestamp'] == robot.GetUpdateStamp())
+            # nothing moved
+            env.UpdatePublishedBodies()
+            generation2,states,environmentids = env.GetPublishedBodiesChangedSince(generation)
+            assert(generation2 > generation and len(states) == 0 and len(environmentids) == len(env.GetBodies()))
+            robot.SetTransform(matrixFromAxisAngle([0,0,0.5]))
+            env.UpdatePublishedBodies()
+            generation3,states,environmentids = env.GetPublishedBodiesChangedSince(generation2)
+            assert(generation3 > generation2 and [state['name'] for state in states] == [robot.GetName()])
+            robotenvironmentid = robot.GetEnvironmentBodyIndex()
+            env.Remove(robot)
+            env.UpdatePublishedBodies()
+            generation4,states,environmentids = env.GetPublishedBodiesChangedSince(generation3)
+            assert(len(states) == 0 and robotenvironmentid not in environmentids)
+
+    def test_publishedbodiesreleased(self):
+        self.log.info('test that a destroyed environment is released even though it published its bodies several times')
+        numenvironments = len(RaveGetEnvironments())
+        env2=Environment()
+        with env2:
+            env2.Load('data/lab1.env.xml')
+            env2.UpdatePublishedBodies()
+            env2.GetBodies()[0].SetTransform(matrixFromAxisAngle([0,0,0.5]))
+            env2.UpdatePublishedBodies()
+            # the previous generation is kept as a spare and still references the bodies
+            env2.UpdatePublishedBodies()
+        env2.Destroy()
+        del env2
+        gc.collect()
+        assert(len(RaveGetEnvironments()) == numenvironments)
+
     def test_dataccess(self):
         RaveDestroy()
         OPENRAVE_DATA = os.environ.get('OPENRAVE_DATA','')
@@ -233,6 +273,216 @@ class TestEnvironment(EnvironmentSetup):
             env2.Destroy()
             RaveDestroy()
             
+    def test_loadjson_manybodies(self):
+        self.log.info('test loading many new bodies from json, which are decoded and initialized in parallel')
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        with env:
+            for ibody in range(20):
+                body = RaveCreateKinBody(env,'')
+                body.SetName('box%d'%ibody)
+                body.InitFromBoxes(array([[0,0,0,0.01*(ibody+1),0.02,0.03]]),True)
+                body.SetTransform(matrixFromPose([1,0,0,0,0.1*ibody,0,0]))
+                env.Add(body)
+            envinfo = env.ExtractInfo().SerializeJSON()
+
+        loadedenv = Environment()
+        try:
+            with loadedenv:
+                loadedenv.LoadJSON(envinfo)
+                assert(len(loadedenv.GetBodies()) == len(env.GetBodies()))
+                for body in env.GetBodies():
+                    loadedbody = loadedenv.GetKinBody(body.GetName())
+                    assert(loadedbody is not None)
+                    assert(loadedbody.GetKinematicsGeometryHash() == body.GetKinematicsGeometryHash())
+                    assert(transdist(loadedbody.GetTransform(),body.GetTransform()) <= g_epsilon)
+        finally:
+            loadedenv.Destroy()
+
+    def test_loadjson_duplicateids(self):
+        self.log.info('test that new bodies without a name are dropped even when a later entry refers to them')
+        env=self.env
+        with env:
+            for name in ['boxa', 'boxb']:
+                body = RaveCreateKinBody(env,'')
+                body.SetName(name)
+                body.InitFromBoxes(array([[0,0,0,0.1,0.2,0.3]]),True)
+                env.Add(body)
+            envinfo = env.ExtractInfo().SerializeJSON()
+        bodyinfos = dict([(bodyinfo['name'], bodyinfo) for bodyinfo in envinfo['bodies']])
+        unnamedinfo = dict(bodyinfos['boxa'])
+        unnamedinfo['id'] = 'dup'
+        del unnamedinfo['name']
+        namedinfo = dict(bodyinfos['boxa'])
+        namedinfo['id'] = 'dup'
+        updatedinfo = dict(bodyinfos['boxb'])
+        T = eye(4)
+        T[0,3] = 0.5
+        updatedinfo['transform'] = poseFromMatrix(T).tolist()
+        # the unnamed first 'dup' entry is dropped when pending infos are flushed for the second 'boxb' entry, and again for the second 'dup' entry
+        envinfo['bodies'] = [unnamedinfo, bodyinfos['boxb'], updatedinfo, namedinfo]
+
+        loadedenv = Environment()
+        try:
+            with loadedenv:
+                loadedenv.LoadJSON(envinfo)
+                assert(len(loadedenv.GetBodies()) == 2)
+                assert(loadedenv.GetKinBody('boxa').GetId() == 'dup')
+                assert(transdist(loadedenv.GetKinBody('boxb').GetTransform(), T) <= g_epsilon)
+        finally:
+            loadedenv.Destroy()
+
+    def test_loadjson_contenthash(self):
+        self.log.info('test that updates skipping unchanged parts by their content hash still apply every change')
+        env=self.env
+        with env:
+            for ibody in range(3):
+                body = RaveCreateKinBody(env,'')
+                body.SetName('box%d'%ibody)
+                body.InitFromBoxes(array([[0,0,0,0.1,0.2,0.3]]),True)
+                env.Add(body)
+            isoContentHash = int(InfoSerializeOption.ContentHash)
+            envinfo = env.ExtractInfo().SerializeJSON(1.0, isoContentHash)
+            assert('contentHash' in envinfo['bodies'][0])
+
+        syncedenv = Environment()
+        try:
+            with syncedenv:
+                syncedenv.LoadJSON(envinfo)
+                counters = syncedenv.GetUpdateFromInfoCounters()
+                assert(counters['numCreatedBodies'] == 3)
+                assert(counters['numSkippedBodyStructures'] == 0)
+
+                # the second load compares everything once and records the content hashes
+                syncedenv.LoadJSON(envinfo)
+                counters = syncedenv.GetUpdateFromInfoCounters()
+                assert(counters['numCreatedBodies'] == 0)
+                assert(counters['numSkippedBodyStructures'] == 0)
+
+                # nothing changed since, so the third load skips all the body structures
+                syncedenv.LoadJSON(envinfo)
+                counters = syncedenv.GetUpdateFromInfoCounters()
+                assert(counters['numCreatedBodies'] == 0)
+                assert(counters['numModifiedBodies'] == 0)
+                assert(counters['numSkippedBodyStructures'] == 3)
+                syncedbody = syncedenv.GetKinBody('box0')
+                geom = syncedbody.GetLinks()[0].GetGeometries()[0]
+                diffusecolor = geom.GetDiffuseColor()
+
+                # local changes have to be reverted even though the hashes did not change
+                geom.SetDiffuseColor([1,0,0])
+                syncedenv.LoadJSON(envinfo)
+                assert(transdist(geom.GetDiffuseColor(), diffusecolor) <= g_epsilon)
+
+                # moving a body changes its state but not its content hash
+                with env:
+                    T = eye(4)
+                    T[0,3] = 0.5
+                    env.GetKinBody('box1').SetTransform(T)
+                    envinfo = env.ExtractInfo().SerializeJSON(1.0, isoContentHash)
+                syncedenv.LoadJSON(envinfo)
+                assert(transdist(syncedenv.GetKinBody('box1').GetTransform(), T) <= g_epsilon)
+
+                # changed geometry changes the hash
+                with env:
+                    env.GetKinBody('box2').GetLinks()[0].GetGeometries()[0].SetBoxExtents([0.2,0.2,0.2])
+                    envinfo = env.ExtractInfo().SerializeJSON(1.0, isoContentHash)
+                syncedenv.LoadJSON(envinfo)
+                assert(transdist(syncedenv.GetKinBody('box2').GetLinks()[0].GetGeometries()[0].GetBoxExtents(), [0.2,0.2,0.2]) <= g_epsilon)
+        finally:
+            syncedenv.Destroy()
+
+    def test_environmentstatesaver(self):
+        self.log.info('test that the environment state saver restores the state of all the saved bodies')
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        with env:
+            robot = env.GetRobots()[0]
+            armindices = robot.GetActiveManipulator().GetArmIndices()
+            robot.SetDOFValues(0.1*ones(len(armindices)), armindices)
+            robot.Grab(env.GetKinBody('mug2'))
+            bodies = env.GetBodies()
+            def GetState():
+                return [(body.GetLinkTransformations(), body.GetDOFValues(), [grabbed.GetName() for grabbed in body.GetGrabbed()]) for body in bodies]
+            def CheckState(state):
+                for body, (linktransforms, dofvalues, grabbednames) in zip(bodies, state):
+                    for Tlink, Tsaved in zip(body.GetLinkTransformations(), linktransforms):
+                        assert(transdist(Tlink, Tsaved) <= g_epsilon)
+                    assert(transdist(body.GetDOFValues(), dofvalues) <= g_epsilon)
+                    assert([grabbed.GetName() for grabbed in body.GetGrabbed()] == grabbednames)
+            savedstate = GetState()
+            savedactivedofs = robot.GetActiveDOFIndices()
+            saver = EnvironmentStateSaver(env)
+            assert(saver.GetBufferSize() > 0)
+
+            mug = env.GetKinBody('mug1')
+            T = mug.GetTransform()
+            T[0,3] += 0.5
+            mug.SetTransform(T)
+            robot.SetDOFValues(0.2*ones(len(armindices)), armindices)
+            robot.ReleaseAllGrabbed()
+            robot.Grab(env.GetKinBody('mug3'))
+            robot.SetActiveDOFs(armindices[:2])
+            newbody = RaveCreateKinBody(env,'')
+            newbody.SetName('newbox')
+            newbody.InitFromBoxes(array([[0,0,0,0.1,0.1,0.1]]),True)
+            env.Add(newbody)
+
+            saver.Restore()
+            CheckState(savedstate)
+            assert(all(robot.GetActiveDOFIndices() == savedactivedofs))
+            # bodies added after saving are left untouched
+            assert(env.GetKinBody('newbox') is not None)
+
+            # restoring again without changes keeps the state, and a with statement restores on exit
+            saver.Restore()
+            CheckState(savedstate)
+            with EnvironmentStateSaver(env):
+                mug.SetTransform(T)
+                robot.ReleaseAllGrabbed()
+            CheckState(savedstate)
+
+            # releasing and grabbing the same body at a different pose has to restore the saved relative pose
+            mug2 = env.GetKinBody('mug2')
+            grabbinglink = robot.IsGrabbing(mug2)
+            Tsavedrelative = dot(linalg.inv(grabbinglink.GetTransform()), mug2.GetTransform())
+            robot.Release(mug2)
+            Tmug2 = mug2.GetTransform()
+            Tmug2[2,3] += 0.1
+            mug2.SetTransform(Tmug2)
+            robot.Grab(mug2)
+            saver.Restore()
+            CheckState(savedstate)
+            robot.SetDOFValues(0.2*ones(len(armindices)), armindices)
+            Trelative = dot(linalg.inv(grabbinglink.GetTransform()), mug2.GetTransform())
+            assert(transdist(Trelative, Tsavedrelative) <= g_epsilon)
+
+    def test_msgpack_binarymeshblobs(self):
+        self.log.info('test that trimeshes saved to msgpack as binary blobs load back unchanged')
+        env=self.env
+        with env:
+            body = RaveCreateKinBody(env,'')
+            body.SetName('mesh')
+            vertices = array([[0,0,0],[1,0,0],[0,1,0],[0,0,1],[0.1,-0.2,0.3]])
+            indices = array([[0,1,2],[0,1,3],[0,2,3],[1,2,4]],int32)
+            body.InitFromTrimesh(TriMesh(vertices,indices),True)
+            env.Add(body)
+            env.Save('test_binarymeshblobs.msgpack',Environment.SelectionOptions.Everything,{'binaryMeshBlobs':'1'})
+            env.Save('test_numbermeshes.msgpack',Environment.SelectionOptions.Everything)
+        # blobs are opt-in and smaller than number arrays
+        assert(os.path.getsize('test_binarymeshblobs.msgpack') < os.path.getsize('test_numbermeshes.msgpack'))
+
+        for filename in ['test_binarymeshblobs.msgpack', 'test_numbermeshes.msgpack']:
+            loadedenv = Environment()
+            try:
+                with loadedenv:
+                    assert(loadedenv.Load(filename))
+                    loadedmesh = loadedenv.GetKinBody('mesh').GetLinks()[0].GetGeometries()[0].GetCollisionMesh()
+                    assert(transdist(loadedmesh.vertices,vertices) <= g_epsilon)
+                    assert(all(loadedmesh.indices==indices))
+            finally:
+                loadedenv.Destroy()
+
     def test_load_cwd(self):
         env=self.env
         oldcwd = os.getcwd()
@@ -24,6 +24,50 @@ def test_pluginloading():
     env=Environment()
     assert(RaveCreateProblem(env,'ikfast') is not None)
 
+@with_destroy
+def test_pluginmanifest():
+    import json, shutil, subprocess, sys, tempfile
+    RaveInitialize(load_all_plugins=False)
+    assert(RaveLoadPlugin('basesamplers'))
+    pluginpath = [path for path, info in RaveGetPluginInfo() if 'basesamplers' in os.path.basename(path)][0]
+    tempdir = tempfile.mkdtemp()
+    try:
+        # a private plugin directory and manifest, so that only the copied plugin is listed
+        copiedpath = os.path.join(tempdir, os.path.basename(pluginpath))
+        shutil.copyfile(pluginpath, copiedpath)
+        manifestfilename = os.path.join(tempdir, 'pluginmanifest.json')
+        subenv = dict(os.environ, OPENRAVE_PLUGINS=tempdir, OPENRAVE_PLUGINS_MANIFEST=manifestfilename)
+        def RunAndReadManifest(command):
+            subprocess.check_call([sys.executable, '-c', 'from openravepy import *\nRaveInitialize()\n%s\nRaveDestroy()'%command], env=subenv)
+            with open(manifestfilename) as f:
+                return dict([(plugin['path'], plugin) for plugin in json.load(f)['plugins']])
+
+        entries = RunAndReadManifest('')
+        assert(copiedpath in entries)
+        vsamplernames = entries[copiedpath]['interfaces']['spacesampler']
+        assert('MT19937' in vsamplernames)
+
+        # an entry whose stamp matches but whose interfaces are wrong is dropped as soon as the plugin is loaded
+        entries[copiedpath]['interfaces'] = {'spacesampler':vsamplernames+['MissingSampler']}
+        with open(manifestfilename) as f:
+            manifest = json.load(f)
+        manifest['plugins'] = list(entries.values())
+        with open(manifestfilename, 'w') as f:
+            json.dump(manifest, f)
+        entries = RunAndReadManifest("assert(RaveCreateSpaceSampler(Environment(), 'mt19937') is not None)")
+        assert(copiedpath not in entries)
+        entries = RunAndReadManifest('')
+        assert(entries[copiedpath]['interfaces']['spacesampler'] == vsamplernames)
+
+        # changing the modification time makes the plugin get scanned again
+        mtime = entries[copiedpath]['mtime']
+        os.utime(copiedpath, (mtime+10, mtime+10))
+        entries = RunAndReadManifest('')
+        assert(entries[copiedpath]['mtime'] == mtime+10)
+        assert(entries[copiedpath]['interfaces']['spacesampler'] == vsamplernames)
+    finally:
+        shutil.rmtree(tempdir)
+
 class RunTutorialExample(object):
     __name__= 'test_global.tutorialexample'
     def __call__(self,modulepath):
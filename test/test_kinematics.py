@@ -704,6 +704,61 @@ class TestKinematics(EnvironmentSetup):
                         vmax = numpy.max(geom.GetCollisionMesh().vertices,0)
                         assert( transdist(0.5*(vmax-vmin),extents) <= g_epsilon )
 
+    def test_collisionmeshbuffer(self):
+        self.log.info('test that compact collision mesh buffers match the collision meshes')
+        env=self.env
+        with env:
+            self.LoadEnv(g_envfiles[0])
+            numgeometries = 0
+            for body in env.GetBodies():
+                for link in body.GetLinks():
+                    for geom in link.GetGeometries():
+                        mesh = geom.GetCollisionMesh()
+                        positions,indices = geom.CreateCollisionMeshBuffer()
+                        assert(positions.dtype == numpy.float32)
+                        assert(indices.dtype == (numpy.uint16 if len(mesh.vertices) <= 0x10000 else numpy.int32))
+                        assert(positions.shape == (len(mesh.vertices),3))
+                        assert(all(indices.flatten()==mesh.indices.flatten()))
+                        if len(mesh.vertices) > 0:
+                            assert(numpy.max(abs(positions-mesh.vertices)) <= 1e-6*max(1.0,numpy.max(abs(mesh.vertices))))
+                            numgeometries += 1
+            assert(numgeometries > 0)
+
+            # buffers are created from the current mesh
+            geom = [geom for body in env.GetBodies() for link in body.GetLinks() for geom in link.GetGeometries() if geom.IsModifiable()][0]
+            geom.SetCollisionMesh(TriMesh(*misc.ComputeBoxMesh([0.6,0.5,0.1])))
+            positions,indices = geom.CreateCollisionMeshBuffer()
+            assert(transdist(positions,geom.GetCollisionMesh().vertices) <= 1e-6)
+            assert(all(indices.flatten()==geom.GetCollisionMesh().indices.flatten()))
+
+    def test_preallocatedoutputs(self):
+        self.log.info('test filling preallocated arrays and reading trimesh views')
+        env=self.env
+        with env:
+            robot = self.LoadRobot(g_robotfiles[0])
+            lower,upper = robot.GetDOFLimits()
+            robot.SetDOFValues(lower+random.rand(robot.GetDOF())*(upper-lower))
+            values = zeros(robot.GetDOF())
+            assert(robot.GetDOFValues(None,values) is values)
+            assert(transdist(values,robot.GetDOFValues()) <= g_epsilon)
+            indices = [0,2]
+            values = zeros(len(indices))
+            robot.GetDOFValues(indices,values)
+            assert(transdist(values,robot.GetDOFValues(indices)) <= g_epsilon)
+
+            poses = zeros((len(robot.GetLinks()),7))
+            robot.GetLinkTransformPoses(poses)
+            assert(transdist(poses,robot.GetLinkTransformPoses()) <= g_epsilon)
+            for link,pose in zip(robot.GetLinks(),poses):
+                assert(transdist(pose,link.GetTransformPose()) <= g_epsilon)
+
+            for link in robot.GetLinks():
+                vertices,indices = link.GetCollisionDataView()
+                mesh = link.GetCollisionData()
+                assert(not vertices.flags.writeable)
+                assert(transdist(vertices,mesh.vertices) <= g_epsilon)
+                assert(all(indices.flatten()==mesh.indices.flatten()))
+
     def test_hashes(self):
         robot = self.LoadRobot(g_robotfiles[0])
         s = robot.serialize(SerializationOptions.Kinematics)
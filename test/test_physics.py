@@ -112,6 +112,27 @@ class RunPhysics(EnvironmentSetup):
                 break
         env.StopSimulation()
 
+    def test_stepsimulationbatch(self):
+        env=self.env
+        env.GetPhysicsEngine().SetGravity([0,0,-9.81])
+        with env:
+            body = env.ReadKinBodyURI('data/lego2.kinbody.xml')
+            body.SetName('body')
+            env.Add(body)
+            Tinit = eye(4)
+            Tinit[2,3] = 3
+            body.SetTransform(Tinit)
+
+        simtime0 = env.GetSimulationTime()
+        stats = env.StepSimulationBatch(100, 0.01)
+        assert(stats['numsteps'] == 100)
+        assert(stats['simulationtime'] == 1000000)
+        assert(env.GetSimulationTime()-simtime0 == 1000000)
+        assert(stats['stepspersecond'] > 0)
+        with env:
+            T = body.GetTransform()
+            assert(abs(T[2,3]-Tinit[2,3]) > 0.2)
+
     def test_kinematics(self):
         log.info("test that physics kinematics are consistent")
         env=self.env
@@ -121,6 +121,60 @@ class RunRobot(EnvironmentSetup):
             robot.ReleaseAllGrabbed()
             assert(env.CheckCollision(leftmug,rightmug))
             
+    def test_grabcollision_regrab(self):
+        self.log.info('test that regrabbing with the same and different states gives consistent self-collisions')
+        env=self.env
+        self.LoadEnv('robots/man1.zae')
+        with env:
+            robot = env.GetRobots()[0]
+            leftarm = robot.GetManipulator('leftarm')
+            rightarm = robot.GetManipulator('rightarm')
+            self.LoadEnv('data/mug1.kinbody.xml')
+            leftmug = env.GetKinBody('mug')
+            self.LoadEnv('data/mug2.kinbody.xml')
+            rightmug = env.GetKinBody('mug2')
+            leftmug.SetTransform(array([[ 0.99516672, -0.0976999 ,  0.00989374,  0.14321238],
+                                        [ 0.09786028,  0.99505007, -0.01728364,  0.94120538],
+                                        [-0.00815616,  0.01816831,  0.9998017 ,  0.38686624],
+                                        [ 0.        ,  0.        ,  0.        ,  1.        ]]))
+            rightmug.SetTransform(array([[  9.99964535e-01,  -1.53668225e-08,   8.41848925e-03, -1.92047462e-01],
+                                         [ -8.40134174e-03,  -6.37951940e-02,   9.97927606e-01, 9.22815084e-01],
+                                         [  5.37044369e-04,  -9.97963011e-01,  -6.37929291e-02, 4.16847348e-01],
+                                         [  0.00000000e+00,   0.00000000e+00,   0.00000000e+00, 1.00000000e+00]]))
+            grabJointAngles = array([ -3.57627869e-07,   0.00000000e+00,  -1.46997878e-15, -1.65528119e+00,  -1.23030146e-08,  -8.41909389e-11, 0.00000000e+00])
+            collisionJointAngles = array([ -2.38418579e-07,   0.00000000e+00,  -2.96873480e-01, -1.65527940e+00,  -3.82479293e-08,  -1.23165381e-10, 1.35525272e-20])
+
+            def grabmugs(jointangles):
+                robot.SetDOFValues(jointangles,rightarm.GetArmIndices())
+                robot.SetDOFValues(jointangles,leftarm.GetArmIndices())
+                robot.Grab(rightmug,rightarm.GetEndEffector())
+                robot.Grab(leftmug,leftarm.GetEndEffector())
+
+            def setarms(jointangles):
+                robot.SetDOFValues(jointangles,rightarm.GetArmIndices())
+                robot.SetDOFValues(jointangles,leftarm.GetArmIndices())
+
+            Tleftmug = leftmug.GetTransform()
+            Trightmug = rightmug.GetTransform()
+            for iteration in range(2):
+                leftmug.SetTransform(Tleftmug)
+                rightmug.SetTransform(Trightmug)
+                grabmugs(grabJointAngles)
+                assert(not robot.CheckSelfCollision())
+                setarms(collisionJointAngles)
+                assert(robot.CheckSelfCollision())
+                # restoring a saved state has to give the same result as the original grab
+                with robot:
+                    robot.ReleaseAllGrabbed()
+                    assert(not robot.CheckSelfCollision())
+                assert(robot.CheckSelfCollision())
+                robot.ReleaseAllGrabbed()
+
+                # grabbing while the mugs collide ignores their collision
+                grabmugs(collisionJointAngles)
+                assert(not robot.CheckSelfCollision())
+                robot.ReleaseAllGrabbed()
+
     def test_grabcollision_dynamic(self):
         self.log.info('test if can handle grabbed bodies being enabled/disabled')
         env=self.env
@@ -0,0 +1,78 @@
+# -*- coding: utf-8 -*-
+# Copyright (C) 2026 OpenRAVE
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+from common_test_openrave import *
+
+class TestSensors(EnvironmentSetup):
+    def test_camerasoftwarerendering(self):
+        self.log.info('test the depth image of a box rendered without a viewer')
+        env=self.env
+        with env:
+            body = RaveCreateKinBody(env,'')
+            body.SetName('box')
+            body.InitFromBoxes(array([[0,0,2,0.5,0.5,0.5]]),True)
+            env.Add(body)
+
+            camera = RaveCreateSensor(env,'BaseCamera')
+            assert(camera.SendCommand('setdims 64 48') is not None)
+            assert(camera.SendCommand('setintrinsic 50 50 32 24') is not None)
+            camera.SetTransform(eye(4)) # looking along +z
+            camera.Configure(Sensor.ConfigureCommand.PowerOn)
+            camera.SimulationStep(0.5)
+            # software rendering is off by default
+            depthdata = camera.GetSensorData(Sensor.Type.Camera).depthdata
+            assert(depthdata is None or len(depthdata) == 0)
+
+            assert(camera.SendCommand('SetSoftwareRendering depth 2') is not None)
+            camera.SimulationStep(0.5)
+            depthdata = camera.GetSensorData(Sensor.Type.Camera).depthdata
+            assert(depthdata.shape == (48,64))
+            # the front face of the box is at z=1.5 and spans 50*0.5/1.5 pixels around the image center
+            assert(abs(depthdata[24,32]-1.5) <= 1e-4)
+            assert(abs(depthdata[24+10,32-10]-1.5) <= 1e-4)
+            assert(depthdata[0,0] == 0)
+            assert(depthdata[24,63] == 0)
+
+    def test_laserthreadedscan(self):
+        self.log.info('test that threaded and asynchronous laser scans give the same ranges as serial scans')
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        with env:
+            laser = RaveCreateSensor(env,'BaseLaser2D')
+            T = eye(4)
+            T[2,3] = 0.5
+            laser.SetTransform(T)
+            laser.Configure(Sensor.ConfigureCommand.PowerOn)
+            laser.SimulationStep(0.1)
+            serialdata = laser.GetSensorData(Sensor.Type.Laser)
+            assert(len(serialdata.ranges) > 0)
+            assert(any(serialdata.intensity > 0))
+
+            assert(laser.SendCommand('scanthreads 4') is not None)
+            laser.Configure(Sensor.ConfigureCommand.PowerOn)
+            laser.SimulationStep(0.1)
+            threadeddata = laser.GetSensorData(Sensor.Type.Laser)
+            assert(transdist(threadeddata.ranges,serialdata.ranges) <= g_epsilon)
+            assert(all(threadeddata.intensity==serialdata.intensity))
+
+            assert(laser.SendCommand('scanthreads 4 1') is not None)
+            laser.Configure(Sensor.ConfigureCommand.PowerOn)
+            laser.SimulationStep(0.1)
+            for itry in range(1000):
+                asyncdata = laser.GetSensorData(Sensor.Type.Laser)
+                if any(asyncdata.intensity > 0):
+                    break
+                time.sleep(0.01)
+                laser.SimulationStep(0)
+            assert(transdist(asyncdata.ranges,serialdata.ranges) <= g_epsilon)
+            assert(all(asyncdata.intensity==serialdata.intensity))
@@ -844,6 +844,53 @@ class TestTrajectory(EnvironmentSetup):
             planningutils.VerifyTrajectory(parameters, traj,0.01)
             
 
+    def test_polynomialroots(self):
+        from openravepy import openravepy_piecewisepolynomials as piecewisepolynomials
+        def Deduplicate(vroots, tol):
+            vunique = []
+            for root in sorted(vroots):
+                if len(vunique) == 0 or root - vunique[-1] > tol:
+                    vunique.append(root)
+            return vunique
+
+        rng = random.RandomState(0)
+        tmin, tmax = -1.0, 1.0
+        for itrial in range(4000):
+            degree = rng.randint(1, 5)
+            vroots = list(rng.uniform(-1.5, 1.5, degree))
+            case = itrial % 4
+            if case == 1 and degree >= 2:
+                vroots[1] = vroots[0] # repeated root
+            elif case == 2:
+                vroots[0] = tmin + 1e-9 if rng.randint(2) else tmax - 1e-9 # root close to the boundary
+            coeffs = array([rng.uniform(0.5, 2)*(1 if rng.randint(2) else -1)])
+            if case == 3 and degree >= 2:
+                # replace two of the roots by a complex pair
+                vroots = vroots[2:]
+                re, im = rng.uniform(-1.5, 1.5), rng.uniform(0.1, 1)
+                coeffs = polymul(coeffs, [1, -2*re, re*re+im*im])
+            for root in vroots:
+                coeffs = polymul(coeffs, [1, -root])
+            coeffs = coeffs[::-1] # weakest term first
+
+            vfound = piecewisepolynomials.FindRealRootsInRange(coeffs, tmin, tmax)
+            assert(all(vfound[i] < vfound[i+1] for i in range(len(vfound)-1)))
+            vfound = Deduplicate(vfound, 1e-6)
+            vexpected = Deduplicate([root for root in vroots if tmin <= root <= tmax], 1e-6)
+            assert(len(vfound) == len(vexpected))
+            assert(all(abs(root - expectedroot) <= 1e-6 for root, expectedroot in zip(vfound, vexpected)))
+
+            # polyroots has to agree on the roots it finds inside the range. it can miss repeated roots, whose iterates drift
+            # off the real axis, so it only has to find the simple roots far from the other roots.
+            vpolyroots = piecewisepolynomials.PolyRoots(coeffs)
+            for root in vpolyroots:
+                if tmin + 1e-6 <= root <= tmax - 1e-6:
+                    assert(min(abs(array(vfound) - root)) <= 1e-6)
+            for root in vfound:
+                vdistances = sorted(abs(array(vroots) - root))
+                if len(vdistances) == 1 or vdistances[1] > 1e-2:
+                    assert(len(vpolyroots) > 0 and min(abs(array(vpolyroots) - root)) <= 1e-6)
+
     def test_segmenttraj2():
         env=self.env
         trajstr = '''<trajectory>